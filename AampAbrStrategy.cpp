@@ -0,0 +1,194 @@
+/*
+ * If not stated otherwise in this file or this component's license file the
+ * following copyright and licenses apply:
+ *
+ * Copyright 2020 RDK Management
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ * http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+*/
+
+/**
+ * @file AampAbrStrategy.cpp
+ * @brief Built-in ABR strategies, selectable instead of the ABRManager rules
+ */
+
+#include "AampAbrStrategy.h"
+#include <math.h>
+#include <algorithm>
+
+#define ABR_THROUGHPUT_SAFETY_FACTOR 0.9    /**< Share of measured throughput a profile may use */
+
+/**
+ * @brief Create strategy of an ABR mode
+ * @param mode ABR mode
+ * @param minBufferSeconds buffer below which lowest sustainable profile is preferred
+ * @param targetBufferSeconds buffer at which highest profile is preferred
+ * @retval strategy, NULL for eAAMP_ABR_MODE_DEFAULT
+ */
+AampAbrStrategy *AampAbrStrategy::Create(AAMPAbrMode mode, double minBufferSeconds, double targetBufferSeconds)
+{
+	AampAbrStrategy *strategy = NULL;
+	switch (mode)
+	{
+		case eAAMP_ABR_MODE_THROUGHPUT:
+			strategy = new AampThroughputAbr();
+			break;
+		case eAAMP_ABR_MODE_BOLA:
+			strategy = new AampBolaAbr(minBufferSeconds, targetBufferSeconds);
+			break;
+		default:
+			break;
+	}
+	return strategy;
+}
+
+
+/**
+ * @brief Get ladder position of a profile index
+ * @param ladder profiles in ascending bandwidth
+ * @param profileIndex profile index
+ * @retval position in ladder, 0 if not found
+ */
+int AampAbrStrategy::GetLadderPosition(const std::vector<AbrLadderProfile> &ladder, int profileIndex)
+{
+	for (size_t i = 0; i < ladder.size(); i++)
+	{
+		if (ladder[i].profileIndex == profileIndex)
+		{
+			return (int)i;
+		}
+	}
+	return 0;
+}
+
+
+/**
+ * @brief Get ladder position of highest profile sustainable by a throughput
+ * @param ladder profiles in ascending bandwidth
+ * @param networkBandwidth throughput in bps
+ * @retval position in ladder, 0 if none fits
+ */
+int AampAbrStrategy::GetLadderPositionForBandwidth(const std::vector<AbrLadderProfile> &ladder, long networkBandwidth)
+{
+	int pos = 0;
+	double usable = networkBandwidth * ABR_THROUGHPUT_SAFETY_FACTOR;
+	for (size_t i = 0; i < ladder.size(); i++)
+	{
+		if (ladder[i].bandwidthBitsPerSecond <= usable)
+		{
+			pos = (int)i;
+		}
+	}
+	return pos;
+}
+
+
+/**
+ * @brief Select profile of next video fragment by throughput
+ * @param input player state
+ * @retval profile index of desired profile
+ */
+int AampThroughputAbr::GetDesiredProfile(const AbrStrategyInput &input)
+{
+	if (input.ladder.empty())
+	{
+		return input.currentProfileIndex;
+	}
+	if (input.networkBandwidth <= 0)
+	{
+		return input.currentProfileIndex;
+	}
+	return input.ladder[GetLadderPositionForBandwidth(input.ladder, input.networkBandwidth)].profileIndex;
+}
+
+
+/**
+ * @brief AampBolaAbr constructor
+ * @param minBufferSeconds buffer below which lowest profile has best score
+ * @param targetBufferSeconds buffer at which highest profile has best score
+ */
+AampBolaAbr::AampBolaAbr(double minBufferSeconds, double targetBufferSeconds) : mMinBufferSeconds(minBufferSeconds),
+		mTargetBufferSeconds(targetBufferSeconds), mStartup(true)
+{
+	if (mMinBufferSeconds <= 0)
+	{
+		mMinBufferSeconds = 1;
+	}
+	if (mTargetBufferSeconds <= mMinBufferSeconds)
+	{
+		mTargetBufferSeconds = mMinBufferSeconds + 1;
+	}
+}
+
+
+/**
+ * @brief Select profile of next video fragment by buffer level
+ * @param input player state
+ * @retval profile index of desired profile
+ */
+int AampBolaAbr::GetDesiredProfile(const AbrStrategyInput &input)
+{
+	const std::vector<AbrLadderProfile> &ladder = input.ladder;
+	if (ladder.size() < 2 || input.fragmentDurationSeconds <= 0)
+	{
+		// Nothing to score profiles by, stay on current profile
+		return input.currentProfileIndex;
+	}
+	int currentPos = GetLadderPosition(ladder, input.currentProfileIndex);
+	bool throughputKnown = (input.networkBandwidth > 0);
+	int throughputPos = throughputKnown ? GetLadderPositionForBandwidth(ladder, input.networkBandwidth) : currentPos;
+
+	if (mStartup)
+	{
+		if (input.bufferedSeconds < mMinBufferSeconds)
+		{
+			// Not enough buffer for its level to be meaningful
+			return ladder[throughputPos].profileIndex;
+		}
+		mStartup = false;
+	}
+
+	// Utility of profile is log of its fragment size, relative to lowest profile (utility 1)
+	double lowestSize = ladder[0].bandwidthBitsPerSecond * input.fragmentDurationSeconds;
+	double highestUtility = log(ladder.back().bandwidthBitsPerSecond * input.fragmentDurationSeconds / lowestSize) + 1;
+	double gp = (highestUtility - 1) / (mTargetBufferSeconds / mMinBufferSeconds - 1);
+	double vp = mMinBufferSeconds / gp;
+	double buffer = std::max(input.bufferedSeconds, 0.0);
+
+	int bolaPos = 0;
+	double bestScore = 0;
+	for (size_t i = 0; i < ladder.size(); i++)
+	{
+		double size = ladder[i].bandwidthBitsPerSecond * input.fragmentDurationSeconds;
+		double utility = log(size / lowestSize) + 1;
+		double score = (vp * (utility + gp) - buffer) / size;
+		if (i == 0 || score >= bestScore)
+		{
+			bestScore = score;
+			bolaPos = (int)i;
+		}
+	}
+
+	int desiredPos = bolaPos;
+	if (bolaPos > currentPos)
+	{
+		// Up-switch only as far as throughput sustains, buffer alone may be a burst
+		desiredPos = std::max(currentPos, std::min(bolaPos, throughputPos));
+	}
+	else if (bolaPos < currentPos && throughputKnown)
+	{
+		// Down-switch not below what throughput sustains, buffer refills at that profile
+		desiredPos = std::min(currentPos, std::max(bolaPos, throughputPos));
+	}
+	return ladder[desiredPos].profileIndex;
+}
@@ -0,0 +1,164 @@
+/*
+ * If not stated otherwise in this file or this component's license file the
+ * following copyright and licenses apply:
+ *
+ * Copyright 2020 RDK Management
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ * http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+*/
+
+/**
+ * @file AampAbrStrategy.h
+ * @brief Built-in ABR strategies, selectable instead of the ABRManager rules
+ *
+ * Strategies have no player dependencies, so they can be driven by the
+ * offline simulator (test/abrsimulator.cpp) as well as StreamAbstractionAAMP.
+ */
+
+#ifndef __AAMP_ABR_STRATEGY_H__
+#define __AAMP_ABR_STRATEGY_H__
+
+#include <vector>
+
+/**
+ * @brief ABR algorithm used for video profile selection
+ */
+enum AAMPAbrMode
+{
+	eAAMP_ABR_MODE_DEFAULT,         /**< ABRManager throughput rules with buffer checks */
+	eAAMP_ABR_MODE_THROUGHPUT,      /**< Built-in throughput rule */
+	eAAMP_ABR_MODE_BOLA             /**< Built-in buffer occupancy (BOLA) rule capped by throughput */
+};
+
+/**
+ * @brief Profile of ABR ladder
+ */
+struct AbrLadderProfile
+{
+	int profileIndex;               /**< Profile index of stream abstraction */
+	long bandwidthBitsPerSecond;    /**< Advertised bandwidth of profile */
+};
+
+/**
+ * @brief Player state an ABR decision is based on
+ */
+struct AbrStrategyInput
+{
+	AbrStrategyInput() : ladder(), currentProfileIndex(0), bufferedSeconds(0), fragmentDurationSeconds(0), networkBandwidth(-1)
+	{
+	}
+
+	std::vector<AbrLadderProfile> ladder;   /**< Video profiles, in ascending bandwidth */
+	int currentProfileIndex;                /**< Profile of last downloaded fragment */
+	double bufferedSeconds;                 /**< Buffered video duration, <= 0 if unknown */
+	double fragmentDurationSeconds;         /**< Duration of a video fragment */
+	long networkBandwidth;                  /**< Estimated throughput in bps, -1 if unknown */
+};
+
+/**
+ * @brief ABR strategy interface
+ */
+class AampAbrStrategy
+{
+public:
+	/**
+	 * @brief Create strategy of an ABR mode
+	 *
+	 * @param[in] mode - ABR mode
+	 * @param[in] minBufferSeconds - buffer below which lowest sustainable profile is preferred
+	 * @param[in] targetBufferSeconds - buffer at which highest profile is preferred
+	 * @return strategy, NULL for eAAMP_ABR_MODE_DEFAULT
+	 */
+	static AampAbrStrategy *Create(AAMPAbrMode mode, double minBufferSeconds, double targetBufferSeconds);
+
+	/**
+	 * @brief AampAbrStrategy destructor
+	 */
+	virtual ~AampAbrStrategy() {}
+
+	/**
+	 * @brief Select profile of next video fragment
+	 *
+	 * @param[in] input - player state
+	 * @return profile index of desired profile
+	 */
+	virtual int GetDesiredProfile(const AbrStrategyInput &input) = 0;
+
+	/**
+	 * @brief Get strategy name for logging
+	 *
+	 * @return name
+	 */
+	virtual const char *GetName() const = 0;
+
+protected:
+	/**
+	 * @brief Get ladder position of a profile index
+	 *
+	 * @param[in] ladder - profiles in ascending bandwidth
+	 * @param[in] profileIndex - profile index
+	 * @return position in ladder, 0 if not found
+	 */
+	static int GetLadderPosition(const std::vector<AbrLadderProfile> &ladder, int profileIndex);
+
+	/**
+	 * @brief Get ladder position of highest profile sustainable by a throughput
+	 *
+	 * @param[in] ladder - profiles in ascending bandwidth
+	 * @param[in] networkBandwidth - throughput in bps
+	 * @return position in ladder, 0 if none fits
+	 */
+	static int GetLadderPositionForBandwidth(const std::vector<AbrLadderProfile> &ladder, long networkBandwidth);
+};
+
+/**
+ * @brief Throughput rule: highest profile within a safety margin of measured throughput
+ */
+class AampThroughputAbr : public AampAbrStrategy
+{
+public:
+	int GetDesiredProfile(const AbrStrategyInput &input) override;
+	const char *GetName() const override { return "throughput"; }
+};
+
+/**
+ * @brief Buffer occupancy rule (BOLA) with throughput cap on up-switches
+ *
+ * Profile utility is the log of fragment size; the profile maximizing
+ * (Vp * (utility + gp) - buffer) / fragment size is chosen, so quality rises
+ * with buffer level between the min and target buffer. Up-switches are capped
+ * to what throughput sustains and down-switches do not go below it, which
+ * avoids oscillation when buffer level hovers around a decision boundary.
+ * Throughput alone decides during startup, until buffer first reaches min.
+ */
+class AampBolaAbr : public AampAbrStrategy
+{
+public:
+	/**
+	 * @brief AampBolaAbr constructor
+	 *
+	 * @param[in] minBufferSeconds - buffer below which lowest profile has best score
+	 * @param[in] targetBufferSeconds - buffer at which highest profile has best score
+	 */
+	AampBolaAbr(double minBufferSeconds, double targetBufferSeconds);
+
+	int GetDesiredProfile(const AbrStrategyInput &input) override;
+	const char *GetName() const override { return "bola"; }
+
+private:
+	double mMinBufferSeconds;       /**< buffer below which lowest profile has best score */
+	double mTargetBufferSeconds;    /**< buffer at which highest profile has best score */
+	bool mStartup;                  /**< buffer has not reached mMinBufferSeconds yet */
+};
+
+#endif /* __AAMP_ABR_STRATEGY_H__ */
@@ -0,0 +1,214 @@
+/*
+ * If not stated otherwise in this file or this component's license file the
+ * following copyright and licenses apply:
+ *
+ * Copyright 2020 RDK Management
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ * http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+*/
+
+/**
+ * @file AampBufferPool.cpp
+ * @brief Size classed memory pool for fragment and playlist GrowableBuffers
+ */
+
+#include "AampBufferPool.h"
+#include "priv_aamp.h"
+#include <algorithm>
+#include <assert.h>
+#include <math.h>
+
+#define AAMP_BUFFER_POOL_ALIGNMENT (4*1024)
+#define AAMP_BUFFER_POOL_CLASS_SEARCH_RANGE 2   /**< Number of bigger size classes looked up for a free block */
+
+/**
+ * @brief AampBufferPool constructor
+ * @param maxPoolSize max bytes kept in free lists, 0 disables pooling
+ */
+AampBufferPool::AampBufferPool(size_t maxPoolSize) : mMutex(), mClassSize(), mFreeBlocks(), mPooledSize(0), mMaxPoolSize(maxPoolSize)
+{
+	pthread_mutex_init(&mMutex, NULL);
+	// Geometric size classes, a block is at most ~19% bigger than requested
+	double factor = pow(2.0, 1.0 / AAMP_BUFFER_POOL_CLASSES_PER_OCTAVE);
+	double size = AAMP_BUFFER_POOL_MIN_CLASS_SIZE;
+	while (size <= AAMP_BUFFER_POOL_MAX_CLASS_SIZE)
+	{
+		size_t classSize = ((size_t)size + AAMP_BUFFER_POOL_ALIGNMENT - 1) & ~((size_t)AAMP_BUFFER_POOL_ALIGNMENT - 1);
+		if (mClassSize.empty() || classSize > mClassSize.back())
+		{
+			mClassSize.push_back(classSize);
+		}
+		size *= factor;
+	}
+	mFreeBlocks.resize(mClassSize.size());
+}
+
+
+/**
+ * @brief AampBufferPool destructor
+ */
+AampBufferPool::~AampBufferPool()
+{
+	Flush();
+	pthread_mutex_destroy(&mMutex);
+}
+
+
+/**
+ * @brief Get smallest size class which can hold size bytes
+ * @param size number of bytes
+ * @retval size class index, -1 if size is above largest class
+ */
+int AampBufferPool::GetClassForSize(size_t size) const
+{
+	std::vector<size_t>::const_iterator it = std::lower_bound(mClassSize.begin(), mClassSize.end(), size);
+	return (it == mClassSize.end()) ? -1 : (int)(it - mClassSize.begin());
+}
+
+
+/**
+ * @brief Get largest size class which fits in a block of avail bytes
+ * @param avail allocated size of block
+ * @retval size class index, -1 if avail is below smallest class
+ */
+int AampBufferPool::GetClassForBlock(size_t avail) const
+{
+	std::vector<size_t>::const_iterator it = std::upper_bound(mClassSize.begin(), mClassSize.end(), avail);
+	return (int)(it - mClassSize.begin()) - 1;
+}
+
+
+/**
+ * @brief Attach memory of at least size bytes to an empty buffer
+ * @param buffer buffer with no memory attached
+ * @param size minimum number of bytes required
+ */
+void AampBufferPool::Acquire(struct GrowableBuffer *buffer, size_t size)
+{
+	assert(!buffer->ptr);
+	int sizeClass = (mMaxPoolSize > 0) ? GetClassForSize(size) : -1;
+	if (sizeClass < 0)
+	{
+		buffer->ptr = (char *)g_malloc(size);
+		buffer->avail = size;
+	}
+	else
+	{
+		char *ptr = NULL;
+		int lastClass = std::min(sizeClass + AAMP_BUFFER_POOL_CLASS_SEARCH_RANGE, (int)mClassSize.size() - 1);
+		pthread_mutex_lock(&mMutex);
+		// A block from a slightly bigger class is preferred over a new allocation
+		for (int i = sizeClass; i <= lastClass; i++)
+		{
+			std::vector<char *> &freeBlocks = mFreeBlocks[i];
+			if (!freeBlocks.empty())
+			{
+				ptr = freeBlocks.back();
+				freeBlocks.pop_back();
+				mPooledSize -= mClassSize[i];
+				sizeClass = i;
+				break;
+			}
+		}
+		pthread_mutex_unlock(&mMutex);
+		if (!ptr)
+		{
+			ptr = (char *)g_malloc(mClassSize[sizeClass]);
+		}
+		buffer->ptr = ptr;
+		buffer->avail = mClassSize[sizeClass];
+	}
+	buffer->len = 0;
+}
+
+
+/**
+ * @brief Make sure buffer can hold size bytes without reallocation
+ * @param buffer buffer to be sized
+ * @param size number of bytes required
+ */
+void AampBufferPool::Reserve(struct GrowableBuffer *buffer, size_t size)
+{
+	if (buffer->ptr && buffer->avail >= size)
+	{
+		return;
+	}
+	if (buffer->len == 0)
+	{
+		Release(buffer);
+		Acquire(buffer, size);
+	}
+	else
+	{
+		int sizeClass = (mMaxPoolSize > 0) ? GetClassForSize(size) : -1;
+		buffer->avail = (sizeClass < 0) ? size : mClassSize[sizeClass];
+		buffer->ptr = (char *)g_realloc(buffer->ptr, buffer->avail);
+	}
+}
+
+
+/**
+ * @brief Return memory of buffer to the pool and reset buffer
+ * @param buffer buffer to be released
+ */
+void AampBufferPool::Release(struct GrowableBuffer *buffer)
+{
+	Release(buffer->ptr, buffer->avail);
+	memset(buffer, 0x00, sizeof(*buffer));
+}
+
+
+/**
+ * @brief Return a memory block to the pool
+ * @param ptr memory block
+ * @param avail allocated size of block
+ */
+void AampBufferPool::Release(char *ptr, size_t avail)
+{
+	if (ptr)
+	{
+		// Blocks bigger than the largest size class are not pooled
+		int sizeClass = (avail <= mClassSize.back()) ? GetClassForBlock(avail) : -1;
+		pthread_mutex_lock(&mMutex);
+		if (sizeClass >= 0 && mPooledSize + mClassSize[sizeClass] <= mMaxPoolSize)
+		{
+			mFreeBlocks[sizeClass].push_back(ptr);
+			mPooledSize += mClassSize[sizeClass];
+			ptr = NULL;
+		}
+		pthread_mutex_unlock(&mMutex);
+		if (ptr)
+		{
+			g_free(ptr);
+		}
+	}
+}
+
+
+/**
+ * @brief Free all pooled blocks
+ */
+void AampBufferPool::Flush()
+{
+	pthread_mutex_lock(&mMutex);
+	for (std::vector<char *> &freeBlocks : mFreeBlocks)
+	{
+		for (char *ptr : freeBlocks)
+		{
+			g_free(ptr);
+		}
+		freeBlocks.clear();
+	}
+	mPooledSize = 0;
+	pthread_mutex_unlock(&mMutex);
+}
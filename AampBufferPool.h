@@ -0,0 +1,132 @@
+/*
+ * If not stated otherwise in this file or this component's license file the
+ * following copyright and licenses apply:
+ *
+ * Copyright 2020 RDK Management
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ * http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+*/
+
+/**
+ * @file AampBufferPool.h
+ * @brief Size classed memory pool for fragment and playlist GrowableBuffers
+ */
+
+#ifndef __AAMP_BUFFER_POOL_H__
+#define __AAMP_BUFFER_POOL_H__
+
+#include <stddef.h>
+#include <pthread.h>
+#include <vector>
+
+struct GrowableBuffer;
+
+#define AAMP_BUFFER_POOL_MIN_CLASS_SIZE      (16*1024)          /**< Smallest size class, covers most playlists */
+#define AAMP_BUFFER_POOL_MAX_CLASS_SIZE      (32*1024*1024)     /**< Largest size class, bigger blocks are not pooled */
+#define AAMP_BUFFER_POOL_CLASSES_PER_OCTAVE  4                  /**< Size classes between two powers of 2 */
+
+/**
+ * @brief Pool of heap blocks used as GrowableBuffer memory
+ *
+ * Blocks are plain glib allocations, so memory taken from the pool can still
+ * be released with aamp_Free (or grown with aamp_AppendBytes) by code which
+ * is not aware of the pool; such memory is simply not recycled.
+ */
+class AampBufferPool
+{
+public:
+	/**
+	 * @brief AampBufferPool constructor
+	 *
+	 * @param[in] maxPoolSize - max bytes kept in free lists, 0 disables pooling
+	 */
+	AampBufferPool(size_t maxPoolSize);
+
+	/**
+	 * @brief AampBufferPool destructor
+	 */
+	~AampBufferPool();
+
+	AampBufferPool(const AampBufferPool&) = delete;
+	AampBufferPool& operator=(const AampBufferPool&) = delete;
+
+	/**
+	 * @brief Attach memory of at least size bytes to an empty buffer
+	 *
+	 * @param[in,out] buffer - buffer with no memory attached
+	 * @param[in] size - minimum number of bytes required
+	 * @return void
+	 */
+	void Acquire(struct GrowableBuffer *buffer, size_t size);
+
+	/**
+	 * @brief Make sure buffer can hold size bytes without reallocation
+	 *
+	 * Memory of a buffer holding no data is swapped for a block from the
+	 * matching size class, else buffer is grown preserving its data.
+	 *
+	 * @param[in,out] buffer - buffer to be sized
+	 * @param[in] size - number of bytes required
+	 * @return void
+	 */
+	void Reserve(struct GrowableBuffer *buffer, size_t size);
+
+	/**
+	 * @brief Return memory of buffer to the pool and reset buffer
+	 *
+	 * @param[in,out] buffer - buffer to be released
+	 * @return void
+	 */
+	void Release(struct GrowableBuffer *buffer);
+
+	/**
+	 * @brief Return a memory block to the pool
+	 *
+	 * @param[in] ptr - memory block
+	 * @param[in] avail - allocated size of block
+	 * @return void
+	 */
+	void Release(char *ptr, size_t avail);
+
+	/**
+	 * @brief Free all pooled blocks
+	 *
+	 * @return void
+	 */
+	void Flush();
+
+private:
+	/**
+	 * @brief Get smallest size class which can hold size bytes
+	 *
+	 * @param[in] size - number of bytes
+	 * @return size class index, -1 if size is above largest class
+	 */
+	int GetClassForSize(size_t size) const;
+
+	/**
+	 * @brief Get largest size class which fits in a block of avail bytes
+	 *
+	 * @param[in] avail - allocated size of block
+	 * @return size class index, -1 if avail is below smallest class
+	 */
+	int GetClassForBlock(size_t avail) const;
+
+	pthread_mutex_t mMutex;
+	std::vector<size_t> mClassSize;                 /**< block size of each size class */
+	std::vector<std::vector<char *>> mFreeBlocks;   /**< free blocks of each size class */
+	size_t mPooledSize;                             /**< bytes held in free lists */
+	size_t mMaxPoolSize;                            /**< max bytes held in free lists */
+};
+
+#endif /* __AAMP_BUFFER_POOL_H__ */
@@ -55,7 +55,7 @@ void AampCacheHandler::InsertToPlaylistCache(const std::string url, const Growab
 				bool cacheStoreReady = true;
 				if(mCacheStoredSize + buffer->len > mMaxPlaylistCacheSize)
 				{
-					AAMPLOG_WARN("[%s][%d] Count[%d]Avail[%d]Needed[%d] Reached max cache size ",__FUNCTION__,__LINE__,mPlaylistCache.size(),mCacheStoredSize,buffer->len);
+					AAMPLOG_WARN("[%s][%d] Count[%zu]Avail[%zu]Needed[%zu] Reached max cache size ",__FUNCTION__,__LINE__,mPlaylistCache.size(),mCacheStoredSize,buffer->len);
 					cacheStoreReady = AllocatePlaylistCacheSlot(fileType,buffer->len);
 				}
 				if(cacheStoreReady)
@@ -133,6 +133,147 @@ bool AampCacheHandler::RetrieveFromPlaylistCache(const std::string url, Growable
 }
 
 
+/**
+ * @brief Insert live playlist into cache for conditional download of its next refresh
+ * @param url URL corresponding to playlist
+ * @param buffer Contains the playlist
+ * @param effectiveUrl Effective URL of playlist
+ * @param eTag ETag response header
+ * @param lastModified Last-Modified response header
+ */
+void AampCacheHandler::InsertToLivePlaylistCache(const std::string &url, const GrowableBuffer* buffer, const std::string &effectiveUrl,
+		const std::string &eTag, const std::string &lastModified)
+{
+	std::shared_ptr<LivePlaylistData> data = std::make_shared<LivePlaylistData>();
+	data->mEffectiveUrl = effectiveUrl;
+	data->mETag = eTag;
+	data->mLastModified = lastModified;
+	data->mData.assign(buffer->ptr, buffer->len);
+
+	pthread_mutex_lock(&mMutex);
+	if (mLivePlaylistCache.find(url) != mLivePlaylistCache.end())
+	{
+		mLivePlaylistLru.remove(url);
+	}
+	else if (mLivePlaylistCache.size() >= MAX_LIVE_PLAYLIST_CACHE_ENTRIES)
+	{
+		mLivePlaylistCache.erase(mLivePlaylistLru.front());
+		mLivePlaylistLru.pop_front();
+	}
+	mLivePlaylistCache[url] = data;
+	mLivePlaylistLru.push_back(url);
+	pthread_mutex_unlock(&mMutex);
+}
+
+/**
+ * @brief Retrieve live playlist from cache
+ * @param url URL corresponding to playlist
+ * @retval cached download, NULL if not found
+ */
+std::shared_ptr<const LivePlaylistData> AampCacheHandler::RetrieveFromLivePlaylistCache(const std::string &url)
+{
+	std::shared_ptr<const LivePlaylistData> data;
+	pthread_mutex_lock(&mMutex);
+	std::unordered_map<std::string, std::shared_ptr<const LivePlaylistData>>::iterator it = mLivePlaylistCache.find(url);
+	if (it != mLivePlaylistCache.end())
+	{
+		data = it->second;
+	}
+	pthread_mutex_unlock(&mMutex);
+	return data;
+}
+
+/**
+ * @brief Clear live playlist cache
+ */
+void AampCacheHandler::ClearLivePlaylistCache()
+{
+	pthread_mutex_lock(&mMutex);
+	mLivePlaylistCache.clear();
+	mLivePlaylistLru.clear();
+	pthread_mutex_unlock(&mMutex);
+}
+
+/**
+ * @brief Insert init fragment to init fragment cache
+ * @param key URL of fragment, with byte range if any
+ * @param buffer Contains the fragment
+ * @param effectiveUrl Effective URL of fragment
+ */
+void AampCacheHandler::InsertToInitFragmentCache(const std::string &key, const GrowableBuffer* buffer, const std::string &effectiveUrl)
+{
+	if (buffer->len == 0 || buffer->len > MAX_INIT_FRAGMENT_CACHE_SIZE)
+	{
+		return;
+	}
+	std::shared_ptr<InitFragmentData> data = std::make_shared<InitFragmentData>();
+	data->mEffectiveUrl = effectiveUrl;
+	data->mData.assign(buffer->ptr, buffer->len);
+
+	pthread_mutex_lock(&mMutex);
+	std::unordered_map<std::string, std::shared_ptr<const InitFragmentData>>::iterator it = mInitFragmentCache.find(key);
+	if (it != mInitFragmentCache.end())
+	{
+		mInitFragmentCacheSize -= it->second->mData.size();
+		mInitFragmentCache.erase(it);
+		mInitFragmentLru.remove(key);
+	}
+	while (!mInitFragmentLru.empty() && (mInitFragmentCache.size() >= MAX_INIT_FRAGMENT_CACHE_ENTRIES ||
+		mInitFragmentCacheSize + buffer->len > MAX_INIT_FRAGMENT_CACHE_SIZE))
+	{
+		it = mInitFragmentCache.find(mInitFragmentLru.front());
+		mInitFragmentCacheSize -= it->second->mData.size();
+		mInitFragmentCache.erase(it);
+		mInitFragmentLru.pop_front();
+	}
+	mInitFragmentCache[key] = data;
+	mInitFragmentLru.push_back(key);
+	mInitFragmentCacheSize += buffer->len;
+	AAMPLOG_INFO("%s:%d Inserted %s, %d entries", __FUNCTION__, __LINE__, key.c_str(), (int)mInitFragmentCache.size());
+	pthread_mutex_unlock(&mMutex);
+}
+
+/**
+ * @brief Retrieve init fragment from init fragment cache
+ * @param key URL of fragment, with byte range if any
+ * @param[out] buffer fragment is appended
+ * @param[out] effectiveUrl Effective URL of fragment
+ * @retval true if found
+ */
+bool AampCacheHandler::RetrieveFromInitFragmentCache(const std::string &key, GrowableBuffer* buffer, std::string &effectiveUrl)
+{
+	std::shared_ptr<const InitFragmentData> data;
+	pthread_mutex_lock(&mMutex);
+	std::unordered_map<std::string, std::shared_ptr<const InitFragmentData>>::iterator it = mInitFragmentCache.find(key);
+	if (it != mInitFragmentCache.end())
+	{
+		data = it->second;
+		mInitFragmentLru.remove(key);
+		mInitFragmentLru.push_back(key);
+	}
+	pthread_mutex_unlock(&mMutex);
+	if (data)
+	{
+		// Copied outside of lock, entry is immutable and kept alive by reference
+		aamp_AppendBytes(buffer, data->mData.data(), data->mData.size());
+		effectiveUrl = data->mEffectiveUrl;
+		return true;
+	}
+	return false;
+}
+
+/**
+ * @brief Clear init fragment cache
+ */
+void AampCacheHandler::ClearInitFragmentCache()
+{
+	pthread_mutex_lock(&mMutex);
+	mInitFragmentCache.clear();
+	mInitFragmentLru.clear();
+	mInitFragmentCacheSize = 0;
+	pthread_mutex_unlock(&mMutex);
+}
+
 /**
  * @brief Clear playlist cache
  */
@@ -231,7 +372,8 @@ bool AampCacheHandler::AllocatePlaylistCacheSlot(MediaType fileType,size_t newLe
 AampCacheHandler::AampCacheHandler():
 	mCacheStoredSize(0),mAsyncThreadStartedFlag(false),mAsyncCleanUpTaskThreadId(0),mCacheActive(false),
 	mAsyncCacheCleanUpThread(false),mMutex(),mCondVarMutex(),mCondVar(),mPlaylistCache()
-	,mMaxPlaylistCacheSize(MAX_PLAYLIST_CACHE_SIZE)
+	,mMaxPlaylistCacheSize(MAX_PLAYLIST_CACHE_SIZE), mLivePlaylistCache(), mLivePlaylistLru()
+	,mInitFragmentCache(), mInitFragmentLru(), mInitFragmentCacheSize(0)
 {
 	pthread_mutex_init(&mMutex, NULL);
 	pthread_mutex_init(&mCondVarMutex, NULL);
@@ -324,6 +466,8 @@ void AampCacheHandler::AsyncCacheCleanUpTask()
 			{
 				AAMPLOG_INFO("%s:%d[%p] Cacheflush timed out", __FUNCTION__, __LINE__, this);
 				ClearPlaylistCache();
+				ClearLivePlaylistCache();
+				ClearInitFragmentCache();
 			}
 		}
 	}
@@ -340,7 +484,7 @@ void AampCacheHandler::AsyncCacheCleanUpTask()
 void AampCacheHandler::SetMaxPlaylistCacheSize(int maxPlaylistCacheSz)
 {
 	pthread_mutex_lock(&mMutex);
-	mMaxPlaylistCacheSize = maxPlaylistCacheSz;
+	mMaxPlaylistCacheSize = (maxPlaylistCacheSz > 0) ? maxPlaylistCacheSz : 0;
 	AAMPLOG_WARN("%s Setting mMaxPlaylistCacheSize to :%d",__FUNCTION__,maxPlaylistCacheSz);
 	pthread_mutex_unlock(&mMutex);	
 }
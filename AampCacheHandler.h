@@ -21,10 +21,15 @@
 #define __AAMP_CACHE_HANDLER_H__
 
 #include <iostream>
+#include <list>
 #include <memory>
 #include <unordered_map>
 #include "priv_aamp.h"
 
+#define MAX_LIVE_PLAYLIST_CACHE_ENTRIES 8   /**< Live playlists kept for conditional download */
+#define MAX_INIT_FRAGMENT_CACHE_ENTRIES 32  /**< Init fragments kept, covers all profiles of usual bitrate ladders */
+#define MAX_INIT_FRAGMENT_CACHE_SIZE (2*1024*1024)   /**< Max bytes of init fragments kept */
+
 /**
  * @brief PlayListCachedData structure to store playlist data
  */
@@ -56,6 +61,37 @@ typedef struct playlistcacheddata{
 
 }PlayListCachedData;
 
+/**
+ * @brief Last download of a live playlist, with validators for conditional download
+ *
+ * Entries are immutable once inserted, so a reference taken before a download
+ * stays valid even if the entry is replaced meanwhile.
+ */
+struct LivePlaylistData
+{
+	LivePlaylistData() : mEffectiveUrl(), mETag(), mLastModified(), mData()
+	{
+	}
+
+	std::string mEffectiveUrl;    /**< effective URL of download */
+	std::string mETag;            /**< ETag response header, empty if not sent */
+	std::string mLastModified;    /**< Last-Modified response header, empty if not sent */
+	std::string mData;            /**< playlist */
+};
+
+/**
+ * @brief Downloaded init fragment
+ */
+struct InitFragmentData
+{
+	InitFragmentData() : mEffectiveUrl(), mData()
+	{
+	}
+
+	std::string mEffectiveUrl;    /**< effective URL of download */
+	std::string mData;            /**< init fragment */
+};
+
 
 class AampCacheHandler
 {
@@ -64,15 +100,20 @@ private:
 	typedef std::unordered_map<std::string, PlayListCachedData *> PlaylistCache ;
 	typedef std::unordered_map<std::string, PlayListCachedData *>::iterator PlaylistCacheIter;
 	PlaylistCache mPlaylistCache;
-	int mCacheStoredSize;
+	size_t mCacheStoredSize;
 	bool mCacheActive;
 	bool mAsyncCacheCleanUpThread;
 	bool mAsyncThreadStartedFlag;
-	int mMaxPlaylistCacheSize;
+	size_t mMaxPlaylistCacheSize;
 	pthread_mutex_t mMutex;
 	pthread_mutex_t mCondVarMutex;
 	pthread_cond_t mCondVar ;
 	pthread_t mAsyncCleanUpTaskThreadId;
+	std::unordered_map<std::string, std::shared_ptr<const LivePlaylistData>> mLivePlaylistCache;
+	std::list<std::string> mLivePlaylistLru;   /**< live playlist URLs, most recently inserted last */
+	std::unordered_map<std::string, std::shared_ptr<const InitFragmentData>> mInitFragmentCache;
+	std::list<std::string> mInitFragmentLru;   /**< init fragment keys, most recently used last */
+	size_t mInitFragmentCacheSize;             /**< bytes of cached init fragments */
 private:
 
 	/**
@@ -152,6 +193,66 @@ public:
 	 */
 	bool RetrieveFromPlaylistCache(const std::string url, GrowableBuffer* buffer, std::string& effectiveUrl);
 
+	/**
+	 *   @brief Insert live playlist into cache for conditional download of its next refresh
+	 *
+	 *   Least recently inserted playlist is removed once MAX_LIVE_PLAYLIST_CACHE_ENTRIES are cached.
+	 *
+	 *   @param[in] url - URL
+	 *   @param[in] buffer - Pointer to growable buffer
+	 *   @param[in] effectiveUrl - Final URL
+	 *   @param[in] eTag - ETag response header
+	 *   @param[in] lastModified - Last-Modified response header
+	 *   @return void
+	 */
+	void InsertToLivePlaylistCache(const std::string &url, const GrowableBuffer* buffer, const std::string &effectiveUrl,
+			const std::string &eTag, const std::string &lastModified);
+
+	/**
+	 *   @brief Retrieve live playlist from cache
+	 *
+	 *   @param[in] url - URL
+	 *   @return cached download, NULL if not found
+	 */
+	std::shared_ptr<const LivePlaylistData> RetrieveFromLivePlaylistCache(const std::string &url);
+
+	/**
+	 *   @brief Clear live playlist cache
+	 *
+	 *   @return void
+	 */
+	void ClearLivePlaylistCache();
+
+	/**
+	 *   @brief Insert init fragment into cache
+	 *
+	 *   Least recently used fragments are removed to stay within MAX_INIT_FRAGMENT_CACHE_ENTRIES
+	 *   and MAX_INIT_FRAGMENT_CACHE_SIZE.
+	 *
+	 *   @param[in] key - fragment URL, with byte range if any
+	 *   @param[in] buffer - Pointer to growable buffer
+	 *   @param[in] effectiveUrl - Final URL
+	 *   @return void
+	 */
+	void InsertToInitFragmentCache(const std::string &key, const GrowableBuffer* buffer, const std::string &effectiveUrl);
+
+	/**
+	 *   @brief Retrieve init fragment from cache
+	 *
+	 *   @param[in] key - fragment URL, with byte range if any
+	 *   @param[out] buffer - Pointer to growable buffer, fragment is appended
+	 *   @param[out] effectiveUrl - Final URL
+	 *   @return true: found, false: not found
+	 */
+	bool RetrieveFromInitFragmentCache(const std::string &key, GrowableBuffer* buffer, std::string &effectiveUrl);
+
+	/**
+	 *   @brief Clear init fragment cache
+	 *
+	 *   @return void
+	 */
+	void ClearInitFragmentCache();
+
 	/**
 	*   @brief SetMaxPlaylistCacheSize - Set Max Cache Size
 	*
@@ -164,7 +265,7 @@ public:
 	*
 	*   @return int - maxCacheSize
 	*/
-	int  GetMaxPlaylistCacheSize() { return mMaxPlaylistCacheSize; }
+	int  GetMaxPlaylistCacheSize() { return (int)mMaxPlaylistCacheSize; }
 	/**
 	*   @brief IsUrlCached - Check if URL is already cached
 	*
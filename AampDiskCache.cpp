@@ -0,0 +1,373 @@
+/*
+ * If not stated otherwise in this file or this component's license file the
+ * following copyright and licenses apply:
+ *
+ * Copyright 2020 RDK Management
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ * http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+*/
+
+/**
+ * @file AampDiskCache.cpp
+ * @brief Size bounded LRU cache of downloaded files on local storage
+ */
+
+#include "AampDiskCache.h"
+#include "priv_aamp.h"
+#include <openssl/sha.h>
+#include <dirent.h>
+#include <fcntl.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <sys/uio.h>
+#include <errno.h>
+#include <limits.h>
+#include <string.h>
+#include <unistd.h>
+#include <algorithm>
+#include <vector>
+
+#define DISK_CACHE_MAGIC 0x41414443     /**< "AADC", identifies entry files */
+#define DISK_CACHE_VERSION 1            /**< Entry file layout version */
+#define DISK_CACHE_TMP_SUFFIX ".tmp"    /**< Suffix of entry files being written */
+
+/**
+ * @brief Header of entry file, followed by key, effective URL and data
+ */
+struct DiskCacheHeader
+{
+	uint32_t magic;             /**< DISK_CACHE_MAGIC */
+	uint32_t version;           /**< DISK_CACHE_VERSION */
+	uint32_t keyLen;            /**< length of key */
+	uint32_t effectiveUrlLen;   /**< length of effective URL */
+	uint64_t dataLen;           /**< length of data */
+};
+
+static pthread_mutex_t instanceLock = PTHREAD_MUTEX_INITIALIZER;
+static std::weak_ptr<AampDiskCache> gDiskCache;
+
+/**
+ * @brief Get shared instance for cache directory of configuration
+ * @param path cache directory
+ * @param maxSize max bytes stored in cache directory
+ * @retval shared pointer to AampDiskCache
+ */
+std::shared_ptr<AampDiskCache> AampDiskCache::GetInstance(const char *path, size_t maxSize)
+{
+	pthread_mutex_lock(&instanceLock);
+	std::shared_ptr<AampDiskCache> instance = gDiskCache.lock();
+	if (nullptr == instance)
+	{
+		instance = std::make_shared<AampDiskCache>(path, maxSize);
+		gDiskCache = instance;
+	}
+	pthread_mutex_unlock(&instanceLock);
+	return instance;
+}
+
+
+/**
+ * @brief AampDiskCache constructor
+ * @param path cache directory
+ * @param maxSize max bytes stored in cache directory
+ */
+AampDiskCache::AampDiskCache(const char *path, size_t maxSize) : mPath(path), mMaxSize(maxSize), mSize(0), mLru(), mEntries(), mMutex()
+{
+	pthread_mutex_init(&mMutex, NULL);
+	if (mPath.empty() || mPath.back() != '/')
+	{
+		mPath += '/';
+	}
+	LoadIndex();
+}
+
+
+/**
+ * @brief AampDiskCache destructor
+ */
+AampDiskCache::~AampDiskCache()
+{
+	pthread_mutex_destroy(&mMutex);
+}
+
+
+/**
+ * @brief Get name of entry file of a key
+ * @param key cache key
+ * @retval file name relative to cache directory
+ */
+std::string AampDiskCache::GetFileName(const std::string &key)
+{
+	static const char hex[] = "0123456789abcdef";
+	unsigned char digest[SHA_DIGEST_LENGTH];
+	SHA1((const unsigned char *)key.data(), key.size(), digest);
+	std::string name;
+	name.reserve(2 * SHA_DIGEST_LENGTH + sizeof(AAMP_DISK_CACHE_FILE_SUFFIX));
+	for (int i = 0; i < SHA_DIGEST_LENGTH; i++)
+	{
+		name += hex[digest[i] >> 4];
+		name += hex[digest[i] & 0x0F];
+	}
+	name += AAMP_DISK_CACHE_FILE_SUFFIX;
+	return name;
+}
+
+
+/**
+ * @brief Build index from entry files present in cache directory
+ */
+void AampDiskCache::LoadIndex()
+{
+	if (mkdir(mPath.c_str(), 0700) != 0 && errno != EEXIST)
+	{
+		logprintf("%s:%d Failed to create cache directory %s, errno %d", __FUNCTION__, __LINE__, mPath.c_str(), errno);
+		return;
+	}
+	DIR *dir = opendir(mPath.c_str());
+	if (!dir)
+	{
+		logprintf("%s:%d Failed to open cache directory %s, errno %d", __FUNCTION__, __LINE__, mPath.c_str(), errno);
+		return;
+	}
+
+	std::vector<std::pair<time_t, std::pair<std::string, size_t>>> files;
+	const size_t suffixLen = strlen(AAMP_DISK_CACHE_FILE_SUFFIX);
+	const size_t tmpSuffixLen = strlen(DISK_CACHE_TMP_SUFFIX);
+	struct dirent *ent;
+	while ((ent = readdir(dir)) != NULL)
+	{
+		std::string name(ent->d_name);
+		std::string filePath = mPath + name;
+		if (name.size() > tmpSuffixLen && 0 == name.compare(name.size() - tmpSuffixLen, tmpSuffixLen, DISK_CACHE_TMP_SUFFIX))
+		{
+			// Left over by an interrupted Insert
+			unlink(filePath.c_str());
+			continue;
+		}
+		if (name.size() <= suffixLen || 0 != name.compare(name.size() - suffixLen, suffixLen, AAMP_DISK_CACHE_FILE_SUFFIX))
+		{
+			continue;
+		}
+		struct stat st;
+		if (0 == stat(filePath.c_str(), &st) && S_ISREG(st.st_mode))
+		{
+			files.push_back(std::make_pair(st.st_mtime, std::make_pair(name, (size_t)st.st_size)));
+		}
+	}
+	closedir(dir);
+
+	// Oldest first, so the most recently used ends up at front of mLru
+	std::sort(files.begin(), files.end());
+	pthread_mutex_lock(&mMutex);
+	for (auto &file : files)
+	{
+		AddEntry(file.second.first, file.second.second);
+	}
+	Evict(0);
+	pthread_mutex_unlock(&mMutex);
+	logprintf("%s:%d %s: %d entries, %zu bytes", __FUNCTION__, __LINE__, mPath.c_str(), (int)mEntries.size(), mSize);
+}
+
+
+/**
+ * @brief Add entry file to index as most recently used, mMutex to be held
+ * @param fileName entry file name
+ * @param size entry file size
+ */
+void AampDiskCache::AddEntry(const std::string &fileName, size_t size)
+{
+	auto it = mEntries.find(fileName);
+	if (it != mEntries.end())
+	{
+		mSize -= it->second.size;
+		mLru.erase(it->second.lruPos);
+		mEntries.erase(it);
+	}
+	mLru.push_front(fileName);
+	mEntries.insert(std::make_pair(fileName, Entry(mLru.begin(), size)));
+	mSize += size;
+}
+
+
+/**
+ * @brief Remove entry file and its index record, mMutex to be held
+ * @param fileName entry file name
+ */
+void AampDiskCache::RemoveEntry(const std::string &fileName)
+{
+	auto it = mEntries.find(fileName);
+	if (it != mEntries.end())
+	{
+		mSize -= it->second.size;
+		mLru.erase(it->second.lruPos);
+		mEntries.erase(it);
+	}
+	unlink((mPath + fileName).c_str());
+}
+
+
+/**
+ * @brief Remove least recently used entries till size fits in limit, mMutex to be held
+ * @param required bytes to be added
+ */
+void AampDiskCache::Evict(size_t required)
+{
+	while (!mLru.empty() && mSize + required > mMaxSize)
+	{
+		std::string fileName = mLru.back();
+		RemoveEntry(fileName);
+	}
+}
+
+
+/**
+ * @brief Append data of cached file to buffer
+ * @param key request URL, with byte range if any
+ * @param buffer buffer to append to
+ * @param effectiveUrl effective URL of cached download
+ * @retval true if found in cache
+ */
+bool AampDiskCache::Retrieve(const std::string &key, struct GrowableBuffer *buffer, std::string &effectiveUrl)
+{
+	std::string fileName = GetFileName(key);
+	pthread_mutex_lock(&mMutex);
+	bool found = (mEntries.find(fileName) != mEntries.end());
+	pthread_mutex_unlock(&mMutex);
+	if (!found)
+	{
+		return false;
+	}
+
+	bool ret = false;
+	int fd = open((mPath + fileName).c_str(), O_RDONLY);
+	if (fd >= 0)
+	{
+		struct stat st;
+		if (0 == fstat(fd, &st) && (size_t)st.st_size >= sizeof(DiskCacheHeader))
+		{
+			size_t fileSize = (size_t)st.st_size;
+			void *map = mmap(NULL, fileSize, PROT_READ, MAP_PRIVATE, fd, 0);
+			if (MAP_FAILED != map)
+			{
+				const char *base = (const char *)map;
+				DiskCacheHeader header;
+				memcpy(&header, base, sizeof(header));
+				size_t headerLen = sizeof(header) + header.keyLen + header.effectiveUrlLen;
+				if (DISK_CACHE_MAGIC == header.magic && DISK_CACHE_VERSION == header.version &&
+					headerLen + header.dataLen == fileSize && header.keyLen == key.size() &&
+					0 == memcmp(base + sizeof(header), key.data(), key.size()))
+				{
+					effectiveUrl.assign(base + sizeof(header) + header.keyLen, header.effectiveUrlLen);
+					aamp_AppendBytes(buffer, base + headerLen, (size_t)header.dataLen);
+					ret = true;
+				}
+				munmap(map, fileSize);
+			}
+		}
+		if (ret)
+		{
+			// Persist recency for index rebuilt on next start
+			futimens(fd, NULL);
+		}
+		close(fd);
+	}
+
+	pthread_mutex_lock(&mMutex);
+	auto it = mEntries.find(fileName);
+	if (it != mEntries.end())
+	{
+		if (ret)
+		{
+			mLru.splice(mLru.begin(), mLru, it->second.lruPos);
+		}
+		else
+		{
+			AAMPLOG_WARN("%s:%d Removing invalid cache entry %s", __FUNCTION__, __LINE__, fileName.c_str());
+			RemoveEntry(fileName);
+		}
+	}
+	pthread_mutex_unlock(&mMutex);
+	return ret;
+}
+
+
+/**
+ * @brief Store downloaded file in cache
+ * @param key request URL, with byte range if any
+ * @param buffer downloaded data
+ * @param effectiveUrl effective URL of download
+ */
+void AampDiskCache::Insert(const std::string &key, const struct GrowableBuffer *buffer, const std::string &effectiveUrl)
+{
+	DiskCacheHeader header;
+	header.magic = DISK_CACHE_MAGIC;
+	header.version = DISK_CACHE_VERSION;
+	header.keyLen = (uint32_t)key.size();
+	header.effectiveUrlLen = (uint32_t)effectiveUrl.size();
+	header.dataLen = buffer->len;
+	size_t fileSize = sizeof(header) + key.size() + effectiveUrl.size() + buffer->len;
+	if (fileSize > mMaxSize)
+	{
+		return;
+	}
+
+	std::string fileName = GetFileName(key);
+	std::string filePath = mPath + fileName;
+	char tmpPath[PATH_MAX];
+	snprintf(tmpPath, sizeof(tmpPath), "%s.%d.%lx" DISK_CACHE_TMP_SUFFIX, filePath.c_str(), (int)getpid(), (unsigned long)pthread_self());
+
+	// Written to a temporary file outside the lock, rename publishes it atomically
+	int fd = open(tmpPath, O_WRONLY | O_CREAT | O_TRUNC, 0600);
+	if (fd < 0)
+	{
+		AAMPLOG_WARN("%s:%d Failed to create %s, errno %d", __FUNCTION__, __LINE__, tmpPath, errno);
+		return;
+	}
+	struct iovec iov[4];
+	iov[0].iov_base = &header;
+	iov[0].iov_len = sizeof(header);
+	iov[1].iov_base = (void *)key.data();
+	iov[1].iov_len = key.size();
+	iov[2].iov_base = (void *)effectiveUrl.data();
+	iov[2].iov_len = effectiveUrl.size();
+	iov[3].iov_base = buffer->ptr;
+	iov[3].iov_len = buffer->len;
+	bool written = (writev(fd, iov, 4) == (ssize_t)fileSize);
+	close(fd);
+	if (!written)
+	{
+		AAMPLOG_WARN("%s:%d Failed to write %s, errno %d", __FUNCTION__, __LINE__, tmpPath, errno);
+		unlink(tmpPath);
+		return;
+	}
+
+	pthread_mutex_lock(&mMutex);
+	auto it = mEntries.find(fileName);
+	if (it != mEntries.end())
+	{
+		mSize -= it->second.size;
+		mLru.erase(it->second.lruPos);
+		mEntries.erase(it);
+	}
+	Evict(fileSize);
+	if (0 == rename(tmpPath, filePath.c_str()))
+	{
+		AddEntry(fileName, fileSize);
+	}
+	else
+	{
+		AAMPLOG_WARN("%s:%d Failed to rename %s, errno %d", __FUNCTION__, __LINE__, tmpPath, errno);
+		unlink(tmpPath);
+	}
+	pthread_mutex_unlock(&mMutex);
+}
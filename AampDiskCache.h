@@ -0,0 +1,159 @@
+/*
+ * If not stated otherwise in this file or this component's license file the
+ * following copyright and licenses apply:
+ *
+ * Copyright 2020 RDK Management
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ * http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+*/
+
+/**
+ * @file AampDiskCache.h
+ * @brief Size bounded LRU cache of downloaded files on local storage
+ */
+
+#ifndef __AAMP_DISK_CACHE_H__
+#define __AAMP_DISK_CACHE_H__
+
+#include <stddef.h>
+#include <pthread.h>
+#include <list>
+#include <memory>
+#include <string>
+#include <unordered_map>
+
+struct GrowableBuffer;
+
+#define AAMP_DISK_CACHE_FILE_SUFFIX ".cache"    /**< Suffix of cache entry files */
+
+/**
+ * @brief Persistent cache of downloaded files, keyed by request URL
+ *
+ * Each entry is a file in the cache directory named after the SHA1 of its key,
+ * holding the key, effective URL and file data. Entries are memory mapped on
+ * retrieval. Least recently used entries are removed to keep total size within
+ * limit; recency is kept in file modification time, so it survives restart.
+ */
+class AampDiskCache
+{
+public:
+	/**
+	 * @brief Get shared instance for cache directory of configuration
+	 *
+	 * Instance is destroyed when the last reference is dropped.
+	 *
+	 * @param[in] path - cache directory, created if not present
+	 * @param[in] maxSize - max bytes stored in cache directory
+	 * @return shared pointer to AampDiskCache
+	 */
+	static std::shared_ptr<AampDiskCache> GetInstance(const char *path, size_t maxSize);
+
+	/**
+	 * @brief AampDiskCache constructor
+	 *
+	 * @param[in] path - cache directory, created if not present
+	 * @param[in] maxSize - max bytes stored in cache directory
+	 */
+	AampDiskCache(const char *path, size_t maxSize);
+
+	/**
+	 * @brief AampDiskCache destructor
+	 */
+	~AampDiskCache();
+
+	AampDiskCache(const AampDiskCache&) = delete;
+	AampDiskCache& operator=(const AampDiskCache&) = delete;
+
+	/**
+	 * @brief Append data of cached file to buffer
+	 *
+	 * @param[in] key - request URL, with byte range if any
+	 * @param[in,out] buffer - buffer to append to
+	 * @param[out] effectiveUrl - effective URL of cached download
+	 * @return true if found in cache
+	 */
+	bool Retrieve(const std::string &key, struct GrowableBuffer *buffer, std::string &effectiveUrl);
+
+	/**
+	 * @brief Store downloaded file in cache
+	 *
+	 * @param[in] key - request URL, with byte range if any
+	 * @param[in] buffer - downloaded data
+	 * @param[in] effectiveUrl - effective URL of download
+	 * @return void
+	 */
+	void Insert(const std::string &key, const struct GrowableBuffer *buffer, const std::string &effectiveUrl);
+
+private:
+	/**
+	 * @brief Index record of a cache entry
+	 */
+	struct Entry
+	{
+		Entry(std::list<std::string>::iterator pos, size_t sz) : lruPos(pos), size(sz)
+		{
+		}
+
+		std::list<std::string>::iterator lruPos;   /**< position in mLru */
+		size_t size;                                /**< size of entry file */
+	};
+
+	/**
+	 * @brief Get name of entry file of a key
+	 *
+	 * @param[in] key - cache key
+	 * @return file name relative to cache directory
+	 */
+	static std::string GetFileName(const std::string &key);
+
+	/**
+	 * @brief Build index from entry files present in cache directory
+	 *
+	 * @return void
+	 */
+	void LoadIndex();
+
+	/**
+	 * @brief Add entry file to index as most recently used
+	 *
+	 * @param[in] fileName - entry file name
+	 * @param[in] size - entry file size
+	 * @return void
+	 */
+	void AddEntry(const std::string &fileName, size_t size);
+
+	/**
+	 * @brief Remove entry file and its index record
+	 *
+	 * @param[in] fileName - entry file name
+	 * @return void
+	 */
+	void RemoveEntry(const std::string &fileName);
+
+	/**
+	 * @brief Remove least recently used entries till size fits in limit
+	 *
+	 * @param[in] required - bytes to be added
+	 * @return void
+	 */
+	void Evict(size_t required);
+
+	std::string mPath;                                      /**< cache directory, with trailing '/' */
+	size_t mMaxSize;                                        /**< max bytes stored */
+	size_t mSize;                                           /**< bytes stored */
+	std::list<std::string> mLru;                            /**< entry files, most recently used first */
+	std::unordered_map<std::string, Entry> mEntries;        /**< index of entry files */
+	pthread_mutex_t mMutex;                                 /**< protects index */
+};
+
+#endif /* __AAMP_DISK_CACHE_H__ */
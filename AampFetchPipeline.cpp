@@ -0,0 +1,266 @@
+/*
+ * If not stated otherwise in this file or this component's license file the
+ * following copyright and licenses apply:
+ *
+ * Copyright 2020 RDK Management
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ * http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+*/
+
+/**
+ * @file AampFetchPipeline.cpp
+ * @brief Downloads fragments of a track ahead of its fetcher
+ */
+
+#include "AampFetchPipeline.h"
+#include "AampBufferPool.h"
+#include <algorithm>
+#include <assert.h>
+
+/**
+ * @brief AampFetchPipeline constructor
+ * @param aamp player instance
+ * @param mediaType media type of the track
+ * @param depth downloads in flight including the fetcher's own
+ */
+AampFetchPipeline::AampFetchPipeline(PrivateInstanceAAMP *aamp, MediaType mediaType, int depth) : mAamp(aamp), mMediaType(mediaType),
+		mWorkerCount(std::min(depth, AAMP_FETCH_PIPELINE_MAX_DEPTH) - 1), mFirstCurlInstance(eCURLINSTANCE_PIPELINE), mWorkers(),
+		mNextWorker(0), mRequests(), mMutex(), mCond(), mStop(false)
+{
+	assert(mediaType < AAMP_TRACK_COUNT);
+	mFirstCurlInstance = (AampCurlInstance)(eCURLINSTANCE_PIPELINE + mediaType * (AAMP_FETCH_PIPELINE_MAX_DEPTH - 1));
+	pthread_mutex_init(&mMutex, NULL);
+	pthread_cond_init(&mCond, NULL);
+}
+
+
+/**
+ * @brief AampFetchPipeline destructor
+ */
+AampFetchPipeline::~AampFetchPipeline()
+{
+	Stop();
+	pthread_cond_destroy(&mCond);
+	pthread_mutex_destroy(&mMutex);
+}
+
+
+/**
+ * @brief Worker thread entry function
+ * @param arg AampFetchPipeline instance
+ * @retval NULL
+ */
+void *AampFetchPipeline::WorkerThread(void *arg)
+{
+	AampFetchPipeline *pipeline = (AampFetchPipeline *)arg;
+	if (aamp_pthread_setname(pthread_self(), "aampPrefetch"))
+	{
+		logprintf("%s:%d: pthread_setname_np failed", __FUNCTION__, __LINE__);
+	}
+	pthread_mutex_lock(&pipeline->mMutex);
+	AampCurlInstance curlInstance = (AampCurlInstance)(pipeline->mFirstCurlInstance + pipeline->mNextWorker++);
+	pthread_mutex_unlock(&pipeline->mMutex);
+	pipeline->WorkerLoop(curlInstance);
+	return NULL;
+}
+
+
+/**
+ * @brief Start workers and their curl instances
+ */
+void AampFetchPipeline::StartWorkers()
+{
+	mAamp->CurlInit(mFirstCurlInstance, mWorkerCount, mAamp->GetNetworkProxy());
+	for (int i = 0; i < mWorkerCount; i++)
+	{
+		mAamp->SetCurlTimeout(mAamp->mNetworkTimeoutMs, (AampCurlInstance)(mFirstCurlInstance + i));
+		pthread_t worker;
+		if (0 == pthread_create(&worker, NULL, &WorkerThread, this))
+		{
+			mWorkers.push_back(worker);
+		}
+		else
+		{
+			logprintf("%s:%d Failed to create fetch pipeline worker", __FUNCTION__, __LINE__);
+		}
+	}
+	AAMPLOG_INFO("%s:%d type %d started %d workers", __FUNCTION__, __LINE__, mMediaType, (int)mWorkers.size());
+}
+
+
+/**
+ * @brief Download queued fragments until stopped
+ * @param curlInstance curl instance of the worker
+ */
+void AampFetchPipeline::WorkerLoop(AampCurlInstance curlInstance)
+{
+	pthread_mutex_lock(&mMutex);
+	while (!mStop)
+	{
+		std::list<Request *>::iterator it = std::find_if(mRequests.begin(), mRequests.end(),
+				[](const Request *request) { return !request->started && !request->discarded; });
+		if (it == mRequests.end())
+		{
+			pthread_cond_wait(&mCond, &mMutex);
+			continue;
+		}
+		Request *request = *it;
+		request->started = true;
+		pthread_mutex_unlock(&mMutex);
+
+		request->fetched = mAamp->GetFile(request->url, &request->buffer, request->effectiveUrl, &request->httpError,
+				request->range.empty() ? NULL : request->range.c_str(), curlInstance, true, mMediaType, NULL, NULL, request->durationSeconds);
+
+		pthread_mutex_lock(&mMutex);
+		request->done = true;
+		if (request->discarded)
+		{
+			mRequests.remove(request);
+			mAamp->GetBufferPool()->Release(&request->buffer);
+			delete request;
+		}
+		pthread_cond_broadcast(&mCond);
+	}
+	pthread_mutex_unlock(&mMutex);
+}
+
+
+/**
+ * @brief Drop a request, called with mMutex held
+ * @param it request to drop
+ * @retval iterator to next request
+ */
+std::list<AampFetchPipeline::Request *>::iterator AampFetchPipeline::Discard(std::list<Request *>::iterator it)
+{
+	Request *request = *it;
+	if (request->started && !request->done)
+	{
+		request->discarded = true;
+		return ++it;
+	}
+	mAamp->GetBufferPool()->Release(&request->buffer);
+	delete request;
+	return mRequests.erase(it);
+}
+
+
+/**
+ * @brief Queue download of a fragment, no-op if it is already queued
+ * @param url fragment url
+ * @param range byte range, NULL for whole file
+ * @param durationSeconds fragment duration
+ */
+void AampFetchPipeline::Queue(const std::string &url, const char *range, double durationSeconds)
+{
+	std::string byteRange(range ? range : "");
+	pthread_mutex_lock(&mMutex);
+	if (!mStop && mWorkerCount > 0)
+	{
+		bool queued = std::any_of(mRequests.begin(), mRequests.end(), [&](const Request *request) {
+				return !request->discarded && request->url == url && request->range == byteRange; });
+		if (!queued)
+		{
+			if (mWorkers.empty())
+			{
+				StartWorkers();
+			}
+			mRequests.push_back(new Request(url, range, durationSeconds));
+			pthread_cond_broadcast(&mCond);
+		}
+	}
+	pthread_mutex_unlock(&mMutex);
+}
+
+
+/**
+ * @brief Take a queued fragment, waiting for its download to complete
+ * @param url fragment url
+ * @param range byte range, NULL for whole file
+ * @param[out] buffer receives downloaded fragment, memory attached to it is released
+ * @param[out] effectiveUrl effective url of download
+ * @param[out] http_error http status of download
+ * @retval true if fragment was downloaded, false if caller has to download it
+ */
+bool AampFetchPipeline::Take(const std::string &url, const char *range, struct GrowableBuffer *buffer, std::string &effectiveUrl, long &http_error)
+{
+	bool ret = false;
+	std::string byteRange(range ? range : "");
+	pthread_mutex_lock(&mMutex);
+	std::list<Request *>::iterator it = std::find_if(mRequests.begin(), mRequests.end(), [&](const Request *request) {
+			return !request->discarded && request->url == url && request->range == byteRange; });
+	// Fragments queued before this one are skipped by the fetcher, none of them if it is not queued
+	std::list<Request *>::iterator pos = mRequests.begin();
+	while (pos != it)
+	{
+		pos = Discard(pos);
+	}
+	if (it != mRequests.end())
+	{
+		Request *request = *it;
+		while (!request->done && !mStop)
+		{
+			pthread_cond_wait(&mCond, &mMutex);
+		}
+		if (request->done)
+		{
+			mRequests.erase(it);
+			if (request->fetched)
+			{
+				mAamp->GetBufferPool()->Release(buffer);
+				*buffer = request->buffer;
+				effectiveUrl = request->effectiveUrl;
+				http_error = request->httpError;
+				ret = true;
+			}
+			else
+			{
+				// Download is repeated by the fetcher, which handles the error
+				mAamp->GetBufferPool()->Release(&request->buffer);
+			}
+			delete request;
+		}
+	}
+	pthread_mutex_unlock(&mMutex);
+	return ret;
+}
+
+
+/**
+ * @brief Stop workers and discard all queued fragments
+ */
+void AampFetchPipeline::Stop()
+{
+	pthread_mutex_lock(&mMutex);
+	mStop = true;
+	pthread_cond_broadcast(&mCond);
+	pthread_mutex_unlock(&mMutex);
+	for (pthread_t worker : mWorkers)
+	{
+		pthread_join(worker, NULL);
+	}
+	if (!mWorkers.empty())
+	{
+		mWorkers.clear();
+		mAamp->CurlTerm(mFirstCurlInstance, mWorkerCount);
+	}
+	// Workers are gone, no request is in progress
+	for (Request *request : mRequests)
+	{
+		mAamp->GetBufferPool()->Release(&request->buffer);
+		delete request;
+	}
+	mRequests.clear();
+	// Workers are started again if the track resumes fetching
+	mNextWorker = 0;
+	mStop = false;
+}
@@ -0,0 +1,175 @@
+/*
+ * If not stated otherwise in this file or this component's license file the
+ * following copyright and licenses apply:
+ *
+ * Copyright 2020 RDK Management
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ * http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+*/
+
+/**
+ * @file AampFetchPipeline.h
+ * @brief Downloads fragments of a track ahead of its fetcher
+ */
+
+#ifndef __AAMP_FETCH_PIPELINE_H__
+#define __AAMP_FETCH_PIPELINE_H__
+
+#include "priv_aamp.h"
+#include <pthread.h>
+#include <list>
+#include <string>
+#include <vector>
+
+/**
+ * @brief Keeps fragment downloads of a track in flight while its fetcher waits on the current one
+ *
+ * Fetcher queues the fragments following the one it fetches; worker threads
+ * download them, each on its own curl instance, so they run in parallel
+ * (multiplexed on one connection when the multi download engine is used).
+ * Fetcher then takes them one by one, in order, into its fetch buffer and
+ * keeps decryption, metrics and error handling as for its own downloads.
+ * A download that is not the next one taken (ABR switch, seek, discontinuity)
+ * is discarded, so stale fragments never reach the fetch ring.
+ */
+class AampFetchPipeline
+{
+public:
+	/**
+	 * @brief AampFetchPipeline constructor
+	 *
+	 * @param[in] aamp - player instance
+	 * @param[in] mediaType - media type of the track
+	 * @param[in] depth - downloads in flight including the fetcher's own
+	 */
+	AampFetchPipeline(PrivateInstanceAAMP *aamp, MediaType mediaType, int depth);
+
+	/**
+	 * @brief AampFetchPipeline destructor
+	 */
+	~AampFetchPipeline();
+
+	AampFetchPipeline(const AampFetchPipeline&) = delete;
+	AampFetchPipeline& operator=(const AampFetchPipeline&) = delete;
+
+	/**
+	 * @brief Get number of fragments to keep queued ahead of the fetcher
+	 *
+	 * @return fragments downloaded ahead
+	 */
+	int GetDepth() { return mWorkerCount; }
+
+	/**
+	 * @brief Queue download of a fragment, no-op if it is already queued
+	 *
+	 * @param[in] url - fragment url
+	 * @param[in] range - byte range, NULL for whole file
+	 * @param[in] durationSeconds - fragment duration
+	 * @return void
+	 */
+	void Queue(const std::string &url, const char *range, double durationSeconds);
+
+	/**
+	 * @brief Take a queued fragment, waiting for its download to complete
+	 *
+	 * Fragments queued before it are discarded; if it is not queued at all,
+	 * fetcher has moved elsewhere and all queued fragments are discarded.
+	 *
+	 * @param[in] url - fragment url
+	 * @param[in] range - byte range, NULL for whole file
+	 * @param[out] buffer - receives downloaded fragment, memory attached to it is released
+	 * @param[out] effectiveUrl - effective url of download
+	 * @param[out] http_error - http status of download
+	 * @return true if fragment was downloaded, false if caller has to download it
+	 */
+	bool Take(const std::string &url, const char *range, struct GrowableBuffer *buffer, std::string &effectiveUrl, long &http_error);
+
+	/**
+	 * @brief Stop workers and discard all queued fragments
+	 *
+	 * To be called with downloads disabled, so transfers in progress abort,
+	 * and fetcher stopped. Workers are started again on next Queue.
+	 *
+	 * @return void
+	 */
+	void Stop();
+
+private:
+	/**
+	 * @brief Fragment queued for download
+	 */
+	struct Request
+	{
+		Request(const std::string &fragmentUrl, const char *byteRange, double duration) :
+			url(fragmentUrl), range(byteRange ? byteRange : ""), durationSeconds(duration), buffer(), effectiveUrl(),
+			httpError(0), fetched(false), started(false), done(false), discarded(false)
+		{
+		}
+		std::string url;            /**< fragment url */
+		std::string range;          /**< byte range, empty for whole file */
+		double durationSeconds;     /**< fragment duration */
+		struct GrowableBuffer buffer; /**< downloaded fragment */
+		std::string effectiveUrl;   /**< effective url of download */
+		long httpError;             /**< http status of download */
+		bool fetched;               /**< download succeeded */
+		bool started;               /**< taken by a worker */
+		bool done;                  /**< download completed */
+		bool discarded;             /**< not needed anymore, freed once done */
+	};
+
+	/**
+	 * @brief Worker thread entry function
+	 *
+	 * @param[in] arg - AampFetchPipeline instance
+	 * @return NULL
+	 */
+	static void *WorkerThread(void *arg);
+
+	/**
+	 * @brief Download queued fragments until stopped
+	 *
+	 * @param[in] curlInstance - curl instance of the worker
+	 * @return void
+	 */
+	void WorkerLoop(AampCurlInstance curlInstance);
+
+	/**
+	 * @brief Start workers and their curl instances
+	 *
+	 * @return void
+	 */
+	void StartWorkers();
+
+	/**
+	 * @brief Drop a request, called with mMutex held
+	 *
+	 * Request in progress is freed by its worker on completion.
+	 *
+	 * @param[in] it - request to drop
+	 * @return iterator to next request
+	 */
+	std::list<Request *>::iterator Discard(std::list<Request *>::iterator it);
+
+	PrivateInstanceAAMP *mAamp;         /**< player instance */
+	MediaType mMediaType;               /**< media type of downloads */
+	int mWorkerCount;                   /**< worker threads, one per fragment downloaded ahead */
+	AampCurlInstance mFirstCurlInstance; /**< curl instance of first worker */
+	std::vector<pthread_t> mWorkers;    /**< started worker threads */
+	int mNextWorker;                    /**< index of next worker to pick its curl instance */
+	std::list<Request *> mRequests;     /**< queued requests in fragment order */
+	pthread_mutex_t mMutex;             /**< protects requests */
+	pthread_cond_t mCond;               /**< signaled on new request, completion and stop */
+	bool mStop;                         /**< workers exit request */
+};
+
+#endif /* __AAMP_FETCH_PIPELINE_H__ */
@@ -0,0 +1,392 @@
+/*
+ * If not stated otherwise in this file or this component's license file the
+ * following copyright and licenses apply:
+ *
+ * Copyright 2020 RDK Management
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ * http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+*/
+
+/**
+ * @file AampLogQueue.cpp
+ * @brief Per thread log record rings drained by a background writer
+ */
+
+#include "AampLogQueue.h"
+#include <pthread.h>
+#include <unistd.h>
+#include <stdlib.h>
+#include <atomic>
+#include <vector>
+
+#define AAMP_LOG_PREFIX "[AAMP-PLAYER]"
+
+/**
+ * @brief Single producer, single consumer ring of log records
+ */
+struct AampLogRing
+{
+	AampLogRing() : records(), head(0), tail(0), orphaned(false)
+	{
+	}
+
+	AampLogRecord records[AAMP_LOG_RING_SIZE];
+	std::atomic<unsigned> head;     /**< Next record to fill, written by owner thread */
+	std::atomic<unsigned> tail;     /**< Next record to write out, written by writer thread */
+	std::atomic<bool> orphaned;     /**< Owner thread exited, ring freed by writer once empty */
+};
+
+/**
+ * @brief Per thread ownership of a ring, releases it on thread exit
+ */
+struct AampLogRingOwner
+{
+	AampLogRingOwner() : ring(NULL)
+	{
+	}
+
+	~AampLogRingOwner()
+	{
+		if (ring)
+		{
+			ring->orphaned.store(true, std::memory_order_release);
+			ring = NULL;
+		}
+	}
+
+	AampLogRingOwner(const AampLogRingOwner&) = delete;
+	AampLogRingOwner& operator=(const AampLogRingOwner&) = delete;
+
+	AampLogRing *ring;
+};
+
+static thread_local AampLogRingOwner gLogRingOwner;
+static std::atomic<unsigned long long> gLogSeq(0);
+static std::atomic<unsigned> gLogDropped(0);
+
+/* Ring registry; taken only when a thread logs for the first time and by the writer */
+static pthread_mutex_t gLogRingsMutex = PTHREAD_MUTEX_INITIALIZER;
+static std::vector<AampLogRing*> gLogRings;
+
+/* Writer thread control */
+static pthread_mutex_t gLogWriterMutex = PTHREAD_MUTEX_INITIALIZER;
+static pthread_t gLogWriterThread;
+static std::atomic<bool> gLogWriterRunning(false);
+static std::atomic<bool> gLogWriterStop(false);
+
+/* Writer sleeps on gLogWakeCond when all rings are empty, producers signal it only while asleep */
+static pthread_mutex_t gLogWakeMutex = PTHREAD_MUTEX_INITIALIZER;
+static pthread_cond_t gLogWakeCond = PTHREAD_COND_INITIALIZER;
+static std::atomic<bool> gLogWriterSleeping(false);
+
+/**
+ * @brief Write out a record
+ * @param[in] record - log record
+ * @return void
+ */
+static void WriteRecord(const AampLogRecord &record)
+{
+	if (record.formatter)
+	{
+		char line[AAMP_LOG_RECORD_DATA_SIZE + sizeof(AAMP_LOG_PREFIX)];
+		size_t len = strlen(AAMP_LOG_PREFIX);
+		memcpy(line, AAMP_LOG_PREFIX, len);
+		record.formatter(record.format, record.data, line + len, sizeof(line) - len);
+		aamp_WriteLogLine(line, record.time);
+	}
+	else
+	{
+		aamp_WriteLogLine(record.data, record.time);
+	}
+}
+
+/**
+ * @brief Write out committed records of all rings in sequence order
+ * @return true if any record was written
+ */
+static bool DrainRings()
+{
+	std::vector<AampLogRing*> rings;
+	pthread_mutex_lock(&gLogRingsMutex);
+	rings = gLogRings;
+	pthread_mutex_unlock(&gLogRingsMutex);
+
+	bool written = false;
+	while (true)
+	{
+		AampLogRing *next = NULL;
+		unsigned long long nextSeq = 0;
+		for (AampLogRing *ring : rings)
+		{
+			unsigned tail = ring->tail.load(std::memory_order_relaxed);
+			if (tail != ring->head.load(std::memory_order_acquire))
+			{
+				const AampLogRecord &record = ring->records[tail & (AAMP_LOG_RING_SIZE - 1)];
+				if (!next || record.seq < nextSeq)
+				{
+					next = ring;
+					nextSeq = record.seq;
+				}
+			}
+		}
+		if (!next)
+		{
+			break;
+		}
+		unsigned tail = next->tail.load(std::memory_order_relaxed);
+		WriteRecord(next->records[tail & (AAMP_LOG_RING_SIZE - 1)]);
+		next->tail.store(tail + 1, std::memory_order_release);
+		written = true;
+	}
+
+	unsigned dropped = gLogDropped.exchange(0);
+	if (dropped)
+	{
+		char line[64];
+		struct timeval t;
+		gettimeofday(&t, NULL);
+		snprintf(line, sizeof(line), AAMP_LOG_PREFIX "%u log records dropped", dropped);
+		aamp_WriteLogLine(line, t);
+	}
+
+	// Free rings of exited threads; orphaned is set after their last commit
+	pthread_mutex_lock(&gLogRingsMutex);
+	for (std::vector<AampLogRing*>::iterator it = gLogRings.begin(); it != gLogRings.end();)
+	{
+		AampLogRing *ring = *it;
+		if (ring->orphaned.load(std::memory_order_acquire) &&
+			ring->tail.load(std::memory_order_relaxed) == ring->head.load(std::memory_order_acquire))
+		{
+			delete ring;
+			it = gLogRings.erase(it);
+		}
+		else
+		{
+			it++;
+		}
+	}
+	pthread_mutex_unlock(&gLogRingsMutex);
+	return written;
+}
+
+/**
+ * @brief Check if any ring has records to write out
+ * @return true if a record is pending
+ */
+static bool HasPendingRecords()
+{
+	bool pending = false;
+	pthread_mutex_lock(&gLogRingsMutex);
+	for (AampLogRing *ring : gLogRings)
+	{
+		if (ring->tail.load(std::memory_order_relaxed) != ring->head.load(std::memory_order_acquire))
+		{
+			pending = true;
+			break;
+		}
+	}
+	pthread_mutex_unlock(&gLogRingsMutex);
+	return pending;
+}
+
+/**
+ * @brief Wake writer thread if it is waiting for records
+ * @return void
+ */
+static void WakeWriter()
+{
+	// Pairs with the fence in LogWriter, either writer sees the record or producer sees it sleeping
+	std::atomic_thread_fence(std::memory_order_seq_cst);
+	if (gLogWriterSleeping.load(std::memory_order_relaxed))
+	{
+		pthread_mutex_lock(&gLogWakeMutex);
+		pthread_cond_signal(&gLogWakeCond);
+		pthread_mutex_unlock(&gLogWakeMutex);
+	}
+}
+
+/**
+ * @brief Writer thread, drains rings till stopped
+ * @param[in] arg - unused
+ * @return NULL
+ */
+static void* LogWriter(void *arg)
+{
+	(void)arg;
+	while (!gLogWriterStop.load(std::memory_order_acquire))
+	{
+		if (!DrainRings())
+		{
+			pthread_mutex_lock(&gLogWakeMutex);
+			gLogWriterSleeping.store(true, std::memory_order_relaxed);
+			std::atomic_thread_fence(std::memory_order_seq_cst);
+			if (!gLogWriterStop.load(std::memory_order_acquire) && !HasPendingRecords())
+			{
+				pthread_cond_wait(&gLogWakeCond, &gLogWakeMutex);
+			}
+			gLogWriterSleeping.store(false, std::memory_order_relaxed);
+			pthread_mutex_unlock(&gLogWakeMutex);
+		}
+	}
+	DrainRings();
+	return NULL;
+}
+
+/**
+ * @brief Write out queued records on process exit
+ * @return void
+ */
+static void FlushAtExit()
+{
+	AampLogQueue::Flush();
+}
+
+/**
+ * @brief Start writer thread if not running
+ * @return void
+ */
+static void StartWriter()
+{
+	static bool atExitRegistered = false;
+	pthread_mutex_lock(&gLogWriterMutex);
+	if (!gLogWriterRunning.load())
+	{
+		gLogWriterStop.store(false);
+		if (0 == pthread_create(&gLogWriterThread, NULL, &LogWriter, NULL))
+		{
+			gLogWriterRunning.store(true);
+			if (!atExitRegistered)
+			{
+				atexit(FlushAtExit);
+				atExitRegistered = true;
+			}
+		}
+	}
+	pthread_mutex_unlock(&gLogWriterMutex);
+}
+
+/**
+ * @brief Get ring of calling thread, registering it on first use
+ * @return ring
+ */
+static AampLogRing* GetThreadRing()
+{
+	AampLogRing *ring = gLogRingOwner.ring;
+	if (!ring)
+	{
+		ring = new AampLogRing();
+		pthread_mutex_lock(&gLogRingsMutex);
+		gLogRings.push_back(ring);
+		pthread_mutex_unlock(&gLogRingsMutex);
+		gLogRingOwner.ring = ring;
+	}
+	return ring;
+}
+
+/**
+ * @brief Get free record in ring of calling thread
+ * @return record with seq and time set, NULL if ring is full
+ */
+static AampLogRecord* ReserveRecord()
+{
+	if (!gLogWriterRunning.load(std::memory_order_relaxed))
+	{
+		StartWriter();
+	}
+	AampLogRing *ring = GetThreadRing();
+	unsigned head = ring->head.load(std::memory_order_relaxed);
+	if (head - ring->tail.load(std::memory_order_acquire) >= AAMP_LOG_RING_SIZE)
+	{
+		return NULL;
+	}
+	AampLogRecord *record = &ring->records[head & (AAMP_LOG_RING_SIZE - 1)];
+	record->seq = gLogSeq.fetch_add(1, std::memory_order_relaxed);
+	gettimeofday(&record->time, NULL);
+	return record;
+}
+
+/**
+ * @brief Get free record in ring of calling thread
+ * @return record with seq and time set, NULL if ring is full
+ */
+AampLogRecord* AampLogQueue::Reserve()
+{
+	AampLogRecord *record = ReserveRecord();
+	if (!record)
+	{
+		gLogDropped.fetch_add(1, std::memory_order_relaxed);
+	}
+	return record;
+}
+
+/**
+ * @brief Publish record reserved by calling thread to the writer
+ * @param[in] record - record from Reserve
+ * @return void
+ */
+void AampLogQueue::Commit(AampLogRecord *record)
+{
+	(void)record;
+	AampLogRing *ring = gLogRingOwner.ring;
+	ring->head.store(ring->head.load(std::memory_order_relaxed) + 1, std::memory_order_release);
+	WakeWriter();
+}
+
+/**
+ * @brief Queue preformatted text
+ * @param[in] text - log line
+ * @param[in] droppable - true if line may be dropped when ring is full, else it is written synchronously
+ * @return void
+ */
+void AampLogQueue::Push(const char *text, bool droppable)
+{
+	AampLogRecord *record = ReserveRecord();
+	if (record)
+	{
+		record->format = NULL;
+		record->formatter = NULL;
+		strncpy(record->data, text, sizeof(record->data) - 1);
+		record->data[sizeof(record->data) - 1] = 0;
+		Commit(record);
+	}
+	else if (droppable)
+	{
+		gLogDropped.fetch_add(1, std::memory_order_relaxed);
+	}
+	else
+	{
+		// Warnings and errors are never lost; may appear ahead of queued records of this thread
+		struct timeval t;
+		gettimeofday(&t, NULL);
+		aamp_WriteLogLine(text, t);
+	}
+}
+
+/**
+ * @brief Write out all queued records and stop the writer thread
+ * @return void
+ */
+void AampLogQueue::Flush()
+{
+	pthread_mutex_lock(&gLogWriterMutex);
+	if (gLogWriterRunning.load())
+	{
+		gLogWriterStop.store(true, std::memory_order_release);
+		pthread_mutex_lock(&gLogWakeMutex);
+		pthread_cond_signal(&gLogWakeCond);
+		pthread_mutex_unlock(&gLogWakeMutex);
+		pthread_join(gLogWriterThread, NULL);
+		gLogWriterRunning.store(false);
+	}
+	pthread_mutex_unlock(&gLogWriterMutex);
+}
@@ -0,0 +1,284 @@
+/*
+ * If not stated otherwise in this file or this component's license file the
+ * following copyright and licenses apply:
+ *
+ * Copyright 2020 RDK Management
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ * http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+*/
+
+/**
+ * @file AampLogQueue.h
+ * @brief Per thread log record rings drained by a background writer
+ */
+
+#ifndef __AAMP_LOG_QUEUE_H__
+#define __AAMP_LOG_QUEUE_H__
+
+#include <stdio.h>
+#include <string.h>
+#include <sys/time.h>
+#include <type_traits>
+
+#define AAMP_LOG_RECORD_DATA_SIZE 1024  /**< Bytes of text or packed arguments in a log record */
+#define AAMP_LOG_RING_SIZE 256          /**< Records in ring of each logging thread, power of 2 */
+
+/**
+ * @brief Formats packed arguments of a deferred log record
+ *
+ * @param[in] format - printf style format string
+ * @param[in] args - packed arguments
+ * @param[out] out - output buffer
+ * @param[in] size - output buffer size
+ * @return snprintf style return value
+ */
+typedef int (*AampLogFormatter)(const char *format, const char *args, char *out, size_t size);
+
+/**
+ * @brief Log record queued for the writer thread
+ *
+ * Holds either preformatted text (formatter NULL) or a format string of static
+ * lifetime with its arguments packed in binary form, formatted by the writer.
+ */
+struct AampLogRecord
+{
+	unsigned long long seq;                 /**< Global sequence, orders records of different threads */
+	struct timeval time;                    /**< Time of logging */
+	const char *format;                     /**< Format string of deferred record */
+	AampLogFormatter formatter;             /**< Formatter of deferred record, NULL for text */
+	char data[AAMP_LOG_RECORD_DATA_SIZE];   /**< Text or packed arguments */
+};
+
+/**
+ * @brief Lock-free queue of log records
+ *
+ * Each logging thread owns a single producer ring, so logging never blocks on
+ * another thread or on the log sink. A background writer merges the rings in
+ * sequence order and writes the records. When the ring of a thread is full,
+ * droppable (trace and info) records are dropped and counted, others are
+ * written synchronously.
+ */
+class AampLogQueue
+{
+public:
+	/**
+	 * @brief Get free record in ring of calling thread
+	 *
+	 * Record must be passed to Commit before next Reserve on the thread.
+	 *
+	 * @return record with seq and time set, NULL if ring is full
+	 */
+	static AampLogRecord* Reserve();
+
+	/**
+	 * @brief Publish record reserved by calling thread to the writer
+	 *
+	 * @param[in] record - record from Reserve
+	 * @return void
+	 */
+	static void Commit(AampLogRecord *record);
+
+	/**
+	 * @brief Queue preformatted text
+	 *
+	 * @param[in] text - log line
+	 * @param[in] droppable - true if line may be dropped when ring is full, else it is written synchronously
+	 * @return void
+	 */
+	static void Push(const char *text, bool droppable = false);
+
+	/**
+	 * @brief Write out all queued records and stop the writer thread
+	 *
+	 * Writer restarts on next queued record.
+	 *
+	 * @return void
+	 */
+	static void Flush();
+};
+
+/**
+ * @brief Write a log line to the configured sink
+ *
+ * @param[in] line - log line
+ * @param[in] time - time of logging
+ * @return void
+ */
+void aamp_WriteLogLine(const char *line, const struct timeval &time);
+
+/**
+ * @brief Packing of a deferred log argument
+ *
+ * Arithmetic, enum and pointer values are stored as is.
+ */
+template<typename T>
+struct AampLogArg
+{
+	static_assert(std::is_arithmetic<T>::value || std::is_enum<T>::value || std::is_pointer<T>::value,
+			"deferred log arguments must be scalars or C strings");
+	typedef T Type;
+	static const size_t minSize = sizeof(T);
+	static const size_t strings = 0;
+
+	static char* Store(char *dst, const char *end, T value)
+	{
+		(void)end;
+		memcpy(dst, &value, sizeof(T));
+		return dst + sizeof(T);
+	}
+
+	static T Load(const char *&src)
+	{
+		T value;
+		memcpy(&value, src, sizeof(T));
+		src += sizeof(T);
+		return value;
+	}
+};
+
+/**
+ * @brief Packing of a C string log argument
+ *
+ * String is copied, truncated to fit the record, as caller's buffer may be gone
+ * by the time record is formatted. Stored as NULL flag followed by text.
+ */
+template<>
+struct AampLogArg<const char*>
+{
+	typedef const char* Type;
+	static const size_t minSize = 2;
+	static const size_t strings = 1;
+
+	static char* Store(char *dst, const char *end, const char *value)
+	{
+		*dst++ = (value != NULL);
+		size_t len = value ? strnlen(value, end - dst - 1) : 0;
+		memcpy(dst, value ? value : "", len);
+		dst[len] = 0;
+		return dst + len + 1;
+	}
+
+	static const char* Load(const char *&src)
+	{
+		bool valid = *src++;
+		const char *value = src;
+		src += strlen(src) + 1;
+		return valid ? value : NULL;
+	}
+};
+
+template<>
+struct AampLogArg<char*> : public AampLogArg<const char*>
+{
+};
+
+/**
+ * @brief Minimum bytes needed to pack a list of arguments, and number of strings in it
+ */
+template<typename... Args>
+struct AampLogArgsSize
+{
+	static const size_t value = 0;
+	static const size_t strings = 0;
+};
+
+template<typename T, typename... Rest>
+struct AampLogArgsSize<T, Rest...>
+{
+	static const size_t value = AampLogArg<T>::minSize + AampLogArgsSize<Rest...>::value;
+	static const size_t strings = AampLogArg<T>::strings + AampLogArgsSize<Rest...>::strings;
+};
+
+/**
+ * @brief Type list of packed arguments
+ */
+template<typename... Types>
+struct AampLogTypes
+{
+};
+
+inline char* aamp_PackLogArgs(char *dst, const char *end)
+{
+	(void)end;
+	return dst;
+}
+
+/**
+ * @brief Pack arguments of a deferred log record
+ *
+ * Space for the arguments that follow is kept aside, so only strings get truncated;
+ * free space is shared evenly by the strings still to be packed.
+ */
+template<typename T, typename... Rest>
+char* aamp_PackLogArgs(char *dst, const char *end, T value, Rest... rest)
+{
+	const char *limit = end - AampLogArgsSize<Rest...>::value;
+	limit = dst + (limit - dst) / (1 + AampLogArgsSize<Rest...>::strings);
+	dst = AampLogArg<T>::Store(dst, limit, value);
+	return aamp_PackLogArgs(dst, end, rest...);
+}
+
+inline int aamp_FormatLogArgs(const char *format, const char *src, char *out, size_t size, AampLogTypes<>)
+{
+	(void)src;
+	// Unused argument keeps format non-literal warnings away; excess arguments are ignored
+	return snprintf(out, size, format, 0);
+}
+
+template<typename... Loaded>
+int aamp_FormatLogArgs(const char *format, const char *src, char *out, size_t size, AampLogTypes<>, Loaded... loaded)
+{
+	(void)src;
+	return snprintf(out, size, format, loaded...);
+}
+
+/**
+ * @brief Unpack arguments one by one, then format them
+ */
+template<typename T, typename... Rest, typename... Loaded>
+int aamp_FormatLogArgs(const char *format, const char *src, char *out, size_t size, AampLogTypes<T, Rest...>, Loaded... loaded)
+{
+	T value = AampLogArg<T>::Load(src);
+	return aamp_FormatLogArgs(format, src, out, size, AampLogTypes<Rest...>(), loaded..., value);
+}
+
+/**
+ * @brief Formatter of deferred records with given argument types
+ */
+template<typename... Types>
+int aamp_FormatLogRecord(const char *format, const char *args, char *out, size_t size)
+{
+	return aamp_FormatLogArgs(format, args, out, size, AampLogTypes<Types...>());
+}
+
+/**
+ * @brief Queue log record with arguments in binary form, formatted by the writer
+ *
+ * @param[in] format - printf style format string, must be a string literal
+ * @param[in] args - scalar or C string arguments
+ * @return void
+ */
+template<typename... Args>
+void aamp_LogDeferred(const char *format, Args... args)
+{
+	AampLogRecord *record = AampLogQueue::Reserve();
+	if (record)
+	{
+		record->format = format;
+		record->formatter = &aamp_FormatLogRecord<typename AampLogArg<Args>::Type...>;
+		aamp_PackLogArgs(record->data, record->data + sizeof(record->data), args...);
+		AampLogQueue::Commit(record);
+	}
+}
+
+#endif /* __AAMP_LOG_QUEUE_H__ */
@@ -0,0 +1,246 @@
+/*
+ * If not stated otherwise in this file or this component's license file the
+ * following copyright and licenses apply:
+ *
+ * Copyright 2020 RDK Management
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ * http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+*/
+
+/**
+ * @file AampMultiDownloader.cpp
+ * @brief Download engine driving curl easy handles through a shared curl multi handle
+ */
+
+#include "AampMultiDownloader.h"
+#include "priv_aamp.h"
+#include <unistd.h>
+#include <fcntl.h>
+
+#define MULTI_DOWNLOADER_MAX_HOST_CONNECTIONS 4     /**< Parallel connections to a host when multiplexing is not possible */
+#define MULTI_DOWNLOADER_WAIT_TIMEOUT_MS 1000       /**< Max wait for socket activity, transfer timeouts are handled by curl */
+
+static pthread_mutex_t instanceLock = PTHREAD_MUTEX_INITIALIZER;
+static std::weak_ptr<AampMultiDownloader> gMultiDownloader;
+
+/**
+ * @brief Get shared instance, created on first use
+ * @retval shared pointer to AampMultiDownloader
+ */
+std::shared_ptr<AampMultiDownloader> AampMultiDownloader::GetInstance()
+{
+	pthread_mutex_lock(&instanceLock);
+	std::shared_ptr<AampMultiDownloader> instance = gMultiDownloader.lock();
+	if (nullptr == instance)
+	{
+		instance = std::make_shared<AampMultiDownloader>();
+		gMultiDownloader = instance;
+	}
+	pthread_mutex_unlock(&instanceLock);
+	return instance;
+}
+
+
+/**
+ * @brief AampMultiDownloader constructor
+ */
+AampMultiDownloader::AampMultiDownloader() : mMulti(NULL), mThreadId(0), mThreadStarted(false), mMutex(), mTransferDone(),
+		mPending(), mWakeupPipe(), mExit(false)
+{
+	pthread_mutex_init(&mMutex, NULL);
+	pthread_cond_init(&mTransferDone, NULL);
+	mWakeupPipe[0] = mWakeupPipe[1] = -1;
+	if (0 == pipe(mWakeupPipe))
+	{
+		fcntl(mWakeupPipe[0], F_SETFL, O_NONBLOCK);
+		fcntl(mWakeupPipe[1], F_SETFL, O_NONBLOCK);
+	}
+	else
+	{
+		logprintf("%s:%d pipe creation failed, new transfers wait for socket activity", __FUNCTION__, __LINE__);
+	}
+
+	mMulti = curl_multi_init();
+	// Multiplex requests on HTTP/2 connections, connection and DNS caches are shared by all easy handles of multi
+	curl_multi_setopt(mMulti, CURLMOPT_PIPELINING, CURLPIPE_MULTIPLEX);
+	curl_multi_setopt(mMulti, CURLMOPT_MAX_HOST_CONNECTIONS, (long)MULTI_DOWNLOADER_MAX_HOST_CONNECTIONS);
+
+	if (0 == pthread_create(&mThreadId, NULL, &DownloadThread, this))
+	{
+		mThreadStarted = true;
+	}
+	else
+	{
+		logprintf("%s:%d Failed to create download thread", __FUNCTION__, __LINE__);
+	}
+}
+
+
+/**
+ * @brief AampMultiDownloader destructor
+ */
+AampMultiDownloader::~AampMultiDownloader()
+{
+	pthread_mutex_lock(&mMutex);
+	mExit = true;
+	pthread_mutex_unlock(&mMutex);
+	Wakeup();
+	if (mThreadStarted)
+	{
+		pthread_join(mThreadId, NULL);
+	}
+	curl_multi_cleanup(mMulti);
+	for (int i = 0; i < 2; i++)
+	{
+		if (mWakeupPipe[i] >= 0)
+		{
+			close(mWakeupPipe[i]);
+		}
+	}
+	pthread_cond_destroy(&mTransferDone);
+	pthread_mutex_destroy(&mMutex);
+}
+
+
+/**
+ * @brief Download thread entry function
+ * @param arg AampMultiDownloader instance
+ * @retval NULL
+ */
+void *AampMultiDownloader::DownloadThread(void *arg)
+{
+	if (aamp_pthread_setname(pthread_self(), "aampDownloader"))
+	{
+		logprintf("%s:%d: pthread_setname_np failed", __FUNCTION__, __LINE__);
+	}
+	((AampMultiDownloader *)arg)->DownloadLoop();
+	return NULL;
+}
+
+
+/**
+ * @brief Wake up download thread waiting for socket activity
+ */
+void AampMultiDownloader::Wakeup()
+{
+	if (mWakeupPipe[1] >= 0)
+	{
+		char c = 0;
+		if (write(mWakeupPipe[1], &c, 1) < 0)
+		{
+			// Pipe full, download thread is already signaled
+		}
+	}
+}
+
+
+/**
+ * @brief Perform transfer of an easy handle and wait for its completion
+ * @param curl configured curl easy handle
+ * @retval transfer result
+ */
+CURLcode AampMultiDownloader::Perform(CURL *curl)
+{
+	Transfer transfer;
+	transfer.curl = curl;
+	transfer.result = CURLE_OK;
+	transfer.done = false;
+
+	if (!mThreadStarted)
+	{
+		return curl_easy_perform(curl);
+	}
+
+	curl_easy_setopt(curl, CURLOPT_PRIVATE, &transfer);
+	// Prefer waiting for a multiplexed connection over opening a new one
+	curl_easy_setopt(curl, CURLOPT_PIPEWAIT, 1L);
+
+	pthread_mutex_lock(&mMutex);
+	mPending.push_back(&transfer);
+	pthread_mutex_unlock(&mMutex);
+	Wakeup();
+
+	pthread_mutex_lock(&mMutex);
+	while (!transfer.done)
+	{
+		pthread_cond_wait(&mTransferDone, &mMutex);
+	}
+	pthread_mutex_unlock(&mMutex);
+	curl_easy_setopt(curl, CURLOPT_PRIVATE, NULL);
+	return transfer.result;
+}
+
+
+/**
+ * @brief Drive all transfers until instance is destroyed
+ */
+void AampMultiDownloader::DownloadLoop()
+{
+	while (true)
+	{
+		pthread_mutex_lock(&mMutex);
+		if (mExit)
+		{
+			pthread_mutex_unlock(&mMutex);
+			break;
+		}
+		for (Transfer *transfer : mPending)
+		{
+			CURLMcode rc = curl_multi_add_handle(mMulti, transfer->curl);
+			if (CURLM_OK != rc)
+			{
+				logprintf("%s:%d curl_multi_add_handle failed: %s", __FUNCTION__, __LINE__, curl_multi_strerror(rc));
+				transfer->result = CURLE_FAILED_INIT;
+				transfer->done = true;
+				pthread_cond_broadcast(&mTransferDone);
+			}
+		}
+		mPending.clear();
+		pthread_mutex_unlock(&mMutex);
+
+		int running = 0;
+		curl_multi_perform(mMulti, &running);
+
+		int msgsLeft = 0;
+		CURLMsg *msg = NULL;
+		while ((msg = curl_multi_info_read(mMulti, &msgsLeft)) != NULL)
+		{
+			if (CURLMSG_DONE == msg->msg)
+			{
+				CURL *curl = msg->easy_handle;
+				CURLcode result = msg->data.result;
+				char *priv = NULL;
+				curl_easy_getinfo(curl, CURLINFO_PRIVATE, &priv);
+				curl_multi_remove_handle(mMulti, curl);
+
+				Transfer *transfer = (Transfer *)priv;
+				pthread_mutex_lock(&mMutex);
+				transfer->result = result;
+				transfer->done = true;
+				pthread_cond_broadcast(&mTransferDone);
+				pthread_mutex_unlock(&mMutex);
+			}
+		}
+
+		struct curl_waitfd wakeupFd;
+		wakeupFd.fd = mWakeupPipe[0];
+		wakeupFd.events = CURL_WAIT_POLLIN;
+		wakeupFd.revents = 0;
+		curl_multi_wait(mMulti, &wakeupFd, (mWakeupPipe[0] >= 0) ? 1 : 0, MULTI_DOWNLOADER_WAIT_TIMEOUT_MS, NULL);
+		if (wakeupFd.revents)
+		{
+			char buf[64];
+			while (read(mWakeupPipe[0], buf, sizeof(buf)) > 0);
+		}
+	}
+}
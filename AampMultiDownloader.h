@@ -0,0 +1,126 @@
+/*
+ * If not stated otherwise in this file or this component's license file the
+ * following copyright and licenses apply:
+ *
+ * Copyright 2020 RDK Management
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ * http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+*/
+
+/**
+ * @file AampMultiDownloader.h
+ * @brief Download engine driving curl easy handles through a shared curl multi handle
+ */
+
+#ifndef __AAMP_MULTI_DOWNLOADER_H__
+#define __AAMP_MULTI_DOWNLOADER_H__
+
+#include <curl/curl.h>
+#include <pthread.h>
+#include <memory>
+#include <vector>
+
+/**
+ * @brief Download engine built on curl multi interface
+ *
+ * All transfers of all player instances are driven by a single thread through
+ * one multi handle, so connections, DNS cache and HTTP/2 sessions are shared
+ * and concurrent requests of different tracks are multiplexed on the same
+ * connection when the server supports it.
+ *
+ * Callers block in Perform; a track keeps several fragments in flight through
+ * the workers of its AampFetchPipeline, each performing one transfer. Write
+ * and progress callbacks of all transfers run on the download thread and
+ * must stay short.
+ */
+class AampMultiDownloader
+{
+public:
+	/**
+	 * @brief Get shared instance, created on first use
+	 *
+	 * Instance is destroyed when the last reference is dropped.
+	 *
+	 * @return shared pointer to AampMultiDownloader
+	 */
+	static std::shared_ptr<AampMultiDownloader> GetInstance();
+
+	/**
+	 * @brief AampMultiDownloader constructor
+	 */
+	AampMultiDownloader();
+
+	/**
+	 * @brief AampMultiDownloader destructor
+	 */
+	~AampMultiDownloader();
+
+	AampMultiDownloader(const AampMultiDownloader&) = delete;
+	AampMultiDownloader& operator=(const AampMultiDownloader&) = delete;
+
+	/**
+	 * @brief Perform transfer of an easy handle and wait for its completion
+	 *
+	 * Drop-in replacement of curl_easy_perform, calling thread is blocked
+	 * till the transfer completes; callbacks of the handle are invoked from
+	 * the download thread.
+	 *
+	 * @param[in] curl - configured curl easy handle
+	 * @return transfer result
+	 */
+	CURLcode Perform(CURL *curl);
+
+private:
+	/**
+	 * @brief State of a transfer handed over to download thread
+	 */
+	struct Transfer
+	{
+		CURL *curl;         /**< easy handle */
+		CURLcode result;    /**< transfer result */
+		bool done;          /**< set when transfer is complete */
+	};
+
+	/**
+	 * @brief Download thread entry function
+	 *
+	 * @param[in] arg - AampMultiDownloader instance
+	 * @return NULL
+	 */
+	static void *DownloadThread(void *arg);
+
+	/**
+	 * @brief Drive all transfers until instance is destroyed
+	 *
+	 * @return void
+	 */
+	void DownloadLoop();
+
+	/**
+	 * @brief Wake up download thread waiting for socket activity
+	 *
+	 * @return void
+	 */
+	void Wakeup();
+
+	CURLM *mMulti;                      /**< multi handle shared by all transfers */
+	pthread_t mThreadId;                /**< download thread */
+	bool mThreadStarted;                /**< download thread started or not */
+	pthread_mutex_t mMutex;             /**< protects transfer lists */
+	pthread_cond_t mTransferDone;       /**< signaled when a transfer completes */
+	std::vector<Transfer *> mPending;   /**< transfers yet to be added to multi handle */
+	int mWakeupPipe[2];                 /**< pipe to interrupt curl_multi_wait */
+	bool mExit;                         /**< download thread exit request */
+};
+
+#endif /* __AAMP_MULTI_DOWNLOADER_H__ */
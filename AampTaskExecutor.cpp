@@ -0,0 +1,185 @@
+/*
+ * If not stated otherwise in this file or this component's license file the
+ * following copyright and licenses apply:
+ *
+ * Copyright 2020 RDK Management
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ * http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+*/
+
+/**
+ * @file AampTaskExecutor.cpp
+ * @brief Process wide pool of worker threads for short lived tasks
+ */
+
+#include "AampTaskExecutor.h"
+#include "priv_aamp.h"
+#include <errno.h>
+#include <sys/time.h>
+
+/* Max tasks of each priority running at a time */
+static const int gMaxRunning[eAAMP_TASK_PRIORITY_COUNT] =
+{
+	AAMP_TASK_EXECUTOR_MAX_THREADS,
+	AAMP_TASK_EXECUTOR_MAX_THREADS - AAMP_TASK_EXECUTOR_TUNE_RESERVED,
+	AAMP_TASK_EXECUTOR_MAX_BACKGROUND
+};
+
+/**
+ * @brief Get the process wide executor
+ * @return executor
+ */
+AampTaskExecutor* AampTaskExecutor::GetInstance()
+{
+	// Never destroyed, idle workers may still be waiting on it at exit
+	static AampTaskExecutor *instance = new AampTaskExecutor();
+	return instance;
+}
+
+/**
+ * @brief AampTaskExecutor constructor
+ */
+AampTaskExecutor::AampTaskExecutor() : mQueue(), mRunning(), mThreads(0), mIdleThreads(0), mMutex(), mCond()
+{
+	pthread_mutex_init(&mMutex, NULL);
+	pthread_cond_init(&mCond, NULL);
+}
+
+/**
+ * @brief Queue a task
+ * @param[in] priority - task priority
+ * @param[in] task - function to run
+ * @return future, ready once task has run
+ */
+std::future<void> AampTaskExecutor::Submit(AampTaskPriority priority, std::function<void()> task)
+{
+	std::shared_ptr<std::packaged_task<void()>> packagedTask = std::make_shared<std::packaged_task<void()>>(task);
+	std::future<void> future = packagedTask->get_future();
+	bool runHere = false;
+
+	pthread_mutex_lock(&mMutex);
+	mQueue[priority].push_back([packagedTask]() { (*packagedTask)(); });
+	size_t queued = 0;
+	for (int i = 0; i < eAAMP_TASK_PRIORITY_COUNT; i++)
+	{
+		queued += mQueue[i].size();
+	}
+	if (queued > (size_t)mIdleThreads && mThreads < AAMP_TASK_EXECUTOR_MAX_THREADS)
+	{
+		pthread_t threadId;
+		if (0 == pthread_create(&threadId, NULL, &Worker, this))
+		{
+			pthread_detach(threadId);
+			mThreads++;
+		}
+		else
+		{
+			logprintf("%s:%d pthread_create failed, errno = %d, %s", __FUNCTION__, __LINE__, errno, strerror(errno));
+			if (mThreads == 0)
+			{
+				mQueue[priority].pop_back();
+				runHere = true;
+			}
+		}
+	}
+	pthread_cond_signal(&mCond);
+	pthread_mutex_unlock(&mMutex);
+
+	if (runHere)
+	{
+		(*packagedTask)();
+	}
+	return future;
+}
+
+/**
+ * @brief Thread entry of worker
+ * @param[in] arg - executor
+ * @return NULL
+ */
+void* AampTaskExecutor::Worker(void *arg)
+{
+	AampTaskExecutor *executor = (AampTaskExecutor *)arg;
+	if (aamp_pthread_setname(pthread_self(), "aampWorker"))
+	{
+		logprintf("%s:%d: aamp_pthread_setname failed", __FUNCTION__, __LINE__);
+	}
+	executor->WorkerLoop();
+	return NULL;
+}
+
+/**
+ * @brief Get priority of next task to run, called with mMutex held
+ * @return priority, eAAMP_TASK_PRIORITY_COUNT if no task can run now
+ */
+AampTaskPriority AampTaskExecutor::GetNextPriority()
+{
+	// Playback and background tasks share the workers not reserved for tune
+	int nonTuneRunning = mRunning[eAAMP_TASK_PRIORITY_PLAYBACK] + mRunning[eAAMP_TASK_PRIORITY_BACKGROUND];
+	for (int i = 0; i < eAAMP_TASK_PRIORITY_COUNT; i++)
+	{
+		if (!mQueue[i].empty() && mRunning[i] < gMaxRunning[i] &&
+			(i == eAAMP_TASK_PRIORITY_TUNE || nonTuneRunning < AAMP_TASK_EXECUTOR_MAX_THREADS - AAMP_TASK_EXECUTOR_TUNE_RESERVED))
+		{
+			return (AampTaskPriority)i;
+		}
+	}
+	return eAAMP_TASK_PRIORITY_COUNT;
+}
+
+/**
+ * @brief Run queued tasks till idle for AAMP_TASK_EXECUTOR_IDLE_MS
+ * @return void
+ */
+void AampTaskExecutor::WorkerLoop()
+{
+	pthread_mutex_lock(&mMutex);
+	while (true)
+	{
+		AampTaskPriority priority = GetNextPriority();
+		if (priority != eAAMP_TASK_PRIORITY_COUNT)
+		{
+			std::function<void()> task = mQueue[priority].front();
+			mQueue[priority].pop_front();
+			mRunning[priority]++;
+			pthread_mutex_unlock(&mMutex);
+
+			task();
+			// Tasks may name the thread after themselves
+			aamp_pthread_setname(pthread_self(), "aampWorker");
+
+			pthread_mutex_lock(&mMutex);
+			mRunning[priority]--;
+			// Task of a priority at its limit may run now
+			pthread_cond_broadcast(&mCond);
+			continue;
+		}
+
+		struct timespec ts;
+		struct timeval tv;
+		gettimeofday(&tv, NULL);
+		ts.tv_sec = time(NULL) + AAMP_TASK_EXECUTOR_IDLE_MS / 1000;
+		ts.tv_nsec = (long)(tv.tv_usec * 1000 + 1000 * 1000 * (AAMP_TASK_EXECUTOR_IDLE_MS % 1000));
+		ts.tv_sec += ts.tv_nsec / (1000 * 1000 * 1000);
+		ts.tv_nsec %= (1000 * 1000 * 1000);
+		mIdleThreads++;
+		int rc = pthread_cond_timedwait(&mCond, &mMutex, &ts);
+		mIdleThreads--;
+		if (rc == ETIMEDOUT && GetNextPriority() == eAAMP_TASK_PRIORITY_COUNT)
+		{
+			break;
+		}
+	}
+	mThreads--;
+	pthread_mutex_unlock(&mMutex);
+}
@@ -0,0 +1,118 @@
+/*
+ * If not stated otherwise in this file or this component's license file the
+ * following copyright and licenses apply:
+ *
+ * Copyright 2020 RDK Management
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ * http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+*/
+
+/**
+ * @file AampTaskExecutor.h
+ * @brief Process wide pool of worker threads for short lived tasks
+ */
+
+#ifndef __AAMP_TASK_EXECUTOR_H__
+#define __AAMP_TASK_EXECUTOR_H__
+
+#include <pthread.h>
+#include <deque>
+#include <functional>
+#include <future>
+
+#define AAMP_TASK_EXECUTOR_MAX_THREADS 8          /**< Max worker threads of all players */
+#define AAMP_TASK_EXECUTOR_TUNE_RESERVED 2        /**< Workers never taken by playback or background tasks */
+#define AAMP_TASK_EXECUTOR_MAX_BACKGROUND 2       /**< Max workers running background tasks at a time */
+#define AAMP_TASK_EXECUTOR_IDLE_MS 30000          /**< Idle time after which a worker exits */
+
+/**
+ * @brief Priority of a task, queued tasks of higher priority run first
+ */
+enum AampTaskPriority
+{
+	eAAMP_TASK_PRIORITY_TUNE,           /**< Tune or seek waits for it */
+	eAAMP_TASK_PRIORITY_PLAYBACK,       /**< Needed for playback, not immediately */
+	eAAMP_TASK_PRIORITY_BACKGROUND,     /**< Opportunistic work */
+	eAAMP_TASK_PRIORITY_COUNT
+};
+
+/**
+ * @brief Runs tasks on a bounded set of worker threads shared by all players
+ *
+ * Workers are created on demand up to AAMP_TASK_EXECUTOR_MAX_THREADS and exit
+ * after AAMP_TASK_EXECUTOR_IDLE_MS without work. Playback and background tasks
+ * together never take the last AAMP_TASK_EXECUTOR_TUNE_RESERVED workers, so a
+ * tune task finds a worker even when slow tasks fill the rest of the pool.
+ * Tasks are expected to be short; long running loops keep dedicated threads.
+ */
+class AampTaskExecutor
+{
+public:
+	/**
+	 * @brief Get the process wide executor
+	 *
+	 * @return executor
+	 */
+	static AampTaskExecutor* GetInstance();
+
+	/**
+	 * @brief Queue a task
+	 *
+	 * Task runs on the calling thread if no worker is available and none can be created.
+	 *
+	 * @param[in] priority - task priority
+	 * @param[in] task - function to run
+	 * @return future, ready once task has run
+	 */
+	std::future<void> Submit(AampTaskPriority priority, std::function<void()> task);
+
+	AampTaskExecutor(const AampTaskExecutor&) = delete;
+	AampTaskExecutor& operator=(const AampTaskExecutor&) = delete;
+
+private:
+	/**
+	 * @brief AampTaskExecutor constructor
+	 */
+	AampTaskExecutor();
+
+	/**
+	 * @brief Thread entry of worker
+	 *
+	 * @param[in] arg - executor
+	 * @return NULL
+	 */
+	static void* Worker(void *arg);
+
+	/**
+	 * @brief Run queued tasks till idle for AAMP_TASK_EXECUTOR_IDLE_MS
+	 *
+	 * @return void
+	 */
+	void WorkerLoop();
+
+	/**
+	 * @brief Get priority of next task to run, called with mMutex held
+	 *
+	 * @return priority, eAAMP_TASK_PRIORITY_COUNT if no task can run now
+	 */
+	AampTaskPriority GetNextPriority();
+
+	std::deque<std::function<void()>> mQueue[eAAMP_TASK_PRIORITY_COUNT];    /**< queued tasks per priority */
+	int mRunning[eAAMP_TASK_PRIORITY_COUNT];        /**< running tasks per priority */
+	int mThreads;                                   /**< worker threads */
+	int mIdleThreads;                               /**< worker threads waiting for tasks */
+	pthread_mutex_t mMutex;
+	pthread_cond_t mCond;                           /**< signalled on new task and task completion */
+};
+
+#endif /* __AAMP_TASK_EXECUTOR_H__ */
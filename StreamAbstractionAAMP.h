@@ -29,6 +29,7 @@
 #include <map>
 #include <iterator>
 #include <vector>
+#include <atomic>
 
 #include <ABRManager.h>
 #include <glib.h>
@@ -230,6 +231,45 @@ public:
 	 */
 	CachedFragment* GetFetchBuffer(bool initialize);
 
+	/**
+	 * @brief Get number of fragments following the one being fetched to download ahead
+	 *
+	 * Limited by free slots of the fetch ring, so downloads in flight never
+	 * exceed what the ring can take.
+	 *
+	 * @return fragments to queue with PrefetchFragment, 0 if pipelining is disabled
+	 */
+	int GetPrefetchCount();
+
+	/**
+	 * @brief Download a fragment ahead of the fetcher, no-op if it is already downloading
+	 *
+	 * @param[in] url - fragment url
+	 * @param[in] range - byte range, NULL for whole file
+	 * @param[in] durationSeconds - fragment duration
+	 * @return void
+	 */
+	void PrefetchFragment(const std::string &url, const char *range, double durationSeconds);
+
+	/**
+	 * @brief Take fragment downloaded ahead into fetch buffer
+	 *
+	 * @param[in] url - fragment url
+	 * @param[in] range - byte range, NULL for whole file
+	 * @param[out] cachedFragment - fetch buffer
+	 * @param[out] effectiveUrl - effective url of download
+	 * @param[out] http_error - http status of download
+	 * @return true if fragment was downloaded ahead, false if it has to be downloaded now
+	 */
+	bool TakePrefetchedFragment(const std::string &url, const char *range, CachedFragment* cachedFragment, std::string &effectiveUrl, long &http_error);
+
+	/**
+	 * @brief Stop downloads ahead of the fetcher, to be called with downloads disabled
+	 *
+	 * @return void
+	 */
+	void StopPrefetch();
+
 	/**
 	 * @brief Set current bandwidth
 	 *
@@ -352,11 +392,12 @@ private:
 public:
 	bool eosReached;                    /**< set to true when a vod asset has been played to completion */
 	bool enabled;                       /**< set to true if track is enabled */
-	int numberOfFragmentsCached;        /**< Number of fragments cached in this track*/
+	std::atomic<int> numberOfFragmentsCached; /**< Number of fragments cached in this track, published by fetcher and consumed by injector without lock*/
+	const int maxCachedFragments;       /**< Capacity of fragment cache of this track*/
 	const char* name;                   /**< Track name used for debugging*/
 	double fragmentDurationSeconds;     /**< duration in seconds for current fragment-of-interest */
 	int segDLFailCount;                 /**< Segment download fail count*/
-	int segDrmDecryptFailCount;         /**< Segment decryption failure count*/
+	std::atomic<int> segDrmDecryptFailCount;    /**< Segment decryption failure count, updated by fetch and decrypt threads*/
 	int mSegInjectFailCount;            /**< Segment Inject/Decode fail count */
 	TrackType type;                     /**< Media type of the track*/
 	SubtitleParser* mSubtitleParser;    /**< Parser for subtitle data*/
@@ -368,6 +409,7 @@ protected:
 	bool ptsError;                      /**< flag to indicate if last injected fragment has ptsError */
 	bool abortInject;                   /**< Abort inject operations if flag is set*/
 private:
+	class AampFetchPipeline *mFetchPipeline; /**< Downloads fragments ahead of fetcher, NULL if disabled*/
 	pthread_cond_t fragmentFetched;     /**< Signaled after a fragment is fetched*/
 	pthread_cond_t fragmentInjected;    /**< Signaled after a fragment is injected*/
 	pthread_t fragmentInjectorThreadID; /**< Fragment injector thread id*/
@@ -379,8 +421,8 @@ private:
 	int currentInitialCacheDurationSeconds;    /**< Current cached fragments duration before playing*/
 	bool sinkBufferIsFull;                /**< True if sink buffer is full and do not want new fragments*/
 	bool notifiedCachingComplete;       /**< Fragment caching completed or not*/
-	int fragmentIdxToInject;            /**< Write position */
-	int fragmentIdxToFetch;             /**< Read position */
+	int fragmentIdxToInject;            /**< Read position, owned by injector */
+	int fragmentIdxToFetch;             /**< Write position, owned by fetcher */
 	int bandwidthBitsPerSecond;        /**< Bandwidth of last selected profile*/
 	double totalFetchedDuration;        /**< Total fragment fetched duration*/
 	bool discontinuityProcessed;
@@ -580,6 +622,13 @@ public:
 	 */
 	bool CheckForRampDownProfile(long http_error);
 
+	/**
+	 *   @brief Check if a lower video profile is available to ramp down to
+	 *
+	 *   @return true if not at lowest profile and ramp down limit not reached
+	 */
+	bool CanRampDownProfile();
+
 	/**
 	 *   @brief Checks and update profile based on bandwidth.
 	 *
@@ -921,6 +970,13 @@ private:
 	 */
 	int GetDesiredProfileBasedOnCache(void);
 
+	/**
+	 * @brief Get desired profile from ABR strategy selected for tune
+	 *
+	 * @return Profile index
+	 */
+	int GetDesiredProfileByStrategy(void);
+
 	/**
 	 * @brief Update profile based on fragments downloaded.
 	 *
@@ -947,6 +1003,7 @@ private:
 	int mABRHighBufferCounter;	    /**< ABR High buffer counter */
 	int mABRLowBufferCounter;	    /**< ABR Low Buffer counter */
 	int mMaxBufferCountCheck;
+	AampAbrStrategy *mAbrStrategy;      /**< ABR strategy selected for tune, NULL for ABRManager rules */
 	bool mESChangeStatus;               /**< flag value which is used to call pipeline configuration if the audio type changed in mid stream */
 	double mLastVideoFragParsedTimeMS;  /**< timestamp when last video fragment was parsed */
 
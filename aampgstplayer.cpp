@@ -31,8 +31,11 @@
 #include <stdlib.h>
 #include <stdio.h> // for sprintf
 #include "priv_aamp.h"
+#include "AampBufferPool.h"
 #include <pthread.h>
 #include <atomic>
+#include <vector>
+#include <algorithm>
 
 #ifdef __APPLE__
 #include "gst/video/videooverlay.h"
@@ -1871,30 +1874,124 @@ uint32_t getId3TagSize(const uint8_t *data, size_t &len0)
 }
 
 
+/**
+ * @struct FragmentMemoryContext
+ * @brief Fragment memory wrapped into a GstBuffer and the pool it is returned to
+ */
+struct FragmentMemoryContext
+{
+	std::shared_ptr<AampBufferPool> pool;
+	char *ptr;
+	size_t avail;
+};
+
 
 /**
- * @brief Inject buffer of a stream type to its pipeline
+ * @brief Release callback for fragment memory wrapped into a GstBuffer
+ * @param[in] data FragmentMemoryContext of the wrapped memory
+ */
+static void AAMPGstPlayer_ReleaseFragmentMemory(gpointer data)
+{
+	FragmentMemoryContext *context = (FragmentMemoryContext *)data;
+	context->pool->Release(context->ptr, context->avail);
+	delete context;
+}
+
+
+/**
+ * @brief Wrap fragment memory into a GstBuffer without copying it
+ * @param[in] aamp AAMP instance, owner of the buffer pool
+ * @param[in] ptr fragment memory, ownership is taken by the GstBuffer
+ * @param[in] len length of data
+ * @param[in] avail allocated size of memory
+ * @param[in] pts PTS of buffer
+ * @param[in] dts DTS of buffer
+ * @param[in] duration duration of buffer
+ * @retval GstBuffer wrapping the memory
+ */
+static GstBuffer* AAMPGstPlayer_WrapFragmentMemory(PrivateInstanceAAMP *aamp, char *ptr, size_t len, size_t avail,
+		GstClockTime pts, GstClockTime dts, GstClockTime duration)
+{
+	// Wrap fragment memory as is (no copy); memory goes back to the pool once downstream drops the buffer
+	FragmentMemoryContext *memoryContext = new FragmentMemoryContext();
+	memoryContext->pool = aamp->GetBufferPool();
+	memoryContext->ptr = ptr;
+	memoryContext->avail = avail;
+#ifdef USE_GST1
+	GstBuffer* buffer = gst_buffer_new_wrapped_full((GstMemoryFlags)0, ptr, avail, 0, len,
+						memoryContext, AAMPGstPlayer_ReleaseFragmentMemory);
+	GST_BUFFER_PTS(buffer) = pts;
+	GST_BUFFER_DTS(buffer) = dts;
+#else
+	// Free function is called with malloc data on finalize, which holds the context instead of the memory
+	GstBuffer* buffer = gst_buffer_new();
+	GST_BUFFER_SIZE (buffer) = len;
+	GST_BUFFER_DATA (buffer) = (guint8*)ptr;
+	GST_BUFFER_MALLOCDATA (buffer) = (guint8*)memoryContext;
+	GST_BUFFER_FREE_FUNC (buffer) = AAMPGstPlayer_ReleaseFragmentMemory;
+	GST_BUFFER_TIMESTAMP(buffer) = pts;
+	GST_BUFFER_DURATION(buffer) = duration;
+#endif
+	return buffer;
+}
+
+
+/**
+ * @brief Check result of pushing buffers to appsrc of a stream
+ * @param[in] privateContext player context
  * @param[in] mediaType stream type
- * @param[in] ptr buffer pointer
- * @param[in] len0 length of buffer
- * @param[in] fpts PTS of buffer (in sec)
- * @param[in] fdts DTS of buffer (in sec)
- * @param[in] fDuration duration of buffer (in sec)
+ * @param[in] ret result of push
  */
-void AAMPGstPlayer::Send(MediaType mediaType, const void *ptr, size_t len0, double fpts, double fdts, double fDuration)
+static void AAMPGstPlayer_CheckPushResult(AAMPGstPlayerPriv *privateContext, MediaType mediaType, GstFlowReturn ret)
 {
+	if (ret != GST_FLOW_OK)
+	{
+		logprintf("gst_app_src_push_buffer error: %d[%s] mediaType %d", ret, gst_flow_get_name (ret), (int)mediaType);
+		assert(false);
+	}
+	else if (privateContext->stream[mediaType].bufferUnderrun)
+	{
+		privateContext->stream[mediaType].bufferUnderrun = false;
+	}
+}
+
+
 #define MAX_BYTES_TO_SEND (128*1024)
-	GstClockTime pts = (GstClockTime)(fpts * GST_SECOND);
-	GstClockTime dts = (GstClockTime)(fdts * GST_SECOND);
-	GstClockTime duration = (GstClockTime)(fDuration * 1000000000LL);
 
-	if (aamp->GetEventListenerStatus(AAMP_EVENT_ID3_METADATA) &&
-		hasId3Header(mediaType, privateContext->stream[eMEDIATYPE_AUDIO].format,
-								static_cast<const uint8_t*>(ptr), len0))
+/**
+ * @brief Get max bytes to push to appsrc in one buffer
+ * @param[in] privateContext player context
+ * @param[in] len length of data to push
+ * @retval max bytes in one buffer
+ */
+static size_t AAMPGstPlayer_GetMaxBytesToSend(AAMPGstPlayerPriv *privateContext, size_t len)
+{
+	if (privateContext->stream[eMEDIATYPE_VIDEO].format == FORMAT_ISO_BMFF)
+	{
+		//For mpeg-dash, sent the entire fragment.
+		return len;
+	}
+	//For Dash, if using playersinkbin, broadcom plugins has buffer size limitation.
+	return MAX_BYTES_TO_SEND;
+}
+
+
+/**
+ * @brief Schedule ID3 metadata event if buffer starts with an ID3 tag
+ * @param[in] _this player instance
+ * @param[in] mediaType stream type
+ * @param[in] ptr buffer pointer
+ * @param[in] len length of buffer
+ */
+static void AAMPGstPlayer_CheckForId3Metadata(AAMPGstPlayer *_this, MediaType mediaType, const void *ptr, size_t len)
+{
+	if (_this->aamp->GetEventListenerStatus(AAMP_EVENT_ID3_METADATA) &&
+		hasId3Header(mediaType, _this->privateContext->stream[eMEDIATYPE_AUDIO].format,
+								static_cast<const uint8_t*>(ptr), len))
 	{
 		Id3CallbackData* id3Metadata = new Id3CallbackData;
-		id3Metadata->_this = this;
-		id3Metadata->len = getId3TagSize(static_cast<const uint8_t*>(ptr), len0);
+		id3Metadata->_this = _this;
+		id3Metadata->len = getId3TagSize(static_cast<const uint8_t*>(ptr), len);
 		if (id3Metadata->len) {
 			id3Metadata->data = (uint8_t*)g_malloc(id3Metadata->len);
 			//TODO: Consider maximum length for ID3 data - spec allows 256MB
@@ -1902,26 +1999,73 @@ void AAMPGstPlayer::Send(MediaType mediaType, const void *ptr, size_t len0, doub
 				memcpy(id3Metadata->data, ptr, id3Metadata->len);
 			}
 
-			privateContext->id3MetadataCallbackTaskPending = true;
-			privateContext->id3MetadataCallbackIdleTaskId = g_idle_add(IdleCallbackOnId3Metadata, id3Metadata);
+			_this->privateContext->id3MetadataCallbackTaskPending = true;
+			_this->privateContext->id3MetadataCallbackIdleTaskId = g_idle_add(IdleCallbackOnId3Metadata, id3Metadata);
 		}
 	}
+}
 
-	gboolean discontinuity = FALSE;
-	size_t maxBytes;
-	GstFlowReturn ret;
-	bool isFirstBuffer = privateContext->stream[mediaType].resetPosition;
 
-	if (privateContext->stream[eMEDIATYPE_VIDEO].format == FORMAT_ISO_BMFF)
+/**
+ * @brief Split a buffer wrapping fragment memory into buffers of at most maxBytes
+ *
+ * Chunks share the wrapped memory, which is released once the last chunk is dropped.
+ *
+ * @param[in] buffer buffer to split, reference is taken over
+ * @param[in] maxBytes max bytes in one buffer
+ * @param[out] chunks buffers to push, in order
+ */
+static void AAMPGstPlayer_SplitBuffer(GstBuffer *buffer, size_t maxBytes, std::vector<GstBuffer*> &chunks)
+{
+#ifdef USE_GST1
+	size_t len0 = gst_buffer_get_size(buffer);
+#else
+	size_t len0 = GST_BUFFER_SIZE(buffer);
+#endif
+	if (len0 <= maxBytes)
 	{
-		//For mpeg-dash, sent the entire fragment.
-		maxBytes = len0;
+		chunks.push_back(buffer);
+		return;
 	}
-	else
+	for (size_t offset = 0; offset < len0; offset += maxBytes)
 	{
-		//For Dash, if using playersinkbin, broadcom plugins has buffer size limitation.
-		maxBytes = MAX_BYTES_TO_SEND;
+		size_t len = std::min(maxBytes, len0 - offset);
+#ifdef USE_GST1
+		GstBuffer *chunk = gst_buffer_copy_region(buffer, GST_BUFFER_COPY_MEMORY, offset, len);
+		GST_BUFFER_PTS(chunk) = GST_BUFFER_PTS(buffer);
+		GST_BUFFER_DTS(chunk) = GST_BUFFER_DTS(buffer);
+#else
+		GstBuffer *chunk = gst_buffer_create_sub(buffer, offset, len);
+		GST_BUFFER_TIMESTAMP(chunk) = GST_BUFFER_TIMESTAMP(buffer);
+		GST_BUFFER_DURATION(chunk) = GST_BUFFER_DURATION(buffer);
+#endif
+		chunks.push_back(chunk);
 	}
+	gst_buffer_unref(buffer);
+}
+
+
+/**
+ * @brief Inject buffer of a stream type to its pipeline
+ * @param[in] mediaType stream type
+ * @param[in] ptr buffer pointer
+ * @param[in] len0 length of buffer
+ * @param[in] fpts PTS of buffer (in sec)
+ * @param[in] fdts DTS of buffer (in sec)
+ * @param[in] fDuration duration of buffer (in sec)
+ */
+void AAMPGstPlayer::Send(MediaType mediaType, const void *ptr, size_t len0, double fpts, double fdts, double fDuration)
+{
+	GstClockTime pts = (GstClockTime)(fpts * GST_SECOND);
+	GstClockTime dts = (GstClockTime)(fdts * GST_SECOND);
+	GstClockTime duration = (GstClockTime)(fDuration * 1000000000LL);
+
+	AAMPGstPlayer_CheckForId3Metadata(this, mediaType, ptr, len0);
+
+	gboolean discontinuity = FALSE;
+	size_t maxBytes = AAMPGstPlayer_GetMaxBytesToSend(privateContext, len0);
+	GstFlowReturn ret;
+	bool isFirstBuffer = privateContext->stream[mediaType].resetPosition;
 #ifdef TRACE_VID_PTS
 	if (mediaType == eMEDIATYPE_VIDEO && privateContext->rate != AAMP_NORMAL_PLAY_RATE)
 	{
@@ -1951,6 +2095,10 @@ void AAMPGstPlayer::Send(MediaType mediaType, const void *ptr, size_t len0, doub
 		discontinuity = TRUE;
 	}
 
+#if defined(USE_GST1) && GST_CHECK_VERSION(1,14,0)
+	// Chunks of a buffer bigger than maxBytes are pushed together
+	GstBufferList *bufferList = (len0 > maxBytes) ? gst_buffer_list_new_sized((len0 + maxBytes - 1) / maxBytes) : NULL;
+#endif
 	while (aamp->DownloadsAreEnabled())
 	{
 		size_t len = len0;
@@ -1977,15 +2125,16 @@ void AAMPGstPlayer::Send(MediaType mediaType, const void *ptr, size_t len0, doub
 		GST_BUFFER_TIMESTAMP(buffer) = pts;
 		GST_BUFFER_DURATION(buffer) = duration;
 #endif
-		ret = gst_app_src_push_buffer(GST_APP_SRC(privateContext->stream[mediaType].source), buffer);
-		if (ret != GST_FLOW_OK)
+#if defined(USE_GST1) && GST_CHECK_VERSION(1,14,0)
+		if (bufferList)
 		{
-			logprintf("gst_app_src_push_buffer error: %d[%s] mediaType %d", ret, gst_flow_get_name (ret), (int)mediaType);
-			assert(false);
+			gst_buffer_list_add(bufferList, buffer);
 		}
-		else if (privateContext->stream[mediaType].bufferUnderrun)
+		else
+#endif
 		{
-			privateContext->stream[mediaType].bufferUnderrun = false;
+			ret = gst_app_src_push_buffer(GST_APP_SRC(privateContext->stream[mediaType].source), buffer);
+			AAMPGstPlayer_CheckPushResult(privateContext, mediaType, ret);
 		}
 		ptr = len + (unsigned char *)ptr;
 		len0 -= len;
@@ -1994,6 +2143,20 @@ void AAMPGstPlayer::Send(MediaType mediaType, const void *ptr, size_t len0, doub
 			break;
 		}
 	}
+#if defined(USE_GST1) && GST_CHECK_VERSION(1,14,0)
+	if (bufferList)
+	{
+		if (gst_buffer_list_length(bufferList) > 0)
+		{
+			ret = gst_app_src_push_buffer_list(GST_APP_SRC(privateContext->stream[mediaType].source), bufferList);
+			AAMPGstPlayer_CheckPushResult(privateContext, mediaType, ret);
+		}
+		else
+		{
+			gst_buffer_list_unref(bufferList);
+		}
+	}
+#endif
 	if (eMEDIATYPE_VIDEO == mediaType)
 	{
 		// DELIA-42262: For westerossink, it will send first-video-frame-callback signal after each flush
@@ -2024,6 +2187,14 @@ void AAMPGstPlayer::Send(MediaType mediaType, GrowableBuffer* pBuffer, double fp
 	gboolean discontinuity = FALSE;
 	bool isFirstBuffer = privateContext->stream[mediaType].resetPosition;
 
+	if (!aamp->DownloadsAreEnabled())
+	{
+		// Flush or stop in progress, ownership is still taken
+		aamp->GetBufferPool()->Release(pBuffer);
+		return;
+	}
+	AAMPGstPlayer_CheckForId3Metadata(this, mediaType, pBuffer->ptr, pBuffer->len);
+
 #ifdef TRACE_VID_PTS
 	if (mediaType == eMEDIATYPE_VIDEO && privateContext->rate != AAMP_NORMAL_PLAY_RATE)
 	{
@@ -2053,28 +2224,35 @@ void AAMPGstPlayer::Send(MediaType mediaType, GrowableBuffer* pBuffer, double fp
 		discontinuity = TRUE;
 	}
 
-#ifdef USE_GST1
-	GstBuffer* buffer = gst_buffer_new_wrapped (pBuffer->ptr ,pBuffer->len);
-	GST_BUFFER_PTS(buffer) = pts;
-	GST_BUFFER_DTS(buffer) = dts;
-#else
-	GstBuffer* buffer = gst_buffer_new();
-	GST_BUFFER_SIZE (buffer) = pBuffer->len;
-	GST_BUFFER_MALLOCDATA (buffer) = (guint8*)pBuffer->ptr;
-	GST_BUFFER_DATA (buffer) = GST_BUFFER_MALLOCDATA (buffer);
-	GST_BUFFER_TIMESTAMP(buffer) = pts;
-	GST_BUFFER_DURATION(buffer) = duration;
-#endif
+	GstBuffer* buffer = AAMPGstPlayer_WrapFragmentMemory(aamp, pBuffer->ptr, pBuffer->len, pBuffer->avail, pts, dts, duration);
+	std::vector<GstBuffer*> chunks;
+	AAMPGstPlayer_SplitBuffer(buffer, AAMPGstPlayer_GetMaxBytesToSend(privateContext, pBuffer->len), chunks);
+	if (discontinuity)
+	{
+		GST_BUFFER_FLAG_SET(chunks.front(), GST_BUFFER_FLAG_DISCONT);
+	}
 
-	GstFlowReturn ret = gst_app_src_push_buffer(GST_APP_SRC(privateContext->stream[mediaType].source), buffer);
-	if (ret != GST_FLOW_OK)
+	GstFlowReturn ret;
+#if defined(USE_GST1) && GST_CHECK_VERSION(1,14,0)
+	if (chunks.size() > 1)
 	{
-		logprintf("gst_app_src_push_buffer error: %d[%s] mediaType %d", ret, gst_flow_get_name (ret), (int)mediaType);
-		assert(false);
+		// Chunks of a buffer bigger than maxBytes are pushed together
+		GstBufferList *bufferList = gst_buffer_list_new_sized(chunks.size());
+		for (GstBuffer *chunk : chunks)
+		{
+			gst_buffer_list_add(bufferList, chunk);
+		}
+		ret = gst_app_src_push_buffer_list(GST_APP_SRC(privateContext->stream[mediaType].source), bufferList);
+		AAMPGstPlayer_CheckPushResult(privateContext, mediaType, ret);
 	}
-	else if (privateContext->stream[mediaType].bufferUnderrun)
+	else
+#endif
 	{
-		privateContext->stream[mediaType].bufferUnderrun = false;
+		for (GstBuffer *chunk : chunks)
+		{
+			ret = gst_app_src_push_buffer(GST_APP_SRC(privateContext->stream[mediaType].source), chunk);
+			AAMPGstPlayer_CheckPushResult(privateContext, mediaType, ret);
+		}
 	}
 
 	/*Since ownership of buffer is given to gstreamer, reset pBuffer */
@@ -2094,6 +2272,76 @@ void AAMPGstPlayer::Send(MediaType mediaType, GrowableBuffer* pBuffer, double fp
 }
 
 
+/**
+ * @brief Inject a batch of buffers of a stream type to its pipeline
+ * @param[in] mediaType stream type
+ * @param[in,out] buffers buffers in presentation order, ownership of memory is taken and list is cleared
+ */
+void AAMPGstPlayer::SendBatch(MediaType mediaType, std::vector<StreamSinkBuffer>& buffers)
+{
+#if defined(USE_GST1) && GST_CHECK_VERSION(1,14,0)
+	if (buffers.empty())
+	{
+		return;
+	}
+	if (!aamp->DownloadsAreEnabled())
+	{
+		// Flush or stop in progress, ownership is still taken
+		for (StreamSinkBuffer &entry : buffers)
+		{
+			aamp->GetBufferPool()->Release(entry.ptr, entry.avail);
+		}
+		buffers.clear();
+		return;
+	}
+	bool isFirstBuffer = privateContext->stream[mediaType].resetPosition;
+	bool discontinuity = isFirstBuffer;
+	// Whole batch goes in with one appsrc lock and one round of signals
+	GstBufferList *bufferList = gst_buffer_list_new_sized(buffers.size());
+	std::vector<GstBuffer*> chunks;
+	for (StreamSinkBuffer &entry : buffers)
+	{
+		GstClockTime pts = (GstClockTime)(entry.fpts * GST_SECOND);
+		GstClockTime dts = (GstClockTime)(entry.fdts * GST_SECOND);
+		GstClockTime duration = (GstClockTime)(entry.duration * 1000000000LL);
+		AAMPGstPlayer_CheckForId3Metadata(this, mediaType, entry.ptr, entry.len);
+		GstBuffer* buffer = AAMPGstPlayer_WrapFragmentMemory(aamp, entry.ptr, entry.len, entry.avail, pts, dts, duration);
+		chunks.clear();
+		AAMPGstPlayer_SplitBuffer(buffer, AAMPGstPlayer_GetMaxBytesToSend(privateContext, entry.len), chunks);
+		if (discontinuity)
+		{
+			AAMPGstPlayer_SendPendingEvents(aamp, privateContext, mediaType, pts);
+			GST_BUFFER_FLAG_SET(chunks.front(), GST_BUFFER_FLAG_DISCONT);
+			discontinuity = false;
+		}
+		for (GstBuffer *chunk : chunks)
+		{
+			gst_buffer_list_add(bufferList, chunk);
+		}
+	}
+
+	GstFlowReturn ret = gst_app_src_push_buffer_list(GST_APP_SRC(privateContext->stream[mediaType].source), bufferList);
+	AAMPGstPlayer_CheckPushResult(privateContext, mediaType, ret);
+
+	if (eMEDIATYPE_VIDEO == mediaType)
+	{
+		// DELIA-42262: For westerossink, it will send first-video-frame-callback signal after each flush
+		// So we can move NotifyFirstBufferProcessed to the more accurate signal callback
+		if (isFirstBuffer && !privateContext->using_westerossink)
+		{
+			aamp->NotifyFirstBufferProcessed();
+		}
+		privateContext->numberOfVideoBuffersSent += buffers.size();
+		StopBuffering(false);
+	}
+	buffers.clear();
+#else
+	// appsrc buffer lists need GStreamer 1.14
+	StreamSink::SendBatch(mediaType, buffers);
+#endif
+}
+
+
 
 /**
  * @brief To start playback
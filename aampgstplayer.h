@@ -46,6 +46,7 @@ public:
 	void Configure(StreamOutputFormat format, StreamOutputFormat audioFormat, bool bESChangeStatus);
 	void Send(MediaType mediaType, const void *ptr, size_t len, double fpts, double fdts, double duration);
 	void Send(MediaType mediaType, GrowableBuffer* buffer, double fpts, double fdts, double duration);
+	void SendBatch(MediaType mediaType, std::vector<StreamSinkBuffer>& buffers);
 	void EndOfStreamReached(MediaType type);
 	void Stream(void);
 	void Stop(bool keepLastFrame);
@@ -43,16 +43,7 @@ static char gAampCliCfg[] = "c:/tmp/aampcli.cfg";
 
 /*-----------------------------------------------------------------------------------------------------*/
 bool AampLogManager::disableLogRedirection = false;
-
-/**
- * @brief To check the given log level is allowed to print mechanism
- * @param[in] chkLevel - log level
- * @retval true if the log level allowed for print mechanism
- */
-bool AampLogManager::isLogLevelAllowed(AAMP_LogLevel chkLevel)
-{
-	return (chkLevel>=aampLoglevel);
-}
+bool AampLogManager::asyncLogging = false;
 
 /**
  * @brief Set the log level for print mechanism
@@ -430,37 +421,25 @@ bool AampLogManager::isLogworthyErrorCode(int errorCode)
 }
 
 /**
- * @brief Print logs to console / log file
- * @param[in] format - printf style string
+ * @brief Write a log line to the configured sink
+ * @param[in] line - log line
+ * @param[in] time - time of logging
  * @retuen void
  */
-void logprintf(const char *format, ...)
+void aamp_WriteLogLine(const char *line, const struct timeval &time)
 {
-	int len = 0;
-	va_list args;
-	va_start(args, format);
-
-	char gDebugPrintBuffer[MAX_DEBUG_LOG_BUFF_SIZE];
-	len = sprintf(gDebugPrintBuffer, "[AAMP-PLAYER]");
-	vsnprintf(gDebugPrintBuffer+len, MAX_DEBUG_LOG_BUFF_SIZE-len, format, args);
-	gDebugPrintBuffer[(MAX_DEBUG_LOG_BUFF_SIZE-1)] = 0;
-
-	va_end(args);
-
 #if (defined (USE_SYSTEMD_JOURNAL_PRINT) || defined (USE_SYSLOG_HELPER_PRINT))
 	if(!AampLogManager::disableLogRedirection)
 	{
 #ifdef USE_SYSTEMD_JOURNAL_PRINT
-		sd_journal_print(LOG_NOTICE, "%s", gDebugPrintBuffer);
+		sd_journal_print(LOG_NOTICE, "%s", line);
 #else
-		send_logs_to_syslog(gDebugPrintBuffer);
+		send_logs_to_syslog((char *)line);
 #endif
 	}
 	else
 	{
-		struct timeval t;
-		gettimeofday(&t, NULL);
-		printf("%ld:%3ld : %s\n", (long int)t.tv_sec, (long int)t.tv_usec / 1000, gDebugPrintBuffer);
+		printf("%ld:%3ld : %s\n", (long int)time.tv_sec, (long int)time.tv_usec / 1000, line);
 	}
 #else  //USE_SYSTEMD_JOURNAL_PRINT
 #ifdef WIN32
@@ -470,19 +449,71 @@ void logprintf(const char *format, ...)
 	if (f)
 	{
 		init = true;
-		fputs(gDebugPrintBuffer, f);
+		fputs(line, f);
 		fclose(f);
 	}
 
-	printf("%s\n", gDebugPrintBuffer);
+	printf("%s\n", line);
 #else
-	struct timeval t;
-	gettimeofday(&t, NULL);
-	printf("%ld:%3ld : %s\n", (long int)t.tv_sec, (long int)t.tv_usec / 1000, gDebugPrintBuffer);
+	printf("%ld:%3ld : %s\n", (long int)time.tv_sec, (long int)time.tv_usec / 1000, line);
 #endif
 #endif
 }
 
+/**
+ * @brief Print logs to console / log file
+ * @param[in] droppable - true if line may be dropped when asynchronous log queue is full
+ * @param[in] format - printf style string
+ * @param[in] args - arguments
+ * @retuen void
+ */
+static void vlogprintf(bool droppable, const char *format, va_list args)
+{
+	int len = 0;
+	char gDebugPrintBuffer[MAX_DEBUG_LOG_BUFF_SIZE];
+	len = sprintf(gDebugPrintBuffer, "[AAMP-PLAYER]");
+	vsnprintf(gDebugPrintBuffer+len, MAX_DEBUG_LOG_BUFF_SIZE-len, format, args);
+	gDebugPrintBuffer[(MAX_DEBUG_LOG_BUFF_SIZE-1)] = 0;
+
+	if (AampLogManager::asyncLogging)
+	{
+		AampLogQueue::Push(gDebugPrintBuffer, droppable);
+	}
+	else
+	{
+		struct timeval t;
+		gettimeofday(&t, NULL);
+		aamp_WriteLogLine(gDebugPrintBuffer, t);
+	}
+}
+
+/**
+ * @brief Print logs to console / log file
+ * @param[in] format - printf style string
+ * @retuen void
+ */
+void logprintf(const char *format, ...)
+{
+	va_list args;
+	va_start(args, format);
+	vlogprintf(false, format, args);
+	va_end(args);
+}
+
+/**
+ * @brief Print logs of a level to console / log file
+ * @param[in] level - log level, trace and info logs may be dropped under asynchronous logging
+ * @param[in] format - printf style string
+ * @retuen void
+ */
+void aamp_LevelLogPrintf(AAMP_LogLevel level, const char *format, ...)
+{
+	va_list args;
+	va_start(args, format);
+	vlogprintf(level < eLOGLEVEL_WARN, format, args);
+	va_end(args);
+}
+
 /**
  * @brief Compactly log blobs of binary data
  *
@@ -24,6 +24,7 @@
 
 #include "admanager_mpd.h"
 #include "fragmentcollector_mpd.h"
+#include "AampTaskExecutor.h"
 #include <inttypes.h>
 
 #include <algorithm>
@@ -60,7 +61,7 @@ void CDAIObjectMPD::SetAlternateContents(const std::string &periodId, const std:
 
 
 
-PrivateCDAIObjectMPD::PrivateCDAIObjectMPD(PrivateInstanceAAMP* aamp) : mAamp(aamp),mDaiMtx(), mIsFogTSB(false), mAdBreaks(), mPeriodMap(), mCurPlayingBreakId(), mAdObjThreadID(0), mAdFailed(false), mCurAds(nullptr),
+PrivateCDAIObjectMPD::PrivateCDAIObjectMPD(PrivateInstanceAAMP* aamp) : mAamp(aamp),mDaiMtx(), mIsFogTSB(false), mAdBreaks(), mPeriodMap(), mCurPlayingBreakId(), mAdObjTask(), mAdFailed(false), mCurAds(nullptr),
 					mCurAdIdx(-1), mContentSeekOffset(0), mAdState(AdState::OUTSIDE_ADBREAK),mPlacementObj(), mAdFulfillObj()
 {
 	mAamp->CurlInit(eCURLINSTANCE_DAI,1,mAamp->GetNetworkProxy());
@@ -68,14 +69,9 @@ PrivateCDAIObjectMPD::PrivateCDAIObjectMPD(PrivateInstanceAAMP* aamp) : mAamp(aa
 
 PrivateCDAIObjectMPD::~PrivateCDAIObjectMPD()
 {
-	if(mAdObjThreadID)
+	if(mAdObjTask.valid())
 	{
-		int rc = pthread_join(mAdObjThreadID, NULL);
-		if (rc != 0)
-		{
-			logprintf("%s:%d ***pthread_join failed, returned %d", __FUNCTION__, __LINE__, rc);
-		}
-		mAdObjThreadID = 0;
+		mAdObjTask.wait();
 	}
 	mAamp->CurlTerm(eCURLINSTANCE_DAI);
 }
@@ -713,11 +709,11 @@ void PrivateCDAIObjectMPD::SetAlternateContents(const std::string &periodId, con
 	}
 	else
 	{
-		if(mAdObjThreadID)
+		if(mAdObjTask.valid())
 		{
-			//Clearing the previous thread
-			int rc = pthread_join(mAdObjThreadID, NULL);
-			mAdObjThreadID = 0;
+			//Waiting for the previous task
+			mAdObjTask.wait();
+			mAdObjTask = std::future<void>();
 		}
 		if(isAdBreakObjectExist(periodId))
 		{
@@ -733,11 +729,8 @@ void PrivateCDAIObjectMPD::SetAlternateContents(const std::string &periodId, con
 				mAdFulfillObj.periodId = periodId;
 				mAdFulfillObj.adId = adId;
 				mAdFulfillObj.url = url;
-				int ret = pthread_create(&mAdObjThreadID, NULL, &AdFulfillThreadEntry, this);
-				if(ret != 0)
-				{
-					logprintf("%s:%d pthread_create(FulFillAdObject) failed, errno = %d, %s. Rejecting promise.", __FUNCTION__, __LINE__, errno, strerror(errno));
-				}
+				PrivateCDAIObjectMPD *_this = this;
+				mAdObjTask = AampTaskExecutor::GetInstance()->Submit(eAAMP_TASK_PRIORITY_PLAYBACK, [_this]() { AdFulfillThreadEntry(_this); });
 			}
 			if(ret != 0)
 			{
@@ -27,6 +27,7 @@
 
 #include "AdManagerBase.h"
 #include <string>
+#include <future>
 #include "libdash/INode.h"
 #include "libdash/IDASHManager.h"
 #include "libdash/xml/Node.h"
@@ -285,7 +286,7 @@ public:
 	std::unordered_map<std::string, AdBreakObject> mAdBreaks;           /**< Periodid to adbreakobject map*/
 	std::unordered_map<std::string, Period2AdData> mPeriodMap;          /**< periodId to Ad map */
 	std::string                                    mCurPlayingBreakId;  /**< Currently playing Ad */
-	pthread_t                                      mAdObjThreadID;      /**< ThreadId of Ad fulfillment */
+	std::future<void>                              mAdObjTask;          /**< Ad fulfillment task */
 	bool                                           mAdFailed;           /**< Current Ad playback failed flag */
 	std::shared_ptr<std::vector<AdNode>>           mCurAds;             /**< Vector of ads from the current Adbreak */
 	int                                            mCurAdIdx;           /**< Currently playing Ad index */
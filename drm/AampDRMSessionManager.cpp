@@ -25,9 +25,11 @@
 
 #include "AampDRMSessionManager.h"
 #include "priv_aamp.h"
+#include "AampTaskExecutor.h"
 #include <pthread.h>
 #include "_base64.h"
 #include <iostream>
+#include <vector>
 //#define LOG_TRACE 1
 #define COMCAST_LICENCE_REQUEST_HEADER_ACCEPT "Accept: application/vnd.xcal.mds.licenseResponse+json; version=1"
 #define COMCAST_LICENCE_REQUEST_HEADER_CONTENT_TYPE "Content-Type: application/vnd.xcal.mds.licenseRequest+json; version=1"
@@ -45,15 +47,201 @@
 #define COMCAST_DRM_METADATA_TAG_END "</ckm:policy>"
 #define SESSION_TOKEN_URL "http://localhost:50050/authService/getSessionToken"
 #define MAX_LICENSE_REQUEST_ATTEMPTS 2
+#define MAX_POOLED_LICENSE_CURL_HANDLES 2   /**< Idle license curl handles kept for reuse, one per concurrent request */
+#define MAX_CACHED_LICENSES 8               /**< Licenses kept by key ID across tunes */
+#define CACHED_LICENSE_MAX_AGE_MS (30*60*1000) /**< Age after which a cached license is requested again from server */
 
 static const char *sessionTypeName[] = {"video", "audio"};
 
 static pthread_mutex_t drmSessionMutex = PTHREAD_MUTEX_INITIALIZER;
 
+/* License request curl handles, kept across requests and tunes so that license
+ * server connections and TLS sessions are reused instead of set up per request */
+static pthread_mutex_t licenseCurlMutex = PTHREAD_MUTEX_INITIALIZER;
+static std::vector<CURL*> licenseCurlPool;
+static CURLSH *licenseCurlShare = NULL;
+static pthread_mutex_t licenseCurlShareLocks[CURL_LOCK_DATA_LAST];
+
+/**
+ *  @struct	CachedLicense
+ *  @brief	License accepted by a DRM session, kept for sessions of the same key ID
+ */
+struct CachedLicense
+{
+	std::string data;
+	long long creationTime;
+
+	CachedLicense() : data(), creationTime(0)
+	{
+	}
+};
+
+/* Licenses by key system and key ID, kept across tunes and session managers so that
+ * a retune to content already licensed does not wait on the license server */
+static pthread_mutex_t licenseCacheMutex = PTHREAD_MUTEX_INITIALIZER;
+static std::map<std::string, CachedLicense> licenseCache;
+
 KeyID::KeyID() : len(0), data(NULL), creationTime(0), isFailedKeyId(false), isPrimaryKeyId(false)
 {
 }
 
+/**
+ *  @brief		Lock callback of license curl share handle
+ */
+static void licenseCurlShareLock(CURL *curl, curl_lock_data data, curl_lock_access access, void *userptr)
+{
+	(void)curl;
+	(void)access;
+	(void)userptr;
+	pthread_mutex_lock(&licenseCurlShareLocks[data]);
+}
+
+/**
+ *  @brief		Unlock callback of license curl share handle
+ */
+static void licenseCurlShareUnlock(CURL *curl, curl_lock_data data, void *userptr)
+{
+	(void)curl;
+	(void)userptr;
+	pthread_mutex_unlock(&licenseCurlShareLocks[data]);
+}
+
+/**
+ *  @brief		Get curl handle for license request, reusing an idle one if available.
+ *  			Handles share DNS, TLS session and, where supported, connection caches,
+ *  			so concurrent requests to the same server also avoid full handshakes.
+ *
+ *  @return		curl handle with default options
+ */
+static CURL* acquireLicenseCurl()
+{
+	CURL *curl = NULL;
+	pthread_mutex_lock(&licenseCurlMutex);
+	if (!licenseCurlShare)
+	{
+		for (int i = 0; i < CURL_LOCK_DATA_LAST; i++)
+		{
+			pthread_mutex_init(&licenseCurlShareLocks[i], NULL);
+		}
+		licenseCurlShare = curl_share_init();
+		curl_share_setopt(licenseCurlShare, CURLSHOPT_LOCKFUNC, licenseCurlShareLock);
+		curl_share_setopt(licenseCurlShare, CURLSHOPT_UNLOCKFUNC, licenseCurlShareUnlock);
+		curl_share_setopt(licenseCurlShare, CURLSHOPT_SHARE, CURL_LOCK_DATA_DNS);
+		curl_share_setopt(licenseCurlShare, CURLSHOPT_SHARE, CURL_LOCK_DATA_SSL_SESSION);
+#if LIBCURL_VERSION_NUM >= 0x073900
+		curl_share_setopt(licenseCurlShare, CURLSHOPT_SHARE, CURL_LOCK_DATA_CONNECT);
+#endif
+	}
+	if (!licenseCurlPool.empty())
+	{
+		curl = licenseCurlPool.back();
+		licenseCurlPool.pop_back();
+	}
+	pthread_mutex_unlock(&licenseCurlMutex);
+
+	if (curl)
+	{
+		// Options are cleared, live connections and TLS session cache are kept
+		curl_easy_reset(curl);
+	}
+	else
+	{
+		curl = curl_easy_init();
+	}
+	curl_easy_setopt(curl, CURLOPT_SHARE, licenseCurlShare);
+	curl_easy_setopt(curl, CURLOPT_NOSIGNAL, 1L);
+	curl_easy_setopt(curl, CURLOPT_TCP_KEEPALIVE, 1L);
+	return curl;
+}
+
+/**
+ *  @brief		Return curl handle of license request for reuse
+ *
+ *  @param[in]	curl - handle from acquireLicenseCurl
+ *  @return		void
+ */
+static void releaseLicenseCurl(CURL *curl)
+{
+	pthread_mutex_lock(&licenseCurlMutex);
+	if (licenseCurlPool.size() < MAX_POOLED_LICENSE_CURL_HANDLES)
+	{
+		licenseCurlPool.push_back(curl);
+		curl = NULL;
+	}
+	pthread_mutex_unlock(&licenseCurlMutex);
+	if (curl)
+	{
+		curl_easy_cleanup(curl);
+	}
+}
+
+/**
+ *  @brief		Get cached license of a key ID
+ *
+ *  @param[in]	cacheKey - key system and key ID
+ *  @return		copy of license to be freed by caller, NULL if not cached or too old
+ */
+static DrmData* getCachedLicense(const std::string &cacheKey)
+{
+	DrmData *license = NULL;
+	pthread_mutex_lock(&licenseCacheMutex);
+	std::map<std::string, CachedLicense>::iterator it = licenseCache.find(cacheKey);
+	if (it != licenseCache.end())
+	{
+		if (aamp_GetCurrentTimeMS() - it->second.creationTime < CACHED_LICENSE_MAX_AGE_MS)
+		{
+			license = new DrmData(reinterpret_cast<unsigned char*>(const_cast<char*>(it->second.data.c_str())), it->second.data.length());
+		}
+		else
+		{
+			licenseCache.erase(it);
+		}
+	}
+	pthread_mutex_unlock(&licenseCacheMutex);
+	return license;
+}
+
+/**
+ *  @brief		Cache license accepted by a DRM session, replacing oldest one if cache is full
+ *
+ *  @param[in]	cacheKey - key system and key ID
+ *  @param[in]	license - license processed by DRM session
+ *  @return		void
+ */
+static void cacheLicense(const std::string &cacheKey, DrmData *license)
+{
+	pthread_mutex_lock(&licenseCacheMutex);
+	if (licenseCache.size() >= MAX_CACHED_LICENSES && licenseCache.find(cacheKey) == licenseCache.end())
+	{
+		std::map<std::string, CachedLicense>::iterator oldest = licenseCache.begin();
+		for (std::map<std::string, CachedLicense>::iterator it = licenseCache.begin(); it != licenseCache.end(); it++)
+		{
+			if (it->second.creationTime < oldest->second.creationTime)
+			{
+				oldest = it;
+			}
+		}
+		licenseCache.erase(oldest);
+	}
+	CachedLicense &entry = licenseCache[cacheKey];
+	entry.data.assign(reinterpret_cast<const char*>(license->getData()), license->getDataLength());
+	entry.creationTime = aamp_GetCurrentTimeMS();
+	pthread_mutex_unlock(&licenseCacheMutex);
+}
+
+/**
+ *  @brief		Remove license rejected by a DRM session from cache
+ *
+ *  @param[in]	cacheKey - key system and key ID
+ *  @return		void
+ */
+static void removeCachedLicense(const std::string &cacheKey)
+{
+	pthread_mutex_lock(&licenseCacheMutex);
+	licenseCache.erase(cacheKey);
+	pthread_mutex_unlock(&licenseCacheMutex);
+}
+
 
 void *CreateDRMSession(void *arg);
 int SpawnDRMLicenseAcquireThread(PrivateInstanceAAMP *aamp, DrmSessionDataInfo* drmData);
@@ -101,7 +289,7 @@ AampDRMSessionManager::AampDRMSessionManager() : drmSessionContexts(new DrmSessi
 		cachedKeyIDs(new KeyID[gpGlobalConfig->dash_MaxDRMSessions]), accessToken(NULL),
 		accessTokenLen(0), sessionMgrState(SessionMgrState::eSESSIONMGR_ACTIVE), accessTokenMutex(PTHREAD_MUTEX_INITIALIZER),
 		cachedKeyMutex(PTHREAD_MUTEX_INITIALIZER)
-		,curlSessionAbort(false)
+		,curlSessionAbort(false), encryptionSchemes()
 {
 }
 
@@ -150,6 +338,74 @@ void AampDRMSessionManager::clearSessionData()
 		delete[] cachedKeyIDs;
 		cachedKeyIDs = NULL;
 	}
+	encryptionSchemes.clear();
+}
+
+/**
+ *  @brief		Apply encryption scheme set for keyId to a new DRM session.
+ *
+ *  @param[in]	drmSession - session to be bound to init data of keyId.
+ *  @param[in]	keyId - key ID.
+ *  @param[in]	keyIdLen - key ID length.
+ *  @return		void.
+ */
+void AampDRMSessionManager::applyEncryptionScheme(AampDrmSession *drmSession, const unsigned char *keyId, int keyIdLen)
+{
+	pthread_mutex_lock(&cachedKeyMutex);
+	std::map<std::string, AampEncryptionScheme>::iterator schemeIt = encryptionSchemes.find(std::string(reinterpret_cast<const char*>(keyId), keyIdLen));
+	if (schemeIt != encryptionSchemes.end())
+	{
+		drmSession->setEncryptionScheme(schemeIt->second.cbcs, schemeIt->second.cryptByteBlock, schemeIt->second.skipByteBlock);
+	}
+	pthread_mutex_unlock(&cachedKeyMutex);
+}
+
+/**
+ *  @brief		Set encryption scheme of content protected with keyId.
+ *  			Applied to the session of keyId now if it exists,
+ *  			else when the session is created.
+ *
+ *  @param[in]	keyId - default key ID from tenc.
+ *  @param[in]	keyIdLen - key ID length.
+ *  @param[in]	scheme - encryption scheme from schm and tenc.
+ *  @return		void.
+ */
+void AampDRMSessionManager::setEncryptionScheme(const unsigned char *keyId, size_t keyIdLen, const AampEncryptionScheme &scheme)
+{
+	int sessionSlot = -1;
+	std::string key(reinterpret_cast<const char*>(keyId), keyIdLen);
+
+	pthread_mutex_lock(&cachedKeyMutex);
+	std::map<std::string, AampEncryptionScheme>::iterator it = encryptionSchemes.find(key);
+	if (it != encryptionSchemes.end() && it->second.cbcs == scheme.cbcs &&
+		it->second.cryptByteBlock == scheme.cryptByteBlock && it->second.skipByteBlock == scheme.skipByteBlock)
+	{
+		// Same init segment info on every period and profile switch
+		pthread_mutex_unlock(&cachedKeyMutex);
+		return;
+	}
+	encryptionSchemes[key] = scheme;
+	for (int i = 0; i < gpGlobalConfig->dash_MaxDRMSessions; i++)
+	{
+		if (keyIdLen == cachedKeyIDs[i].len && 0 == memcmp(cachedKeyIDs[i].data, keyId, keyIdLen))
+		{
+			sessionSlot = i;
+			break;
+		}
+	}
+	pthread_mutex_unlock(&cachedKeyMutex);
+
+	AAMPLOG_INFO("%s:%d scheme %s pattern %d:%d slot %d", __FUNCTION__, __LINE__, scheme.cbcs ? "cbcs" : "cenc",
+				scheme.cryptByteBlock, scheme.skipByteBlock, sessionSlot);
+	if (sessionSlot >= 0)
+	{
+		pthread_mutex_lock(&(drmSessionContexts[sessionSlot].sessionMutex));
+		if (drmSessionContexts[sessionSlot].drmSession)
+		{
+			drmSessionContexts[sessionSlot].drmSession->setEncryptionScheme(scheme.cbcs, scheme.cryptByteBlock, scheme.skipByteBlock);
+		}
+		pthread_mutex_unlock(&(drmSessionContexts[sessionSlot].sessionMutex));
+	}
 }
 
 /**
@@ -444,7 +700,7 @@ DrmData * AampDRMSessionManager::getLicense(DrmData * keyChallenge,
 	const long challegeLength = keyChallenge->getDataLength();
 	char* destURL = new char[destinationURL.length() + 1];
 	long long downloadTimeMS = 0;
-	curl = curl_easy_init();
+	curl = acquireLicenseCurl();
 	if (customHeader != NULL)
 	{
 		headers = customHeader;
@@ -605,7 +861,7 @@ DrmData * AampDRMSessionManager::getLicense(DrmData * keyChallenge,
 	delete destURL;
         delete callbackData;
 	curl_slist_free_all(headers);
-	curl_easy_cleanup(curl);
+	releaseLicenseCurl(curl);
 
 	return keyInfo;
 }
@@ -890,6 +1146,8 @@ AampDrmSession * AampDRMSessionManager::createDrmSession(
 	}
 
 
+	applyEncryptionScheme(drmSessionContexts[sessionSlot].drmSession, keyId, keyIdLen);
+
 	drmSessionContexts[sessionSlot].drmSession->generateAampDRMSession(initDataPtr, dataLength);
 	code = drmSessionContexts[sessionSlot].drmSession->getState();
 	if(code == KEY_ERROR_EMPTY_SESSION_ID)
@@ -914,6 +1172,35 @@ AampDrmSession * AampDRMSessionManager::createDrmSession(
 	DrmData * licenceChallenge = drmSessionContexts[sessionSlot].drmSession->aampGenerateKeyRequest(
 			destinationURL);
 	code = drmSessionContexts[sessionSlot].drmSession->getState();
+
+	std::string licenseCacheKey = std::string(keySystem ? keySystem : "") + std::string(reinterpret_cast<const char*>(keyId), keyIdLen);
+	DrmData * cachedLicense = (code == KEY_PENDING) ? getCachedLicense(licenseCacheKey) : NULL;
+	if (cachedLicense)
+	{
+		aamp->profiler.ProfileEnd(PROFILE_BUCKET_LA_PREPROC);
+		AAMPLOG_INFO("%s:%d Using cached license for %s stream", __FUNCTION__, __LINE__, sessionTypeName[streamType]);
+		aamp->profiler.ProfileBegin(PROFILE_BUCKET_LA_POSTPROC);
+		processKeyRetValue = drmSessionContexts[sessionSlot].drmSession->aampDRMProcessKey(cachedLicense);
+		aamp->profiler.ProfileEnd(PROFILE_BUCKET_LA_POSTPROC);
+		delete cachedLicense;
+		code = drmSessionContexts[sessionSlot].drmSession->getState();
+		if (code != KEY_READY)
+		{
+			logprintf("%s:%d Cached license rejected for %s stream: Key State %d, requesting license from server",
+						__FUNCTION__, __LINE__, sessionTypeName[streamType], code);
+			removeCachedLicense(licenseCacheKey);
+			processKeyRetValue = -1;
+			// Session that rejected a license is not reused for the license request
+			delete licenceChallenge;
+			delete drmSessionContexts[sessionSlot].drmSession;
+			drmSessionContexts[sessionSlot].drmSession = AampDrmSessionFactory::GetDrmSession(systemId);
+			applyEncryptionScheme(drmSessionContexts[sessionSlot].drmSession, keyId, keyIdLen);
+			drmSessionContexts[sessionSlot].drmSession->generateAampDRMSession(initDataPtr, dataLength);
+			licenceChallenge = drmSessionContexts[sessionSlot].drmSession->aampGenerateKeyRequest(destinationURL);
+			code = drmSessionContexts[sessionSlot].drmSession->getState();
+		}
+	}
+
 	if (code == KEY_PENDING)
 	{
 		aamp->profiler.ProfileEnd(PROFILE_BUCKET_LA_PREPROC);
@@ -1180,6 +1467,10 @@ AampDrmSession * AampDRMSessionManager::createDrmSession(
 			aamp->profiler.ProfileBegin(PROFILE_BUCKET_LA_POSTPROC);
 			processKeyRetValue = drmSessionContexts[sessionSlot].drmSession->aampDRMProcessKey(key);
 			aamp->profiler.ProfileEnd(PROFILE_BUCKET_LA_POSTPROC);
+			if (drmSessionContexts[sessionSlot].drmSession->getState() == KEY_READY)
+			{
+				cacheLicense(licenseCacheKey, key);
+			}
 		}
 		else
 		{
@@ -1220,7 +1511,7 @@ AampDrmSession * AampDRMSessionManager::createDrmSession(
 			delete key;
 		}
 	}
-	else
+	else if (code != KEY_READY)
 	{
 		logprintf("%s:%d Error in getting license challenge for %s stream : Key State %d ",
 					__FUNCTION__, __LINE__, sessionTypeName[streamType], code);
@@ -1285,16 +1576,10 @@ AampDrmSession * AampDRMSessionManager::createDrmSession(
  */
 void ReleaseDRMLicenseAcquireThread(PrivateInstanceAAMP *aamp){
 		
-	if(aamp->drmSessionThreadStarted) //In the case of license rotation
+	if(aamp->createDRMSessionTask.valid()) //In the case of license rotation
 	{
-		void *value_ptr = NULL;
-		int rc = pthread_join(aamp->createDRMSessionThreadID, &value_ptr);
-		if (rc != 0)
-		{
-			AAMPLOG_WARN("%s:%d pthread_join returned %d for createDRMSession Thread", 
-			__FUNCTION__, __LINE__, rc);
-		}
-		aamp->drmSessionThreadStarted = false;
+		aamp->createDRMSessionTask.wait();
+		aamp->createDRMSessionTask = std::future<void>();
 	}
 }
 
@@ -1317,21 +1602,13 @@ int SpawnDRMLicenseAcquireThread(PrivateInstanceAAMP *aamp, DrmSessionDataInfo*
 		}
 		/** Achieve single thread logic for DRM Session Creation **/
 		ReleaseDRMLicenseAcquireThread(aamp);
-		AAMPLOG_INFO("%s:%d Creating thread with sessionData = 0x%08x",
+		AAMPLOG_INFO("%s:%d Creating task with sessionData = 0x%08x",
 					__FUNCTION__, __LINE__, drmData->sessionData );
-        if(0 == pthread_create(&aamp->createDRMSessionThreadID, NULL,\
-		 CreateDRMSession, drmData->sessionData))
-		{
-			drmData->isProcessedLicenseAcquire = true;
-			aamp->drmSessionThreadStarted = true;
-			aamp->setCurrentDrm(drmData->drmType);
-			iState = DRM_API_SUCCESS;
-		}
-		else
-		{
-			AAMPLOG_ERR("%s:%d pthread_create failed for CreateDRMSession : error code %d, %s", 
-			__FUNCTION__, __LINE__, errno, strerror(errno));
-		}
+		void *sessionData = drmData->sessionData;
+		aamp->createDRMSessionTask = AampTaskExecutor::GetInstance()->Submit(eAAMP_TASK_PRIORITY_TUNE, [sessionData]() { CreateDRMSession(sessionData); });
+		drmData->isProcessedLicenseAcquire = true;
+		aamp->setCurrentDrm(drmData->drmType);
+		iState = DRM_API_SUCCESS;
 	}while(0);
 
 	return iState;
@@ -30,6 +30,7 @@
 #include "AampDRMutils.h"
 #include "main_aamp.h"
 #include <string>
+#include <map>
 #include <curl/curl.h>
 
 #ifdef USE_SECCLIENT
@@ -124,6 +125,7 @@ private:
 	pthread_mutex_t accessTokenMutex;
 	pthread_mutex_t cachedKeyMutex;
 	bool curlSessionAbort;
+	std::map<std::string, AampEncryptionScheme> encryptionSchemes;
 
 	AampDRMSessionManager(const AampDRMSessionManager &) = delete;
 	AampDRMSessionManager& operator=(const AampDRMSessionManager &) = delete;
@@ -132,6 +134,8 @@ private:
 			void *userdata);
 	static int progress_callback(void *clientp,	double dltotal, 
 			double dlnow, double ultotal, double ulnow );
+
+	void applyEncryptionScheme(AampDrmSession *drmSession, const unsigned char *keyId, int keyIdLen);
 public:
 
 	AampDRMSessionManager();
@@ -155,6 +159,8 @@ public:
 
 	void clearFailedKeyIds();
 
+	void setEncryptionScheme(const unsigned char *keyId, size_t keyIdLen, const AampEncryptionScheme &scheme);
+
 	void setSessionMgrState(SessionMgrState state);
 	
 	void setCurlAbort(bool isAbort);
@@ -397,7 +397,7 @@ unsigned char * aamp_ExtractKeyIdFromPssh(const char* psshData, int dataLength,
 		uint8_t  key_id_count = (uint8_t)psshData[header];
 		key_id = (unsigned char*)malloc(16 + 1);
 		memset(key_id, 0, 16 + 1);
-		strncpy(reinterpret_cast<char*>(key_id), psshData + header, 16);
+		memcpy(key_id, psshData + header, 16);
 		*len = (int)16;
 		AAMPLOG_INFO("%s:%d ck keyid: %s keyIdlen: %d",__FUNCTION__, __LINE__, key_id, 16);
 		if(gpGlobalConfig->logging.trace)
@@ -505,3 +505,127 @@ unsigned char * aamp_ExtractDataFromPssh(const char* psshData, int dataLength,
 	free(cleanedPssh);
 	return contentMetaData;
 }
+
+/**
+ *  @brief		Check type of an ISO BMFF box.
+ *
+ *  @param[in]	type - Pointer to box type.
+ *  @param[in]	name - Four character code to compare.
+ *  @return		true if box is of given type.
+ */
+static bool aamp_IsBoxType(const unsigned char *type, const char *name)
+{
+	return (0 == memcmp(type, name, 4));
+}
+
+/**
+ *  @brief		Read big endian 32 bit value.
+ *
+ *  @param[in]	ptr - Pointer to value.
+ *  @return		value.
+ */
+static uint32_t aamp_ReadUint32(const unsigned char *ptr)
+{
+	return ((uint32_t)ptr[0] << 24) | ((uint32_t)ptr[1] << 16) | ((uint32_t)ptr[2] << 8) | (uint32_t)ptr[3];
+}
+
+/**
+ *  @brief		Walk boxes down to the protection scheme info of a sample entry.
+ *
+ *  @param[in]	ptr - Pointer to first box.
+ *  @param[in]	end - End of boxes.
+ *  @param[out]	scheme - Gets updated from schm and tenc.
+ *  @param[out]	keyId - Gets default key ID from tenc, 16 bytes.
+ *  @param[out]	schmFound - Gets set once schm is parsed.
+ *  @return		true once tenc is parsed after schm.
+ */
+static bool aamp_ParseEncryptionBoxes(const unsigned char *ptr, const unsigned char *end, AampEncryptionScheme &scheme, unsigned char *keyId, bool &schmFound)
+{
+	while (end - ptr >= 8)
+	{
+		uint64_t size = aamp_ReadUint32(ptr);
+		const unsigned char *type = ptr + 4;
+		const unsigned char *payload = ptr + 8;
+		if (size == 1)
+		{
+			if (end - ptr < 16)
+			{
+				break;
+			}
+			size = ((uint64_t)aamp_ReadUint32(ptr + 8) << 32) | aamp_ReadUint32(ptr + 12);
+			payload = ptr + 16;
+		}
+		else if (size == 0)
+		{
+			size = end - ptr;
+		}
+		if (size < (uint64_t)(payload - ptr) || size > (uint64_t)(end - ptr))
+		{
+			break;
+		}
+		const unsigned char *boxEnd = ptr + size;
+		size_t payloadLen = boxEnd - payload;
+		const unsigned char *children = NULL;
+
+		if (aamp_IsBoxType(type, "moov") || aamp_IsBoxType(type, "trak") || aamp_IsBoxType(type, "mdia") ||
+			aamp_IsBoxType(type, "minf") || aamp_IsBoxType(type, "stbl") || aamp_IsBoxType(type, "sinf") ||
+			aamp_IsBoxType(type, "schi"))
+		{
+			children = payload;
+		}
+		else if (aamp_IsBoxType(type, "stsd") && payloadLen >= 8)
+		{
+			// version, flags and entry count
+			children = payload + 8;
+		}
+		else if (aamp_IsBoxType(type, "encv") && payloadLen >= 78)
+		{
+			// VisualSampleEntry fields
+			children = payload + 78;
+		}
+		else if (aamp_IsBoxType(type, "enca") && payloadLen >= 28)
+		{
+			// AudioSampleEntry fields
+			children = payload + 28;
+		}
+		else if (aamp_IsBoxType(type, "schm") && payloadLen >= 8)
+		{
+			scheme.cbcs = aamp_IsBoxType(payload + 4, "cbcs");
+			schmFound = true;
+		}
+		else if (aamp_IsBoxType(type, "tenc") && payloadLen >= 24)
+		{
+			// version 0 has no pattern, byte is reserved
+			if (payload[0] >= 1)
+			{
+				scheme.cryptByteBlock = payload[5] >> 4;
+				scheme.skipByteBlock = payload[5] & 0x0F;
+			}
+			memcpy(keyId, payload + 8, 16);
+			return schmFound;
+		}
+
+		if (children && aamp_ParseEncryptionBoxes(children, boxEnd, scheme, keyId, schmFound))
+		{
+			return true;
+		}
+		ptr = boxEnd;
+	}
+	return false;
+}
+
+/**
+ *  @brief		Get common encryption scheme and default key ID from
+ *  			schm and tenc boxes of an init segment.
+ *
+ *  @param[in]	initSegment - Pointer to init segment.
+ *  @param[in]	len - Length of init segment.
+ *  @param[out]	scheme - Gets updated with encryption scheme.
+ *  @param[out]	keyId - Gets updated with default key ID, 16 bytes.
+ *  @return		true if init segment has protection scheme info.
+ */
+bool aamp_ParseEncryptionScheme(const unsigned char *initSegment, size_t len, AampEncryptionScheme &scheme, unsigned char *keyId)
+{
+	bool schmFound = false;
+	return aamp_ParseEncryptionBoxes(initSegment, initSegment + len, scheme, keyId, schmFound);
+}
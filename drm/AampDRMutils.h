@@ -40,6 +40,21 @@
 #define DRM_API_SUCCESS (0)
 #define DRM_API_FAILED  (-1)
 
+/**
+ * @struct AampEncryptionScheme
+ * @brief Common encryption scheme signalled in schm and tenc boxes
+ */
+struct AampEncryptionScheme
+{
+	bool cbcs;                  /**< true for 'cbcs', AES-CBC pattern encryption */
+	uint8_t cryptByteBlock;     /**< encrypted 16 byte blocks in pattern, 0 if not pattern encrypted */
+	uint8_t skipByteBlock;      /**< clear 16 byte blocks in pattern */
+
+	AampEncryptionScheme() : cbcs(false), cryptByteBlock(0), skipByteBlock(0)
+	{
+	}
+};
+
 /**
  * @class DrmData
  * @brief To hold DRM key, license request etc.
@@ -78,4 +93,6 @@ unsigned char * aamp_ExtractKeyIdFromPssh(const char* psshData, int dataLength,
 
 unsigned char * aamp_ExtractWVContentMetadataFromPssh(const char* psshData, int dataLength, int *len);
 
+bool aamp_ParseEncryptionScheme(const unsigned char *initSegment, size_t len, AampEncryptionScheme &scheme, unsigned char *keyId);
+
 #endif
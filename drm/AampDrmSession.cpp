@@ -38,6 +38,19 @@ AampDrmSession::~AampDrmSession()
 {
 }
 
+/**
+ *  @brief	Set common encryption scheme of the content, no-op unless
+ *  		session decrypts samples itself.
+ *
+ *  @param[in]	cbcs - true for 'cbcs', AES-CBC pattern encryption
+ *  @param[in]	cryptByteBlock - encrypted 16 byte blocks in pattern
+ *  @param[in]	skipByteBlock - clear 16 byte blocks in pattern
+ *  @return	void.
+ */
+void AampDrmSession::setEncryptionScheme(bool cbcs, uint8_t cryptByteBlock, uint8_t skipByteBlock)
+{
+}
+
 /**
  *  @brief	Getter function for DRM key system.
  *
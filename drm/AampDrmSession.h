@@ -120,6 +120,15 @@ public:
 	 */
 	virtual void clearDecryptContext() = 0;
 
+	/**
+	 * @brief Set common encryption scheme of the content.
+	 *        Sessions decrypting in the DRM system ignore it.
+	 * @param cbcs : true for 'cbcs', AES-CBC pattern encryption
+	 * @param cryptByteBlock : encrypted 16 byte blocks in pattern, 0 if not pattern encrypted
+	 * @param skipByteBlock : clear 16 byte blocks in pattern
+	 */
+	virtual void setEncryptionScheme(bool cbcs, uint8_t cryptByteBlock, uint8_t skipByteBlock);
+
 	/**
 	 * @brief Constructor for AampDrmSession.
 	 * @param keySystem : DRM key system uuid
@@ -30,6 +30,7 @@
 #include <string>
 #include <string.h>
 #include <vector>
+#include <algorithm>
 #include "priv_aamp.h"
 
 #include <openssl/err.h>
@@ -39,6 +40,7 @@
 #define AES_CTR_KID_LEN 16
 #define AES_CTR_IV_LEN 16
 #define AES_CTR_KEY_LEN 16
+#define AES_BLOCK_LEN 16
 /**
  * @brief ClearKeySession Constructor
  */
@@ -51,7 +53,10 @@ ClearKeySession::ClearKeySession() :
 		mOpensslCtx(),
 		m_keyStr(NULL),
 		m_keyLen(0),
-		m_keyIdLen(0)
+		m_keyIdLen(0),
+		m_cbcs(false),
+		m_cryptByteBlock(0),
+		m_skipByteBlock(0)
 {
 	pthread_mutex_init(&decryptMutex,NULL);
 	initAampDRMSession();
@@ -84,6 +89,112 @@ void ClearKeySession::setKeyId(const char* keyId, int32_t keyIDLen)
 	m_keyIdLen = keyIDLen;
 }
 
+/**
+ * @brief Set common encryption scheme of the content.
+ * @param cbcs : true for 'cbcs', AES-CBC pattern encryption
+ * @param cryptByteBlock : encrypted 16 byte blocks in pattern, 0 if not pattern encrypted
+ * @param skipByteBlock : clear 16 byte blocks in pattern
+ */
+void ClearKeySession::setEncryptionScheme(bool cbcs, uint8_t cryptByteBlock, uint8_t skipByteBlock)
+{
+	pthread_mutex_lock(&decryptMutex);
+	m_cbcs = cbcs;
+	m_cryptByteBlock = cryptByteBlock;
+	m_skipByteBlock = skipByteBlock;
+	pthread_mutex_unlock(&decryptMutex);
+	AAMPLOG_INFO("ClearKeySession:: %s:%d scheme %s pattern %u:%u", __FUNCTION__, __LINE__, cbcs ? "cbcs" : "cenc", cryptByteBlock, skipByteBlock);
+}
+
+/**
+ * @brief Build 16 byte IV, 8 byte IV is padded with 0
+ * @param f_pbIV : Initialization vector.
+ * @param f_cbIV : Initialization vector length.
+ * @param iv : 16 byte output IV
+ * @retval true if IV length is valid
+ */
+static bool BuildIV(const uint8_t *f_pbIV, uint32_t f_cbIV, uint8_t *iv)
+{
+	bool ret = true;
+	if(f_cbIV == 8)
+	{
+		memcpy(iv, f_pbIV, 8);
+		memset(iv + 8, 0, 8);
+	}
+	else if(f_cbIV == AES_CTR_IV_LEN)
+	{
+		memcpy(iv, f_pbIV, AES_CTR_IV_LEN);
+	}
+	else
+	{
+		AAMPLOG_TRACE("ClearKeySession::%s:%d: invalid IV size %u",  __FUNCTION__, __LINE__, f_cbIV);
+		ret = false;
+	}
+	return ret;
+}
+
+/**
+ * @brief Initialize cipher context with key of session and given IV
+ * @param iv : 16 byte initialization vector
+ * @retval true on success
+ */
+bool ClearKeySession::initCipher(const uint8_t *iv)
+{
+	const EVP_CIPHER *cipher = m_cbcs ? EVP_aes_128_cbc() : EVP_aes_128_ctr();
+	if(!EVP_DecryptInit_ex(&mOpensslCtx, cipher, NULL, m_keyStr, iv))
+	{
+		AAMPLOG_TRACE( "ClearKeySession::%s:%d: EVP_DecryptInit_ex failed",  __FUNCTION__, __LINE__);
+		return false;
+	}
+	// Protected ranges are whole blocks in cbcs, no block is held back for padding
+	EVP_CIPHER_CTX_set_padding(&mOpensslCtx, 0);
+	return true;
+}
+
+/**
+ * @brief Decrypt a protected range in place.
+ * @param iv : 16 byte initialization vector
+ * @param data : Data to decrypt.
+ * @param size : Size of data.
+ * @retval true on success
+ */
+bool ClearKeySession::decryptRange(const uint8_t *iv, uint8_t *data, uint32_t size)
+{
+	int len = 0;
+	if(!m_cbcs)
+	{
+		// CTR keystream position is kept in the context across updates
+		return (size == 0 || EVP_DecryptUpdate(&mOpensslCtx, data, &len, data, size));
+	}
+
+	if(!initCipher(iv))
+	{
+		return false;
+	}
+	uint32_t cryptSize = m_cryptByteBlock * AES_BLOCK_LEN;
+	uint32_t skipSize = m_skipByteBlock * AES_BLOCK_LEN;
+	if(cryptSize == 0)
+	{
+		// No pattern, all whole blocks are encrypted
+		cryptSize = size;
+		skipSize = 0;
+	}
+	// CBC chain continues over the skipped blocks; trailing partial block is clear
+	while(size >= AES_BLOCK_LEN)
+	{
+		uint32_t encrypted = std::min(cryptSize, size - (size % AES_BLOCK_LEN));
+		if(!EVP_DecryptUpdate(&mOpensslCtx, data, &len, data, encrypted))
+		{
+			return false;
+		}
+		data += encrypted;
+		size -= encrypted;
+		uint32_t skipped = std::min(skipSize, size);
+		data += skipped;
+		size -= skipped;
+	}
+	return true;
+}
+
 /**
  * @brief Create drm session with given init data
  *        state will be KEY_INIT on success KEY_ERROR if failed
@@ -300,15 +411,13 @@ int ClearKeySession::decrypt(GstBuffer* keyIDBuffer, GstBuffer* ivBuffer, GstBuf
                 GstBuffer* subSamplesBuffer)
 {
 	int retVal = 1;
-	uint8_t *pbData = NULL;
-	uint32_t cbData = 0;
 	uint16_t nBytesClear = 0;
 	uint32_t nBytesEncrypted = 0;
 
 	GstMapInfo ivMap;
 	GstMapInfo subsampleMap;
 	GstMapInfo bufferMap;
-	GstByteReader* reader = NULL;
+	GstByteReader reader;
 
 	bool ivMapped = false;
 	bool subSampleMapped = false;
@@ -346,94 +455,58 @@ int ClearKeySession::decrypt(GstBuffer* keyIDBuffer, GstBuffer* ivBuffer, GstBuf
 
 	if(bufferMapped && ivMapped && (subSampleCount ==0 || subSampleMapped))
 	{
-		reader = gst_byte_reader_new(subsampleMap.data, subsampleMap.size);
-		if(reader)
+		uint8_t iv[AES_CTR_IV_LEN];
+		pthread_mutex_lock(&decryptMutex);
+		if (m_eKeyState != KEY_READY)
 		{
-			// collect all the encrypted bytes into one contiguous buffer
-			// we need to call decrypt once for all encrypted bytes.
+			AAMPLOG_ERR( "ClearKeySession:: %s:%d:key not ready! mDrmState = %d",  __FUNCTION__, __LINE__, m_eKeyState);
+		}
+		else if (BuildIV(static_cast<uint8_t *>(ivMap.data), static_cast<uint32_t>(ivMap.size), iv)
+				&& (m_cbcs || initCipher(iv)))
+		{
+			// Decrypt protected ranges in place, walking the subsample map; for cenc the
+			// counter runs on from one range to the next as if they were contiguous
 			if (subSampleCount > 0)
 			{
-				pbData = (uint8_t *) malloc(sizeof(uint8_t) * bufferMap.size);
-				uint8_t *pbCurrTarget = (uint8_t *) pbData;
-				uint32_t iCurrSource = 0;
-
-		        for (int i = 0; i < subSampleCount; i++)
-		        {
-					if (!gst_byte_reader_get_uint16_be(reader, &nBytesClear)
-							|| !gst_byte_reader_get_uint32_be(reader, &nBytesEncrypted))
+				gst_byte_reader_init(&reader, subsampleMap.data, subsampleMap.size);
+				uint8_t *pbCurr = bufferMap.data;
+				size_t remaining = bufferMap.size;
+				retVal = 0;
+
+				for (unsigned i = 0; i < subSampleCount; i++)
+				{
+					if (!gst_byte_reader_get_uint16_be(&reader, &nBytesClear)
+							|| !gst_byte_reader_get_uint32_be(&reader, &nBytesEncrypted))
 					{
 						AAMPLOG_ERR("ClearKeySession:: %s:%d ERROR : Failed to read from subsamples reader", __FUNCTION__, __LINE__);
-						cbData = 0;
+						retVal = 1;
 						break;
 					}
-					// Skip the clear byte range from source buffer.
-					iCurrSource += nBytesClear;
-
-					// Copy cipher bytes from f_pbData to target buffer.
-					memcpy(pbCurrTarget, (uint8_t*) bufferMap.data + iCurrSource, nBytesEncrypted);
-
-					// Adjust current pointer of target buffer.
-					pbCurrTarget += nBytesEncrypted;
-
-					// Adjust current offset of source buffer.
-					iCurrSource += nBytesEncrypted;
-					cbData += nBytesEncrypted;
+					if (nBytesClear > remaining || nBytesEncrypted > remaining - nBytesClear)
+					{
+						AAMPLOG_ERR("ClearKeySession:: %s:%d ERROR : Subsample %u exceeds buffer size %u", __FUNCTION__, __LINE__, i, (unsigned)bufferMap.size);
+						retVal = 1;
+						break;
+					}
+					pbCurr += nBytesClear;
+					if (!decryptRange(iv, pbCurr, nBytesEncrypted))
+					{
+						AAMPLOG_TRACE("ClearKeySession::%s:%d: EVP_DecryptUpdate failed", __FUNCTION__, __LINE__);
+						retVal = 1;
+						break;
+					}
+					pbCurr += nBytesEncrypted;
+					remaining -= (nBytesClear + nBytesEncrypted);
 				}
 			}
-	        else
-	        {
-				pbData = bufferMap.data;
-				cbData = bufferMap.size;
-	        }
-
-			if(cbData != 0)
+			else if (decryptRange(iv, bufferMap.data, bufferMap.size))
 			{
-				retVal = decrypt(static_cast<uint8_t *>(ivMap.data), static_cast<uint32_t>(ivMap.size),
-			            pbData, cbData, NULL);
+				retVal = 0;
 			}
-
-			if(retVal == 0)
-			{
-				if(subSampleCount > 0)
-				{
-					// If subsample mapping is used, copy decrypted bytes back
-					// to the original buffer.
-					gst_byte_reader_set_pos(reader, 0);
-					uint8_t *pbCurrTarget = bufferMap.data;
-					uint32_t iCurrSource = 0;
-
-			        for (int i = 0; i < subSampleCount; i++)
-			        {
-						if (!gst_byte_reader_get_uint16_be(reader, &nBytesClear)
-								|| !gst_byte_reader_get_uint32_be(reader, &nBytesEncrypted))
-						{
-							AAMPLOG_ERR("ClearKeySession:: %s:%d ERROR : Failed to read from subsamples reader", __FUNCTION__, __LINE__);
-							retVal = 1;
-							break;
-						}
-						// Skip the clear byte range from target buffer.
-						pbCurrTarget += nBytesClear;
-						memcpy(pbCurrTarget, pbData + iCurrSource, nBytesEncrypted);
-
-						// Adjust current pointer of target buffer.
-						pbCurrTarget += nBytesEncrypted;
-
-						// Adjust current offset of source buffer.
-						iCurrSource += nBytesEncrypted;
-					}
-				}//SubSample end if
-			} //retVal end if
-		}//reader end if
-		else
-		{
-			AAMPLOG_ERR("ClearKeySession:: %s:%d ERROR : Failed to allocate subsample reader", __FUNCTION__, __LINE__);
 		}
+		pthread_mutex_unlock(&decryptMutex);
 	}
 
-	if(subSampleCount > 0 && pbData)
-	{
-		free(pbData);
-	}
 	if(bufferMapped)
 	{
 		gst_buffer_unmap(buffer, &bufferMap);
@@ -468,62 +541,20 @@ int ClearKeySession::decrypt(const uint8_t *f_pbIV, uint32_t f_cbIV,
 
 	if (m_eKeyState == KEY_READY)
 	{
-		uint8_t *decryptedDataBuf = (uint8_t *)malloc(payloadDataSize);
-		uint32_t decryptedDataLen = 0;
-		uint8_t *ivBuff = NULL;
-		memset(decryptedDataBuf, 0, payloadDataSize);
-		if(f_cbIV == 8)//8 byte IV need to pad with 0 before decrypt
-		{
-			ivBuff = (uint8_t *)malloc(sizeof(uint8_t) * AES_CTR_IV_LEN);
-			memset(ivBuff + 8, 0, 8);
-			memcpy(ivBuff, f_pbIV, 8);
-		}
-		else if(f_cbIV == AES_CTR_IV_LEN)
+		uint8_t iv[AES_CTR_IV_LEN];
+		// Payload is decrypted in place
+		uint8_t *data = const_cast<uint8_t *>(payloadData);
+		if (BuildIV(f_pbIV, f_cbIV, iv) && (m_cbcs || initCipher(iv)))
 		{
-			ivBuff = (uint8_t *)malloc(sizeof(uint8_t) * AES_CTR_IV_LEN);
-			memcpy(ivBuff, f_pbIV, AES_CTR_IV_LEN);
-		}
-		else
-		{
-			AAMPLOG_TRACE("ClearKeySession::%s:%d: invalid IV size %u",  __FUNCTION__, __LINE__, f_cbIV);
-		}
-
-		if (decryptedDataBuf && ivBuff)
-		{
-			uint32_t decLen = payloadDataSize;
-
-			if(!EVP_DecryptInit_ex(&mOpensslCtx, EVP_aes_128_ctr(), NULL, m_keyStr, ivBuff))
+			if (!decryptRange(iv, data, payloadDataSize))
 			{
-				AAMPLOG_TRACE( "ClearKeySession::%s:%d: EVP_DecryptInit_ex failed",  __FUNCTION__, __LINE__);
+				AAMPLOG_TRACE("ClearKeySession::%s:%d: EVP_DecryptUpdate failed", __FUNCTION__, __LINE__);
 			}
 			else
 			{
-				if (!EVP_DecryptUpdate(&mOpensslCtx,(unsigned char*) decryptedDataBuf, (int*) &decLen, (const unsigned char*) payloadData,
-					payloadDataSize))
-				{
-					AAMPLOG_TRACE("ClearKeySession::%s:%d: EVP_DecryptUpdate failed", __FUNCTION__, __LINE__);
-				}
-				else
-				{
-					decryptedDataLen = decLen;
-					decLen = 0;
-					AAMPLOG_TRACE("ClearKeySession::%s:%d: EVP_DecryptUpdate success decryptedDataLen = %d payload Data length = %d", __FUNCTION__, __LINE__, (int) decryptedDataLen, (int)payloadDataSize);
-					if (!EVP_DecryptFinal_ex(&mOpensslCtx, (unsigned char*) (decryptedDataBuf + decryptedDataLen), (int*) &decLen))
-					{
-						AAMPLOG_TRACE("ClearKeySession::%s:%d: EVP_DecryptFinal_ex failed mDrmState = %d", __FUNCTION__, __LINE__, (int) m_eKeyState);
-					}
-					else
-					{
-						decryptedDataLen += decLen;
-						AAMPLOG_TRACE("ClearKeySession::%s:%d decrypt success", __FUNCTION__, __LINE__);
-						status = 0;
-					}
-				}
+				AAMPLOG_TRACE("ClearKeySession::%s:%d decrypt success payload Data length = %d", __FUNCTION__, __LINE__, (int)payloadDataSize);
+				status = 0;
 			}
-
-			memcpy((void *)payloadData, decryptedDataBuf, payloadDataSize);
-			free(decryptedDataBuf);
-			free(ivBuff);
 		}
 	}
 	else
@@ -51,9 +51,30 @@ private:
 	size_t m_keyLen;
 	unsigned char* m_keyId;
 	size_t m_keyIdLen;
+	bool m_cbcs;
+	uint8_t m_cryptByteBlock;
+	uint8_t m_skipByteBlock;
 	void initAampDRMSession();
 	EVP_CIPHER_CTX mOpensslCtx;
 
+	/**
+	 * @brief Initialize cipher context with key of session and given IV
+	 * @param iv : 16 byte initialization vector
+	 * @retval true on success
+	 */
+	bool initCipher(const uint8_t *iv);
+
+	/**
+	 * @brief Decrypt a protected range in place.
+	 *        For cenc, counter continues from the previous range of the sample.
+	 *        For cbcs, IV is restarted and the crypt/skip pattern is applied.
+	 * @param iv : 16 byte initialization vector
+	 * @param data : Data to decrypt.
+	 * @param size : Size of data.
+	 * @retval true on success
+	 */
+	bool decryptRange(const uint8_t *iv, uint8_t *data, uint32_t size);
+
 public:
 
 	/**
@@ -101,6 +122,15 @@ public:
 	 */
 	void setKeyId(const char* keyId, int32_t keyIDLen);
 
+	/**
+	 * @brief Set common encryption scheme of the content.
+	 *        Default is 'cenc', AES-CTR full sample encryption.
+	 * @param cbcs : true for 'cbcs', AES-CBC pattern encryption
+	 * @param cryptByteBlock : encrypted 16 byte blocks in pattern, 0 if not pattern encrypted
+	 * @param skipByteBlock : clear 16 byte blocks in pattern
+	 */
+	void setEncryptionScheme(bool cbcs, uint8_t cryptByteBlock, uint8_t skipByteBlock);
+
 	/**
 	 * @brief Function to decrypt stream.
 	 * @param f_pbIV : Initialization vector.
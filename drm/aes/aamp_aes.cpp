@@ -222,6 +222,7 @@ DrmReturn AesDec::SetDecryptInfo( PrivateInstanceAAMP *aamp, const struct DrmInf
 	}
 	mDrmUrl = strdup(drmInfo->uri);
 	mDrmState = eDRM_ACQUIRING_KEY;
+	mCipherKeySet = false;
 	mPrevDrmState = eDRM_INITIALIZED;
 	if (-1 == mCurlInstance)
 	{
@@ -299,47 +300,48 @@ DrmReturn AesDec::Decrypt( ProfilerBucketType bucketType, void *encryptedDataPtr
 	if (mDrmState == eDRM_KEY_ACQUIRED)
 	{
 		AAMPLOG_INFO("AesDec::%s:%d Starting decrypt", __FUNCTION__, __LINE__);
-		unsigned char *decryptedDataBuf = (unsigned char *)malloc(encryptedDataLen);
+		unsigned char *dataPtr = (unsigned char *)encryptedDataPtr;
 		int decryptedDataLen = 0;
-		if (decryptedDataBuf)
+		int decLen = 0;
+		int initStatus;
+		mpAamp->LogDrmDecryptBegin(bucketType);
+		if (mCipherKeySet)
 		{
-			int decLen = encryptedDataLen;
-			memset(decryptedDataBuf, 0, encryptedDataLen);
-			mpAamp->LogDrmDecryptBegin(bucketType);
-			if(!EVP_DecryptInit_ex(&mOpensslCtx, EVP_aes_128_cbc(), NULL, (unsigned char*)mAesKeyBuf.ptr, mDrmInfo.iv))
+			// Key schedule is retained in context, only IV changes per fragment
+			initStatus = EVP_DecryptInit_ex(&mOpensslCtx, NULL, NULL, NULL, mDrmInfo.iv);
+		}
+		else
+		{
+			initStatus = EVP_DecryptInit_ex(&mOpensslCtx, EVP_aes_128_cbc(), NULL, (unsigned char*)mAesKeyBuf.ptr, mDrmInfo.iv);
+		}
+		mCipherKeySet = (0 != initStatus);
+		if(!initStatus)
+		{
+			logprintf( "AesDec::%s:%d: EVP_DecryptInit_ex failed mDrmState = %d",  __FUNCTION__, __LINE__, (int)mDrmState);
+		}
+		// CBC decryption output never runs ahead of input, so data is decrypted in place
+		else if (!EVP_DecryptUpdate(&mOpensslCtx, dataPtr, &decLen, dataPtr, encryptedDataLen))
+		{
+			logprintf("AesDec::%s:%d: EVP_DecryptUpdate failed mDrmState = %d", __FUNCTION__, __LINE__, (int) mDrmState);
+		}
+		else
+		{
+			decryptedDataLen = decLen;
+			decLen = 0;
+			AAMPLOG_INFO("AesDec::%s:%d: EVP_DecryptUpdate success decryptedDataLen = %d encryptedDataLen %d", __FUNCTION__, __LINE__, (int) decryptedDataLen, (int)encryptedDataLen);
+			if (!EVP_DecryptFinal_ex(&mOpensslCtx, dataPtr + decryptedDataLen, &decLen))
 			{
-				logprintf( "AesDec::%s:%d: EVP_DecryptInit_ex failed mDrmState = %d",  __FUNCTION__, __LINE__, (int)mDrmState);
+				logprintf("AesDec::%s:%d: EVP_DecryptFinal_ex failed mDrmState = %d", __FUNCTION__, __LINE__,
+				        (int) mDrmState);
 			}
 			else
 			{
-				if (!EVP_DecryptUpdate(&mOpensslCtx, decryptedDataBuf, &decLen, (const unsigned char*) encryptedDataPtr,
-				        encryptedDataLen))
-				{
-					logprintf("AesDec::%s:%d: EVP_DecryptUpdate failed mDrmState = %d", __FUNCTION__, __LINE__, (int) mDrmState);
-				}
-				else
-				{
-					decryptedDataLen = decLen;
-					decLen = 0;
-					AAMPLOG_INFO("AesDec::%s:%d: EVP_DecryptUpdate success decryptedDataLen = %d encryptedDataLen %d", __FUNCTION__, __LINE__, (int) decryptedDataLen, (int)encryptedDataLen);
-					if (!EVP_DecryptFinal_ex(&mOpensslCtx, decryptedDataBuf + decryptedDataLen, &decLen))
-					{
-						logprintf("AesDec::%s:%d: EVP_DecryptFinal_ex failed mDrmState = %d", __FUNCTION__, __LINE__,
-						        (int) mDrmState);
-					}
-					else
-					{
-						decryptedDataLen += decLen;
-						AAMPLOG_INFO("AesDec::%s:%d decrypt success", __FUNCTION__, __LINE__);
-						err = eDRM_SUCCESS;
-					}
-				}
+				decryptedDataLen += decLen;
+				AAMPLOG_INFO("AesDec::%s:%d decrypt success", __FUNCTION__, __LINE__);
+				err = eDRM_SUCCESS;
 			}
-			mpAamp->LogDrmDecryptEnd(bucketType);
-
-			memcpy(encryptedDataPtr, decryptedDataBuf, encryptedDataLen);
-			free(decryptedDataBuf);
 		}
+		mpAamp->LogDrmDecryptEnd(bucketType);
 	}
 	else
 	{
@@ -443,7 +445,7 @@ std::shared_ptr<AesDec> AesDec::GetInstance()
  */
 AesDec::AesDec() : mpAamp(nullptr), mDrmState(eDRM_INITIALIZED),
 		mPrevDrmState(eDRM_INITIALIZED), mDrmUrl(nullptr),
-		mCond(), mMutex(), mOpensslCtx(),
+		mCond(), mMutex(), mOpensslCtx(), mCipherKeySet(false),
 		mDrmInfo(), mAesKeyBuf(), mCurlInstance(-1),
 		licenseAcquisitionThreadId(),
 		licenseAcquisitionThreadStarted(false)
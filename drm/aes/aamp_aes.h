@@ -61,6 +61,7 @@ private:
 	pthread_cond_t mCond;
 	pthread_mutex_t mMutex;
 	EVP_CIPHER_CTX mOpensslCtx;
+	bool mCipherKeySet;          /**< mOpensslCtx holds key schedule of mAesKeyBuf */
 	DrmInfo mDrmInfo ;
 	GrowableBuffer mAesKeyBuf;
 	DRMState mDrmState;
@@ -51,6 +51,7 @@
 #include <vector>
 #include "HlsDrmBase.h"
 #include "AampCacheHandler.h"
+#include "AampTaskExecutor.h"
 #ifdef AAMP_VANILLA_AES_SUPPORT
 #include "aamp_aes.h"
 #endif
@@ -162,6 +163,7 @@ extern void setCustomLicensePayLoad(const char* customData);
 }
 #endif
 static size_t FindLineLength(const char* ptr);
+static bool IsSamePlaylistLine(const char *line1, const char *line2);
 
 /***************************************************************************
 * @fn startswith
@@ -339,6 +341,8 @@ static void ParseKeyAttributeCallback(char *attrName, char *delimEqual, char *fi
 		char *uri = GetAttributeValueString(valuePtr, fin);
 		if (ts->mDrmInfo.uri)
 		{
+			// Decrypt context of queued fragments may refer to current uri
+			ts->WaitForPendingDecrypt();
 			free(ts->mDrmInfo.uri);
 		}
 		ts->mDrmInfo.uri = strdup(uri);
@@ -1251,61 +1255,7 @@ char *TrackState::GetFragmentUriFromIndex()
 	if (idxNode)
 	{
 		currentIdx = idx;
-		byteRangeOffset = 0;
-		byteRangeLength = 0;
-		//logprintf("%s fragmentinfo %s", __FUNCTION__, idxNode->pFragmentInfo);
-		const char *fragmentInfo = idxNode->pFragmentInfo;
-		fragmentDurationSeconds = idxNode->completionTimeSecondsFromStart;
-		if (idx > 0)
-		{
-			fragmentDurationSeconds -= index[idx - 1].completionTimeSecondsFromStart;
-		}
-		while (fragmentInfo[0] == '#')
-		{
-			if (!memcmp(fragmentInfo, "#EXT-X-BYTERANGE:", 17))
-			{
-				char temp[1024];
-				const char * end = fragmentInfo;
-				while (end[0] != CHAR_LF)
-				{
-					end++;
-				}
-				int len = end - fragmentInfo;
-				assert(len < 1024);
-				strncpy(temp, fragmentInfo + 17, len);
-				temp[1023] = 0x00;
-				char * offsetDelim = strchr(temp, '@'); // optional
-				if (offsetDelim)
-				{
-					*offsetDelim++ = 0x00;
-					byteRangeOffset = atoi(offsetDelim);
-				}
-				byteRangeLength = atoi(temp);
-			}
-			/*Skip to next line*/
-			while (fragmentInfo[0] != CHAR_LF)
-			{
-				fragmentInfo++;
-			}
-			fragmentInfo++;
-		}
-		const char *urlEnd = strchr(fragmentInfo, CHAR_LF);
-		if (urlEnd)
-		{
-			if (*(urlEnd - 1) == CHAR_CR)
-			{
-				urlEnd--;
-			}
-			int urlLen = urlEnd - fragmentInfo;
-			mFragmentURIFromIndex.assign(fragmentInfo, urlLen);
-			if(!mFragmentURIFromIndex.empty()){
-				uri = (char *)mFragmentURIFromIndex.c_str();
-			}
-		}
-		else
-		{
-			logprintf("%s - unable to find end", __FUNCTION__);
-		}
+		uri = SelectIndexedFragment(idx);
 		if (-1 == idxNode->drmMetadataIdx)
 		{
 			fragmentEncrypted = false;
@@ -1344,6 +1294,76 @@ char *TrackState::GetFragmentUriFromIndex()
 	return uri;
 }
 
+/***************************************************************************
+* @fn SelectIndexedFragment
+* @brief Function to load URI, byte range and duration of indexed fragment
+* @param idx index of fragment
+* @return string fragment URI pointer, NULL if fragment has no URI
+***************************************************************************/
+char *TrackState::SelectIndexedFragment(int idx)
+{
+	char *uri = NULL;
+	const IndexNode *node = &((IndexNode *) index.ptr)[idx];
+	fragmentDurationSeconds = node->durationSeconds;
+	byteRangeOffset = node->byteRangeOffset;
+	byteRangeLength = node->byteRangeLength;
+	if (node->uriOffset >= 0)
+	{
+		mFragmentURIFromIndex.assign(node->pFragmentInfo + node->uriOffset, node->uriLength);
+		if (!mFragmentURIFromIndex.empty())
+		{
+			uri = (char *)mFragmentURIFromIndex.c_str();
+		}
+	}
+	else
+	{
+		logprintf("%s - no uri for fragment %d", __FUNCTION__, idx);
+	}
+	return uri;
+}
+
+/***************************************************************************
+* @fn ApplyKeyTag
+* @brief Function to apply indexed #EXT-X-KEY to decryption state
+* @param keyTagIdx index of key tag in mKeyHashTable, -1 if none
+* @return void
+***************************************************************************/
+void TrackState::ApplyKeyTag(int keyTagIdx)
+{
+	if (keyTagIdx >= 0 && keyTagIdx < (int)mKeyHashTable.size() && mKeyHashTable[keyTagIdx].mKeyTagStr.size())
+	{
+		// ParseAttrList modifies the input string, so parse a copy
+		std::string key = mKeyHashTable[keyTagIdx].mKeyTagStr;
+		ParseAttrList(&key[0], ParseKeyAttributeCallback, this);
+	}
+	mLastKeyTagIdx = keyTagIdx;
+}
+
+/***************************************************************************
+* @fn GetFragmentStartTime
+* @brief Function to get start time of indexed fragment
+* @param index indexed fragments
+* @param idx index of fragment
+* @return time of fragment start from start of playlist
+***************************************************************************/
+static inline double GetFragmentStartTime(const IndexNode *index, int idx)
+{
+	return (idx > 0) ? index[idx - 1].completionTimeSecondsFromStart : (index[0].completionTimeSecondsFromStart - index[0].durationSeconds);
+}
+
+/***************************************************************************
+* @fn IsAtPlayTarget
+* @brief Function to check if fragment is the one to present for play target
+* @param position playlist position of fragment
+* @param duration duration of fragment
+* @param playTarget play target
+* @return true if fragment reaches play target
+***************************************************************************/
+static inline bool IsAtPlayTarget(double position, double duration, double playTarget)
+{
+	return ((position + duration) > playTarget) || ((playTarget - position) < PLAYLIST_TIME_DIFF_THRESHOLD_SECONDS);
+}
+
 /***************************************************************************
 * @fn GetNextFragmentUriFromPlaylist
 * @brief Function to get next fragment URI from playlist based on playtarget
@@ -1352,12 +1372,10 @@ char *TrackState::GetFragmentUriFromIndex()
 ***************************************************************************/
 char *TrackState::GetNextFragmentUriFromPlaylist(bool ignoreDiscontinuity)
 {
-	char *ptr = fragmentURI;
 	char *rc = NULL;
-	int byteRangeLength = 0; // default, when optional byterange offset is left unspecified
-	int byteRangeOffset = 0;
-	bool discontinuity = false;
-	const char* programDateTime = NULL;
+	const IndexNode *index = (IndexNode *) this->index.ptr;
+	int idx = 0;
+	double fragmentPosition = 0.0; // playlist position of fragment at idx
 
 	traceprintf ("GetNextFragmentUriFromPlaylist : playTarget %f playlistPosition %f fragmentURI %p", playTarget, playlistPosition, fragmentURI);
 	if (playTarget < 0)
@@ -1371,10 +1389,11 @@ char *TrackState::GetNextFragmentUriFromPlaylist(bool ignoreDiscontinuity)
 		//logprintf("[PLAYLIST_POSITION==PLAY_TARGET]");
 		return fragmentURI;
 	}
-	if (playlistPosition != -1)
+	if (playlistPosition != -1 && playlistIdx >= 0)
 	{ // already presenting - skip past previous segment
 		//logprintf("[PLAYLIST_POSITION!= -1]");
-		ptr += strlen(fragmentURI) + 1;
+		idx = playlistIdx + 1;
+		fragmentPosition = playlistPosition + fragmentDurationSeconds;
 	}
 	if ((playlistPosition > playTarget) && (fragmentDurationSeconds > PLAYLIST_TIME_DIFF_THRESHOLD_SECONDS) &&
 		((playlistPosition - playTarget) > fragmentDurationSeconds))
@@ -1384,306 +1403,139 @@ char *TrackState::GetNextFragmentUriFromPlaylist(bool ignoreDiscontinuity)
 	}
 	if (-1 == playlistPosition)
 	{
-		// Starts parsing from beginning, so change to default
+		// Starts from beginning, so change to default
 		fragmentEncrypted = false;
+		mLastKeyTagIdx = -1;
 	}
-	//logprintf("%s: before loop, ptr = %p fragmentURI %p", __FUNCTION__, ptr, fragmentURI);
-	while (ptr)
+	while (idx < indexCount)
 	{
-		char *next = mystrpbrk(ptr);
-		//logprintf("ptr %s next %.*s", ptr, 10, next);
-		if (*ptr)
-		{
-			if (startswith(&ptr, "#EXT"))
-			{ // tags begins with #EXT
-				if (startswith(&ptr, "M3U"))
-				{ // "Extended M3U file" - always first line
+		if (!IsAtPlayTarget(fragmentPosition, index[idx].durationSeconds, playTarget))
+		{ // seek ahead - binary search for first fragment reaching play target
+			double base = fragmentPosition - GetFragmentStartTime(index, idx);
+			int low = idx + 1;
+			int high = indexCount;
+			while (low < high)
+			{
+				int mid = low + (high - low) / 2;
+				if (IsAtPlayTarget(base + GetFragmentStartTime(index, mid), index[mid].durationSeconds, playTarget))
+				{
+					high = mid;
 				}
-				else if (startswith(&ptr, "INF:"))
-				{// preceeds each advertised fragment in a playlist
-					if (-1 != playlistPosition)
-					{
-						playlistPosition += fragmentDurationSeconds;
-					}
-					else
-					{
-						playlistPosition = 0;
-					}
-					fragmentDurationSeconds = atof(ptr);
+				else
+				{
+					low = mid + 1;
+				}
+			}
+			idx = (low < indexCount) ? low : (indexCount - 1);
+			fragmentPosition = base + GetFragmentStartTime(index, idx);
+			if (low == indexCount)
+			{ // play target beyond last fragment
+				playlistPosition = fragmentPosition;
+				fragmentDurationSeconds = index[idx].durationSeconds;
+				playlistIdx = idx;
+				idx = indexCount;
+				break;
+			}
+		}
+		const IndexNode *node = &index[idx];
+		playlistPosition = fragmentPosition;
+		fragmentDurationSeconds = node->durationSeconds;
+		playlistIdx = idx;
+		nextMediaSequenceNumber = indexFirstMediaSequenceNumber + idx + 1;
 #ifdef TRACE
-					logprintf("Next - EXTINF - playlistPosition updated to %f", playlistPosition);
-					// optionally followed by human-readable title
+		logprintf("Next - EXTINF - playlistPosition updated to %f", playlistPosition);
 #endif
-				}
-				else if (startswith(&ptr, "-X-BYTERANGE:"))
+		if (node->keyTagIdx != mLastKeyTagIdx)
+		{
+			ApplyKeyTag(node->keyTagIdx);
+		}
+		if (node->pInitFragmentInfo)
+		{
+			AAMPLOG_TRACE("%s:%d: Old-Init : %s, New-Init:%s", __FUNCTION__, __LINE__, mInitFragmentInfo, node->pInitFragmentInfo);
+			if (!mInitFragmentInfo || !IsSamePlaylistLine(mInitFragmentInfo, node->pInitFragmentInfo))
+			{
+				mInitFragmentInfo = node->pInitFragmentInfo;
+				mInjectInitFragment = true;
+				AAMPLOG_INFO("%s:%d: Found #EXT-X-MAP data: %s", __FUNCTION__, __LINE__, mInitFragmentInfo);
+			}
+		}
+		bool discontinuity = node->discontinuity;
+		const char* programDateTime = (context->mNumberOfTracks > 1) ? node->pProgramDateTime : NULL;
+		if (discontinuity)
+		{
+			if (!ignoreDiscontinuity)
+			{
+				logprintf("%s:%d #EXT-X-DISCONTINUITY in track[%d] playTarget %f total mCulledSeconds %f", __FUNCTION__, __LINE__, type, playTarget, mCulledSeconds);
+				// Check if X-DISCONTINUITY tag is seen without explicit X-MAP tag
+				// Reuse last parsed/seen X-MAP tag in such cases
+				if (mInitFragmentInfo != NULL && mInjectInitFragment == false)
 				{
-					char  temp[1024];
-					strncpy(temp, ptr, 1023);
-					temp[1023] = 0x00;
-					char * offsetDelim = strchr(temp, '@'); // optional
-					if (offsetDelim)
-					{
-						*offsetDelim++ = 0x00;
-						byteRangeOffset = atoi(offsetDelim);
-					}
-					byteRangeLength = atoi(temp);
-					mByteOffsetCalculation = true;
-					if (0 != byteRangeLength && 0 == byteRangeOffset)
-					{
-						byteRangeOffset = this->byteRangeOffset + this->byteRangeLength;
-					}
-					AAMPLOG_TRACE("%s:%d byteRangeOffset:%d Last played fragment Offset:%d byteRangeLength:%d Last fragment Length:%d", __FUNCTION__,__LINE__, byteRangeOffset, this->byteRangeOffset, byteRangeLength, this->byteRangeLength);
-				}
-				else if (startswith(&ptr, "-X-TARGETDURATION:"))
-				{ // max media segment duration; required; appears once
-					targetDurationSeconds = atof(ptr);
+					mInjectInitFragment = true;
+					AAMPLOG_WARN("%s:%d: Reusing last seen #EXT-X-MAP for this discontinuity, data: %s", __FUNCTION__, __LINE__, mInitFragmentInfo);
 				}
-				else if (startswith(&ptr, "-X-MEDIA-SEQUENCE:"))
-				{// first media URI's unique integer sequence number
-					nextMediaSequenceNumber = atoll(ptr);
-				}
-				else if (startswith(&ptr, "-X-KEY:"))
-				{ // identifies licensing server to contact for authentication
-					ParseAttrList(ptr, ParseKeyAttributeCallback, this);
-				}
-				else if(startswith(&ptr,"-X-MAP:"))
+
+				TrackType otherType = (type == eTRACK_VIDEO)? eTRACK_AUDIO: eTRACK_VIDEO;
+				TrackState *other = context->trackState[otherType];
+				if (other->enabled)
 				{
-					AAMPLOG_TRACE("%s:%d: Old-Init : %s, New-Init:%s", __FUNCTION__, __LINE__, mInitFragmentInfo, ptr);
-					if ((!mInitFragmentInfo) || (mInitFragmentInfo && ptr && strcmp(mInitFragmentInfo, ptr) != 0))
+					double diff;
+					double position;
+					double playPosition = playTarget - mCulledSeconds;
+					if (!programDateTime)
 					{
-						mInitFragmentInfo = ptr;
-						mInjectInitFragment = true;
-						AAMPLOG_INFO("%s:%d: Found #EXT-X-MAP data: %s", __FUNCTION__, __LINE__, mInitFragmentInfo);
-					}
-				}
-				else if (startswith(&ptr, "-X-PROGRAM-DATE-TIME:"))
-				{ // associates following media URI with absolute date/time
-					// if used, should supplement any EXT-X-DISCONTINUITY tags
-					AAMPLOG_TRACE("Got EXT-X-PROGRAM-DATE-TIME: %s ", ptr);
-					if (context->mNumberOfTracks > 1)
-					{
-						programDateTime = ptr;
-						// The first X-PROGRAM-DATE-TIME tag holds the start time for each track
-						if (startTimeForPlaylistSync == 0.0 )
-						{
-							/* discarding timezone assuming audio and video tracks has same timezone and we use this time only for synchronization*/
-							startTimeForPlaylistSync = ISO8601DateTimeToUTCSeconds(ptr);
-							logprintf("%s %s StartTimeForPlaylistSync : %f ",__FUNCTION__,name, startTimeForPlaylistSync);							
-						}
-					}
-				}
-				else if (startswith(&ptr, "-X-ALLOW-CACHE:"))
-				{ // YES or NO - authorizes client to cache segments for later replay
-					if (startswith(&ptr, "YES"))
-					{
-						context->allowsCache = true;
-					}
-					else if (startswith(&ptr, "NO"))
-					{
-						context->allowsCache = false;
+						position = playPosition;
 					}
 					else
 					{
-						aamp_Error("unknown ALLOW-CACHE setting");
+						position = ISO8601DateTimeToUTCSeconds(programDateTime );
+						logprintf("%s:%d [%s] Discontinuity - position from program-date-time %f", __FUNCTION__, __LINE__, name, position);
 					}
-				}
-				else if (startswith(&ptr, "-X-PLAYLIST-TYPE:"))
-				{
-					//PlaylistType is handled during indexing.
-				}
-				else if (startswith(&ptr, "-X-ENDLIST"))
-				{ // indicates that no more media segments are available
-					logprintf("#EXT-X-ENDLIST");
-					mReachedEndListTag = true;
-				}
-				else if (startswith(&ptr, "-X-DISCONTINUITY-SEQUENCE"))
-				{
-					// ignore this tag for now 
-				}
-				else if (startswith(&ptr, "-X-DISCONTINUITY"))
-				{
-					discontinuity = true;
-				}
-				else if (startswith(&ptr, "-X-I-FRAMES-ONLY"))
-				{
-					logprintf("#EXT-X-I-FRAMES-ONLY");
-				}
-				else if (startswith(&ptr, "-X-VERSION:"))
-				{
-					int version = atoi(ptr);
-					(void)version;
-				}
-				// custom tags follow:
-				else if (startswith(&ptr, "-X-FAXS-CM:"))
-				{
-					//DRM meta data is stored during indexing.
-				}
-				else if (startswith(&ptr, "-X-FAXS-PACKAGINGCERT"))
-				{
-				}
-				else if (startswith(&ptr, "-X-FAXS-SIGNATURE"))
-				{
-				}
-				else if (startswith(&ptr, "-X-CUE"))
-				{
-				}
-				else if (startswith(&ptr, "-X-CM-SEQUENCE"))
-				{
-				}
-				else if (startswith(&ptr, "-X-MARKER"))
-				{
-				}
-				else if (startswith(&ptr, "-X-MAP"))
-				{
-				}
-				else if (startswith(&ptr, "-X-MEDIA-TIME"))
-				{
-				}
-				else if (startswith(&ptr, "-X-END-TOP-TAGS"))
-				{
-				}
-				else if (startswith(&ptr, "-X-CONTENT-IDENTIFIER"))
-				{
-				}
-				else if (startswith(&ptr, "-X-TRICKMODE-RESTRICTION"))
-				{
-				}
-				else if (startswith(&ptr, "-X-INDEPENDENT-SEGMENTS"))
-				{
-				}
-				else if (startswith(&ptr, "-X-BITRATE"))
-				{
-				}
-				else if (startswith(&ptr, "-X-FOG"))
-				{
-				}
-				else if (startswith(&ptr,"-UPLYNK-LIVE"))
-				{//tag related to uplynk streaming service
-				}
-				else if (startswith(&ptr, "-X-START:"))
-				{
-				}
-				else if (startswith(&ptr, "-X-XCAL-CONTENTMETADATA"))
-				{ // placeholder for new Super8 DRM Agnostic Metadata
-				}
-				else if (startswith(&ptr, "-NOM-I-FRAME-DISTANCE"))
-				{ // placeholder for nominal distance between IFrames
-				}
-				else if (startswith(&ptr, "-X-ADVERTISING"))
-				{ // placeholder for advertising zone for linear (soon to be deprecated)
-				}
-				else if (startswith(&ptr, "-X-SOURCE-STREAM"))
-				{ // placeholder for vss source stream id
-				}
-				else if (startswith(&ptr, "-X-X1-LIN-CK"))
-				{ // placeholder for deferred drm information
-				}
-				else if (startswith(&ptr, "-X-SCTE35"))
-				{ // placeholder for DAI tag processing
-				}
-				else 
-				{
-					std::string unknowTag= ptr;
-					AAMPLOG_INFO("***unknown tag:%s", unknowTag.substr(0,24).c_str());	
-				}
-			}
-			else if (*ptr == '#')
-			{ // all other lines beginning with # are comments
-			}
-			else if (*ptr == '\0')
-			{ // skip inserted null char
-			}
-			else
-			{ // URI
-				nextMediaSequenceNumber++;
-				if (((playlistPosition + fragmentDurationSeconds) > playTarget) || ((playTarget - playlistPosition) < PLAYLIST_TIME_DIFF_THRESHOLD_SECONDS))
-				{
-					//logprintf("Return fragment %s playlistPosition %f playTarget %f", ptr, playlistPosition, playTarget);
-					this->byteRangeOffset = byteRangeOffset;
-					this->byteRangeLength = byteRangeLength;
-					mByteOffsetCalculation = false;
-					if (discontinuity)
+					logprintf("%s %s Checking HasDiscontinuity for position :%f, playposition :%f playtarget:%f mDiscontinuityCheckingOn:%d",__FUNCTION__,name,position,playPosition,playTarget,mDiscontinuityCheckingOn);
+					if (!mDiscontinuityCheckingOn)
 					{
-						if (!ignoreDiscontinuity)
+						if(false == other->HasDiscontinuityAroundPosition(position, (NULL != programDateTime), diff, playPosition,mCulledSeconds,mProgramDateTime))
 						{
-							logprintf("%s:%d #EXT-X-DISCONTINUITY in track[%d] playTarget %f total mCulledSeconds %f", __FUNCTION__, __LINE__, type, playTarget, mCulledSeconds);
-							// Check if X-DISCONTINUITY tag is seen without explicit X-MAP tag
-							// Reuse last parsed/seen X-MAP tag in such cases
-							if (mInitFragmentInfo != NULL && mInjectInitFragment == false)
-							{
-								mInjectInitFragment = true;
-								AAMPLOG_WARN("%s:%d: Reusing last seen #EXT-X-MAP for this discontinuity, data: %s", __FUNCTION__, __LINE__, mInitFragmentInfo);
-							}
-
-							TrackType otherType = (type == eTRACK_VIDEO)? eTRACK_AUDIO: eTRACK_VIDEO;
-							TrackState *other = context->trackState[otherType];
-							if (other->enabled)
-							{
-								double diff;
-								double position;
-								double playPosition = playTarget - mCulledSeconds;
-								if (!programDateTime)
-								{
-									position = playPosition;
-								}
-								else
-								{
-									position = ISO8601DateTimeToUTCSeconds(programDateTime );
-									logprintf("%s:%d [%s] Discontinuity - position from program-date-time %f", __FUNCTION__, __LINE__, name, position);
-								}
-								logprintf("%s %s Checking HasDiscontinuity for position :%f, playposition :%f playtarget:%f mDiscontinuityCheckingOn:%d",__FUNCTION__,name,position,playPosition,playTarget,mDiscontinuityCheckingOn);								
-								if (!mDiscontinuityCheckingOn) 
-								{
-									if(false == other->HasDiscontinuityAroundPosition(position, (NULL != programDateTime), diff, playPosition,mCulledSeconds,mProgramDateTime))
-									{
-										logprintf("%s:%d [%s] Ignoring discontinuity as %s track does not have discontinuity", __FUNCTION__, __LINE__, name, other->name);
-										discontinuity = false;
-									}
-									else if (programDateTime)
-									{
-										logprintf("%s:%d [%s] diff %f ", __FUNCTION__, __LINE__, name, diff);
-										/*If other track's discontinuity is in advanced position, diff is positive*/
-										if (diff > fragmentDurationSeconds/2 )
-										{
-											/*Skip fragment*/
-											logprintf("%s:%d [%s] Discontinuity - other track's discontinuity time greater by %f. updating playTarget %f to %f",
-													__FUNCTION__, __LINE__, name, diff, playTarget, playlistPosition + diff);
-											mSyncAfterDiscontinuityInProgress = true;
-											playTarget = playlistPosition + diff;
-											discontinuity = false;
-											programDateTime = NULL;
-											ptr = next;
-											continue;
-										}
-									}
-								}
-								
-							}
+							logprintf("%s:%d [%s] Ignoring discontinuity as %s track does not have discontinuity", __FUNCTION__, __LINE__, name, other->name);
+							discontinuity = false;
 						}
-						else
+						else if (programDateTime)
 						{
-							discontinuity = false;
+							logprintf("%s:%d [%s] diff %f ", __FUNCTION__, __LINE__, name, diff);
+							/*If other track's discontinuity is in advanced position, diff is positive*/
+							if (diff > fragmentDurationSeconds/2 )
+							{
+								/*Skip fragment*/
+								logprintf("%s:%d [%s] Discontinuity - other track's discontinuity time greater by %f. updating playTarget %f to %f",
+										__FUNCTION__, __LINE__, name, diff, playTarget, playlistPosition + diff);
+								mSyncAfterDiscontinuityInProgress = true;
+								playTarget = playlistPosition + diff;
+								fragmentPosition = playlistPosition + fragmentDurationSeconds;
+								idx++;
+								continue;
+							}
 						}
 					}
-					this->discontinuity = discontinuity || mSyncAfterDiscontinuityInProgress;
-					mSyncAfterDiscontinuityInProgress = false;
-					traceprintf("%s:%d [%s] Discontinuity - %d", __FUNCTION__, __LINE__, name, (int)this->discontinuity);
-					rc = ptr;
-					break;
-				}
-				else
-				{
-					if(mByteOffsetCalculation)
-					{
-						byteRangeOffset += byteRangeLength;
-					}
-					discontinuity = false;
-					programDateTime = NULL;
-					// logprintf("Skipping fragment %s playlistPosition %f playTarget %f", ptr, playlistPosition, playTarget);
 				}
 			}
+			else
+			{
+				discontinuity = false;
+			}
+		}
+		this->discontinuity = discontinuity || mSyncAfterDiscontinuityInProgress;
+		mSyncAfterDiscontinuityInProgress = false;
+		traceprintf("%s:%d [%s] Discontinuity - %d", __FUNCTION__, __LINE__, name, (int)this->discontinuity);
+		rc = SelectIndexedFragment(idx);
+		break;
+	}
+	if (idx >= indexCount)
+	{ // no more fragments in playlist
+		nextMediaSequenceNumber = indexFirstMediaSequenceNumber + indexCount;
+		if (mHasEndListTag)
+		{ // indicates that no more media segments are available
+			logprintf("#EXT-X-ENDLIST");
+			mReachedEndListTag = true;
 		}
-		ptr = next;
 	}
 #ifdef TRACE
 	logprintf("GetNextFragmentUriFromPlaylist :  pos %f returning %s", playlistPosition, rc);
@@ -1697,67 +1549,69 @@ char *TrackState::GetNextFragmentUriFromPlaylist(bool ignoreDiscontinuity)
 * @fn FindMediaForSequenceNumber
 * @brief Get fragment tag based on media sequence number 
 *		 
-* @return string fragment tag line pointer 
+* @return string fragment URI pointer
 ***************************************************************************/
 char *TrackState::FindMediaForSequenceNumber()
 {
-	char *ptr = playlist.ptr;
 	long long mediaSequenceNumber = nextMediaSequenceNumber - 1;
-	char *key = NULL;
-	char *initFragment = NULL;
-
-	long long seq = 0;
-	while (ptr)
+	long long seq = (mediaSequenceNumber > indexFirstMediaSequenceNumber) ? mediaSequenceNumber : indexFirstMediaSequenceNumber;
+	if (seq - indexFirstMediaSequenceNumber >= indexCount)
 	{
-		char *next = mystrpbrk(ptr);
-		if (*ptr)
+		return NULL;
+	}
+	int idx = (int)(seq - indexFirstMediaSequenceNumber);
+	const IndexNode *node = &((IndexNode *) index.ptr)[idx];
+	if ((mDrmKeyTagCount >1) && node->keyTagIdx >= 0)
+	{
+		ApplyKeyTag(node->keyTagIdx);
+	}
+	mLastKeyTagIdx = node->keyTagIdx;
+	if (node->pInitFragmentInfo)
+	{
+		// mInitFragmentInfo will be cleared after calling FlushIndex() from IndexPlaylist()
+		if (!mInitFragmentInfo)
 		{
-			if (startswith(&ptr, "#EXTINF:"))
-			{
-				fragmentDurationSeconds = atof(ptr);
-			}
-			else if (startswith(&ptr, "#EXT-X-MEDIA-SEQUENCE:"))
-			{
-				seq = atoll(ptr);
-			}
-			else if (startswith(&ptr, "#EXT-X-KEY:"))
-			{
-				key = ptr;
-			}
-			else if (startswith(&ptr, "#EXT-X-MAP:"))
-			{
-				initFragment = ptr;
-			}
-			else if (ptr[0] != '#')
-			{ // URI
-				if (seq >= mediaSequenceNumber)
-				{
-					if ((mDrmKeyTagCount >1) && key)
-					{
-						ParseAttrList(key, ParseKeyAttributeCallback, this);
-					}
-					if (initFragment)
-					{
-						// mInitFragmentInfo will be cleared after calling FlushIndex() from IndexPlaylist()
-						if (!mInitFragmentInfo)
-						{
-							mInitFragmentInfo = initFragment;
-							AAMPLOG_INFO("%s:%d: Found #EXT-X-MAP data: %s", __FUNCTION__, __LINE__, mInitFragmentInfo);
-						}
-					}
-					if (seq != mediaSequenceNumber)
-					{
-						logprintf("seq gap %lld!=%lld", seq, mediaSequenceNumber);
-						nextMediaSequenceNumber = seq + 1;
-					}
-					return ptr;
-				}
-				seq++;
-			}
+			mInitFragmentInfo = node->pInitFragmentInfo;
+			AAMPLOG_INFO("%s:%d: Found #EXT-X-MAP data: %s", __FUNCTION__, __LINE__, mInitFragmentInfo);
 		}
-		ptr = next;
 	}
-	return NULL;
+	if (seq != mediaSequenceNumber)
+	{
+		logprintf("seq gap %lld!=%lld", seq, mediaSequenceNumber);
+		nextMediaSequenceNumber = seq + 1;
+	}
+	playlistIdx = idx;
+	return SelectIndexedFragment(idx);
+}
+/***************************************************************************
+* @fn PrefetchNextFragments
+* @brief Queue fragments following the selected one for download ahead
+*
+* Stops at a discontinuity, fragments after it may be skipped to sync tracks.
+*
+* @return void
+***************************************************************************/
+void TrackState::PrefetchNextFragments()
+{
+	const IndexNode *index = (IndexNode *) this->index.ptr;
+	int count = GetPrefetchCount();
+	for (int idx = playlistIdx + 1; count > 0 && idx < indexCount; idx++, count--)
+	{
+		const IndexNode *node = &index[idx];
+		if (node->discontinuity || node->uriOffset < 0 || node->uriLength == 0)
+		{
+			break;
+		}
+		std::string fragmentUrl;
+		std::string uri(node->pFragmentInfo + node->uriOffset, node->uriLength);
+		aamp_ResolveURL(fragmentUrl, mEffectiveUrl, uri.c_str());
+		char rangeStr[128];
+		if (node->byteRangeLength)
+		{
+			sprintf(rangeStr, "%d-%d", node->byteRangeOffset, node->byteRangeOffset + node->byteRangeLength - 1);
+		}
+		PrefetchFragment(fragmentUrl, node->byteRangeLength ? rangeStr : NULL, node->durationSeconds);
+	}
 }
 /***************************************************************************
 * @fn FetchFragmentHelper
@@ -1837,6 +1691,11 @@ bool TrackState::FetchFragmentHelper(long &http_error, bool &decryption_error, b
 			std::string fragmentUrl;
 			CachedFragment* cachedFragment = GetFetchBuffer(true);
 			aamp_ResolveURL(fragmentUrl, mEffectiveUrl, fragmentURI);
+			if (context->rate == AAMP_NORMAL_PLAY_RATE && !context->trickplayMode && !aamp->IsTSBSupported())
+			{
+				// Keep next fragments downloading while this one is fetched
+				PrefetchNextFragments();
+			}
 			traceprintf("Got next fragment url %s fragmentEncrypted %d discontinuity %d mDrmMethod %d", fragmentUrl, fragmentEncrypted, (int)discontinuity, mDrmMethod);
 
 			aamp->profiler.ProfileBegin(mediaTrackBucketTypes[type]);
@@ -1861,7 +1720,8 @@ bool TrackState::FetchFragmentHelper(long &http_error, bool &decryption_error, b
 			// if fragment URI uses relative path, we don't want to replace effective URI
 			std::string tempEffectiveUrl;
 			traceprintf("%s:%d Calling Getfile . buffer %p avail %d", __FUNCTION__, __LINE__, &cachedFragment->fragment, (int)cachedFragment->fragment.avail);
-			bool fetched = aamp->GetFile(fragmentUrl, &cachedFragment->fragment,
+			bool fetched = TakePrefetchedFragment(fragmentUrl, range, cachedFragment, tempEffectiveUrl, http_error) ||
+				aamp->GetFile(fragmentUrl, &cachedFragment->fragment,
 			 tempEffectiveUrl, &http_error, range, type, false, (MediaType)(type), NULL, NULL, fragmentDurationSeconds);
 			//Workaround for 404 of subtitle fragments
 			//TODO: This needs to be handled at server side and this workaround has to be removed
@@ -1931,6 +1791,15 @@ bool TrackState::FetchFragmentHelper(long &http_error, bool &decryption_error, b
 			{
 				// DrmDecrypt resets mKeyTagChanged , take a back up here to give back to caller
 				bKeyChanged = mKeyTagChanged;
+				if (mDecryptThreadStarted && mDrm && !mKeyTagChanged && context->firstFragmentDecrypted)
+				{
+					// Decrypt context is already set, decrypt thread works on it while next fragment is downloaded.
+					// Fragment is published to injector right away, injector waits for decryption to complete
+					QueueFragmentForDecrypt(cachedFragment);
+					return true;
+				}
+				// Fragments queued with current decrypt context have to be done before it is changed
+				WaitForPendingDecrypt();
 				{	
 					traceprintf("%s:%d [%s] uri %s - calling  DrmDecrypt()", __FUNCTION__, __LINE__, name, fragmentURI);
 					DrmReturn drmReturn = DrmDecrypt(cachedFragment, mediaTrackDecryptBucketTypes[type]);
@@ -1939,7 +1808,7 @@ bool TrackState::FetchFragmentHelper(long &http_error, bool &decryption_error, b
 					{
 						if (aamp->DownloadsAreEnabled())
 						{
-							logprintf("FetchFragmentHelper : drm_Decrypt failed. fragmentURI %s - RetryCount %d", fragmentURI, segDrmDecryptFailCount);
+							logprintf("FetchFragmentHelper : drm_Decrypt failed. fragmentURI %s - RetryCount %d", fragmentURI, segDrmDecryptFailCount.load());
 							if (eDRM_KEY_ACQUSITION_TIMEOUT == drmReturn)
 							{
 								decryption_error = true;
@@ -1949,9 +1818,9 @@ bool TrackState::FetchFragmentHelper(long &http_error, bool &decryption_error, b
 							else
 							{
 								/* Added to send tune error when fragments decryption failed */
-								segDrmDecryptFailCount +=1;
+								int failCount = ++segDrmDecryptFailCount;
 
-								if(aamp->mDrmDecryptFailCount <= segDrmDecryptFailCount)
+								if(aamp->mDrmDecryptFailCount <= failCount)
 								{
 									decryption_error = true;
 									AAMPLOG_ERR("FetchFragmentHelper : drm_Decrypt failed for fragments, reached failure threshold (%d) sending failure event", aamp->mDrmDecryptFailCount);
@@ -2173,6 +2042,12 @@ void TrackState::FetchFragment()
 ***************************************************************************/
 void TrackState::InjectFragmentInternal(CachedFragment* cachedFragment, bool &fragmentDiscarded)
 {
+	if (!WaitForFragmentDecrypted(cachedFragment))
+	{
+		AAMPLOG_WARN("%s:%d [%s] Skipping empty or undecrypted fragment, position %f", __FUNCTION__, __LINE__, name, cachedFragment->position);
+		fragmentDiscarded = true;
+		return;
+	}
 #ifndef SUPRESS_DECODE
 #ifndef FOG_HAMMER_TEST // support aamp stress-tests of fog without video decoding/presentation
 	if (playContext)
@@ -2182,13 +2057,14 @@ void TrackState::InjectFragmentInternal(CachedFragment* cachedFragment, bool &fr
 		{
 			position = cachedFragment->position;
 		}
-		fragmentDiscarded = !playContext->sendSegment(cachedFragment->fragment.ptr, cachedFragment->fragment.len,
+		fragmentDiscarded = !playContext->sendSegmentBuffer(&cachedFragment->fragment,
 				position, cachedFragment->duration, cachedFragment->discontinuity, ptsError);
 	}
 	else
 	{
 		fragmentDiscarded = false;
-		aamp->SendStream((MediaType)type, cachedFragment->fragment.ptr, cachedFragment->fragment.len,
+		// Ownership of fragment buffer is handed over to sink, avoids copying the fragment again
+		aamp->SendStream((MediaType)type, &cachedFragment->fragment,
 		        cachedFragment->position, cachedFragment->position, cachedFragment->duration);
 	}
 #endif
@@ -2257,6 +2133,7 @@ void TrackState::FlushIndex()
 	aamp_Free(&index.ptr);
 	indexFirstMediaSequenceNumber = 0;
 	mProgramDateTime = 0.0; // new member - stored first program date time (if any) from playlist
+	mProgramDateTimeInfo = NULL;
 	indexCount = 0;
 	index.len = 0;
 	index.avail = 0;
@@ -2265,6 +2142,7 @@ void TrackState::FlushIndex()
 	mLastKeyTagIdx = -1;
 	mDeferredDrmKeyMaxTime = 0;
 	mKeyHashTable.clear();
+	mHasEndListTag = false;
 	mDiscontinuityIndexCount = 0;
 	aamp_Free(&mDiscontinuityIndex.ptr);
 	memset(&mDiscontinuityIndex, 0, sizeof(mDiscontinuityIndex));
@@ -2456,65 +2334,298 @@ void TrackState::InitiateDRMKeyAcquisition(int indexPosn)
 }
 
 /***************************************************************************
-* @fn SetDrmContext
-* @brief Function to set DRM Context when KeyTag changes
-* @return None
+* @fn SetDrmContext
+* @brief Function to set DRM Context when KeyTag changes
+* @return None
+***************************************************************************/
+void TrackState::SetDrmContext()
+{
+	// Set the appropriate DrmContext for Decryption
+	// This function need to be called where KeyMethod != None is found after indexplaylist
+	// or when new KeyMethod is found , None to AES or between AES with different Method
+	// or between KeyMethond when IV or URL changes (for Vanilla AES)
+
+	bool drmContextUpdated = false;
+	DrmMetadataNode* drmMetadataIdx = (DrmMetadataNode*)mDrmMetaDataIndex.ptr;
+
+	if(drmMetadataIdx)
+	{
+		logprintf("TrackState::[%s][%s] Enter mCMSha1Hash [%p] mDrmMetaDataIndexPosition %d", __FUNCTION__,name, mCMSha1Hash,
+			mDrmMetaDataIndexPosition);
+		// Get the DRM Instance based on current Sha1
+		// a) If Multi Key involved mCMSha1Hash will have value ,based on which DRM Instance is picked
+		// b) If Single Key invloved (no mCMSha1Hash), but with diff Meta for audio and video , based on track type appropriate DRM instance picked
+		// c) If Single Key involved (no mCMSha1Hash) , audio/video having same meta, AveDrmManager will get the the only on Drm Instance
+		mDrm = AveDrmManager::GetAveDrm(mCMSha1Hash,type);
+		if(mDrm && mDrm->GetState() != DRMState::eDRM_KEY_ACQUIRED)
+			{
+				// Need of the hour ,initiate the key before the decrypt function is called
+				logprintf("%s:%d:[%s] Initiating Key Request as Key is not available for index [%d]",__FUNCTION__,__LINE__,name,mDrmMetaDataIndexPosition);
+				InitiateDRMKeyAcquisition(mDrmMetaDataIndexPosition);
+			}
+	}
+	else
+	{
+#ifdef AAMP_VANILLA_AES_SUPPORT
+		AAMPLOG_INFO("StreamAbstractionAAMP_HLS::%s:%d Get AesDec", __FUNCTION__, __LINE__);
+		mDrm = AesDec::GetInstance();
+#else
+		logprintf("StreamAbstractionAAMP_HLS::%s:%d AAMP_VANILLA_AES_SUPPORT not defined", __FUNCTION__, __LINE__);
+#endif
+	}
+	if(mDrm)
+	{
+		mDrm->SetDecryptInfo(aamp, &mDrmInfo);
+	}
+}
+
+/***************************************************************************
+* @fn GetNextLineStart
+* @brief Function to get start of the next line
+* @param[in] ptr buffer to do the operation
+* @return start of the next line
+***************************************************************************/
+static char* GetNextLineStart(char* ptr)
+{
+	ptr = strchr(ptr, CHAR_LF);
+	if( ptr )
+	{
+	    ptr++;
+	}
+	return ptr;
+}
+
+/***************************************************************************
+* @fn IsSamePlaylistLine
+* @brief Function to compare two playlist lines, line end may already be
+*        replaced by NUL in a playlist consumed by fragment collector
+* @param[in] line1 start of first line
+* @param[in] line2 start of second line
+* @return true if lines are identical
+***************************************************************************/
+static bool IsSamePlaylistLine(const char *line1, const char *line2)
+{
+	while (true)
+	{
+		bool end1 = (*line1 == 0x00 || *line1 == CHAR_LF || *line1 == CHAR_CR);
+		bool end2 = (*line2 == 0x00 || *line2 == CHAR_LF || *line2 == CHAR_CR);
+		if (end1 || end2)
+		{
+			return (end1 && end2);
+		}
+		if (*line1++ != *line2++)
+		{
+			return false;
+		}
+	}
+}
+
+/***************************************************************************
+* @fn FindRetainedFragments
+* @brief Function to locate fragments of previous playlist retained in refreshed playlist
+* @param[in] prevPlaylist previously indexed playlist
+* @param[in] prevNodes IndexNode records of previous playlist
+* @param[in] prevIndexCount number of IndexNode records of previous playlist
+* @param[in] culledCount number of fragments removed from head of playlist
+* @param[in] playlist refreshed playlist
+* @param[in] fragmentInfo first #EXTINF line of refreshed playlist
+* @param[out] lastFragmentUri uri line of last retained fragment in refreshed playlist
+* @return offset of retained fragments in refreshed playlist relative to previous playlist,
+*         0 with lastFragmentUri set to NULL if fragments could not be located
+***************************************************************************/
+static long FindRetainedFragments(const GrowableBuffer *prevPlaylist, const IndexNode *prevNodes, int prevIndexCount, int culledCount,
+		const GrowableBuffer *playlist, char *fragmentInfo, char **lastFragmentUri)
+{
+	*lastFragmentUri = NULL;
+	long shift = (fragmentInfo - playlist->ptr) - (prevNodes[culledCount].pFragmentInfo - prevPlaylist->ptr);
+	if (!IsSamePlaylistLine(prevNodes[culledCount].pFragmentInfo, fragmentInfo))
+	{
+		return 0;
+	}
+	// Retained fragments are expected at the same relative offsets, verify last one and its uri
+	long lastOffset = (prevNodes[prevIndexCount - 1].pFragmentInfo - prevPlaylist->ptr) + shift;
+	if (lastOffset < (fragmentInfo - playlist->ptr) || lastOffset >= (long)playlist->len)
+	{
+		return 0;
+	}
+	char *last = playlist->ptr + lastOffset;
+	if (!IsSamePlaylistLine(prevNodes[prevIndexCount - 1].pFragmentInfo, last))
+	{
+		return 0;
+	}
+	char *uri = GetNextLineStart(last);
+	while (uri && *uri == '#')
+	{
+		uri = GetNextLineStart(uri);
+	}
+	if (uri)
+	{
+		long prevUriOffset = (uri - playlist->ptr) - shift;
+		if (prevUriOffset >= 0 && prevUriOffset < (long)prevPlaylist->len && IsSamePlaylistLine(prevPlaylist->ptr + prevUriOffset, uri))
+		{
+			*lastFragmentUri = uri;
+			return shift;
+		}
+	}
+	return 0;
+}
+
+/***************************************************************************
+* @fn GetPlaylistLine
+* @brief Function to get a line of playlist text, line end may already be
+*        replaced by NUL in a playlist consumed by fragment collector
+* @param[in,out] ptr start of line, moved to start of next line
+* @param[in] end end of playlist text
+* @return line without line terminator
+***************************************************************************/
+static std::string GetPlaylistLine(const char *&ptr, const char *end)
+{
+	const char *lineEnd = ptr;
+	while (lineEnd < end && *lineEnd != CHAR_LF && *lineEnd != CHAR_CR && *lineEnd != 0x00)
+	{
+		lineEnd++;
+	}
+	std::string line(ptr, lineEnd - ptr);
+	if (lineEnd < end && *lineEnd == CHAR_CR)
+	{
+		lineEnd++;
+	}
+	if (lineEnd < end)
+	{
+		lineEnd++;
+	}
+	ptr = lineEnd;
+	return line;
+}
+
+/***************************************************************************
+* @fn IsMediaSegmentTag
+* @brief Function to check if playlist tag line belongs to the media segment following it
+* @param[in] line tag line
+* @return false for playlist level tags and tags not carried over by delta update
+***************************************************************************/
+static bool IsMediaSegmentTag(const std::string &line)
+{
+	static const char *playlistTags[] = { "#EXTM3U", "#EXT-X-VERSION", "#EXT-X-TARGETDURATION", "#EXT-X-MEDIA-SEQUENCE",
+		"#EXT-X-DISCONTINUITY-SEQUENCE", "#EXT-X-SERVER-CONTROL", "#EXT-X-PART-INF", "#EXT-X-PLAYLIST-TYPE",
+		"#EXT-X-INDEPENDENT-SEGMENTS", "#EXT-X-START", "#EXT-X-ALLOW-CACHE", "#EXT-X-ENDLIST", "#EXT-X-SKIP",
+		"#EXT-X-DATERANGE", "#EXT-X-PART:", "#EXT-X-PRELOAD-HINT", "#EXT-X-RENDITION-REPORT" };
+	for (const char *tag : playlistTags)
+	{
+		if (line.compare(0, strlen(tag), tag) == 0)
+		{
+			return false;
+		}
+	}
+	return true;
+}
+
+/***************************************************************************
+* @fn ExpandDeltaPlaylist
+* @brief Function to rebuild full playlist from a delta update, segments replaced
+*        by #EXT-X-SKIP are taken from previous playlist
+* @param[in] prevPlaylist previous full playlist
+* @param[in,out] playlist downloaded playlist, replaced by full playlist if it is a delta update
+* @return false if skipped segments are not all present in previous playlist
 ***************************************************************************/
-void TrackState::SetDrmContext()
+static bool ExpandDeltaPlaylist(const GrowableBuffer *prevPlaylist, GrowableBuffer *playlist)
 {
-	// Set the appropriate DrmContext for Decryption
-	// This function need to be called where KeyMethod != None is found after indexplaylist
-	// or when new KeyMethod is found , None to AES or between AES with different Method
-	// or between KeyMethond when IV or URL changes (for Vanilla AES)
-
-	bool drmContextUpdated = false;
-	DrmMetadataNode* drmMetadataIdx = (DrmMetadataNode*)mDrmMetaDataIndex.ptr;
-
-	if(drmMetadataIdx)
+	std::string delta(playlist->ptr, playlist->len);
+	size_t skipPos = delta.find("#EXT-X-SKIP:");
+	if (skipPos == std::string::npos)
 	{
-		logprintf("TrackState::[%s][%s] Enter mCMSha1Hash [%p] mDrmMetaDataIndexPosition %d", __FUNCTION__,name, mCMSha1Hash,
-			mDrmMetaDataIndexPosition);
-		// Get the DRM Instance based on current Sha1
-		// a) If Multi Key involved mCMSha1Hash will have value ,based on which DRM Instance is picked
-		// b) If Single Key invloved (no mCMSha1Hash), but with diff Meta for audio and video , based on track type appropriate DRM instance picked
-		// c) If Single Key involved (no mCMSha1Hash) , audio/video having same meta, AveDrmManager will get the the only on Drm Instance
-		mDrm = AveDrmManager::GetAveDrm(mCMSha1Hash,type);
-		if(mDrm && mDrm->GetState() != DRMState::eDRM_KEY_ACQUIRED)
-			{
-				// Need of the hour ,initiate the key before the decrypt function is called
-				logprintf("%s:%d:[%s] Initiating Key Request as Key is not available for index [%d]",__FUNCTION__,__LINE__,name,mDrmMetaDataIndexPosition);
-				InitiateDRMKeyAcquisition(mDrmMetaDataIndexPosition);
-			}
+		// Server sent full playlist
+		return true;
 	}
-	else
+	size_t skipEnd = delta.find(CHAR_LF, skipPos);
+	skipEnd = (skipEnd == std::string::npos) ? delta.size() : skipEnd + 1;
+	size_t attrPos = delta.find("SKIPPED-SEGMENTS=", skipPos);
+	if (attrPos == std::string::npos || attrPos >= skipEnd)
 	{
-#ifdef AAMP_VANILLA_AES_SUPPORT
-		AAMPLOG_INFO("StreamAbstractionAAMP_HLS::%s:%d Get AesDec", __FUNCTION__, __LINE__);
-		mDrm = AesDec::GetInstance();
-#else
-		logprintf("StreamAbstractionAAMP_HLS::%s:%d AAMP_VANILLA_AES_SUPPORT not defined", __FUNCTION__, __LINE__);
-#endif
+		return false;
 	}
-	if(mDrm)
+	long long skippedCount = atoll(delta.c_str() + attrPos + strlen("SKIPPED-SEGMENTS="));
+	long long firstSkipped = 0;
+	size_t seqPos = delta.find("#EXT-X-MEDIA-SEQUENCE:");
+	if (seqPos != std::string::npos)
 	{
-		mDrm->SetDecryptInfo(aamp, &mDrmInfo);
+		firstSkipped = atoll(delta.c_str() + seqPos + strlen("#EXT-X-MEDIA-SEQUENCE:"));
 	}
-}
 
-/***************************************************************************
-* @fn GetNextLineStart
-* @brief Function to get start of the next line
-* @param[in] ptr buffer to do the operation
-* @return start of the next line
-***************************************************************************/
-static char* GetNextLineStart(char* ptr)
-{
-	ptr = strchr(ptr, CHAR_LF);
-	if( ptr )
+	// Segment block is the segment uri and the tags preceding it; key and map in effect
+	// at first skipped segment are repeated ahead of it
+	std::string segments;
+	std::string block;
+	std::string key;
+	std::string map;
+	long long sequence = 0;
+	long long copied = 0;
+	const char *ptr = prevPlaylist->ptr;
+	const char *end = prevPlaylist->ptr + prevPlaylist->len;
+	while (ptr < end && copied < skippedCount)
 	{
-	    ptr++;
+		std::string line = GetPlaylistLine(ptr, end);
+		if (line.empty())
+		{
+			continue;
+		}
+		if (line[0] == '#')
+		{
+			if (line.compare(0, strlen("#EXT-X-MEDIA-SEQUENCE:"), "#EXT-X-MEDIA-SEQUENCE:") == 0)
+			{
+				sequence = atoll(line.c_str() + strlen("#EXT-X-MEDIA-SEQUENCE:"));
+			}
+			else if (IsMediaSegmentTag(line))
+			{
+				block.append(line).append("\n");
+			}
+			continue;
+		}
+		if (sequence >= firstSkipped)
+		{
+			if (copied == 0)
+			{
+				if (!key.empty() && block.find("#EXT-X-KEY:") == std::string::npos)
+				{
+					segments.append(key).append("\n");
+				}
+				if (!map.empty() && block.find("#EXT-X-MAP:") == std::string::npos)
+				{
+					segments.append(map).append("\n");
+				}
+			}
+			segments.append(block).append(line).append("\n");
+			copied++;
+		}
+		else
+		{
+			const char *blockPtr = block.c_str();
+			const char *blockEnd = blockPtr + block.size();
+			while (blockPtr < blockEnd)
+			{
+				std::string tag = GetPlaylistLine(blockPtr, blockEnd);
+				if (tag.compare(0, strlen("#EXT-X-KEY:"), "#EXT-X-KEY:") == 0)
+				{
+					key = tag;
+				}
+				else if (tag.compare(0, strlen("#EXT-X-MAP:"), "#EXT-X-MAP:") == 0)
+				{
+					map = tag;
+				}
+			}
+		}
+		block.clear();
+		sequence++;
 	}
-	return ptr;
+	if (copied != skippedCount)
+	{
+		AAMPLOG_WARN("%s:%d found %lld of %lld skipped segments from %lld", __FUNCTION__, __LINE__, copied, skippedCount, firstSkipped);
+		return false;
+	}
+	delta.replace(skipPos, skipEnd - skipPos, segments);
+	playlist->len = 0;
+	aamp_AppendBytes(playlist, delta.data(), delta.size());
+	return true;
 }
 
 /***************************************************************************
@@ -2550,9 +2661,12 @@ static size_t FindLineLength(const char* ptr)
 * @fn IndexPlaylist
 * @brief Function to parse playlist 
 *		 
+* @param[in] IsRefresh true if playlist is a refresh of live playlist
+* @param[out] culledSec seconds culled from playlist head on refresh
+* @param[in] prevPlaylist previously indexed playlist, fragments retained from it are not parsed again
 * @return double total duration from playlist
 ***************************************************************************/
-void TrackState::IndexPlaylist(bool IsRefresh, double &culledSec)
+void TrackState::IndexPlaylist(bool IsRefresh, double &culledSec, const GrowableBuffer *prevPlaylist)
 {
 	double totalDuration = 0.0;
 	traceprintf("%s:%d Enter ", __FUNCTION__, __LINE__);
@@ -2565,8 +2679,30 @@ void TrackState::IndexPlaylist(bool IsRefresh, double &culledSec)
 		prevSecondsBeforePlayPoint = GetCompletionTimeForFragment(this, commonPlayPosition); 
 	}
 
+	// On live refresh, keep index of previous playlist so that fragments still listed need not be parsed again.
+	// Playlists with DRM tags are always indexed fully as key/metadata state is tracked per fragment
+	GrowableBuffer prevIndex;
+	GrowableBuffer prevDiscontinuityIndex;
+	memset(&prevIndex, 0, sizeof(prevIndex));
+	memset(&prevDiscontinuityIndex, 0, sizeof(prevDiscontinuityIndex));
+	int prevIndexCount = 0;
+	int prevDiscontinuityIndexCount = 0;
+	long long prevFirstMediaSequenceNumber = indexFirstMediaSequenceNumber;
+	const char* prevProgramDateTimeInfo = mProgramDateTimeInfo;
+	if (IsRefresh && prevPlaylist && prevPlaylist->ptr && gpGlobalConfig->hlsIncrementalIndex && IsLive() && indexCount > 0 &&
+		mDrmKeyTagCount == 0 && mDrmMetaDataIndexCount == 0 && !mCheckForInitialFragEnc)
+	{
+		prevIndex = index;
+		prevIndexCount = indexCount;
+		prevDiscontinuityIndex = mDiscontinuityIndex;
+		prevDiscontinuityIndexCount = mDiscontinuityIndexCount;
+		memset(&index, 0, sizeof(index));
+		memset(&mDiscontinuityIndex, 0, sizeof(mDiscontinuityIndex));
+	}
+
 	FlushIndex();
 	mIndexingInProgress = true;
+	mCanSkipUntil = 0;
 	if (playlist.ptr )
 	{
 		char *ptr;
@@ -2580,14 +2716,15 @@ void TrackState::IndexPlaylist(bool IsRefresh, double &culledSec)
 		    logprintf("ERROR: Invalid Playlist DATA:%s ", temp);
 		    aamp->SendErrorEvent(AAMP_TUNE_INVALID_MANIFEST_FAILURE);
 		    mDuration = totalDuration;
+		    aamp_Free(&prevIndex.ptr);
+		    aamp_Free(&prevDiscontinuityIndex.ptr);
 		    pthread_cond_signal(&mPlaylistIndexed);
 		    pthread_mutex_unlock(&mPlaylistMutex);
 		    return;
 		}
 		DrmMetadataNode drmMetadataNode;
 		IndexNode node;
-		node.completionTimeSecondsFromStart = 0.0;
-		node.pFragmentInfo = NULL;
+		memset(&node, 0, sizeof(node));
 		int drmMetadataIdx = -1;
 		bool deferDrmTagPresent = false;
 		const char* deferDrmVal = NULL;
@@ -2595,13 +2732,103 @@ void TrackState::IndexPlaylist(bool IsRefresh, double &culledSec)
 		bool mediaSequence = false;
 		const char* programDateTimeIdxOfFragment = NULL;
 		bool discontinuity = false;
+		const char* initFragmentInfo = NULL;
+		const char* byteRange = NULL;
+		int byteRangeEnd = 0;
 		ptr = GetNextLineStart(playlist.ptr);
 		while (ptr)
 		{
 			if(startswith(&ptr,"#EXT"))
 			{
-				if (startswith(&ptr,"INF:"))
+				char *lastFragmentUri = NULL;
+				long shift = 0;
+				int culledCount = (int)(indexFirstMediaSequenceNumber - prevFirstMediaSequenceNumber);
+				if (prevIndexCount > 0 && indexCount == 0 && mediaSequence && culledCount >= 0 && culledCount < prevIndexCount &&
+					mDrmKeyTagCount == 0 && mDrmMetaDataIndexCount == 0 && strncmp(ptr, "INF:", 4) == 0)
+				{
+					shift = FindRetainedFragments(prevPlaylist, (IndexNode *)prevIndex.ptr, prevIndexCount, culledCount, &playlist, ptr-4, &lastFragmentUri);
+				}
+				if (lastFragmentUri)
+				{
+					// Carry over records of fragments retained from previous playlist, parsing resumes after them
+					const IndexNode *prevNodes = (IndexNode *)prevIndex.ptr;
+					double culledDuration = (culledCount > 0) ? prevNodes[culledCount - 1].completionTimeSecondsFromStart : 0.0;
+					const char *retainedStart = prevNodes[culledCount].pFragmentInfo;
+					bool firstDiscontinuity = discontinuity;
+					const char *firstProgramDateTime = programDateTimeIdxOfFragment;
+					if (discontinuity)
+					{
+						logprintf("%s:%d #EXT-X-DISCONTINUITY in track[%d] indexCount %d periodPosition %f", __FUNCTION__, __LINE__, type, indexCount, totalDuration);
+						DiscontinuityIndexNode discontinuityIndexNode;
+						discontinuityIndexNode.fragmentIdx = indexCount;
+						discontinuityIndexNode.position = totalDuration;
+						discontinuityIndexNode.programDateTime = programDateTimeIdxOfFragment;
+						discontinuityIndexNode.fragmentDuration = atof(ptr+4);
+						aamp_AppendBytes(&mDiscontinuityIndex, &discontinuityIndexNode, sizeof(DiscontinuityIndexNode));
+						mDiscontinuityIndexCount++;
+						discontinuity = false;
+					}
+					programDateTimeIdxOfFragment = NULL;
+					indexCount = prevIndexCount - culledCount;
+					aamp_AppendBytes(&index, &prevNodes[culledCount], indexCount * sizeof(IndexNode));
+					IndexNode *nodes = (IndexNode *)index.ptr;
+					for (int i = 0; i < indexCount; i++)
+					{
+						nodes[i].pFragmentInfo = playlist.ptr + (nodes[i].pFragmentInfo - prevPlaylist->ptr) + shift;
+						nodes[i].completionTimeSecondsFromStart -= culledDuration;
+						// Tags ahead of first retained fragment are parsed again, those after it moved along with fragments
+						if (nodes[i].pInitFragmentInfo)
+						{
+							nodes[i].pInitFragmentInfo = (nodes[i].pInitFragmentInfo < retainedStart) ? initFragmentInfo :
+									playlist.ptr + (nodes[i].pInitFragmentInfo - prevPlaylist->ptr) + shift;
+						}
+						if (i == 0)
+						{
+							nodes[i].discontinuity = firstDiscontinuity;
+							nodes[i].pProgramDateTime = firstProgramDateTime;
+						}
+						else if (nodes[i].pProgramDateTime)
+						{
+							nodes[i].pProgramDateTime = playlist.ptr + (nodes[i].pProgramDateTime - prevPlaylist->ptr) + shift;
+						}
+					}
+					totalDuration = nodes[indexCount - 1].completionTimeSecondsFromStart;
+					node = nodes[indexCount - 1];
+					initFragmentInfo = node.pInitFragmentInfo;
+					byteRangeEnd = node.byteRangeOffset + node.byteRangeLength;
+
+					const DiscontinuityIndexNode *prevDiscontinuityNodes = (DiscontinuityIndexNode *)prevDiscontinuityIndex.ptr;
+					for (int i = 0; i < prevDiscontinuityIndexCount; i++)
+					{
+						if (prevDiscontinuityNodes[i].fragmentIdx > culledCount)
+						{
+							DiscontinuityIndexNode discontinuityIndexNode = prevDiscontinuityNodes[i];
+							discontinuityIndexNode.fragmentIdx -= culledCount;
+							discontinuityIndexNode.position -= culledDuration;
+							if (discontinuityIndexNode.programDateTime)
+							{
+								discontinuityIndexNode.programDateTime = playlist.ptr + (discontinuityIndexNode.programDateTime - prevPlaylist->ptr) + shift;
+							}
+							aamp_AppendBytes(&mDiscontinuityIndex, &discontinuityIndexNode, sizeof(DiscontinuityIndexNode));
+							mDiscontinuityIndexCount++;
+						}
+					}
+
+					// Last EXT-X-PROGRAM-DATE-TIME seen so far is the one of retained fragments, if any
+					const char *prevLastFragmentUri = prevPlaylist->ptr + (lastFragmentUri - playlist.ptr) - shift;
+					if (prevProgramDateTimeInfo && prevProgramDateTimeInfo > prevNodes[culledCount].pFragmentInfo &&
+						prevProgramDateTimeInfo < prevLastFragmentUri)
+					{
+						mProgramDateTimeInfo = playlist.ptr + (prevProgramDateTimeInfo - prevPlaylist->ptr) + shift;
+						mProgramDateTime = ISO8601DateTimeToUTCSeconds(mProgramDateTimeInfo);
+					}
+					AAMPLOG_INFO("%s %s reused %d indexed fragments, culled %d", __FUNCTION__, name, indexCount, culledCount);
+					ptr = lastFragmentUri;
+				}
+				else if (startswith(&ptr,"INF:"))
 				{
+					node.discontinuity = discontinuity;
+					node.pProgramDateTime = programDateTimeIdxOfFragment;
 					if (discontinuity)
 					{
 						logprintf("%s:%d #EXT-X-DISCONTINUITY in track[%d] indexCount %d periodPosition %f", __FUNCTION__, __LINE__, type, indexCount, totalDuration);
@@ -2617,9 +2844,17 @@ void TrackState::IndexPlaylist(bool IsRefresh, double &culledSec)
 					programDateTimeIdxOfFragment = NULL;
 					node.pFragmentInfo = ptr-8;//Point to beginning of #EXTINF
 					indexCount++;
-					totalDuration += atof(ptr);
+					node.durationSeconds = atof(ptr);
+					totalDuration += node.durationSeconds;
 					node.completionTimeSecondsFromStart = totalDuration;
 					node.drmMetadataIdx = drmMetadataIdx;
+					// Rest is filled from tags up to fragment uri
+					node.keyTagIdx = -1;
+					node.pInitFragmentInfo = NULL;
+					node.uriOffset = -1;
+					node.uriLength = 0;
+					node.byteRangeOffset = 0;
+					node.byteRangeLength = 0;
 					aamp_AppendBytes(&index, &node, sizeof(node));
 				}
 				else if(startswith(&ptr,"-X-MEDIA-SEQUENCE:"))
@@ -2633,6 +2868,17 @@ void TrackState::IndexPlaylist(bool IsRefresh, double &culledSec)
 					targetDurationSeconds = atof(ptr);
 					AAMPLOG_INFO("aamp: EXT-X-TARGETDURATION = %f", targetDurationSeconds);
 				}
+				else if(startswith(&ptr,"-X-SERVER-CONTROL:"))
+				{
+					// Server offers delta updates of playlist, with segments older than CAN-SKIP-UNTIL skipped
+					size_t len = FindLineLength(ptr);
+					std::string attrs(ptr, len);
+					size_t attrPos = attrs.find("CAN-SKIP-UNTIL=");
+					if (attrPos != std::string::npos)
+					{
+						mCanSkipUntil = atof(attrs.c_str() + attrPos + strlen("CAN-SKIP-UNTIL="));
+					}
+				}
 				else if(startswith(&ptr,"-X-X1-LIN-CK:"))
 				{
 					// get the deferred drm key acquisition time
@@ -2692,6 +2938,7 @@ void TrackState::IndexPlaylist(bool IsRefresh, double &culledSec)
 				else if (startswith(&ptr, "-X-PROGRAM-DATE-TIME:"))
 				{
 					programDateTimeIdxOfFragment = ptr;					
+					mProgramDateTimeInfo = ptr;
 					mProgramDateTime = ISO8601DateTimeToUTCSeconds(ptr);
 					AAMPLOG_INFO("%s EXT-X-PROGRAM-DATE-TIME: %.*s ",name, 30, programDateTimeIdxOfFragment);
 					// The first X-PROGRAM-DATE-TIME tag holds the start time for each track
@@ -2768,8 +3015,28 @@ void TrackState::IndexPlaylist(bool IsRefresh, double &culledSec)
 					free (key);
 					mDrmKeyTagCount++;
 				}
+				else if (startswith(&ptr, "-X-BYTERANGE:"))
+				{
+					byteRange = ptr;
+				}
+				else if (startswith(&ptr, "-X-ALLOW-CACHE:"))
+				{ // YES or NO - authorizes client to cache segments for later replay
+					if (startswith(&ptr, "YES"))
+					{
+						context->allowsCache = true;
+					}
+					else if (startswith(&ptr, "NO"))
+					{
+						context->allowsCache = false;
+					}
+					else
+					{
+						aamp_Error("unknown ALLOW-CACHE setting");
+					}
+				}
 				else if(startswith(&ptr,"-X-MAP:"))
 				{
+					initFragmentInfo = ptr;
 					if (mCheckForInitialFragEnc)
 					{
 						AAMPLOG_TRACE("%s:%d fragmentEncrypted-%d drmMethod-%d and ptr - %s", __FUNCTION__, __LINE__, fragmentEncrypted, mDrmMethod, ptr);
@@ -2805,6 +3072,7 @@ void TrackState::IndexPlaylist(bool IsRefresh, double &culledSec)
 				}
 				else if (startswith(&ptr,"-X-ENDLIST"))
 				{
+					mHasEndListTag = true;
 					// ENDLIST found .Check playlist tag with vod was missing or not.If playlist still undefined
 					// mark it as VOD
 					if (IsLive())
@@ -2823,6 +3091,30 @@ void TrackState::IndexPlaylist(bool IsRefresh, double &culledSec)
 					}
 				}
 			}
+			else if (*ptr != '#' && *ptr != CHAR_LF && *ptr != CHAR_CR && *ptr != 0x00 && indexCount > 0)
+			{ // URI, completes record of fragment
+				IndexNode *fragment = &((IndexNode *)index.ptr)[indexCount - 1];
+				if (fragment->uriOffset < 0)
+				{
+					fragment->uriOffset = (int)(ptr - fragment->pFragmentInfo);
+					fragment->uriLength = (int)FindLineLength(ptr);
+					fragment->keyTagIdx = mDrmKeyTagCount - 1;
+					fragment->pInitFragmentInfo = initFragmentInfo;
+					if (byteRange)
+					{
+						// offset is optional, fragment then follows previous sub-range
+						fragment->byteRangeLength = atoi(byteRange);
+						const char *offsetDelim = byteRange;
+						while (*offsetDelim != '@' && *offsetDelim != CHAR_LF && *offsetDelim != 0x00)
+						{
+							offsetDelim++;
+						}
+						fragment->byteRangeOffset = (*offsetDelim == '@') ? atoi(offsetDelim + 1) : byteRangeEnd;
+						byteRangeEnd = fragment->byteRangeOffset + fragment->byteRangeLength;
+						byteRange = NULL;
+					}
+				}
+			}
 			ptr=GetNextLineStart(ptr);
 		}
 
@@ -2924,6 +3216,8 @@ void TrackState::IndexPlaylist(bool IsRefresh, double &culledSec)
 			AAMPLOG_INFO("%s %s Prev:%f Now:%f  culled with ProgramDateTime %f",__FUNCTION__,name,prevProgramDateTime,mProgramDateTime, culledSec);		
 		}
 	}	
+	aamp_Free(&prevIndex.ptr);
+	aamp_Free(&prevDiscontinuityIndex.ptr);
 	pthread_cond_signal(&mPlaylistIndexed);
 	pthread_mutex_unlock(&mPlaylistMutex);
 }
@@ -2999,6 +3293,7 @@ void TrackState::RefreshPlaylist(void)
 {
 	GrowableBuffer tempBuff;
 	long http_error = 0;
+	long long prevPlaylistDownloadTimeMS = lastPlaylistDownloadTimeMS;
 
 	// note: this used to be updated only upon succesful playlist download
 	// this can lead to back-to-back playlist download retries
@@ -3044,9 +3339,25 @@ void TrackState::RefreshPlaylist(void)
 			actualType = eMEDIATYPE_PLAYLIST_AUDIO ;
 		}
 
+		// Request delta update while previous playlist is recent enough for the skipped segments to be in it
+		bool deltaUpdate = (IsLive() && !refreshPlaylist && tempBuff.ptr && mCanSkipUntil > 0 && gpGlobalConfig->playlistDeltaUpdate &&
+				(lastPlaylistDownloadTimeMS - prevPlaylistDownloadTimeMS) < (long long)(mCanSkipUntil * 500));
+		std::string playlistUrl = mPlaylistUrl;
+		if (deltaUpdate)
+		{
+			playlistUrl.append((playlistUrl.find('?') == std::string::npos) ? "?_HLS_skip=YES" : "&_HLS_skip=YES");
+		}
+
 		AampCurlInstance dnldCurlInstance = aamp->GetPlaylistCurlInstance(actualType, false);
 		aamp->SetCurlTimeout(aamp->mPlaylistTimeoutMs,dnldCurlInstance);
-		aamp->GetFile (mPlaylistUrl, &playlist, mEffectiveUrl, &http_error, NULL, (unsigned int)dnldCurlInstance, true, actualType);
+		aamp->GetFile (playlistUrl, &playlist, mEffectiveUrl, &http_error, NULL, (unsigned int)dnldCurlInstance, true, actualType);
+		if (deltaUpdate && playlist.len && http_error != 304 && !ExpandDeltaPlaylist(&tempBuff, &playlist))
+		{
+			AAMPLOG_WARN("%s:%d %s delta update not applicable, downloading full playlist", __FUNCTION__, __LINE__, name);
+			// GetFile resets the buffer without freeing it
+			aamp_Free(&playlist.ptr);
+			aamp->GetFile (mPlaylistUrl, &playlist, mEffectiveUrl, &http_error, NULL, (unsigned int)dnldCurlInstance, true, actualType);
+		}
 		aamp->SetCurlTimeout(aamp->mNetworkTimeoutMs,dnldCurlInstance);
 
 		if(!aamp->mParallelFetchPlaylistRefresh)
@@ -3054,19 +3365,29 @@ void TrackState::RefreshPlaylist(void)
 			pthread_mutex_unlock(&aamp->mParallelPlaylistFetchLock);
 		}
 
+		// Not modified is a successful refresh
 		aamp->UpdateVideoEndMetrics( actualType,
 								(this->GetCurrentBandWidth()),
-								http_error,mEffectiveUrl);
+								(http_error == 304) ? 200 : http_error,mEffectiveUrl);
 
 	}
-	if (playlist.len)
+	if (http_error == 304 && playlist.len && tempBuff.ptr && !refreshPlaylist)
+	{ // playlist not modified, keep indexed one along with fragment position in it
+		AAMPLOG_INFO("%s:%d %s playlist not modified", __FUNCTION__, __LINE__, name);
+		aamp_Free(&playlist.ptr);
+		playlist.ptr = tempBuff.ptr;
+		playlist.len = tempBuff.len;
+		playlist.avail = tempBuff.avail;
+		context->mNetworkDownDetected = false;
+		manifestDLFailCount = 0;
+	}
+	else if (playlist.len)
 	{ // download successful
 		//lastPlaylistDownloadTimeMS = aamp_GetCurrentTimeMS();
 		if (context->mNetworkDownDetected)
 		{
 			context->mNetworkDownDetected = false;
 		}
-		aamp_Free(&tempBuff.ptr);
 		aamp_AppendNulTerminator(&playlist); // hack: make safe for cstring operations
 #ifdef TRACE
 		if (gpGlobalConfig->logging.trace)
@@ -3076,12 +3397,11 @@ void TrackState::RefreshPlaylist(void)
 #endif
 
 		double culled;
-		IndexPlaylist(true, culled);
+		// Previous playlist of same profile lets indexing skip fragments already parsed, freed once indexed
+		IndexPlaylist(true, culled, refreshPlaylist ? NULL : &tempBuff);
+		aamp_Free(&tempBuff.ptr);
 		// Update culled seconds if playlist download was successful
 		// DELIA-40121: We need culledSeconds to find the timedMetadata position in playlist
-		// culledSeconds and FindTimedMetadata have been moved up here, because FindMediaForSequenceNumber
-		// uses mystrpbrk internally which modifies line terminators in playlist.ptr and results in 
-		// FindTimedMetadata failing to parse playlist
 		if (IsLive())
 		{
 			if(UseProgramDateTimeIfAvailable())
@@ -4167,8 +4487,7 @@ AAMPStatusType StreamAbstractionAAMP_HLS::Init(TuneType tuneType)
 		}
 		aamp->profiler.SetBandwidthBitsPerSecondAudio(audio->GetCurrentBandWidth());
 
-		pthread_t trackPLDownloadThreadID;
-		bool trackPLDownloadThreadStarted = false;
+		std::future<void> trackPLDownloadTask;
 		if (audio->enabled)
 		{
 			if (aamp->getAampCacheHandler()->RetrieveFromPlaylistCache(audio->mPlaylistUrl, &audio->playlist, audio->mEffectiveUrl))
@@ -4179,15 +4498,8 @@ AAMPStatusType StreamAbstractionAAMP_HLS::Init(TuneType tuneType)
 			{
 				if (aamp->mParallelFetchPlaylist)
 				{
-					int ret = pthread_create(&trackPLDownloadThreadID, NULL, TrackPLDownloader, audio);
-					if(ret != 0)
-					{
-						logprintf("StreamAbstractionAAMP_HLS::%s:%d pthread_create failed for TrackPLDownloader with errno = %d, %s", __FUNCTION__, __LINE__, errno, strerror(errno));
-					}
-					else
-					{
-						trackPLDownloadThreadStarted = true;
-					}
+					TrackState *audioTrack = audio;
+					trackPLDownloadTask = AampTaskExecutor::GetInstance()->Submit(eAAMP_TASK_PRIORITY_TUNE, [audioTrack]() { TrackPLDownloader(audioTrack); });
 				}
 				else
 				{
@@ -4224,9 +4536,9 @@ AAMPStatusType StreamAbstractionAAMP_HLS::Init(TuneType tuneType)
 			}
 		}
 
-		if (trackPLDownloadThreadStarted)
+		if (trackPLDownloadTask.valid())
 		{
-			pthread_join(trackPLDownloadThreadID, NULL);
+			trackPLDownloadTask.wait();
 		}
 		if (video->enabled && !video->playlist.len)
 		{
@@ -4866,9 +5178,7 @@ AAMPStatusType StreamAbstractionAAMP_HLS::Init(TuneType tuneType)
 		if (rate == AAMP_NORMAL_PLAY_RATE)
 		{
 			// this functionality needed for normal playback , not for trickplay .
-			// After calling GetNextFragmentUriFromPlaylist , all LFs are removed from fragment info
-			// inside GetFragmentUriFromIndex , there is check for LF which fails as its already removed and ends up returning NULL uri
-			// So enforcing this strictly for normal playrate
+			// Trickplay picks fragments with GetFragmentUriFromIndex, so enforcing this strictly for normal playrate
 
 			// DELIA-42052 
 			for (int iTrack = AAMP_TRACK_COUNT - 1; iTrack >= 0; iTrack--)
@@ -4908,6 +5218,7 @@ AAMPStatusType StreamAbstractionAAMP_HLS::Init(TuneType tuneType)
 				std::string defaultIframePlaylistUrl;
 				std::string defaultIframePlaylistEffectiveUrl;
 				GrowableBuffer defaultIframePlaylist;
+				memset(&defaultIframePlaylist, 0, sizeof(defaultIframePlaylist));
 				aamp_ResolveURL(defaultIframePlaylistUrl, aamp->GetManifestUrl(), streamInfo[iframeStreamIdx].uri);
 				traceprintf("StreamAbstractionAAMP_HLS::%s:%d : Downloading iframe playlist", __FUNCTION__, __LINE__);
 				bool bFiledownloaded = false;
@@ -5260,6 +5571,24 @@ static void *FragmentCollector(void *arg)
 	return NULL;
 }
 /***************************************************************************
+* @fn FragmentDecryptor
+* @brief Fragment decrypt thread function
+*		 
+* @param arg[in] TrackState pointer
+* @return void
+***************************************************************************/
+
+static void *FragmentDecryptor(void *arg)
+{
+	TrackState *track = (TrackState *)arg;
+	if(aamp_pthread_setname(pthread_self(), "aampHLSDecrypt"))
+	{
+		logprintf("%s:%d: aamp_pthread_setname failed", __FUNCTION__, __LINE__);
+	}
+	track->RunDecryptLoop();
+	return NULL;
+}
+/***************************************************************************
 * @fn StreamAbstractionAAMP_HLS
 * @brief Constructor function 
 *		 
@@ -5308,27 +5637,29 @@ StreamAbstractionAAMP_HLS::StreamAbstractionAAMP_HLS(class PrivateInstanceAAMP *
 ***************************************************************************/
 TrackState::TrackState(TrackType type, StreamAbstractionAAMP_HLS* parent, PrivateInstanceAAMP* aamp, const char* name) :
 		MediaTrack(type, aamp, name),
-		indexCount(0), currentIdx(0), indexFirstMediaSequenceNumber(0), fragmentURI(NULL), lastPlaylistDownloadTimeMS(0),
+		indexCount(0), currentIdx(0), indexFirstMediaSequenceNumber(0), fragmentURI(NULL), playlistIdx(-1), lastPlaylistDownloadTimeMS(0),
 		byteRangeLength(0), byteRangeOffset(0), nextMediaSequenceNumber(0), playlistPosition(0), playTarget(0),playTargetBufferCalc(0),
 		streamOutputFormat(FORMAT_NONE), playContext(NULL),
 		playTargetOffset(0),
 		discontinuity(false),
 		refreshPlaylist(false), fragmentCollectorThreadID(0),
 		fragmentCollectorThreadStarted(false),
+		mDecryptThreadID(0), mDecryptThreadStarted(false), mDecryptExit(false), mDecryptQueue(), mDecryptMutex(), mDecryptCond(),
 		manifestDLFailCount(0),
 		mCMSha1Hash(NULL), mDrmTimeStamp(0), mDrmMetaDataIndexCount(0),firstIndexDone(false), mDrm(NULL), mDrmLicenseRequestPending(false),
 		mInjectInitFragment(false), mInitFragmentInfo(NULL), mDrmKeyTagCount(0), mIndexingInProgress(false), mForceProcessDrmMetadata(false),
 		mDuration(0), mLastMatchedDiscontPosition(-1), mCulledSeconds(0),mCulledSecondsOld(0),
 		mEffectiveUrl(""), mPlaylistUrl(""), mFragmentURIFromIndex(""),
 		mDiscontinuityIndexCount(0), mSyncAfterDiscontinuityInProgress(false), playlist(),
-		index(), targetDurationSeconds(1), mDeferredDrmKeyMaxTime(0), startTimeForPlaylistSync(),
+		index(), targetDurationSeconds(1), mCanSkipUntil(0), mDeferredDrmKeyMaxTime(0), startTimeForPlaylistSync(),
 		context(parent), fragmentEncrypted(false), mKeyTagChanged(false), mLastKeyTagIdx(0), mDrmInfo(),
 		mDrmMetaDataIndexPosition(0), mDrmMetaDataIndex(), mDiscontinuityIndex(), mKeyHashTable(), mPlaylistMutex(),
 		mPlaylistIndexed(), mTrackDrmMutex(), mPlaylistType(ePLAYLISTTYPE_UNDEFINED), mReachedEndListTag(false),
-		mByteOffsetCalculation(false),mSkipAbr(false),
+		mHasEndListTag(false),mSkipAbr(false),
 		mCheckForInitialFragEnc(false), mFirstEncInitFragmentInfo(NULL), mDrmMethod(eDRM_KEY_METHOD_NONE)
 		,mXStartTimeOFfset(0), mCulledSecondsAtStart(0.0)
 		,mProgramDateTime(0.0)
+		,mProgramDateTimeInfo(NULL)
 		,mDiscontinuityCheckingOn(false)
 		,mSkipSegmentOnError(true)
 {
@@ -5341,6 +5672,8 @@ TrackState::TrackState(TrackType type, StreamAbstractionAAMP_HLS* parent, Privat
 	pthread_cond_init(&mPlaylistIndexed, NULL);
 	pthread_mutex_init(&mPlaylistMutex, NULL);
 	pthread_mutex_init(&mTrackDrmMutex, NULL);
+	pthread_mutex_init(&mDecryptMutex, NULL);
+	pthread_cond_init(&mDecryptCond, NULL);
 	mCulledSecondsAtStart = aamp->culledSeconds;
 }
 /***************************************************************************
@@ -5352,7 +5685,7 @@ TrackState::TrackState(TrackType type, StreamAbstractionAAMP_HLS* parent, Privat
 TrackState::~TrackState()
 {
 	aamp_Free(&playlist.ptr);
-	for (int j=0; j< gpGlobalConfig->maxCachedFragmentsPerTrack; j++)
+	for (int j=0; j< maxCachedFragments; j++)
 	{
 		aamp_Free(&cachedFragment[j].fragment.ptr);
 	}
@@ -5383,7 +5716,8 @@ TrackState::~TrackState()
 	pthread_cond_destroy(&mPlaylistIndexed);
 	pthread_mutex_destroy(&mPlaylistMutex);
 	pthread_mutex_destroy(&mTrackDrmMutex);
-	
+	pthread_cond_destroy(&mDecryptCond);
+	pthread_mutex_destroy(&mDecryptMutex);
 }
 /***************************************************************************
 * @fn Stop
@@ -5415,6 +5749,10 @@ void TrackState::Stop()
 #endif
 		fragmentCollectorThreadStarted = false;
 	}
+	// Downloads are disabled, transfers ahead of the fetcher abort
+	StopPrefetch();
+	// Injector may be waiting for a queued fragment, so stop decryption before injection
+	StopDecryptLoop();
 	StopInjectLoop();
 
 	//To be called after StopInjectLoop to avoid cues to be injected after cleanup
@@ -5469,6 +5807,19 @@ void TrackState::Start(void)
 	{
 		logprintf("Failed to create FragmentCollector thread");
 	}
+	if (gpGlobalConfig->hlsDecryptPipeline && (eTRACK_SUBTITLE != type))
+	{
+		assert(!mDecryptThreadStarted);
+		mDecryptExit = false;
+		if (0 == pthread_create(&mDecryptThreadID, NULL, &FragmentDecryptor, this))
+		{
+			mDecryptThreadStarted = true;
+		}
+		else
+		{
+			logprintf("Failed to create FragmentDecryptor thread, fragments are decrypted by FragmentCollector");
+		}
+	}
 	if(aamp->IsPlayEnabled())
 	{
 		StartInjectLoop();
@@ -5727,6 +6078,149 @@ DrmReturn TrackState::DrmDecrypt( CachedFragment * cachedFragment, ProfilerBucke
 		return drmReturn;
 }
 
+/***************************************************************************
+* @fn QueueFragmentForDecrypt
+* @brief Function to hand over fetched fragment to decrypt thread
+*
+* @param cachedFragment[in] CachedFragment to be decrypted in place
+* @return void
+***************************************************************************/
+void TrackState::QueueFragmentForDecrypt(CachedFragment* cachedFragment)
+{
+	pthread_mutex_lock(&mDecryptMutex);
+	mDecryptQueue.push_back(cachedFragment);
+	pthread_cond_broadcast(&mDecryptCond);
+	pthread_mutex_unlock(&mDecryptMutex);
+}
+
+/***************************************************************************
+* @fn WaitForPendingDecrypt
+* @brief Function to wait till all fragments handed over to decrypt thread are decrypted
+*
+* @return void
+***************************************************************************/
+void TrackState::WaitForPendingDecrypt()
+{
+	pthread_mutex_lock(&mDecryptMutex);
+	while (!mDecryptQueue.empty())
+	{
+		pthread_cond_wait(&mDecryptCond, &mDecryptMutex);
+	}
+	pthread_mutex_unlock(&mDecryptMutex);
+}
+
+/***************************************************************************
+* @fn WaitForFragmentDecrypted
+* @brief Function to wait till fragment is decrypted by decrypt thread
+*
+* @param cachedFragment[in] CachedFragment to be injected
+* @return false if fragment has no data to inject, as in case of decryption failure
+***************************************************************************/
+bool TrackState::WaitForFragmentDecrypted(CachedFragment* cachedFragment)
+{
+	pthread_mutex_lock(&mDecryptMutex);
+	while (std::find(mDecryptQueue.begin(), mDecryptQueue.end(), cachedFragment) != mDecryptQueue.end())
+	{
+		pthread_cond_wait(&mDecryptCond, &mDecryptMutex);
+	}
+	pthread_mutex_unlock(&mDecryptMutex);
+	return (0 != cachedFragment->fragment.len);
+}
+
+/***************************************************************************
+* @fn RunDecryptLoop
+* @brief Fragment decrypt thread execution function
+*
+* Fragments are decrypted in fetch order with the decrypt context in effect,
+* fetch thread waits for the queue to drain before changing the context.
+* Length of a fragment which failed decryption is reset, so that it is
+* skipped by injector.
+*
+* @return void
+***************************************************************************/
+void TrackState::RunDecryptLoop()
+{
+	pthread_mutex_lock(&mDecryptMutex);
+	while (!mDecryptQueue.empty() || !mDecryptExit)
+	{
+		if (mDecryptQueue.empty())
+		{
+			pthread_cond_wait(&mDecryptCond, &mDecryptMutex);
+			continue;
+		}
+		CachedFragment* cachedFragment = mDecryptQueue.front();
+		pthread_mutex_unlock(&mDecryptMutex);
+
+		DrmReturn drmReturn = eDRM_ERROR;
+		if (aamp->DownloadsAreEnabled())
+		{
+			pthread_mutex_lock(&mTrackDrmMutex);
+			if (mDrm)
+			{
+				drmReturn = mDrm->Decrypt(mediaTrackDecryptBucketTypes[type], cachedFragment->fragment.ptr,
+						cachedFragment->fragment.len, MAX_LICENSE_ACQ_WAIT_TIME);
+			}
+			pthread_mutex_unlock(&mTrackDrmMutex);
+
+			if (eDRM_SUCCESS == drmReturn)
+			{
+				segDrmDecryptFailCount = 0;
+			}
+			else
+			{
+				aamp->profiler.ProfileError(mediaTrackDecryptBucketTypes[type], drmReturn);
+				logprintf("%s:%d [%s] drm_Decrypt failed. position %f - RetryCount %d", __FUNCTION__, __LINE__, name, cachedFragment->position, segDrmDecryptFailCount.load());
+				if (eDRM_KEY_ACQUSITION_TIMEOUT == drmReturn)
+				{
+					aamp->SendErrorEvent(AAMP_TUNE_LICENCE_TIMEOUT, NULL, true);
+				}
+				else
+				{
+					int failCount = ++segDrmDecryptFailCount;
+					if (aamp->mDrmDecryptFailCount <= failCount)
+					{
+						AAMPLOG_ERR("%s:%d [%s] drm_Decrypt failed for fragments, reached failure threshold (%d) sending failure event", __FUNCTION__, __LINE__, name, aamp->mDrmDecryptFailCount);
+						aamp->SendErrorEvent(AAMP_TUNE_DRM_DECRYPT_FAILED);
+					}
+				}
+			}
+		}
+		if (eDRM_SUCCESS != drmReturn)
+		{
+			cachedFragment->fragment.len = 0;
+		}
+
+		pthread_mutex_lock(&mDecryptMutex);
+		mDecryptQueue.pop_front();
+		pthread_cond_broadcast(&mDecryptCond);
+	}
+	pthread_mutex_unlock(&mDecryptMutex);
+	AAMPLOG_WARN("%s:%d: fragment decryptor done. track %s", __FUNCTION__, __LINE__, name);
+}
+
+/***************************************************************************
+* @fn StopDecryptLoop
+* @brief Function to stop decrypt thread after queued fragments are processed
+*
+* @return void
+***************************************************************************/
+void TrackState::StopDecryptLoop()
+{
+	if (mDecryptThreadStarted)
+	{
+		pthread_mutex_lock(&mDecryptMutex);
+		mDecryptExit = true;
+		pthread_cond_broadcast(&mDecryptCond);
+		pthread_mutex_unlock(&mDecryptMutex);
+		int rc = pthread_join(mDecryptThreadID, NULL);
+		if (rc != 0)
+		{
+			logprintf("***pthread_join fragmentDecryptThread returned %d(%s)", rc, strerror(rc));
+		}
+		mDecryptThreadStarted = false;
+	}
+}
+
 /***************************************************************************
 * @fn GetContext
 * @brief Function to get current StreamAbstractionAAMP instance value 
@@ -5888,6 +6382,8 @@ void TrackState::UpdateDrmIV(const char *ptr)
 		{
 			traceprintf("%s:%d Same DRM IV", __FUNCTION__, __LINE__);
 		}
+		// Decrypt context of queued fragments refers to current IV
+		WaitForPendingDecrypt();
 		free(mDrmInfo.iv);
 	}
 	mDrmInfo.iv = iv;
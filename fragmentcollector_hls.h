@@ -36,6 +36,7 @@
 #define FRAGMENTCOLLECTOR_HLS_H
 
 #include <memory>
+#include <deque>
 #include "StreamAbstractionAAMP.h"
 #include "mediaprocessor.h"
 #include "drm.h"
@@ -112,12 +113,24 @@ typedef struct MediaInfo
 /**
 *	\struct	IndexNode
 * 	\brief	IndexNode structure for Node/DRM Index
+*
+*	Holds everything needed to fetch the fragment, so fragment lookup
+*	never goes back to the playlist text.
 */
 struct IndexNode
 {
 	double completionTimeSecondsFromStart;	/**< Time of index from start */
+	double durationSeconds;					/**< \#EXTINF duration of fragment */
 	const char *pFragmentInfo;				/**< Fragment Information pointer */
+	const char *pInitFragmentInfo;			/**< \#EXT-X-MAP in effect for fragment, NULL if none */
+	const char *pProgramDateTime;			/**< \#EXT-X-PROGRAM-DATE-TIME preceding fragment, NULL if none */
 	int drmMetadataIdx;						/**< DRM Index for Fragment */
+	int keyTagIdx;							/**< mKeyHashTable index of \#EXT-X-KEY in effect, -1 if none */
+	int uriOffset;							/**< Offset of fragment URI from pFragmentInfo, -1 if not found */
+	int uriLength;							/**< Length of fragment URI */
+	int byteRangeOffset;					/**< \#EXT-X-BYTERANGE offset, resolved when implicit */
+	int byteRangeLength;					/**< \#EXT-X-BYTERANGE length, 0 if whole file */
+	bool discontinuity;						/**< \#EXT-X-DISCONTINUITY precedes fragment */
 };
 
 /**
@@ -186,14 +199,18 @@ public:
 	void Stop();
 	/// Fragment Collector thread execution function
 	void RunFetchLoop();
+	/// Fragment decrypt thread execution function
+	void RunDecryptLoop();
 	/// Function to parse playlist file and update data structures 
-	void IndexPlaylist(bool IsRefresh, double &culledSec);
+	void IndexPlaylist(bool IsRefresh, double &culledSec, const GrowableBuffer *prevPlaylist = NULL);
 	/// Function to handle Profile change after ABR  
 	void ABRProfileChanged(void);
 	/// Function to get next fragment URI for download 
 	char *GetNextFragmentUriFromPlaylist(bool ignoreDiscontinuity=false);
 	/// Function to update IV value from DRM information 
 	void UpdateDrmIV(const char *ptr);
+	/// Function to wait till all fragments handed over to decrypt thread are decrypted
+	void WaitForPendingDecrypt();
 	/// Function to update SHA1 ID from DRM information
 	void UpdateDrmCMSha1Hash(const char *ptr);
 	/// Function to decrypt the fragment data 
@@ -266,6 +283,8 @@ private:
 	void FlushIndex();
 	/// Function to Fetch the fragment and inject for playback 
 	void FetchFragment();
+	/// Queue fragments following the selected one for download ahead
+	void PrefetchNextFragments();
 	/// Helper function fetch the fragments 
 	bool FetchFragmentHelper(long &http_error, bool &decryption_error, bool & bKeyChanged, int * fogError);
 	/// Function to redownload playlist after refresh interval .
@@ -276,6 +295,10 @@ private:
 	void InjectFragmentInternal(CachedFragment* cachedFragment, bool &fragmentDiscarded);
 	/// Function to find the media sequence after refresh for continuity
 	char *FindMediaForSequenceNumber();
+	/// Function to make indexed fragment the current fragment-of-interest
+	char *SelectIndexedFragment(int idx);
+	/// Function to apply indexed key tag to decryption state
+	void ApplyKeyTag(int keyTagIdx);
 	/// Fetch and inject init fragment
 	void FetchInitFragment();
 	/// Helper function fetch the init fragments
@@ -288,19 +311,27 @@ private:
 	void InitiateDRMKeyAcquisition(int indexPosn=-1);
 	/// Function to set the DRM Metadata into Adobe DRM Layer for decryption
 	void SetDrmContext();
+	/// Function to hand over fragment to decrypt thread
+	void QueueFragmentForDecrypt(CachedFragment* cachedFragment);
+	/// Function to wait till fragment is decrypted by decrypt thread
+	bool WaitForFragmentDecrypted(CachedFragment* cachedFragment);
+	/// Function to stop decrypt thread
+	void StopDecryptLoop();
 public:
 	std::string mEffectiveUrl; 		/**< uri associated with downloaded playlist (takes into account 302 redirect) */
 	std::string mPlaylistUrl; 		/**< uri associated with downloaded playlist */
 	GrowableBuffer playlist; 				/**< downloaded playlist contents */
 	
 	double mProgramDateTime;
+	const char* mProgramDateTimeInfo;	/**< last EXT-X-PROGRAM-DATE-TIME value in indexed playlist */
 	GrowableBuffer index; 			/**< packed IndexNode records for associated playlist */
 	int indexCount; 				/**< number of indexed fragments in currently indexed playlist */
 	int currentIdx; 				/**< index for currently-presenting fragment used during FF/REW (-1 if undefined) */
-	std::string mFragmentURIFromIndex; /**< storage for uri generated by GetFragmentUriFromIndex */
+	std::string mFragmentURIFromIndex; /**< storage for uri of current fragment-of-interest */
 	long long indexFirstMediaSequenceNumber; /**< first media sequence number from indexed manifest */
 
-	char *fragmentURI; /**< pointer (into playlist) to URI of current fragment-of-interest */
+	char *fragmentURI; /**< URI of current fragment-of-interest; playlist.ptr if none looked up yet */
+	int playlistIdx; /**< index of current fragment-of-interest in normal play (-1 if undefined) */
 	long long lastPlaylistDownloadTimeMS; /**< UTC time at which playlist was downloaded */
 	int byteRangeLength; /**< state for \#EXT-X-BYTERANGE fragments */
 	int byteRangeOffset; /**< state for \#EXT-X-BYTERANGE fragments */
@@ -310,6 +341,7 @@ public:
 	double playTarget; /**< initially relative seek time (seconds) based on playlist window, but updated as a play_target */
 	double playTargetBufferCalc;
 	double targetDurationSeconds; /**< copy of \#EXT-X-TARGETDURATION to manage playlist refresh frequency */
+	double mCanSkipUntil; /**< CAN-SKIP-UNTIL of \#EXT-X-SERVER-CONTROL, 0 if delta updates are not offered */
 	int mDeferredDrmKeyMaxTime;	 /**< copy of \#EXT-X-X1-LIN DRM refresh randomization Max time interval */
 	StreamOutputFormat streamOutputFormat; /**< type of data encoded in each fragment */
 	MediaProcessor* playContext; /**< state for s/w demuxer / pts/pcr restamper module */
@@ -342,6 +374,12 @@ private:
 	bool refreshPlaylist;	/**< bool flag to indicate if playlist refresh required or not */
 	pthread_t fragmentCollectorThreadID;	/**< Thread Id for Fragment  collector Thread */
 	bool fragmentCollectorThreadStarted;	/**< Flag indicating if fragment collector thread started or not*/
+	pthread_t mDecryptThreadID;		/**< Thread Id for fragment decrypt thread */
+	bool mDecryptThreadStarted;		/**< Flag indicating if fragment decrypt thread started or not*/
+	bool mDecryptExit;			/**< Decrypt thread exits once queued fragments are processed */
+	std::deque<CachedFragment*> mDecryptQueue;	/**< Fetched fragments waiting for decryption, in fetch order */
+	pthread_mutex_t mDecryptMutex;		/**< protects decrypt queue */
+	pthread_cond_t mDecryptCond;		/**< Signaled on decrypt queue update */
 	int manifestDLFailCount;				/**< Manifest Download fail count for retry*/
 	bool firstIndexDone;                    /**< Indicates if first indexing is done*/
 	std::shared_ptr<HlsDrmBase> mDrm;       /**< DRM decrypt context*/
@@ -358,7 +396,7 @@ private:
 	bool mSyncAfterDiscontinuityInProgress; /**< Indicates if a synchronization after discontinuity tag is in progress*/
 	PlaylistType mPlaylistType;		/**< Playlist Type */
 	bool mReachedEndListTag;		/**< Flag indicating if End list tag reached in parser */
-	bool mByteOffsetCalculation;            /**< Flag used to calculte byte offset from byte length for fragmented streams */
+	bool mHasEndListTag;			/**< Flag indicating if indexed playlist has End list tag */
 	bool mSkipAbr;                          /**< Flag that denotes if previous cached fragment is init fragment or not */
 	const char* mFirstEncInitFragmentInfo;  /**< Holds first encrypted init fragment Information index*/
 	double mXStartTimeOFfset;		/**< Holds value of time offset from X-Start tag */
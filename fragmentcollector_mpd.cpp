@@ -38,11 +38,15 @@
 #include <ctime>
 #include <inttypes.h>
 #include <libxml/xmlreader.h>
+#include <libxml/tree.h>
+#include <libxml/xpath.h>
 #include <math.h>
 #include <cmath> // For double abs(double)
 #include <algorithm>
 #include <cctype>
 #include "AampCacheHandler.h"
+#include "AampBufferPool.h"
+#include "AampTaskExecutor.h"
 //#define DEBUG_TIMELINE
 //#define AAMP_HARVEST_SUPPORT_ENABLED
 //#define AAMP_DISABLE_INJECT
@@ -60,7 +64,9 @@
 #define TIMELINE_START_RESET_DIFF 4000000000
 #define MAX_DELAY_BETWEEN_MPD_UPDATE_MS (6000)
 #define MIN_DELAY_BETWEEN_MPD_UPDATE_MS (500) // 500mSec
+#define MANIFEST_REFRESH_WAIT_SLICE_MS (100) // recheck of downloads enabled while waiting for refreshed manifest
 #define MIN_TSB_BUFFER_DEPTH 6 //6 seconds from 4.3.3.2.2 in https://dashif.org/docs/DASH-IF-IOP-v4.2-clean.htm
+#define MAX_PARALLEL_DRM_SESSION_THREADS 2 // one license request in flight per audio/video key
 
 //Comcast DRM Agnostic CENC for Content Metadata
 #define COMCAST_DRM_INFO_ID "afbcb50e-bf74-3d13-be8f-13930c783962"
@@ -179,6 +185,166 @@ static void WriteFile(std::string fileName, const char* data, int len);
 #endif // AAMP_HARVEST_SUPPORT_ENABLED
 
 
+/**
+ * @class SegmentTimelineIndex
+ * @brief Cumulative position of SegmentTimeline S elements, to locate a fragment by time with a binary search
+ */
+class SegmentTimelineIndex
+{
+public:
+	SegmentTimelineIndex() : mTimeline(NULL), mTimeScale(0), mManifestUpdateCount(0), mFirst(NULL), mLast(NULL), mEntries()
+	{
+	}
+	SegmentTimelineIndex(const SegmentTimelineIndex&) = delete;
+	SegmentTimelineIndex& operator=(const SegmentTimelineIndex&) = delete;
+	void Update(const ISegmentTimeline *segmentTimeline, uint32_t timeScale, uint32_t manifestUpdateCount);
+	bool Skip(int &timeLineIndex, int &repeatCount, double &time, uint64_t &number, double &fragmentTime, double &skipTime) const;
+private:
+	/**
+	 * @struct Entry
+	 * @brief Position of first fragment of a S element
+	 */
+	struct Entry
+	{
+		uint64_t firstFragment;   /**< number of fragments before S element */
+		double startSeconds;      /**< duration of fragments before S element in seconds */
+		uint64_t startUnits;      /**< duration of fragments before S element in timescale units */
+		uint64_t startTime;       /**< t attribute */
+		int lastStartTimeIdx;     /**< last S element up to this one having t attribute, -1 if none */
+		uint32_t duration;        /**< d attribute */
+		uint32_t count;           /**< number of fragments, r + 1 */
+	};
+	const ISegmentTimeline *mTimeline;
+	uint32_t mTimeScale;
+	uint32_t mManifestUpdateCount;
+	const ITimeline *mFirst;
+	const ITimeline *mLast;
+	std::vector<Entry> mEntries;      /**< one entry per S element followed by end of timeline */
+};
+
+/**
+ * @brief Build index of a SegmentTimeline, unless already built for it
+ * @param segmentTimeline SegmentTimeline to be indexed
+ * @param timeScale timescale of SegmentTimeline
+ * @param manifestUpdateCount manifest refresh count, index is rebuilt after each refresh
+ */
+void SegmentTimelineIndex::Update(const ISegmentTimeline *segmentTimeline, uint32_t timeScale, uint32_t manifestUpdateCount)
+{
+	std::vector<ITimeline *>&timelines = segmentTimeline->GetTimelines();
+	const ITimeline *first = timelines.empty() ? NULL : timelines.front();
+	const ITimeline *last = timelines.empty() ? NULL : timelines.back();
+	if (mTimeline == segmentTimeline && mTimeScale == timeScale && mManifestUpdateCount == manifestUpdateCount &&
+		mFirst == first && mLast == last && mEntries.size() == timelines.size() + 1)
+	{
+		return;
+	}
+	mTimeline = segmentTimeline;
+	mTimeScale = timeScale;
+	mManifestUpdateCount = manifestUpdateCount;
+	mFirst = first;
+	mLast = last;
+	mEntries.clear();
+	if (0 == timeScale)
+	{
+		return;
+	}
+
+	Entry entry;
+	entry.firstFragment = 0;
+	entry.startSeconds = 0;
+	entry.startUnits = 0;
+	entry.lastStartTimeIdx = -1;
+	mEntries.reserve(timelines.size() + 1);
+	for (size_t i = 0; i < timelines.size(); i++)
+	{
+		ITimeline *timeline = timelines[i];
+		uint32_t repeatCount = timeline->GetRepeatCount();
+		entry.duration = timeline->GetDuration();
+		entry.startTime = 0;
+		if (0 == entry.duration || repeatCount == UINT32_MAX)
+		{
+			// Zero duration or open ended repeat, fragments are located by walking the timeline
+			mEntries.clear();
+			return;
+		}
+		entry.count = repeatCount + 1;
+		map<string, string> attributeMap = timeline->GetRawAttributes();
+		if (attributeMap.find("t") != attributeMap.end())
+		{
+			entry.startTime = timeline->GetStartTime();
+			entry.lastStartTimeIdx = (int)i;
+		}
+		mEntries.push_back(entry);
+		entry.firstFragment += entry.count;
+		entry.startUnits += (uint64_t)entry.count * entry.duration;
+		entry.startSeconds += ((double)entry.count * entry.duration) / timeScale;
+	}
+	// End of timeline
+	entry.startTime = 0;
+	entry.duration = 0;
+	entry.count = 0;
+	mEntries.push_back(entry);
+}
+
+/**
+ * @brief Move timeline position forward by skipTime in one step
+ * @param[in,out] timeLineIndex index of S element
+ * @param[in,out] repeatCount index of fragment in S element
+ * @param[in,out] time start time of fragment in timescale units
+ * @param[in,out] number fragment number
+ * @param[in,out] fragmentTime fragment position in seconds
+ * @param[in,out] skipTime time to be skipped in seconds, reduced by skipped duration
+ * @retval true if position moved, false if stepping fragment by fragment is needed
+ */
+bool SegmentTimelineIndex::Skip(int &timeLineIndex, int &repeatCount, double &time, uint64_t &number, double &fragmentTime, double &skipTime) const
+{
+	if (mEntries.empty() || timeLineIndex < 0 || timeLineIndex + 1 >= (int)mEntries.size() || repeatCount < 0 ||
+		repeatCount >= (int)mEntries[timeLineIndex].count || skipTime <= 0)
+	{
+		return false;
+	}
+	const Entry &current = mEntries[timeLineIndex];
+	double currentSeconds = current.startSeconds + ((double)repeatCount * current.duration) / mTimeScale;
+	double targetSeconds = currentSeconds + skipTime;
+
+	// Last S element starting at or before target, end of timeline if target is past it
+	int idx = (int)(std::upper_bound(mEntries.begin() + timeLineIndex, mEntries.end(), targetSeconds,
+			[](double seconds, const Entry &entry) { return seconds < entry.startSeconds; }) - mEntries.begin()) - 1;
+	const Entry &target = mEntries[idx];
+	uint32_t targetRepeat = 0;
+	if (target.count)
+	{
+		targetRepeat = (uint32_t)(((targetSeconds - target.startSeconds) * mTimeScale) / target.duration);
+		if (targetRepeat >= target.count)
+		{
+			targetRepeat = target.count - 1;
+		}
+	}
+	if (idx == timeLineIndex && (int)targetRepeat <= repeatCount)
+	{
+		return false;
+	}
+
+	uint64_t targetUnits = target.startUnits + (uint64_t)targetRepeat * target.duration;
+	if (idx != timeLineIndex && target.lastStartTimeIdx > timeLineIndex)
+	{
+		const Entry &timeEntry = mEntries[target.lastStartTimeIdx];
+		time = (double)(timeEntry.startTime + (targetUnits - timeEntry.startUnits));
+	}
+	else
+	{
+		time += (double)(targetUnits - (current.startUnits + (uint64_t)repeatCount * current.duration));
+	}
+	double skipped = (target.startSeconds + ((double)targetRepeat * target.duration) / mTimeScale) - currentSeconds;
+	number += (target.firstFragment + targetRepeat) - (current.firstFragment + repeatCount);
+	fragmentTime += skipped;
+	skipTime -= skipped;
+	timeLineIndex = idx;
+	repeatCount = (int)targetRepeat;
+	return true;
+}
+
+
 /**
  * @class MediaStreamContext
  * @brief MPD media track
@@ -200,7 +366,8 @@ public:
 			fragmentIndex(0), timeLineIndex(0), fragmentRepeatCount(0), fragmentOffset(0),
 			eos(false), fragmentTime(0), periodStartOffset(0), index_ptr(NULL), index_len(0),
 			lastSegmentTime(0), lastSegmentNumber(0), adaptationSetIdx(0), representationIndex(0), profileChanged(true),
-			adaptationSetId(0), fragmentDescriptor(), mContext(context), initialization(""), mDownloadedFragment(), discontinuity(false), mSkipSegmentOnError(true)
+			adaptationSetId(0), fragmentDescriptor(), mContext(context), initialization(""), mDownloadedFragment(), discontinuity(false), mSkipSegmentOnError(true),
+			timelineIndex()
 	{
 		memset(&mDownloadedFragment, 0, sizeof(GrowableBuffer));
 	}
@@ -282,6 +449,7 @@ public:
 		if(!initSegment && mDownloadedFragment.ptr)
 		{
 			ret = true;
+			aamp->GetBufferPool()->Release(&cachedFragment->fragment);
 			cachedFragment->fragment.ptr = mDownloadedFragment.ptr;
 			cachedFragment->fragment.len = mDownloadedFragment.len;
 			cachedFragment->fragment.avail = mDownloadedFragment.avail;
@@ -292,8 +460,15 @@ public:
 			std::string effectiveUrl;
 			int iFogError = -1;
 			int iCurrentRate = aamp->rate; //  Store it as back up, As sometimes by the time File is downloaded, rate might have changed due to user initiated Trick-Play
-			ret = aamp->LoadFragment(bucketType, fragmentUrl,effectiveUrl, &cachedFragment->fragment, curlInstance,
+			if (!initSegment && TakePrefetchedFragment(fragmentUrl, range, cachedFragment, effectiveUrl, http_code))
+			{
+				ret = true;
+			}
+			else
+			{
+				ret = aamp->LoadFragment(bucketType, fragmentUrl,effectiveUrl, &cachedFragment->fragment, curlInstance,
 						range, actualType, &http_code, &bitrate, &iFogError, fragmentDurationSeconds );
+			}
 
 			if (iCurrentRate != AAMP_NORMAL_PLAY_RATE)
 			{
@@ -415,6 +590,18 @@ public:
 				logprintf("%s:%d filePath %s", __FUNCTION__, __LINE__, fileName.c_str());
 				WriteFile(fileName, cachedFragment->fragment.ptr, cachedFragment->fragment.len);
 			}
+#endif
+#ifdef AAMP_MPD_DRM
+			if (initSegment)
+			{
+				// Sessions decrypting samples themselves need cenc or cbcs pattern from the sample entry
+				AampEncryptionScheme scheme;
+				unsigned char keyId[16];
+				if (aamp_ParseEncryptionScheme(reinterpret_cast<const unsigned char*>(cachedFragment->fragment.ptr), cachedFragment->fragment.len, scheme, keyId))
+				{
+					aamp->mDRMSessionManager->setEncryptionScheme(keyId, sizeof(keyId), scheme);
+				}
+			}
 #endif
 			cachedFragment->position = position;
 			cachedFragment->duration = duration;
@@ -519,6 +706,7 @@ public:
 	std::string initialization;
 	uint32_t adaptationSetId;
 	bool mSkipSegmentOnError;
+	SegmentTimelineIndex timelineIndex;
 };
 
 /**
@@ -555,6 +743,41 @@ struct FragmentDownloadParams
 
 static bool IsIframeTrack(IAdaptationSet *adaptationSet);
 
+/**
+ * @class MPDPeriodNodeCache
+ * @brief Parsed Period elements of previous manifest, reused on refresh when element text is unchanged
+ *
+ * Cached Period nodes are shared with the manifest tree they are handed out to,
+ * and taken back from it before the tree is deleted.
+ */
+class MPDPeriodNodeCache
+{
+public:
+	MPDPeriodNodeCache();
+	~MPDPeriodNodeCache();
+	MPDPeriodNodeCache(const MPDPeriodNodeCache&) = delete;
+	MPDPeriodNodeCache& operator=(const MPDPeriodNodeCache&) = delete;
+	void BeginManifest(const GrowableBuffer &manifest, const std::string &mpdPath);
+	Node* GetNextPeriod(const char *id);
+	void EndManifest(Node *root);
+	void Clear();
+private:
+	/**
+	 * @struct Entry
+	 * @brief Period element text and its parsed node
+	 */
+	struct Entry
+	{
+		std::string text;
+		Node *node;
+	};
+	std::map<std::string, Entry> mEntries;                      /**< cached periods by id, nodes owned by cache */
+	std::vector<std::pair<const char *, size_t>> mPeriodText;   /**< Period element text of manifest being parsed */
+	size_t mNextPeriod;                                         /**< index of next Period element in manifest being parsed */
+	int mReusedCount;                                           /**< periods reused in manifest being parsed */
+	std::string mMPDPath;                                       /**< base path of cached nodes */
+};
+
 /**
  * @class PrivateStreamAbstractionMPD
  * @brief Private implementation of MPD fragment collector
@@ -580,8 +803,11 @@ public:
 	double GetStreamPosition() { return seekPosition; }
 
 	void FetcherLoop();
+	void ManifestRefreshLoop();
 	bool PushNextFragment( MediaStreamContext *pMediaStreamContext, unsigned int curlInstance = 0);
 	bool FetchFragment(MediaStreamContext *pMediaStreamContext, std::string media, double fragmentDuration, bool isInitializationSegment, unsigned int curlInstance = 0, bool discontinuity = false );
+	void PrefetchTimelineFragments(MediaStreamContext *pMediaStreamContext, const std::string &media, std::vector<ITimeline *> &timelines, uint32_t timeScale);
+	void PrefetchTemplateFragments(MediaStreamContext *pMediaStreamContext, const std::string &media, double fragmentDuration);
 	double GetPeriodEndTime(IMPD *mpd, int periodIndex, uint64_t mpdRefreshTime);
 	double GetPeriodStartTime(IMPD *mpd, int periodIndex);
 	int GetProfileCount();
@@ -626,15 +852,23 @@ private:
 	int GetBestAudioTrackByLanguage(int &desiredRepIdx,AudioType &selectedCodecType);
 	int GetPreferredAudioTrackByLanguage();
 	std::string GetLanguageForAdaptationSet( IAdaptationSet *adaptationSet );
-	AAMPStatusType GetMpdFromManfiest(const GrowableBuffer &manifest, MPD * &mpd, std::string manifestUrl, bool init = false);
+	AAMPStatusType GetMpdFromManfiest(const GrowableBuffer &manifest, MPD * &mpd, std::string manifestUrl, bool init = false, uint32_t fetchTime = 0);
+	void StartManifestRefresh();
+	void StopManifestRefresh();
+	void ScheduleManifestRefresh(int delayMs);
+	bool IsRefreshedManifestReady();
+	bool TakeRefreshedManifest(GrowableBuffer &manifest, std::string &manifestUrl, long &http_error, bool &gotManifest, bool &isPatch,
+		long long &downloadTimeMs, uint32_t &fetchTime);
+	void SetManifestRefreshUrl();
+	bool ApplyRefreshedPatch(GrowableBuffer &manifest, std::string &manifestUrl);
+	void WaitForManifestRefresh(int timeMs);
 
 	bool fragmentCollectorThreadStarted;
 	std::set<std::string> mLangList;
 	double seekPosition;
 	float rate;
 	pthread_t fragmentCollectorThreadID;
-	pthread_t createDRMSessionThreadID;
-	bool drmSessionThreadStarted;
+	std::vector<std::future<void>> createDRMSessionTasks;  /**< License acquisition tasks, oldest first */
 	dash::mpd::IMPD *mpd;
 	MediaStreamContext *mMediaStreamContext[AAMP_TRACK_COUNT];
 	int mNumberOfTracks;
@@ -679,6 +913,36 @@ private:
 	double mCulledSeconds;
 	bool mAdPlayingFromCDN;   /*Note: TRUE: Ad playing currently & from CDN. FALSE: Ad "maybe playing", but not from CDN.*/
 	double mAvailabilityStartTime;
+	MPDPeriodNodeCache mPeriodNodeCache;
+	uint32_t mManifestUpdateCount;   /**< incremented whenever mpd is replaced */
+
+	/* Live manifest refresh, downloaded by its own thread on eCURLINSTANCE_MANIFEST_PLAYLIST
+	 * and handed to FetcherLoop, which parses it in UpdateMPD */
+	bool mManifestRefreshThreadStarted;
+	pthread_t mManifestRefreshThreadID;
+	pthread_mutex_t mManifestRefreshMutex;
+	pthread_cond_t mManifestRefreshCond;   /**< signalled on refresh reschedule, new download and stop */
+	bool mManifestRefreshStop;
+	long long mManifestRefreshDueMs;       /**< time of next download */
+	std::string mManifestRefreshUrl;       /**< url to download, follows MPD Location */
+	GrowableBuffer mRefreshedManifest;     /**< latest download not yet taken by FetcherLoop */
+	bool mRefreshedManifestReady;
+	bool mRefreshedManifestOk;             /**< latest download succeeded */
+	long mRefreshedManifestHttpError;
+	std::string mRefreshedManifestUrl;     /**< effective url of latest download */
+	bool mManifestRefreshIsPatch;          /**< mManifestRefreshUrl is the PatchLocation */
+	bool mRefreshedManifestIsPatch;        /**< latest download is from PatchLocation */
+	long long mRefreshedManifestTimeMs;    /**< time latest download completed */
+	uint32_t mRefreshedManifestFetchTime;  /**< UTC time in seconds latest download completed, MPD fetch time */
+
+	std::string mLastManifest;             /**< text of manifest of current MPD */
+	std::string mLastManifestPath;         /**< base path of manifest of current MPD */
+
+	/* MPD patch, downloaded from PatchLocation and applied to current manifest instead of a full refresh */
+	std::string mPatchBase;                /**< text of current manifest */
+	std::string mPatchBaseUrl;             /**< effective url of current manifest */
+	std::string mPatchLocationUrl;         /**< resolved PatchLocation of current manifest, empty if none */
+	long long mPatchLocationExpiryMs;      /**< time PatchLocation expires, 0 if no ttl */
 };
 
 
@@ -690,8 +954,8 @@ private:
  * @param rate playback rate
  */
 PrivateStreamAbstractionMPD::PrivateStreamAbstractionMPD( StreamAbstractionAAMP_MPD* context, PrivateInstanceAAMP *aamp,double seekpos, float rate) : aamp(aamp),
-	fragmentCollectorThreadStarted(false), mLangList(), seekPosition(seekpos), rate(rate), fragmentCollectorThreadID(0), createDRMSessionThreadID(0),
-	drmSessionThreadStarted(false), mpd(NULL), mNumberOfTracks(0), mCurrentPeriodIdx(0), mEndPosition(0), mIsLiveStream(true), mIsLiveManifest(true), mContext(context),
+	fragmentCollectorThreadStarted(false), mLangList(), seekPosition(seekpos), rate(rate), fragmentCollectorThreadID(0), createDRMSessionTasks(),
+	mpd(NULL), mNumberOfTracks(0), mCurrentPeriodIdx(0), mEndPosition(0), mIsLiveStream(true), mIsLiveManifest(true), mContext(context),
 	mStreamInfo(NULL), mPrevStartTimeSeconds(0), mPrevLastSegurlMedia(""), mPrevLastSegurlOffset(0), lastProcessedKeyId(NULL),
 	lastProcessedKeyIdLen(0), mPeriodEndTime(0), mPeriodStartTime(0), mMinUpdateDurationMs(DEFAULT_INTERVAL_BETWEEN_MPD_UPDATES_MS),
 	mLastPlaylistDownloadTimeMs(0), mFirstPTS(0), mAudioType(eAUDIO_UNKNOWN), mPushEncInitFragment(false),
@@ -703,8 +967,18 @@ PrivateStreamAbstractionMPD::PrivateStreamAbstractionMPD( StreamAbstractionAAMP_
 	,mPresentationOffsetDelay(0)
 	,mAvailabilityStartTime(0)
 	,mUpdateStreamInfo(false)
+	,mPeriodNodeCache()
+	,mManifestUpdateCount(0)
+	,mManifestRefreshThreadStarted(false), mManifestRefreshThreadID(0), mManifestRefreshMutex(), mManifestRefreshCond()
+	,mManifestRefreshStop(false), mManifestRefreshDueMs(0), mManifestRefreshUrl(), mRefreshedManifest()
+	,mRefreshedManifestReady(false), mRefreshedManifestOk(false), mRefreshedManifestHttpError(0), mRefreshedManifestUrl()
+	,mManifestRefreshIsPatch(false), mRefreshedManifestIsPatch(false), mRefreshedManifestTimeMs(0), mRefreshedManifestFetchTime(0)
+	,mLastManifest(), mLastManifestPath(), mPatchBase(), mPatchBaseUrl(), mPatchLocationUrl(), mPatchLocationExpiryMs(0)
 {
 	this->aamp = aamp;
+	pthread_mutex_init(&mManifestRefreshMutex, NULL);
+	pthread_cond_init(&mManifestRefreshCond, NULL);
+	memset(&mRefreshedManifest, 0, sizeof(mRefreshedManifest));
 	memset(&mMediaStreamContext, 0, sizeof(mMediaStreamContext));
 	for (int i=0; i<AAMP_TRACK_COUNT; i++) mFirstFragPTS[i] = 0.0;
 	mContext->GetABRManager().clearProfiles();
@@ -1277,6 +1551,75 @@ bool PrivateStreamAbstractionMPD::FetchFragment(MediaStreamContext *pMediaStream
 }
 
 
+/**
+ * @brief Queue fragments following the current one of a SegmentTimeline for download ahead
+ *
+ * @param pMediaStreamContext Track object pointer
+ * @param media media descriptor string
+ * @param timelines SegmentTimeline entries
+ * @param timeScale timescale of SegmentTemplate
+ */
+void PrivateStreamAbstractionMPD::PrefetchTimelineFragments(MediaStreamContext *pMediaStreamContext, const std::string &media, std::vector<ITimeline *> &timelines, uint32_t timeScale)
+{
+	int count = pMediaStreamContext->GetPrefetchCount();
+	FragmentDescriptor descriptor(pMediaStreamContext->fragmentDescriptor);
+	int timeLineIndex = pMediaStreamContext->timeLineIndex;
+	int repeatCount = pMediaStreamContext->fragmentRepeatCount;
+	ITimeline *timeline = timelines.at(timeLineIndex);
+	for (; count > 0; count--)
+	{
+		descriptor.Time += timeline->GetDuration();
+		descriptor.Number++;
+		if (++repeatCount > (int)timeline->GetRepeatCount())
+		{
+			if (++timeLineIndex >= (int)timelines.size())
+			{
+				break;
+			}
+			repeatCount = 0;
+			timeline = timelines.at(timeLineIndex);
+			map<string, string> attributeMap = timeline->GetRawAttributes();
+			if (attributeMap.find("t") != attributeMap.end())
+			{
+				descriptor.Time = timeline->GetStartTime();
+			}
+		}
+		std::string fragmentUrl;
+		GetFragmentUrl(fragmentUrl, &descriptor, media);
+		pMediaStreamContext->PrefetchFragment(fragmentUrl, NULL, (double)timeline->GetDuration() / timeScale);
+	}
+}
+
+
+/**
+ * @brief Queue fragments following the current one of a SegmentTemplate without timeline for download ahead
+ *
+ * @param pMediaStreamContext Track object pointer
+ * @param media media descriptor string
+ * @param fragmentDuration duration of fragments in seconds
+ */
+void PrivateStreamAbstractionMPD::PrefetchTemplateFragments(MediaStreamContext *pMediaStreamContext, const std::string &media, double fragmentDuration)
+{
+	int count = pMediaStreamContext->GetPrefetchCount();
+	FragmentDescriptor descriptor(pMediaStreamContext->fragmentDescriptor);
+	double availableTime = ((double)aamp_GetCurrentTimeMS() / 1000) - mPresentationOffsetDelay;
+	for (; count > 0; count--)
+	{
+		descriptor.Number++;
+		descriptor.Time += fragmentDuration;
+		// Same period end and live edge checks as PushNextFragment
+		if ((!mIsLiveStream && mPeriodEndTime && (descriptor.Time > mPeriodEndTime)) ||
+			(mIsLiveStream && ((descriptor.Time >= mPeriodEndTime) || ((descriptor.Time + fragmentDuration) >= availableTime))))
+		{
+			break;
+		}
+		std::string fragmentUrl;
+		GetFragmentUrl(fragmentUrl, &descriptor, media);
+		pMediaStreamContext->PrefetchFragment(fragmentUrl, NULL, fragmentDuration);
+	}
+}
+
+
 /**
  * @brief Fetch and push next fragment
  * @param pMediaStreamContext Track object
@@ -1422,6 +1765,11 @@ bool PrivateStreamAbstractionMPD::PushNextFragment( struct MediaStreamContext *p
 					pMediaStreamContext->type,pMediaStreamContext->fragmentDescriptor.Time,pMediaStreamContext->fragmentDescriptor.Number,pMediaStreamContext->lastSegmentTime,duration,pMediaStreamContext->fragmentTime);
 #endif
 					double fragmentDuration = (double)duration/(double)timeScale;
+					if (rate == AAMP_NORMAL_PLAY_RATE && !mIsFogTSB)
+					{
+						// Keep next fragments downloading while this one is fetched
+						PrefetchTimelineFragments(pMediaStreamContext, media, timelines, timeScale);
+					}
 					retval = FetchFragment( pMediaStreamContext, media, fragmentDuration, false, curlInstance);
 					if(retval)
 					{
@@ -1605,6 +1953,11 @@ bool PrivateStreamAbstractionMPD::PushNextFragment( struct MediaStreamContext *p
 				{
 					pMediaStreamContext->fragmentDescriptor.Number = pMediaStreamContext->lastSegmentNumber;
 				}
+				if (rate == AAMP_NORMAL_PLAY_RATE && !mIsFogTSB)
+				{
+					// Keep next fragments downloading while this one is fetched
+					PrefetchTemplateFragments(pMediaStreamContext, media, fragmentDuration);
+				}
 				retval = FetchFragment(pMediaStreamContext, media, fragmentDuration, false, curlInstance);
 				if (mContext->mCheckForRampdown)
 				{
@@ -1978,6 +2331,14 @@ double PrivateStreamAbstractionMPD::SkipFragments( MediaStreamContext *pMediaStr
 					}
 					if (skipTime >= fragmentDuration)
 					{
+						// Jump to target fragment using cumulative durations of S elements
+						pMediaStreamContext->timelineIndex.Update(segmentTimeline, timeScale, mManifestUpdateCount);
+						if (pMediaStreamContext->timelineIndex.Skip(pMediaStreamContext->timeLineIndex, pMediaStreamContext->fragmentRepeatCount,
+								pMediaStreamContext->fragmentDescriptor.Time, pMediaStreamContext->fragmentDescriptor.Number,
+								pMediaStreamContext->fragmentTime, skipTime))
+						{
+							continue;
+						}
 						skipTime -= fragmentDuration;
 						pMediaStreamContext->fragmentTime += fragmentDuration;
 						pMediaStreamContext->fragmentDescriptor.Time += duration;
@@ -2211,17 +2572,643 @@ static void AddAttributesToNode(xmlTextReaderPtr *reader, Node *node)
 	}
 }
 
-
-
+
+/**
+ * @brief MPDPeriodNodeCache Constructor
+ */
+MPDPeriodNodeCache::MPDPeriodNodeCache() : mEntries(), mPeriodText(), mNextPeriod(0), mReusedCount(0), mMPDPath()
+{
+}
+
+
+/**
+ * @brief MPDPeriodNodeCache Destructor
+ */
+MPDPeriodNodeCache::~MPDPeriodNodeCache()
+{
+	Clear();
+}
+
+
+/**
+ * @brief Delete all cached periods
+ */
+void MPDPeriodNodeCache::Clear()
+{
+	for (std::map<std::string, Entry>::iterator it = mEntries.begin(); it != mEntries.end(); ++it)
+	{
+		delete it->second.node;
+	}
+	mEntries.clear();
+}
+
+
+/**
+ * @brief Locate text of Period elements of a manifest before it is parsed
+ * @param manifest manifest buffer
+ * @param mpdPath base path of manifest
+ */
+void MPDPeriodNodeCache::BeginManifest(const GrowableBuffer &manifest, const std::string &mpdPath)
+{
+	static const char periodStartTag[] = "<Period";
+	static const char periodEndTag[] = "</Period>";
+	const char *startTagEnd = periodStartTag + sizeof(periodStartTag) - 1;
+	const char *endTagEnd = periodEndTag + sizeof(periodEndTag) - 1;
+
+	if (mpdPath != mMPDPath)
+	{
+		Clear();
+		mMPDPath = mpdPath;
+	}
+	mPeriodText.clear();
+	mNextPeriod = 0;
+	mReusedCount = 0;
+
+	const char *end = manifest.ptr + manifest.len;
+	const char *ptr = std::search((const char *)manifest.ptr, end, periodStartTag, startTagEnd);
+	while (ptr != end)
+	{
+		const char *next = ptr + sizeof(periodStartTag) - 1;
+		if (next < end && (*next == '>' || *next == '/' || isspace((unsigned char)*next)))
+		{
+			// Attribute values may contain '>', skip quoted text to find end of start tag
+			char quote = 0;
+			while (next < end && (quote || *next != '>'))
+			{
+				if (quote)
+				{
+					if (*next == quote)
+					{
+						quote = 0;
+					}
+				}
+				else if (*next == '"' || *next == '\'')
+				{
+					quote = *next;
+				}
+				next++;
+			}
+			if (next == end)
+			{
+				break;
+			}
+			if (next[-1] == '/')
+			{
+				next++;
+			}
+			else
+			{
+				next = std::search(next, end, periodEndTag, endTagEnd);
+				if (next == end)
+				{
+					break;
+				}
+				next += sizeof(periodEndTag) - 1;
+			}
+			mPeriodText.push_back(std::make_pair(ptr, (size_t)(next - ptr)));
+		}
+		ptr = std::search(next, end, periodStartTag, startTagEnd);
+	}
+}
+
+
+/**
+ * @brief Get cached node for next Period element of manifest being parsed
+ * @param id id attribute of Period element
+ * @retval cached node if element text is unchanged, NULL otherwise. Node stays owned by cache
+ */
+Node* MPDPeriodNodeCache::GetNextPeriod(const char *id)
+{
+	Node *node = NULL;
+	if (mNextPeriod < mPeriodText.size())
+	{
+		const std::pair<const char *, size_t> &text = mPeriodText[mNextPeriod];
+		std::map<std::string, Entry>::iterator it = mEntries.find(id);
+		if (it != mEntries.end() && it->second.text.size() == text.second &&
+			0 == memcmp(it->second.text.data(), text.first, text.second))
+		{
+			node = it->second.node;
+			mReusedCount++;
+		}
+	}
+	mNextPeriod++;
+	return node;
+}
+
+
+/**
+ * @brief Take Period nodes of parsed manifest into cache, to be called before manifest tree is deleted
+ * @param root root node of parsed manifest, its cached Period nodes are removed from it
+ */
+void MPDPeriodNodeCache::EndManifest(Node *root)
+{
+	std::vector<Node *> periods;
+	if (root)
+	{
+		const std::vector<Node *> &subNodes = root->GetSubNodes();
+		for (size_t i = 0; i < subNodes.size(); i++)
+		{
+			if (subNodes[i]->GetName() == "Period")
+			{
+				periods.push_back(subNodes[i]);
+			}
+		}
+	}
+	std::map<std::string, Entry> entries;
+	if (periods.size() != mPeriodText.size() || mNextPeriod != mPeriodText.size())
+	{
+		// Period text could not be matched to parsed elements (prefixed names, commented out periods)
+		AAMPLOG_INFO("%s:%d Period text not matched, cache disabled for this manifest", __FUNCTION__, __LINE__);
+	}
+	else
+	{
+		// All periods are taken over, last period of a live manifest is reused too when it has not grown
+		for (size_t i = 0; i < periods.size(); i++)
+		{
+			if (!periods[i]->HasAttribute("id"))
+			{
+				continue;
+			}
+			const std::string id = periods[i]->GetAttributeValue("id");
+			if (entries.find(id) == entries.end())
+			{
+				std::map<std::string, Entry>::iterator it = mEntries.find(id);
+				Entry entry = { std::string(), periods[i] };
+				if (it != mEntries.end() && it->second.node == periods[i])
+				{
+					entry.text.swap(it->second.text);
+				}
+				else
+				{
+					entry.text.assign(mPeriodText[i].first, mPeriodText[i].second);
+				}
+				entries.insert(std::make_pair(id, entry));
+			}
+		}
+		if (mReusedCount)
+		{
+			AAMPLOG_INFO("%s:%d Reused %d of %d periods", __FUNCTION__, __LINE__, mReusedCount, (int)periods.size());
+		}
+	}
+
+	// Nodes owned by cache are detached from the tree, which deletes the rest
+	std::set<Node *> owned;
+	for (std::map<std::string, Entry>::iterator it = entries.begin(); it != entries.end(); ++it)
+	{
+		owned.insert(it->second.node);
+	}
+	for (std::map<std::string, Entry>::iterator it = mEntries.begin(); it != mEntries.end(); ++it)
+	{
+		owned.insert(it->second.node);
+	}
+	if (root)
+	{
+		// libdash has no API to remove a sub node
+		std::vector<Node *> &subNodes = const_cast<std::vector<Node *> &>(root->GetSubNodes());
+		subNodes.erase(std::remove_if(subNodes.begin(), subNodes.end(), [&owned](Node *node) { return owned.count(node) > 0; }), subNodes.end());
+	}
+	for (std::map<std::string, Entry>::iterator it = mEntries.begin(); it != mEntries.end(); ++it)
+	{
+		std::map<std::string, Entry>::iterator kept = entries.find(it->first);
+		if (kept == entries.end() || kept->second.node != it->second.node)
+		{
+			delete it->second.node;
+		}
+	}
+	mEntries.swap(entries);
+	mPeriodText.clear();
+	mNextPeriod = 0;
+}
+
+
+/**
+ * @brief Get xml node form reader
+ *
+ * @param[in] reader      Pointer to reader object
+ * @param[in] mpdPath     base path of manifest
+ * @param[in] isAd        true if manifest is of an ad
+ * @param[in] periodCache Period elements of previous manifest, NULL if not available
+ *
+ * @retval xml node
+ */
+static Node* ProcessNode(xmlTextReaderPtr *reader, const std::string &mpdPath, bool isAd, MPDPeriodNodeCache *periodCache)
+{
+	int type = xmlTextReaderNodeType(*reader);
+
+	if (type != WhiteSpace && type != Text)
+	{
+		while (type == Comment || type == WhiteSpace)
+		{
+			xmlTextReaderRead(*reader);
+			type = xmlTextReaderNodeType(*reader);
+		}
+
+		const char *name = (const char *)xmlTextReaderConstName(*reader);
+		if (name == NULL)
+		{
+			return NULL;
+		}
+
+		int         isEmpty = xmlTextReaderIsEmptyElement(*reader);
+
+		// Only Period elements of MPD root are cached, these are taken back from root before it is deleted
+		if (periodCache && !strcmp("Period", name) && xmlTextReaderDepth(*reader) == 1)
+		{
+			xmlChar *id = xmlTextReaderGetAttribute(*reader, (const xmlChar *)"id");
+			Node *cachedPeriod = periodCache->GetNextPeriod(id ? (const char *)id : "");
+			if (id)
+			{
+				xmlFree(id);
+			}
+			if (cachedPeriod)
+			{
+				// Element is unchanged since last refresh, skip its subtree
+				if (!isEmpty)
+				{
+					int depth = xmlTextReaderDepth(*reader);
+					while (xmlTextReaderRead(*reader) == 1)
+					{
+						if (xmlTextReaderNodeType(*reader) == XML_READER_TYPE_END_ELEMENT && xmlTextReaderDepth(*reader) == depth)
+						{
+							break;
+						}
+					}
+				}
+				// Shared with the cache, base path is unchanged as cache is cleared on path change
+				return cachedPeriod;
+			}
+		}
+
+		Node *node = new Node();
+		node->SetType(type);
+		node->SetMPDPath(mpdPath);
+		node->SetName(name);
+
+		AddAttributesToNode(reader, node);
+
+		if(isAd && !strcmp("Period", name))
+		{
+			//Making period ids unique. It needs for playing same ad back to back.
+			static int UNIQ_PID = 0;
+			std::string periodId = std::to_string(UNIQ_PID++) + "-";
+			if(node->HasAttribute("id"))
+			{
+				periodId += node->GetAttributeValue("id");
+			}
+			node->AddAttribute("id", periodId);
+		}
+
+		if (isEmpty)
+			return node;
+
+		Node    *subnode = NULL;
+		int     ret = xmlTextReaderRead(*reader);
+
+		while (ret == 1)
+		{
+			if (!strcmp(name, (const char *)xmlTextReaderConstName(*reader)))
+			{
+				return node;
+			}
+
+			subnode = ProcessNode(reader, mpdPath, isAd, periodCache);
+
+			if (subnode != NULL)
+				node->AddSubNode(subnode);
+
+			ret = xmlTextReaderRead(*reader);
+		}
+
+		return node;
+	}
+	else if (type == Text)
+	{
+		xmlChar * text = xmlTextReaderReadString(*reader);
+
+		if (text != NULL)
+		{
+			Node *node = new Node();
+			node->SetType(type);
+			node->SetText((const char*)text);
+			xmlFree(text);
+			return node;
+		}
+	}
+	return NULL;
+}
+
+
+/**
+ * @brief Get attribute of xml element
+ * @param node xml element
+ * @param name attribute name
+ * @retval attribute value, empty if not present
+ */
+static std::string GetXmlAttribute(xmlNodePtr node, const char *name)
+{
+	std::string value;
+	xmlChar *prop = xmlGetProp(node, BAD_CAST name);
+	if (prop)
+	{
+		value = (const char *)prop;
+		xmlFree(prop);
+	}
+	return value;
+}
+
+/**
+ * @brief Take elements of a subtree out of default namespace, so that unprefixed
+ * names of MPD patch selectors match them. Serialized text is unchanged as long as
+ * the default namespace stays declared on the MPD root.
+ * @param node first node of subtree
+ * @param removeDeclarations true to drop default namespace declarations of the subtree too
+ */
+static void ClearDefaultNamespace(xmlNodePtr node, bool removeDeclarations)
+{
+	for (; node; node = node->next)
+	{
+		if (node->type == XML_ELEMENT_NODE)
+		{
+			if (node->ns && !node->ns->prefix)
+			{
+				node->ns = NULL;
+			}
+			ClearDefaultNamespace(node->children, removeDeclarations);
+			if (removeDeclarations)
+			{
+				xmlNsPtr *nsDef = &node->nsDef;
+				while (*nsDef)
+				{
+					xmlNsPtr ns = *nsDef;
+					if (!ns->prefix)
+					{
+						*nsDef = ns->next;
+						ns->next = NULL;
+						xmlFreeNs(ns);
+					}
+					else
+					{
+						nsDef = &ns->next;
+					}
+				}
+			}
+		}
+	}
+}
+
+/**
+ * @brief Apply an add, replace or remove operation of MPD patch
+ * @param xpath XPath context of MPD document
+ * @param op operation element
+ * @retval false if operation is not supported or its selector does not match a single node
+ */
+static bool ApplyMpdPatchOperation(xmlXPathContextPtr xpath, xmlNodePtr op)
+{
+	bool ok = false;
+	std::string sel = GetXmlAttribute(op, "sel");
+	xmlXPathObjectPtr result = sel.empty() ? NULL : xmlXPathEvalExpression(BAD_CAST sel.c_str(), xpath);
+	if (result && result->type == XPATH_NODESET && result->nodesetval && result->nodesetval->nodeNr == 1)
+	{
+		xmlNodePtr target = result->nodesetval->nodeTab[0];
+		const char *opName = (const char *)op->name;
+		if (strcmp(opName, "add") == 0 && target->type == XML_ELEMENT_NODE)
+		{
+			std::string type = GetXmlAttribute(op, "type");
+			if (type.empty())
+			{
+				std::string pos = GetXmlAttribute(op, "pos");
+				xmlNodePtr anchor = (pos == "prepend") ? target->children : target;
+				ok = (pos.empty() || pos == "append" || pos == "prepend" || pos == "before" || pos == "after");
+				for (xmlNodePtr child = op->children; ok && child; child = child->next)
+				{
+					xmlNodePtr copy = xmlDocCopyNode(child, target->doc, 1);
+					ClearDefaultNamespace(copy, true);
+					if (pos == "before" || (pos == "prepend" && anchor))
+					{
+						xmlAddPrevSibling(anchor, copy);
+					}
+					else if (pos == "after")
+					{
+						anchor = xmlAddNextSibling(anchor, copy);
+					}
+					else
+					{
+						xmlAddChild(target, copy);
+					}
+				}
+			}
+			else if (type[0] == '@')
+			{
+				xmlChar *value = xmlNodeGetContent(op);
+				xmlSetProp(target, BAD_CAST type.c_str() + 1, value);
+				xmlFree(value);
+				ok = true;
+			}
+		}
+		else if (strcmp(opName, "replace") == 0)
+		{
+			if (target->type == XML_ATTRIBUTE_NODE || target->type == XML_TEXT_NODE)
+			{
+				xmlChar *value = xmlNodeGetContent(op);
+				if (target->type == XML_ATTRIBUTE_NODE)
+				{
+					xmlSetProp(target->parent, target->name, value);
+				}
+				else
+				{
+					xmlNodeSetContent(target, value);
+				}
+				xmlFree(value);
+				ok = true;
+			}
+			else if (target->type == XML_ELEMENT_NODE)
+			{
+				xmlNodePtr element = op->children;
+				while (element && element->type != XML_ELEMENT_NODE)
+				{
+					element = element->next;
+				}
+				if (element)
+				{
+					xmlNodePtr copy = xmlDocCopyNode(element, target->doc, 1);
+					ClearDefaultNamespace(copy, true);
+					xmlReplaceNode(target, copy);
+					xmlFreeNode(target);
+					ok = true;
+				}
+			}
+		}
+		else if (strcmp(opName, "remove") == 0)
+		{
+			if (target->type == XML_ATTRIBUTE_NODE)
+			{
+				xmlRemoveProp((xmlAttrPtr)target);
+			}
+			else
+			{
+				xmlUnlinkNode(target);
+				xmlFreeNode(target);
+			}
+			ok = true;
+		}
+	}
+	if (!ok)
+	{
+		logprintf("%s:%d Unable to apply MPD patch operation %s sel=%s", __FUNCTION__, __LINE__, (const char *)op->name, sel.c_str());
+	}
+	if (result)
+	{
+		xmlXPathFreeObject(result);
+	}
+	return ok;
+}
+
+/**
+ * @brief Apply MPD patch document to manifest
+ * @param mpdText manifest the patch was published for
+ * @param patch MPD patch document
+ * @param[out] patched updated manifest
+ * @retval false if patch is not for this manifest or could not be applied
+ */
+static bool ApplyMpdPatch(const std::string &mpdText, const GrowableBuffer &patch, std::string &patched)
+{
+	bool ok = false;
+	xmlDocPtr patchDoc = xmlReadMemory(patch.ptr, (int)patch.len, NULL, NULL, XML_PARSE_NONET);
+	xmlDocPtr mpdDoc = xmlReadMemory(mpdText.data(), (int)mpdText.size(), NULL, NULL, XML_PARSE_NONET);
+	xmlNodePtr patchRoot = patchDoc ? xmlDocGetRootElement(patchDoc) : NULL;
+	xmlNodePtr mpdRoot = mpdDoc ? xmlDocGetRootElement(mpdDoc) : NULL;
+	if (patchRoot && mpdRoot && xmlStrEqual(patchRoot->name, BAD_CAST "Patch"))
+	{
+		// Patch is valid only for the manifest instance it was published against
+		std::string mpdId = GetXmlAttribute(mpdRoot, "id");
+		std::string publishTime = GetXmlAttribute(mpdRoot, "publishTime");
+		ok = (!mpdId.empty() && mpdId == GetXmlAttribute(patchRoot, "mpdId") &&
+			!publishTime.empty() && publishTime == GetXmlAttribute(patchRoot, "originalPublishTime"));
+		if (ok)
+		{
+			ClearDefaultNamespace(mpdRoot, false);
+			xmlXPathContextPtr xpath = xmlXPathNewContext(mpdDoc);
+			ok = (xpath != NULL);
+			for (xmlNodePtr op = patchRoot->children; ok && op; op = op->next)
+			{
+				if (op->type == XML_ELEMENT_NODE)
+				{
+					ok = ApplyMpdPatchOperation(xpath, op);
+				}
+			}
+			if (xpath)
+			{
+				xmlXPathFreeContext(xpath);
+			}
+		}
+		else
+		{
+			logprintf("%s:%d MPD patch not for current manifest, id:%s publishTime:%s", __FUNCTION__, __LINE__, mpdId.c_str(), publishTime.c_str());
+		}
+		if (ok)
+		{
+			xmlChar *text = NULL;
+			int len = 0;
+			xmlDocDumpMemory(mpdDoc, &text, &len);
+			ok = (text != NULL && len > 0);
+			if (ok)
+			{
+				patched.assign((const char *)text, len);
+			}
+			xmlFree(text);
+		}
+	}
+	if (patchDoc)
+	{
+		xmlFreeDoc(patchDoc);
+	}
+	if (mpdDoc)
+	{
+		xmlFreeDoc(mpdDoc);
+	}
+	return ok;
+}
+
+/**
+ * @brief Check if manifest download is an MPD patch document
+ * @param manifest downloaded manifest
+ * @retval true if root element is Patch
+ */
+static bool IsMpdPatch(const GrowableBuffer &manifest)
+{
+	const char *ptr = manifest.ptr;
+	const char *end = manifest.ptr + manifest.len;
+	while (ptr < end)
+	{
+		ptr = (const char *)memchr(ptr, '<', end - ptr);
+		if (!ptr || ptr + 1 >= end)
+		{
+			break;
+		}
+		if (ptr[1] != '?' && ptr[1] != '!')
+		{
+			// First element, may be prefixed
+			const char *name = ptr + 1;
+			const char *nameEnd = name;
+			while (nameEnd < end && !isspace(*nameEnd) && *nameEnd != '>' && *nameEnd != '/')
+			{
+				nameEnd++;
+			}
+			const char *colon = (const char *)memchr(name, ':', nameEnd - name);
+			if (colon)
+			{
+				name = colon + 1;
+			}
+			return (nameEnd - name == 5 && memcmp(name, "Patch", 5) == 0);
+		}
+		ptr++;
+	}
+	return false;
+}
+
+/**
+ * @brief Get PatchLocation of parsed manifest
+ * @param root root node of manifest
+ * @param manifestUrl manifest url
+ * @param[out] expiryMs time PatchLocation expires, 0 if no ttl
+ * @retval resolved patch url, empty if manifest has no PatchLocation
+ */
+static std::string GetPatchLocation(Node *root, const std::string &manifestUrl, long long &expiryMs)
+{
+	std::string patchUrl;
+	expiryMs = 0;
+	const std::vector<Node *> &subNodes = root->GetSubNodes();
+	for (size_t i = 0; i < subNodes.size(); i++)
+	{
+		if (subNodes[i]->GetName() == "PatchLocation")
+		{
+			std::string location = subNodes[i]->GetText();
+			size_t first = location.find_first_not_of(" \t\r\n");
+			size_t last = location.find_last_not_of(" \t\r\n");
+			if (first != std::string::npos)
+			{
+				aamp_ResolveURL(patchUrl, manifestUrl, location.substr(first, last - first + 1).c_str());
+				if (subNodes[i]->HasAttribute("ttl"))
+				{
+					expiryMs = aamp_GetCurrentTimeMS() + (long long)(atof(subNodes[i]->GetAttributeValue("ttl").c_str()) * 1000);
+				}
+			}
+			break;
+		}
+	}
+	return patchUrl;
+}
+
 /**
  * @brief Get mpd object of manifest
  * @param manifest buffer pointer
  * @param mpd MPD object of manifest
  * @param manifestUrl manifest url
  * @param init true if this is the first playlist download for a tune/seek/trickplay
+ * @param fetchTime UTC time in seconds manifest was downloaded, 0 for now
  * @retval AAMPStatusType indicates if success or fail
 */
-AAMPStatusType PrivateStreamAbstractionMPD::GetMpdFromManfiest(const GrowableBuffer &manifest, MPD * &mpd, std::string manifestUrl, bool init)
+AAMPStatusType PrivateStreamAbstractionMPD::GetMpdFromManfiest(const GrowableBuffer &manifest, MPD * &mpd, std::string manifestUrl, bool init, uint32_t fetchTime)
 {
 	AAMPStatusType ret = eAAMPSTATUS_GENERIC_ERROR;
 	xmlTextReaderPtr reader = xmlReaderForMemory(manifest.ptr, (int) manifest.len, NULL, NULL, 0);
@@ -2229,14 +3216,34 @@ AAMPStatusType PrivateStreamAbstractionMPD::GetMpdFromManfiest(const GrowableBuf
 	{
 		if (xmlTextReaderRead(reader))
 		{
-			Node *root = aamp_ProcessNode(&reader, manifestUrl);
+			std::string mpdPath = Path::GetDirectoryPath(manifestUrl);
+			MPD *currentMpd = (!init && this->mpd) ? dynamic_cast<MPD *>(this->mpd) : NULL;
+			if (currentMpd && mpdPath == mLastManifestPath && manifest.len == mLastManifest.size() &&
+				0 == memcmp(manifest.ptr, mLastManifest.data(), manifest.len))
+			{
+				// Manifest is unchanged since last refresh, its MPD is still current
+				mpd = currentMpd;
+				mpd->SetFetchTime((0 == fetchTime) ? Time::GetCurrentUTCTimeInSec() : fetchTime);
+				AAMPLOG_INFO("%s:%d Manifest unchanged, MPD reused", __FUNCTION__, __LINE__);
+				xmlFreeTextReader(reader);
+				return eAAMPSTATUS_OK;
+			}
+			mPeriodNodeCache.BeginManifest(manifest, mpdPath);
+			Node *root = ProcessNode(&reader, mpdPath, false, &mPeriodNodeCache);
 			if(root != NULL)
 			{
-				uint32_t fetchTime = Time::GetCurrentUTCTimeInSec();
+				if (0 == fetchTime)
+				{
+					fetchTime = Time::GetCurrentUTCTimeInSec();
+				}
 				mpd = root->ToMPD();
 				if (mpd)
 				{
 					mpd->SetFetchTime(fetchTime);
+					if (gpGlobalConfig->playlistDeltaUpdate)
+					{
+						mPatchLocationUrl = GetPatchLocation(root, manifestUrl, mPatchLocationExpiryMs);
+					}
 #if 1
 					FindTimedMetadata(mpd, root, init, aamp->mBulkTimedMetadata);
 					if(aamp->mBulkTimedMetadata && init && aamp->IsNewTune())
@@ -2261,12 +3268,23 @@ AAMPStatusType PrivateStreamAbstractionMPD::GetMpdFromManfiest(const GrowableBuf
 				{
 				    ret = AAMPStatusType::eAAMPSTATUS_MANIFEST_CONTENT_ERROR;
 				}
+				mPeriodNodeCache.EndManifest(root);
 				delete root;
 			}
 			else if (root == NULL)
 			{
+				mPeriodNodeCache.EndManifest(root);
 				ret = AAMPStatusType::eAAMPSTATUS_MANIFEST_PARSE_ERROR;
 			}
+			if (ret == eAAMPSTATUS_OK)
+			{
+				mLastManifest.assign(manifest.ptr, manifest.len);
+				mLastManifestPath = mpdPath;
+			}
+			else
+			{
+				mLastManifest.clear();
+			}
 		}
 		else if (xmlTextReaderRead(reader) == -1)
 		{
@@ -2283,87 +3301,13 @@ AAMPStatusType PrivateStreamAbstractionMPD::GetMpdFromManfiest(const GrowableBuf
  *
  * @param[in] reader Pointer to reader object
  * @param[in] url    manifest url
+ * @param[in] isAd   true if manifest is of an ad
  *
  * @retval xml node
  */
 Node* aamp_ProcessNode(xmlTextReaderPtr *reader, std::string url, bool isAd)
 {
-	int type = xmlTextReaderNodeType(*reader);
-
-	if (type != WhiteSpace && type != Text)
-	{
-		while (type == Comment || type == WhiteSpace)
-		{
-			xmlTextReaderRead(*reader);
-			type = xmlTextReaderNodeType(*reader);
-		}
-
-		Node *node = new Node();
-		node->SetType(type);
-		node->SetMPDPath(Path::GetDirectoryPath(url));
-
-		const char *name = (const char *)xmlTextReaderConstName(*reader);
-		if (name == NULL)
-		{
-			delete node;
-			return NULL;
-		}
-
-		int         isEmpty = xmlTextReaderIsEmptyElement(*reader);
-
-		node->SetName(name);
-
-		AddAttributesToNode(reader, node);
-
-		if(isAd && !strcmp("Period", name))
-		{
-			//Making period ids unique. It needs for playing same ad back to back.
-			static int UNIQ_PID = 0;
-			std::string periodId = std::to_string(UNIQ_PID++) + "-";
-			if(node->HasAttribute("id"))
-			{
-				periodId += node->GetAttributeValue("id");
-			}
-			node->AddAttribute("id", periodId);
-		}
-
-		if (isEmpty)
-			return node;
-
-		Node    *subnode = NULL;
-		int     ret = xmlTextReaderRead(*reader);
-
-		while (ret == 1)
-		{
-			if (!strcmp(name, (const char *)xmlTextReaderConstName(*reader)))
-			{
-				return node;
-			}
-
-			subnode = aamp_ProcessNode(reader, url, isAd);
-
-			if (subnode != NULL)
-				node->AddSubNode(subnode);
-
-			ret = xmlTextReaderRead(*reader);
-		}
-
-		return node;
-	}
-	else if (type == Text)
-	{
-		xmlChar * text = xmlTextReaderReadString(*reader);
-
-		if (text != NULL)
-		{
-			Node *node = new Node();
-			node->SetType(type);
-			node->SetText((const char*)text);
-			xmlFree(text);
-			return node;
-		}
-	}
-	return NULL;
+	return ProcessNode(reader, Path::GetDirectoryPath(url), isAd, NULL);
 }
 
 
@@ -2637,15 +3581,12 @@ void PrivateStreamAbstractionMPD::ProcessContentProtection(IAdaptationSet * adap
 			sessionParams->drmType = drmType;
 			sessionParams->contentMetadata = contentMetadata;
 
-			if(drmSessionThreadStarted) //In the case of license rotation
+			// Licenses of distinct keys (e.g. audio and video) are acquired in parallel;
+			// beyond that, wait for the oldest request as in the case of license rotation
+			if(createDRMSessionTasks.size() >= MAX_PARALLEL_DRM_SESSION_THREADS)
 			{
-				void *value_ptr = NULL;
-				int rc = pthread_join(createDRMSessionThreadID, &value_ptr);
-				if (rc != 0)
-				{
-					logprintf("pthread_join returned %d for createDRMSession Thread", rc);
-				}
-				drmSessionThreadStarted = false;
+				createDRMSessionTasks.front().wait();
+				createDRMSessionTasks.erase(createDRMSessionTasks.begin());
 			}
 			/*
 			* Memory allocated for data via base64_Decode() and memory for sessionParams
@@ -2655,21 +3596,14 @@ void PrivateStreamAbstractionMPD::ProcessContentProtection(IAdaptationSet * adap
 			* b. Assigned to lastProcessedKeyId which is released before new keyID is assigned
 			*     or in the distructor of PrivateStreamAbstractionMPD
 			*/
-			if(0 == pthread_create(&createDRMSessionThreadID,NULL,CreateDRMSession,sessionParams))
-			{
-				drmSessionThreadStarted = true;
-				if(lastProcessedKeyId)
-				{
-					free(lastProcessedKeyId);
-				}
-				lastProcessedKeyId =  keyId;
-				lastProcessedKeyIdLen = keyIdLen;
-				aamp->setCurrentDrm(drmType);
-			}
-			else
+			createDRMSessionTasks.push_back(AampTaskExecutor::GetInstance()->Submit(eAAMP_TASK_PRIORITY_TUNE, [sessionParams]() { CreateDRMSession(sessionParams); }));
+			if(lastProcessedKeyId)
 			{
-				logprintf("%s %d pthread_create failed for CreateDRMSession : error code %d, %s", __FUNCTION__, __LINE__, errno, strerror(errno));
+				free(lastProcessedKeyId);
 			}
+			lastProcessedKeyId =  keyId;
+			lastProcessedKeyIdLen = keyIdLen;
+			aamp->setCurrentDrm(drmType);
 		}
 		else
 		{
@@ -3023,6 +3957,7 @@ AAMPStatusType PrivateStreamAbstractionMPD::Init(TuneType tuneType)
 {
 	AAMPStatusType retval = eAAMPSTATUS_OK;
 	aamp->CurlInit(eCURLINSTANCE_VIDEO, AAMP_TRACK_COUNT,aamp->GetNetworkProxy());
+	aamp->CurlInit(eCURLINSTANCE_MANIFEST_PLAYLIST, 1, aamp->GetNetworkProxy());
 	mCdaiObject->ResetState();
 
 	aamp->mStreamSink->ClearProtectionEvent();
@@ -3044,6 +3979,7 @@ AAMPStatusType PrivateStreamAbstractionMPD::Init(TuneType tuneType)
 	{
 		aamp->SetCurlTimeout(aamp->mNetworkTimeoutMs, (AampCurlInstance)i);
 	}
+	aamp->SetCurlTimeout(aamp->mManifestTimeoutMs, eCURLINSTANCE_MANIFEST_PLAYLIST);
 
 	AAMPStatusType ret = UpdateMPD(true);
 	if (ret == eAAMPSTATUS_OK)
@@ -3556,8 +4492,12 @@ AAMPStatusType PrivateStreamAbstractionMPD::UpdateMPD(bool init)
 	std::string origManifestUrl = manifestUrl;
 	bool gotManifest = false;
 	bool retrievedPlaylistFromCache = false;
+	bool refreshedInBackground = (!init && mManifestRefreshThreadStarted);
+	bool isPatch = false;
+	long long downloadTimeMs = 0;
+	uint32_t fetchTime = 0;
 	memset(&manifest, 0, sizeof(manifest));
-	if (aamp->getAampCacheHandler()->RetrieveFromPlaylistCache(manifestUrl, &manifest, manifestUrl))
+	if (!refreshedInBackground && aamp->getAampCacheHandler()->RetrieveFromPlaylistCache(manifestUrl, &manifest, manifestUrl))
 	{
 		logprintf("PrivateStreamAbstractionMPD::%s:%d manifest retrieved from cache", __FUNCTION__, __LINE__);
 		retrievedPlaylistFromCache = true;
@@ -3566,18 +4506,64 @@ AAMPStatusType PrivateStreamAbstractionMPD::UpdateMPD(bool init)
 	{
 		long http_error = 0;
 		memset(&manifest, 0, sizeof(manifest));
-		aamp->profiler.ProfileBegin(PROFILE_BUCKET_MANIFEST);
-		aamp->SetCurlTimeout(aamp->mManifestTimeoutMs,eCURLINSTANCE_VIDEO);
-		gotManifest = aamp->GetFile(manifestUrl, &manifest, manifestUrl, &http_error, NULL, eCURLINSTANCE_VIDEO, true, eMEDIATYPE_MANIFEST);
-		aamp->SetCurlTimeout(aamp->mNetworkTimeoutMs,eCURLINSTANCE_VIDEO);
+		if (refreshedInBackground)
+		{
+			// Downloaded by manifest refresh thread; wait if it is still in progress
+			if (!TakeRefreshedManifest(manifest, manifestUrl, http_error, gotManifest, isPatch, downloadTimeMs, fetchTime))
+			{
+				return AAMPStatusType::eAAMPSTATUS_OK;
+			}
+			if (gotManifest && http_error == 304 && this->mpd)
+			{
+				// Not modified, current MPD stays valid
+				AAMPLOG_INFO("%s:%d Manifest not modified", __FUNCTION__, __LINE__);
+				// Reported as success, not as a non-200 response
+				aamp->UpdateVideoEndMetrics(eMEDIATYPE_MANIFEST,0,200,manifestUrl);
+				aamp_Free(&manifest.ptr);
+				MPD *currentMpd = dynamic_cast<MPD *>(this->mpd);
+				if (currentMpd)
+				{
+					currentMpd->SetFetchTime(fetchTime);
+				}
+				mLastPlaylistDownloadTimeMs = downloadTimeMs;
+				mContext->mNetworkDownDetected = false;
+				return AAMPStatusType::eAAMPSTATUS_OK;
+			}
+			if (isPatch)
+			{
+				// Reported here as manifestUrl becomes that of patched manifest
+				aamp->UpdateVideoEndMetrics(eMEDIATYPE_MANIFEST,0,http_error,manifestUrl);
+				if (!gotManifest || !ApplyRefreshedPatch(manifest, manifestUrl))
+				{
+					// Fall back to full manifest right away
+					logprintf("%s:%d MPD patch not applied, refreshing full manifest", __FUNCTION__, __LINE__);
+					aamp_Free(&manifest.ptr);
+					mPatchLocationUrl.clear();
+					SetManifestRefreshUrl();
+					ScheduleManifestRefresh(0);
+					return AAMPStatusType::eAAMPSTATUS_OK;
+				}
+			}
+		}
+		else
+		{
+			aamp->profiler.ProfileBegin(PROFILE_BUCKET_MANIFEST);
+			gotManifest = aamp->GetFile(manifestUrl, &manifest, manifestUrl, &http_error, NULL, eCURLINSTANCE_MANIFEST_PLAYLIST, true, eMEDIATYPE_MANIFEST);
+		}
 
 		//update videoend info
-		aamp->UpdateVideoEndMetrics(eMEDIATYPE_MANIFEST,0,http_error,manifestUrl);
+		if (!isPatch)
+		{
+			aamp->UpdateVideoEndMetrics(eMEDIATYPE_MANIFEST,0,http_error,manifestUrl);
+		}
 
 		if (gotManifest)
 		{
 			aamp->mManifestUrl = manifestUrl;
-			aamp->profiler.ProfileEnd(PROFILE_BUCKET_MANIFEST);
+			if (!refreshedInBackground)
+			{
+				aamp->profiler.ProfileEnd(PROFILE_BUCKET_MANIFEST);
+			}
 			if (mContext->mNetworkDownDetected)
 			{
 				mContext->mNetworkDownDetected = false;
@@ -3585,7 +4571,10 @@ AAMPStatusType PrivateStreamAbstractionMPD::UpdateMPD(bool init)
 		}
 		else if (aamp->DownloadsAreEnabled())
 		{
-			aamp->profiler.ProfileError(PROFILE_BUCKET_MANIFEST, http_error);
+			if (!refreshedInBackground)
+			{
+				aamp->profiler.ProfileError(PROFILE_BUCKET_MANIFEST, http_error);
+			}
 			if (this->mpd != NULL && (CURLE_OPERATION_TIMEDOUT == http_error || CURLE_COULDNT_CONNECT == http_error))
 			{
 				//Skip this for first ever update mpd request
@@ -3630,7 +4619,7 @@ AAMPStatusType PrivateStreamAbstractionMPD::UpdateMPD(bool init)
 
 		MPD* mpd = nullptr;
 		vector<std::string> locationUrl;
-		ret = GetMpdFromManfiest(manifest, mpd, manifestUrl, init);
+		ret = GetMpdFromManfiest(manifest, mpd, manifestUrl, init, fetchTime);
 		AAMPLOG_INFO("%s:%d Created MPD[%p]", __FUNCTION__, __LINE__, mpd);
 		if (eAAMPSTATUS_OK == ret)
 		{
@@ -3642,16 +4631,37 @@ AAMPStatusType PrivateStreamAbstractionMPD::UpdateMPD(bool init)
 			{
 				aamp->SetManifestUrl(locationUrl[0].c_str());
 			}
-			if (this->mpd)
+			if (this->mpd && this->mpd != mpd)
 			{
 				delete this->mpd;
 			}
 			this->mpd = mpd;
+			mManifestUpdateCount++;
 			mIsLiveManifest = !(mpd->GetType() == "static");
 			if (!retrievedPlaylistFromCache && !mIsLiveManifest)
 			{
 				aamp->getAampCacheHandler()->InsertToPlaylistCache(origManifestUrl, &manifest, aamp->GetManifestUrl(), mIsLiveStream,eMEDIATYPE_MANIFEST);
 			}
+			if (mIsLiveManifest && !mPatchLocationUrl.empty())
+			{
+				// Next patch applies to this manifest
+				mPatchBase.assign(manifest.ptr, manifest.len);
+				mPatchBaseUrl = manifestUrl;
+			}
+			else
+			{
+				mPatchBase.clear();
+				mPatchBaseUrl.clear();
+			}
+			if (mManifestRefreshThreadStarted)
+			{
+				SetManifestRefreshUrl();
+				if (!mIsLiveManifest)
+				{
+					// Manifest turned static, nothing more to refresh
+					StopManifestRefresh();
+				}
+			}
 		}
 		else
 		{
@@ -3659,7 +4669,8 @@ AAMPStatusType PrivateStreamAbstractionMPD::UpdateMPD(bool init)
 			retrievedPlaylistFromCache = false;
 		}
 		aamp_Free(&manifest.ptr);
-		mLastPlaylistDownloadTimeMs = aamp_GetCurrentTimeMS();
+		// Background download may have waited up to a refresh interval to be taken
+		mLastPlaylistDownloadTimeMs = refreshedInBackground ? downloadTimeMs : aamp_GetCurrentTimeMS();
 		if(mIsLiveStream && gpGlobalConfig->enableClientDai)
 		{
 			mCdaiObject->PlaceAds(mpd);
@@ -4241,6 +5252,259 @@ static void * FragmentCollector(void *arg)
 	return NULL;
 }
 
+/**
+ * @brief Get interval between live manifest downloads of refresh thread
+ * @param minUpdateDurationMs MPD@minimumUpdatePeriod in ms
+ * @retval interval in ms
+ */
+static int GetManifestRefreshInterval(int64_t minUpdateDurationMs)
+{
+	int intervalMs = (int)minUpdateDurationMs;
+	intervalMs = (intervalMs > MAX_DELAY_BETWEEN_MPD_UPDATE_MS) ? MAX_DELAY_BETWEEN_MPD_UPDATE_MS : intervalMs;
+	intervalMs = (intervalMs < MIN_DELAY_BETWEEN_MPD_UPDATE_MS) ? MIN_DELAY_BETWEEN_MPD_UPDATE_MS : intervalMs;
+	return intervalMs;
+}
+
+/**
+ * @brief Manifest refresh thread
+ * @param arg Pointer to PrivateStreamAbstractionMPD object
+ * @retval NULL
+ */
+static void * ManifestRefresher(void *arg)
+{
+	PrivateStreamAbstractionMPD *context = (PrivateStreamAbstractionMPD *)arg;
+	if(aamp_pthread_setname(pthread_self(), "aampMPDRefresh"))
+	{
+		logprintf("%s:%d: aamp_pthread_setname failed", __FUNCTION__, __LINE__);
+	}
+	context->ManifestRefreshLoop();
+	return NULL;
+}
+
+/**
+ * @brief Start background refresh of live manifest
+ */
+void PrivateStreamAbstractionMPD::StartManifestRefresh()
+{
+	int intervalMs = GetManifestRefreshInterval(mMinUpdateDurationMs);
+
+	pthread_mutex_lock(&mManifestRefreshMutex);
+	mManifestRefreshStop = false;
+	if (mRefreshedManifestReady)
+	{
+		// left over from previous start, stale by now
+		aamp_Free(&mRefreshedManifest.ptr);
+		mRefreshedManifestReady = false;
+	}
+	mManifestRefreshDueMs = mLastPlaylistDownloadTimeMs + intervalMs;
+	pthread_mutex_unlock(&mManifestRefreshMutex);
+	SetManifestRefreshUrl();
+	if (0 == pthread_create(&mManifestRefreshThreadID, NULL, &ManifestRefresher, this))
+	{
+		mManifestRefreshThreadStarted = true;
+	}
+	else
+	{
+		logprintf("%s:%d Failed to create manifest refresh thread, refreshing from fetcher", __FUNCTION__, __LINE__);
+	}
+}
+
+/**
+ * @brief Stop background refresh of live manifest and wait for refresh thread to exit
+ */
+void PrivateStreamAbstractionMPD::StopManifestRefresh()
+{
+	if (mManifestRefreshThreadStarted)
+	{
+		pthread_mutex_lock(&mManifestRefreshMutex);
+		mManifestRefreshStop = true;
+		pthread_cond_broadcast(&mManifestRefreshCond);
+		pthread_mutex_unlock(&mManifestRefreshMutex);
+		int rc = pthread_join(mManifestRefreshThreadID, NULL);
+		if (rc != 0)
+		{
+			logprintf("%s:%d ***pthread_join failed, returned %d", __FUNCTION__, __LINE__, rc);
+		}
+		mManifestRefreshThreadStarted = false;
+	}
+}
+
+/**
+ * @brief Bring next manifest download forward
+ * @param delayMs time from now within which manifest should be downloaded
+ */
+void PrivateStreamAbstractionMPD::ScheduleManifestRefresh(int delayMs)
+{
+	long long dueMs = aamp_GetCurrentTimeMS() + delayMs;
+	pthread_mutex_lock(&mManifestRefreshMutex);
+	if (dueMs < mManifestRefreshDueMs)
+	{
+		mManifestRefreshDueMs = dueMs;
+		pthread_cond_broadcast(&mManifestRefreshCond);
+	}
+	pthread_mutex_unlock(&mManifestRefreshMutex);
+}
+
+/**
+ * @brief Check if refresh thread has a manifest download not yet taken
+ * @retval true if a download is ready
+ */
+bool PrivateStreamAbstractionMPD::IsRefreshedManifestReady()
+{
+	pthread_mutex_lock(&mManifestRefreshMutex);
+	bool ready = mRefreshedManifestReady;
+	pthread_mutex_unlock(&mManifestRefreshMutex);
+	return ready;
+}
+
+/**
+ * @brief Take latest manifest download of refresh thread, waiting for it if not ready
+ * @param[out] manifest buffer with manifest, owned by caller
+ * @param[out] manifestUrl effective url of download
+ * @param[out] http_error http or curl error of download
+ * @param[out] gotManifest true if download succeeded
+ * @param[out] isPatch true if download is from PatchLocation
+ * @param[out] downloadTimeMs time download completed
+ * @param[out] fetchTime UTC time in seconds download completed
+ * @retval false if refresh is stopped or downloads are disabled before a download is ready
+ */
+bool PrivateStreamAbstractionMPD::TakeRefreshedManifest(GrowableBuffer &manifest, std::string &manifestUrl, long &http_error, bool &gotManifest, bool &isPatch,
+		long long &downloadTimeMs, uint32_t &fetchTime)
+{
+	bool taken = false;
+	pthread_mutex_lock(&mManifestRefreshMutex);
+	while (!mRefreshedManifestReady && !mManifestRefreshStop && aamp->DownloadsAreEnabled())
+	{
+		WaitForManifestRefresh(MANIFEST_REFRESH_WAIT_SLICE_MS);
+	}
+	if (mRefreshedManifestReady)
+	{
+		manifest = mRefreshedManifest;
+		memset(&mRefreshedManifest, 0, sizeof(mRefreshedManifest));
+		manifestUrl = mRefreshedManifestUrl;
+		http_error = mRefreshedManifestHttpError;
+		gotManifest = mRefreshedManifestOk;
+		isPatch = mRefreshedManifestIsPatch;
+		downloadTimeMs = mRefreshedManifestTimeMs;
+		fetchTime = mRefreshedManifestFetchTime;
+		mRefreshedManifestReady = false;
+		taken = true;
+	}
+	pthread_mutex_unlock(&mManifestRefreshMutex);
+	return taken;
+}
+
+/**
+ * @brief Wait for a change of manifest refresh state, called with mManifestRefreshMutex held
+ * @param timeMs max time to wait
+ */
+void PrivateStreamAbstractionMPD::WaitForManifestRefresh(int timeMs)
+{
+	struct timespec ts;
+	struct timeval tv;
+	gettimeofday(&tv, NULL);
+	ts.tv_sec = time(NULL) + timeMs / 1000;
+	ts.tv_nsec = (long)(tv.tv_usec * 1000 + 1000 * 1000 * (timeMs % 1000));
+	ts.tv_sec += ts.tv_nsec / (1000 * 1000 * 1000);
+	ts.tv_nsec %= (1000 * 1000 * 1000);
+	pthread_cond_timedwait(&mManifestRefreshCond, &mManifestRefreshMutex, &ts);
+}
+
+/**
+ * @brief Point refresh thread at PatchLocation of current manifest if usable, else at the manifest itself
+ */
+void PrivateStreamAbstractionMPD::SetManifestRefreshUrl()
+{
+	bool usePatch = (!mPatchLocationUrl.empty() && !mPatchBase.empty() &&
+			(mPatchLocationExpiryMs == 0 || aamp_GetCurrentTimeMS() < mPatchLocationExpiryMs));
+	pthread_mutex_lock(&mManifestRefreshMutex);
+	mManifestRefreshUrl = usePatch ? mPatchLocationUrl : aamp->GetManifestUrl();
+	mManifestRefreshIsPatch = usePatch;
+	pthread_mutex_unlock(&mManifestRefreshMutex);
+}
+
+/**
+ * @brief Replace MPD patch download with the manifest it updates
+ * @param[in,out] manifest downloaded patch, replaced by patched manifest
+ * @param[out] manifestUrl url of patched manifest
+ * @retval false if download is not a patch for current manifest
+ */
+bool PrivateStreamAbstractionMPD::ApplyRefreshedPatch(GrowableBuffer &manifest, std::string &manifestUrl)
+{
+	std::string patched;
+	if (mPatchBase.empty())
+	{
+		return false;
+	}
+	if (!IsMpdPatch(manifest))
+	{
+		// Server may answer with full manifest
+		return true;
+	}
+	if (!ApplyMpdPatch(mPatchBase, manifest, patched))
+	{
+		return false;
+	}
+	manifest.len = 0;
+	aamp_AppendBytes(&manifest, patched.data(), patched.size());
+	manifestUrl = mPatchBaseUrl;
+	return true;
+}
+
+/**
+ * @brief Download live manifest on its own curl instance at MPD@minimumUpdatePeriod,
+ * so a slow manifest request does not hold back fragment downloads.
+ * Only the latest download is kept for FetcherLoop.
+ */
+void PrivateStreamAbstractionMPD::ManifestRefreshLoop()
+{
+	int intervalMs = GetManifestRefreshInterval(mMinUpdateDurationMs);
+	AAMPLOG_INFO("%s:%d Manifest refresh interval %d ms", __FUNCTION__, __LINE__, intervalMs);
+
+	pthread_mutex_lock(&mManifestRefreshMutex);
+	while (!mManifestRefreshStop)
+	{
+		long long waitMs = mManifestRefreshDueMs - aamp_GetCurrentTimeMS();
+		if (waitMs > 0)
+		{
+			WaitForManifestRefresh((int)waitMs);
+			continue;
+		}
+		std::string manifestUrl = mManifestRefreshUrl;
+		bool isPatch = mManifestRefreshIsPatch;
+		pthread_mutex_unlock(&mManifestRefreshMutex);
+
+		GrowableBuffer manifest;
+		long http_error = 0;
+		memset(&manifest, 0, sizeof(manifest));
+		bool gotManifest = aamp->GetFile(manifestUrl, &manifest, manifestUrl, &http_error, NULL, eCURLINSTANCE_MANIFEST_PLAYLIST, true, eMEDIATYPE_MANIFEST);
+		long long downloadTimeMs = aamp_GetCurrentTimeMS();
+		uint32_t fetchTime = Time::GetCurrentUTCTimeInSec();
+		if (!gotManifest)
+		{
+			aamp_Free(&manifest.ptr);
+		}
+
+		pthread_mutex_lock(&mManifestRefreshMutex);
+		if (mRefreshedManifestReady)
+		{
+			AAMPLOG_INFO("%s:%d Replacing manifest not taken by fetcher", __FUNCTION__, __LINE__);
+			aamp_Free(&mRefreshedManifest.ptr);
+		}
+		mRefreshedManifest = manifest;
+		mRefreshedManifestUrl = manifestUrl;
+		mRefreshedManifestHttpError = http_error;
+		mRefreshedManifestOk = gotManifest;
+		mRefreshedManifestIsPatch = isPatch;
+		mRefreshedManifestTimeMs = downloadTimeMs;
+		mRefreshedManifestFetchTime = fetchTime;
+		mRefreshedManifestReady = true;
+		mManifestRefreshDueMs = aamp_GetCurrentTimeMS() + intervalMs;
+		pthread_cond_broadcast(&mManifestRefreshCond);
+	}
+	pthread_mutex_unlock(&mManifestRefreshMutex);
+}
+
 
 /**
  * @brief Check if adaptation set is iframe track
@@ -5226,7 +6490,7 @@ double PrivateStreamAbstractionMPD::GetCulledSeconds()
  */
 void PrivateStreamAbstractionMPD::FetchAndInjectInitialization(bool discontinuity)
 {
-	pthread_t trackDownloadThreadID;
+	std::future<void> trackDownloadTask;
 	HeaderFetchParams *fetchParams = NULL;
 	bool dlThreadCreated = false;
 	int numberOfTracks = mNumberOfTracks;
@@ -5270,16 +6534,8 @@ void PrivateStreamAbstractionMPD::FetchAndInjectInitialization(bool discontinuit
 							fetchParams->isinitialization = true;
 							fetchParams->pMediaStreamContext = pMediaStreamContext;
 							fetchParams->discontinuity = pMediaStreamContext->discontinuity;
-							int ret = pthread_create(&trackDownloadThreadID, NULL, TrackDownloader, fetchParams);
-							if(ret != 0)
-							{
-								logprintf("PrivateStreamAbstractionMPD::%s:%d pthread_create failed for TrackDownloader with errno = %d, %s", __FUNCTION__, __LINE__, errno, strerror(errno));
-								delete fetchParams;
-							}
-							else
-							{
-								dlThreadCreated = true;
-							}
+							trackDownloadTask = AampTaskExecutor::GetInstance()->Submit(eAAMP_TASK_PRIORITY_TUNE, [fetchParams]() { TrackDownloader(fetchParams); });
+							dlThreadCreated = true;
 						}
 						else
 						{
@@ -5345,16 +6601,8 @@ void PrivateStreamAbstractionMPD::FetchAndInjectInitialization(bool discontinuit
 									fetchParams->initialization = initialization;
 									fetchParams->isinitialization = true;
 									fetchParams->pMediaStreamContext = pMediaStreamContext;
-									int ret = pthread_create(&trackDownloadThreadID, NULL, TrackDownloader, fetchParams);
-									if(ret != 0)
-									{
-										logprintf("PrivateStreamAbstractionMPD::%s:%d pthread_create failed for TrackDownloader with errno = %d, %s", __FUNCTION__, __LINE__, errno, strerror(errno));
-										delete fetchParams;
-									}
-									else
-									{
-										dlThreadCreated = true;
-									}
+									trackDownloadTask = AampTaskExecutor::GetInstance()->Submit(eAAMP_TASK_PRIORITY_TUNE, [fetchParams]() { TrackDownloader(fetchParams); });
+									dlThreadCreated = true;
 								}
 								else
 								{
@@ -5435,9 +6683,9 @@ void PrivateStreamAbstractionMPD::FetchAndInjectInitialization(bool discontinuit
 
 	if(dlThreadCreated)
 	{
-		AAMPLOG_TRACE("Waiting for pthread_join trackDownloadThread");
-		pthread_join(trackDownloadThreadID, NULL);
-		AAMPLOG_TRACE("Joined trackDownloadThread");
+		AAMPLOG_TRACE("Waiting for trackDownload task");
+		trackDownloadTask.wait();
+		AAMPLOG_TRACE("trackDownload task done");
 		delete fetchParams;
 	}
 }
@@ -5841,7 +7089,7 @@ void PrivateStreamAbstractionMPD::FetcherLoop()
 						struct MediaStreamContext *pMediaStreamContext = mMediaStreamContext[i];
 						if (pMediaStreamContext->adaptationSet )
 						{
-							if((pMediaStreamContext->numberOfFragmentsCached != gpGlobalConfig->maxCachedFragmentsPerTrack) && !(pMediaStreamContext->profileChanged))
+							if((pMediaStreamContext->numberOfFragmentsCached != pMediaStreamContext->maxCachedFragments) && !(pMediaStreamContext->profileChanged))
 							{	// profile not changed and Cache not full scenario
 								if (!pMediaStreamContext->eos)
 								{
@@ -5898,7 +7146,7 @@ void PrivateStreamAbstractionMPD::FetcherLoop()
 								FetchAndInjectInitialization();
 							}
 
-							if(pMediaStreamContext->numberOfFragmentsCached != gpGlobalConfig->maxCachedFragmentsPerTrack)
+							if(pMediaStreamContext->numberOfFragmentsCached != pMediaStreamContext->maxCachedFragments)
 							{
 								bCacheFullState = false;
 							}
@@ -5986,6 +7234,11 @@ void PrivateStreamAbstractionMPD::FetcherLoop()
 						lastPrdOffset = mBasePeriodOffset;
 					}
 					int timeoutMs =  MAX_DELAY_BETWEEN_MPD_UPDATE_MS - (int)(aamp_GetCurrentTimeMS() - mLastPlaylistDownloadTimeMs);
+					if(mManifestRefreshThreadStarted)
+					{
+						// Refresh thread keeps the schedule; switch over once its download is in
+						timeoutMs = IsRefreshedManifestReady() ? 0 : 1;
+					}
 					if(timeoutMs <= 0 && mIsLiveManifest && rate > 0)
 					{
 						liveMPDRefresh = true;
@@ -6110,8 +7363,16 @@ void PrivateStreamAbstractionMPD::FetcherLoop()
 			AAMPLOG_INFO("aamp playlist end refresh bufferMs(%ld) delay(%d) delta(%d) End(%lld) PlayPosition(%lld)",
 				bufferAvailable,minDelayBetweenPlaylistUpdates,timeSinceLastPlaylistDownload,endPositionAvailable,currentPlayPosition);
 
-			// sleep before next manifest update
-			aamp->InterruptableMsSleep(minDelayBetweenPlaylistUpdates);
+			if (mManifestRefreshThreadStarted)
+			{
+				// bring next download forward if due later; UpdateMPD waits for it
+				ScheduleManifestRefresh(minDelayBetweenPlaylistUpdates);
+			}
+			else
+			{
+				// sleep before next manifest update
+				aamp->InterruptableMsSleep(minDelayBetweenPlaylistUpdates);
+			}
 		}
 		if (!aamp->DownloadsAreEnabled() || UpdateMPD() != eAAMPSTATUS_OK)
 		{
@@ -6196,6 +7457,10 @@ void PrivateStreamAbstractionMPD::Start(void)
 #ifdef AAMP_MPD_DRM
 	aamp->mDRMSessionManager->setSessionMgrState(SessionMgrState::eSESSIONMGR_ACTIVE);
 #endif
+	if (mIsLiveManifest)
+	{
+		StartManifestRefresh();
+	}
 	pthread_create(&fragmentCollectorThreadID, NULL, &FragmentCollector, this);
 	fragmentCollectorThreadStarted = true;
 	for (int i=0; i< mNumberOfTracks; i++)
@@ -6236,17 +7501,18 @@ void PrivateStreamAbstractionMPD::Stop()
 			track->StopInjectLoop();
 		}
 	}
-	if(drmSessionThreadStarted)
+	for (std::future<void> &createDRMSessionTask : createDRMSessionTasks)
 	{
-		AAMPLOG_INFO("Waiting to join CreateDRMSession thread");
-		int rc = pthread_join(createDRMSessionThreadID, NULL);
-		if (rc != 0)
-		{
-			logprintf("pthread_join returned %d for createDRMSession Thread", rc);
-		}
-		AAMPLOG_INFO("Joined CreateDRMSession thread");
-		drmSessionThreadStarted = false;
+		AAMPLOG_INFO("Waiting for CreateDRMSession task");
+		createDRMSessionTask.wait();
+		AAMPLOG_INFO("CreateDRMSession task done");
 	}
+	createDRMSessionTasks.clear();
+	// wake FetcherLoop if it waits for a manifest download
+	pthread_mutex_lock(&mManifestRefreshMutex);
+	mManifestRefreshStop = true;
+	pthread_cond_broadcast(&mManifestRefreshCond);
+	pthread_mutex_unlock(&mManifestRefreshMutex);
 	if(fragmentCollectorThreadStarted)
 	{
 		int rc = pthread_join(fragmentCollectorThreadID, NULL);
@@ -6256,6 +7522,16 @@ void PrivateStreamAbstractionMPD::Stop()
 		}
 		fragmentCollectorThreadStarted = false;
 	}
+	// Downloads are disabled, transfers ahead of the fetchers abort
+	for (int iTrack = 0; iTrack < mNumberOfTracks; iTrack++)
+	{
+		MediaStreamContext *track = mMediaStreamContext[iTrack];
+		if (track)
+		{
+			track->StopPrefetch();
+		}
+	}
+	StopManifestRefresh();
 	aamp->mStreamSink->ClearProtectionEvent();
  #ifdef AAMP_MPD_DRM
 	aamp->mDRMSessionManager->setSessionMgrState(SessionMgrState::eSESSIONMGR_INACTIVE);
@@ -6294,8 +7570,13 @@ PrivateStreamAbstractionMPD::~PrivateStreamAbstractionMPD(void)
 	}
 
 	aamp->CurlTerm(eCURLINSTANCE_VIDEO, AAMP_TRACK_COUNT);
+	aamp->CurlTerm(eCURLINSTANCE_MANIFEST_PLAYLIST);
 
 	aamp->SyncEnd();
+
+	aamp_Free(&mRefreshedManifest.ptr);
+	pthread_cond_destroy(&mManifestRefreshCond);
+	pthread_mutex_destroy(&mManifestRefreshMutex);
 }
 
 
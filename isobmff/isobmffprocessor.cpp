@@ -234,6 +234,40 @@ bool IsoBmffProcessor::sendSegment(char *segment, size_t& size, double position,
 	return true;
 }
 
+/**
+ * @brief Process and send media fragment, handing over buffer ownership
+ *
+ * @param[in,out] buffer - fragment buffer, reset if ownership is taken
+ * @param[in] position - position of fragment
+ * @param[in] duration - duration of fragment
+ * @param[in] discontinuous - true if discontinuous fragment
+ * @param[out] ptsError - flag indicates if any PTS error occurred
+ * @return true if fragment was sent, false otherwise
+ */
+bool IsoBmffProcessor::sendSegmentBuffer(GrowableBuffer *buffer, double position, double duration, bool discontinuous, bool &ptsError)
+{
+	bool passThrough;
+	if (type == eBMFFPROCESSOR_TYPE_AUDIO)
+	{
+		passThrough = (processPTSComplete && initSegmentProcessComplete);
+	}
+	else
+	{
+		passThrough = (processPTSComplete || playRate != AAMP_NORMAL_PLAY_RATE);
+	}
+
+	if (!passThrough)
+	{
+		// Init segment caching and base PTS processing still pending, fragment needs inspection
+		return sendSegment(buffer->ptr, buffer->len, position, duration, discontinuous, ptsError);
+	}
+
+	ptsError = false;
+	AAMPLOG_TRACE("IsoBmffProcessor::%s() %d [%s] sending segment at pos:%f dur:%f", __FUNCTION__, __LINE__, IsoBmffProcessorTypeName[type], position, duration);
+	p_aamp->SendStream((MediaType)type, buffer, position, position, duration);
+	return true;
+}
+
 /**
  * @brief Abort all operations
  *
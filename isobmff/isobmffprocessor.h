@@ -92,6 +92,18 @@ public:
 	 */
 	bool sendSegment(char *segment, size_t& size, double position, double duration, bool discontinuous, bool &ptsError) override;
 
+	/**
+	 * @brief Process and send media fragment, handing over buffer ownership
+	 *
+	 * @param[in,out] buffer - fragment buffer, reset if ownership is taken
+	 * @param[in] position - position of fragment
+	 * @param[in] duration - duration of fragment
+	 * @param[in] discontinuous - true if discontinuous fragment
+	 * @param[out] ptsError - flag indicates if any PTS error occurred
+	 * @return true if fragment was sent, false otherwise
+	 */
+	bool sendSegmentBuffer(GrowableBuffer *buffer, double position, double duration, bool discontinuous, bool &ptsError) override;
+
 	/**
 	 * @brief Abort all operations
 	 *
@@ -236,6 +236,7 @@ enum ConfigParamType
 	ePARAM_SEGMENTINJECTLIMIT,
 	ePARAM_DRMDECRYPTLIMIT,
 	ePARAM_USE_MATCHING_BASEURL,
+	ePARAM_ABRMODE,
 	ePARAM_MAX_COUNT
 };
 
@@ -291,6 +292,7 @@ static ConfigParamMap initialConfigParamNames[] =
 	{ ePARAM_SEGMENTINJECTLIMIT, "segmentInjectFailThreshold" },
 	{ ePARAM_DRMDECRYPTLIMIT, "drmDecryptFailThreshold" },
 	{ ePARAM_USE_MATCHING_BASEURL, "useMatchingBaseUrl" },
+	{ ePARAM_ABRMODE, "abrMode" },
 	{ ePARAM_MAX_COUNT, "" }
 };
 
@@ -699,6 +701,7 @@ JSValueRef AAMPMediaPlayerJS_initConfig (JSContextRef ctx, JSObjectRef function,
 			case ePARAM_SEGMENTINJECTLIMIT:
 			case ePARAM_DRMDECRYPTLIMIT:
 			case ePARAM_INIT_FRAGMENT_RETRY_COUNT:
+			case ePARAM_ABRMODE:
 				ret = ParseJSPropAsNumber(ctx, initConfigObj, initialConfigParamNames[iter].paramName, valueAsNumber);
 				break;
 			case ePARAM_AUDIOLANGUAGE:
@@ -807,6 +810,9 @@ JSValueRef AAMPMediaPlayerJS_initConfig (JSContextRef ctx, JSObjectRef function,
 				case ePARAM_USE_NEWABR:
 					privObj->_aamp->SetNewABRConfig(valueAsBoolean);
 					break;
+				case ePARAM_ABRMODE:
+					privObj->_aamp->SetABRMode((int) valueAsNumber);
+					break;
 				case ePARAM_USE_NEW_ADBREAKER:
 					privObj->_aamp->SetNewAdBreakerConfig(valueAsBoolean);
 					break;
@@ -55,6 +55,10 @@
 #include <fstream>
 #include <math.h>
 #include "AampCacheHandler.h"
+#include "AampBufferPool.h"
+#include "AampMultiDownloader.h"
+#include "AampDiskCache.h"
+#include "webvttParser.h"
 #ifdef USE_OPENCDM // AampOutputProtection is compiled when this  flag is enabled 
 #include "aampoutputprotection.h"
 #endif
@@ -120,12 +124,13 @@ int getch(void)
  */
 struct AsyncEventDescriptor
 {
-	AsyncEventDescriptor() : event(), aamp(NULL)
+	AsyncEventDescriptor() : event(), aamp(NULL), coalesced(false)
 	{
 	}
 
 	AAMPEvent event;
 	PrivateInstanceAAMP* aamp;
+	bool coalesced;         /**< event may be replaced by a newer one of same type till dispatched */
 
 	AsyncEventDescriptor(const AsyncEventDescriptor &other) = delete;
 
@@ -277,6 +282,9 @@ GlobalConfigAAMP *gpGlobalConfig;
 #define LOCAL_HOST_IP       "127.0.0.1"
 #define STR_PROXY_BUFF_SIZE  64
 #define AAMP_MAX_TIME_BW_UNDERFLOWS_TO_TRIGGER_RETUNE_MS (20*1000LL)
+#define ABR_ABANDON_SAMPLE_INTERVAL_MS 200      /**< Min interval between mid-download throughput samples */
+#define ABR_ABANDON_MIN_ELAPSED_MS 1000         /**< Min download time before a fragment can be abandoned */
+#define ABR_ABANDON_EWMA_ALPHA 0.3              /**< Weight of latest sample in smoothed mid-download throughput */
 
 #define VALIDATE_INT(param_name, param_value, default_value)        \
     if ((param_value <= 0) || (param_value > INT_MAX))  { \
@@ -679,16 +687,13 @@ void PrivateInstanceAAMP::AddEventListener(AAMPEventType eventType, AAMPEventLis
 	//logprintf("[AAMP_JS] %s(%d, %p)", __FUNCTION__, eventType, eventListener);
 	if ((eventListener != NULL) && (eventType >= 0) && (eventType < AAMP_MAX_NUM_EVENTS))
 	{
-		ListenerData* pListener = new ListenerData;
-		if (pListener)
-		{
-			//logprintf("[AAMP_JS] %s(%d, %p) new %p", __FUNCTION__, eventType, eventListener, pListener);
-			pthread_mutex_lock(&mLock);
-			pListener->eventListener = eventListener;
-			pListener->pNext = mEventListeners[eventType];
-			mEventListeners[eventType] = pListener;
-			pthread_mutex_unlock(&mLock);
-		}
+		// mLock serializes writers only; SendEventSync reads the published table without locking
+		pthread_mutex_lock(&mLock);
+		std::shared_ptr<const EventListenerTable> current = std::atomic_load(&mEventListeners[eventType]);
+		std::shared_ptr<EventListenerTable> table = current ? std::make_shared<EventListenerTable>(*current) : std::make_shared<EventListenerTable>();
+		table->push_back(eventListener);
+		std::atomic_store(&mEventListeners[eventType], std::shared_ptr<const EventListenerTable>(table));
+		pthread_mutex_unlock(&mLock);
 	}
 }
 
@@ -703,19 +708,23 @@ void PrivateInstanceAAMP::RemoveEventListener(AAMPEventType eventType, AAMPEvent
 	if ((eventListener != NULL) && (eventType >= 0) && (eventType < AAMP_MAX_NUM_EVENTS))
 	{
 		pthread_mutex_lock(&mLock);
-		ListenerData** ppLast = &mEventListeners[eventType];
-		while (*ppLast != NULL)
+		std::shared_ptr<const EventListenerTable> current = std::atomic_load(&mEventListeners[eventType]);
+		if (current)
 		{
-			ListenerData* pListener = *ppLast;
-			if (pListener->eventListener == eventListener)
+			// Remove most recent registration of the listener
+			EventListenerTable::const_reverse_iterator it = std::find(current->rbegin(), current->rend(), eventListener);
+			if (it != current->rend())
 			{
-				*ppLast = pListener->pNext;
-				pthread_mutex_unlock(&mLock);
-				AAMPLOG_INFO("[AAMP_JS] %s(%d, %p) delete %p", __FUNCTION__, eventType, eventListener, pListener);
-				delete pListener;
-				return;
+				std::shared_ptr<const EventListenerTable> table;
+				if (current->size() > 1)
+				{
+					std::shared_ptr<EventListenerTable> newTable = std::make_shared<EventListenerTable>(*current);
+					newTable->erase(newTable->begin() + (current->rend() - it - 1));
+					table = newTable;
+				}
+				std::atomic_store(&mEventListeners[eventType], table);
+				AAMPLOG_INFO("[AAMP_JS] %s(%d, %p) removed", __FUNCTION__, eventType, eventListener);
 			}
-			ppLast = &(pListener->pNext);
 		}
 		pthread_mutex_unlock(&mLock);
 	}
@@ -975,13 +984,39 @@ void PrivateInstanceAAMP::SendErrorEvent(AAMPTuneFailure tuneFailure, const char
  */
 void PrivateInstanceAAMP::SendEventAsync(const AAMPEvent &e)
 {
-	if (mEventListener || mEventListeners[0] || mEventListeners[e.type])
+	if (IsEventListenerAvailable(e.type))
 	{
-		AsyncEventDescriptor* aed = new AsyncEventDescriptor();
-		aed->event = e;
-		ScheduleEvent(aed);
-		if(e.type != AAMP_EVENT_PROGRESS)
+		if (e.type == AAMP_EVENT_PROGRESS || e.type == AAMP_EVENT_BUFFERING_CHANGED)
+		{
+			// Only latest state matters for these; if one is still waiting for dispatch,
+			// update it in place rather than queueing a stale burst for a busy main loop
+			pthread_mutex_lock(&mLock);
+			std::map<AAMPEventType, AsyncEventDescriptor*>::iterator it = mCoalescedEvents.find(e.type);
+			if (it != mCoalescedEvents.end())
+			{
+				it->second->event = e;
+				if(e.type != AAMP_EVENT_PROGRESS)
+					AAMPLOG_INFO("PrivateInstanceAAMP::%s:%d event type  %d replaced pending event", __FUNCTION__, __LINE__,e.type);
+			}
+			else
+			{
+				AsyncEventDescriptor* aed = new AsyncEventDescriptor();
+				aed->event = e;
+				aed->coalesced = true;
+				mCoalescedEvents[e.type] = aed;
+				ScheduleEvent(aed);
+				if(e.type != AAMP_EVENT_PROGRESS)
+					AAMPLOG_INFO("PrivateInstanceAAMP::%s:%d event type  %d", __FUNCTION__, __LINE__,e.type);
+			}
+			pthread_mutex_unlock(&mLock);
+		}
+		else
+		{
+			AsyncEventDescriptor* aed = new AsyncEventDescriptor();
+			aed->event = e;
+			ScheduleEvent(aed);
 			AAMPLOG_INFO("PrivateInstanceAAMP::%s:%d event type  %d", __FUNCTION__, __LINE__,e.type);
+		}
 	}
 	else
 	{
@@ -1015,44 +1050,24 @@ void PrivateInstanceAAMP::SendEventSync(const AAMPEvent &e)
 	}
 
 	AAMPEventType eventType = e.type;
-	if ((eventType < 0) && (eventType >= AAMP_MAX_NUM_EVENTS))
+	if ((eventType < 0) || (eventType >= AAMP_MAX_NUM_EVENTS))
 		return;
 
-	// Build list of registered event listeners.
-	ListenerData* pList = NULL;
-	pthread_mutex_lock(&mLock);
-	ListenerData* pListener = mEventListeners[eventType];
-	while (pListener != NULL)
+	// Snapshot the published listener tables; they are immutable, so event
+	// handlers can add/remove listeners for future events while we dispatch.
+	std::shared_ptr<const EventListenerTable> allListeners = std::atomic_load(&mEventListeners[0]);  // listeners registered for "all" event types
+	std::shared_ptr<const EventListenerTable> listeners = std::atomic_load(&mEventListeners[eventType]);
+	const EventListenerTable* tables[] = { allListeners.get(), (eventType != 0) ? listeners.get() : NULL };
+	for (const EventListenerTable* table : tables)
 	{
-		ListenerData* pNew = new ListenerData;
-		pNew->eventListener = pListener->eventListener;
-		pNew->pNext = pList;
-		pList = pNew;
-		pListener = pListener->pNext;
-	}
-	pListener = mEventListeners[0];  // listeners registered for "all" event types
-	while (pListener != NULL)
-	{
-		ListenerData* pNew = new ListenerData;
-		pNew->eventListener = pListener->eventListener;
-		pNew->pNext = pList;
-		pList = pNew;
-		pListener = pListener->pNext;
-	}
-	pthread_mutex_unlock(&mLock);
-
-	// After releasing the lock, dispatch each of the registered listeners.
-	// This allows event handlers to add/remove listeners for future events.
-	while (pList != NULL)
-	{
-		ListenerData* pCurrent = pList;
-		if (pCurrent->eventListener != NULL)
+		if (table)
 		{
-			//logprintf("[AAMP_JS] %s(type=%d) listener=%p", __FUNCTION__, eventType, pCurrent->eventListener);
-			pCurrent->eventListener->Event(e);
+			for (AAMPEventListener* eventListener : *table)
+			{
+				//logprintf("[AAMP_JS] %s(type=%d) listener=%p", __FUNCTION__, eventType, eventListener);
+				eventListener->Event(e);
+			}
 		}
-		pList = pCurrent->pNext;
-		delete pCurrent;
 	}
 }
 
@@ -1066,7 +1081,7 @@ void PrivateInstanceAAMP::SendEventSync(const AAMPEvent &e)
  */
 void PrivateInstanceAAMP::NotifyBitRateChangeEvent(int bitrate, BitrateChangeReason reason, int width, int height, double frameRate, double position, bool GetBWIndex)
 {
-	if (mEventListener || mEventListeners[0] || mEventListeners[AAMP_EVENT_BITRATE_CHANGED])
+	if (IsEventListenerAvailable(AAMP_EVENT_BITRATE_CHANGED))
 	{
 		AsyncEventDescriptor* e = new AsyncEventDescriptor();
 		e->event.type = AAMP_EVENT_BITRATE_CHANGED;
@@ -1131,7 +1146,7 @@ void PrivateInstanceAAMP::NotifySpeedChanged(int rate, bool changeState)
 		}
 	}
 
-	if (mEventListener || mEventListeners[0] || mEventListeners[AAMP_EVENT_SPEED_CHANGED])
+	if (IsEventListenerAvailable(AAMP_EVENT_SPEED_CHANGED))
 	{
 		AsyncEventDescriptor* e = new AsyncEventDescriptor();
 		e->event.type = AAMP_EVENT_SPEED_CHANGED;
@@ -1348,7 +1363,7 @@ void PrivateInstanceAAMP::NotifyOnEnteringLive()
 	{
 		return;
 	}
-	if (mEventListener || mEventListeners[0] || mEventListeners[AAMP_EVENT_ENTERING_LIVE])
+	if (IsEventListenerAvailable(AAMP_EVENT_ENTERING_LIVE))
 	{
 		SendEventAsync(AAMP_EVENT_ENTERING_LIVE);
 	}
@@ -1357,6 +1372,10 @@ void PrivateInstanceAAMP::NotifyOnEnteringLive()
 static void AsyncEventDestroyNotify(gpointer user_data)
 {
 	AsyncEventDescriptor* e = (AsyncEventDescriptor*)user_data;
+	if (e->coalesced)
+	{
+		e->aamp->ReleaseCoalescedEvent(e);
+	}
 	if (e->event.type == AAMP_EVENT_WEBVTT_CUE_DATA)
 	{
 		delete e->event.data.cue.cueData;
@@ -1386,6 +1405,11 @@ static gboolean SendAsynchronousEvent(gpointer user_data)
 	{
 		AAMPLOG_ERR("PrivateInstanceAAMP::%s:%d [type = %d] aamp_GetSourceID returned zero, which is unexpected behavior!", __FUNCTION__, __LINE__, e->event.type);
 	}
+	if (e->coalesced)
+	{
+		// Stop accepting updates before reading the event
+		e->aamp->ReleaseCoalescedEvent(e);
+	}
 	e->aamp->SendEventSync(e->event);
 	return G_SOURCE_REMOVE;
 }
@@ -1420,7 +1444,7 @@ void PrivateInstanceAAMP::sendTuneMetrics(bool success)
 	//extra events push us over limit
 	printf("tune-profiling: %s", jsonStr.c_str());
 
-	if (mEventListener || mEventListeners[0] || mEventListeners[AAMP_EVENT_TUNE_PROFILING])
+	if (IsEventListenerAvailable(AAMP_EVENT_TUNE_PROFILING))
 	{
 		AsyncMicroEventDescriptor* e = new AsyncMicroEventDescriptor(jsonStr.c_str());
 		ScheduleEvent(e);
@@ -1770,8 +1794,11 @@ struct CurlCallbackContext
 	httpRespHeaderData *responseHeaderData;
 	long bitrate;
 	bool downloadIsEncoded;
+	std::string eTag;           /**< ETag header of response */
+	std::string lastModified;   /**< Last-Modified header of response */
 
-	CurlCallbackContext() : aamp(NULL), buffer(NULL), responseHeaderData(NULL),bitrate(0),downloadIsEncoded(false), fileType(eMEDIATYPE_DEFAULT), allResponseHeadersForErrorLogging{""}
+	CurlCallbackContext() : aamp(NULL), buffer(NULL), responseHeaderData(NULL),bitrate(0),downloadIsEncoded(false), fileType(eMEDIATYPE_DEFAULT), allResponseHeadersForErrorLogging{""},
+		eTag(), lastModified()
 	{
 
 	}
@@ -1795,6 +1822,13 @@ struct CurlProgressCbContext
 	long stallTimeout;
 	double downloadSize;
 	CurlAbortReason abortReason;
+	bool abandonCheck;              /**< abort download if projected to outlast buffer */
+	double bufferedMs;              /**< buffered duration when download started */
+	double fragmentDurationMs;      /**< duration of fragment being downloaded */
+	double expectedBytes;           /**< fragment size estimated from profile bitrate, used without Content-Length */
+	long long sampleTime;           /**< time of last throughput sample, -1 before first byte */
+	double sampleBytes;             /**< bytes downloaded at last throughput sample */
+	double throughputBps;           /**< smoothed throughput of download, 0 if not estimated yet */
 };
 
 /**
@@ -1813,6 +1847,11 @@ static size_t write_callback(char *ptr, size_t size, size_t nmemb, void *userdat
 	if (context->aamp->mDownloadsEnabled)
 	{
 		size_t numBytesForBlock = size*nmemb;
+		if (NULL == context->buffer->ptr)
+		{
+			// No Content-Length based sizing, start from a pooled block
+			context->aamp->GetBufferPool()->Acquire(context->buffer, numBytesForBlock);
+		}
 		aamp_AppendBytes(context->buffer, ptr, numBytesForBlock);
 		ret = numBytesForBlock;
 	}
@@ -1844,6 +1883,25 @@ static void print_headerResponse(std::vector<std::string> &allResponseHeadersFor
 	allResponseHeadersForErrorLogging.clear();
 }
 
+/**
+ * @brief Get value of http header, without surrounding spaces
+ * @param value header text following the header name
+ * @retval header value
+ */
+static std::string GetHeaderValue(const char *value)
+{
+	const char *end = value + strlen(value);
+	while (*value == ' ')
+	{
+		value++;
+	}
+	while (end > value && end[-1] == ' ')
+	{
+		end--;
+	}
+	return std::string(value, end - value);
+}
+
 /**
  * @brief callback invoked on http header by curl
  * @param ptr pointer to buffer containing the data
@@ -1902,31 +1960,42 @@ static size_t header_callback(char *ptr, size_t size, size_t nmemb, void *user_d
 		httpHeader->type = eHTTPHEADERTYPE_EFF_LOCATION;
 		startPos = STRLEN_LITERAL("Location:");
 	}
+	else if (STARTS_WITH_IGNORE_CASE(ptr, "ETag:"))
+	{
+		context->eTag = GetHeaderValue(ptr + STRLEN_LITERAL("ETag:"));
+	}
+	else if (STARTS_WITH_IGNORE_CASE(ptr, "Last-Modified:"))
+	{
+		context->lastModified = GetHeaderValue(ptr + STRLEN_LITERAL("Last-Modified:"));
+	}
+	else if (STARTS_WITH_IGNORE_CASE(ptr, "HTTP/"))
+	{
+		// Status line of next response (redirect), validators seen so far are not of the downloaded file
+		context->eTag.clear();
+		context->lastModified.clear();
+	}
 	else if (STARTS_WITH_IGNORE_CASE(ptr, "Content-Encoding:"))
 	{
 		// Enabled IsEncoded as Content-Encoding header is present
 		// The Content-Encoding entity header incidcates media is compressed
 		context->downloadIsEncoded = true;
 	}
-	else if (0 == context->buffer->avail)
+	else if (STARTS_WITH_IGNORE_CASE(ptr, CONTENTLENGTH_STRING))
 	{
-		if (STARTS_WITH_IGNORE_CASE(ptr, CONTENTLENGTH_STRING))
-		{
-			int contentLengthStartPosition = STRLEN_LITERAL(CONTENTLENGTH_STRING);
-			char* contentLengthStr = ptr + contentLengthStartPosition;
-			int contentLength = atoi(contentLengthStr);
+		int contentLengthStartPosition = STRLEN_LITERAL(CONTENTLENGTH_STRING);
+		char* contentLengthStr = ptr + contentLengthStartPosition;
+		int contentLength = atoi(contentLengthStr);
 
-			if(gpGlobalConfig->logging.trace)
-			{
-				traceprintf("%s:%d header %s contentLengthStr %s  contentLength %d\n",__FUNCTION__,__LINE__, ptr, contentLengthStr, contentLength);
-			}
+		if(gpGlobalConfig->logging.trace)
+		{
+			traceprintf("%s:%d header %s contentLengthStr %s  contentLength %d\n",__FUNCTION__,__LINE__, ptr, contentLengthStr, contentLength);
+		}
 
-			/*contentLength can be zero for redirects*/
-			if (contentLength > 0)
-			{
-				/*Add 2 additional characters to take care of extra characters inserted by aamp_AppendNulTerminator*/
-				aamp_Malloc(context->buffer, contentLength + 2);
-			}
+		/*contentLength can be zero for redirects*/
+		if (contentLength > 0)
+		{
+			/*Size buffer upfront to avoid realloc during download. Add 2 additional characters to take care of extra characters inserted by aamp_AppendNulTerminator*/
+			context->aamp->GetBufferPool()->Reserve(context->buffer, context->buffer->len + contentLength + 2);
 		}
 	}
 	
@@ -2031,6 +2100,38 @@ static int progress_callback(
 			}
 		}
 	}
+	// Size is unknown for chunked responses without Content-Length, estimate it from profile bitrate
+	double totalBytes = (dltotal > 0) ? dltotal : context->expectedBytes;
+	if (rc == 0 && context->abandonCheck && dlnow > 0 && totalBytes > dlnow)
+	{
+		long long now = NOW_STEADY_TS_MS;
+		if (context->sampleTime < 0)
+		{ // first byte(s) - estimate from here so connection setup does not count as throughput
+			context->sampleTime = now;
+			context->sampleBytes = dlnow;
+		}
+		else if (now - context->sampleTime >= ABR_ABANDON_SAMPLE_INTERVAL_MS)
+		{
+			double bps = (dlnow - context->sampleBytes) * 8000.0 / (now - context->sampleTime);
+			context->throughputBps = (context->throughputBps > 0) ? (ABR_ABANDON_EWMA_ALPHA * bps + (1 - ABR_ABANDON_EWMA_ALPHA) * context->throughputBps) : bps;
+			context->sampleTime = now;
+			context->sampleBytes = dlnow;
+
+			double elapsedMs = now - context->downloadStartTime;
+			if (elapsedMs >= ABR_ABANDON_MIN_ELAPSED_MS && context->throughputBps > 0)
+			{
+				double remainingMs = (totalBytes - dlnow) * 8000.0 / context->throughputBps;
+				// Abandon only if the fragment can neither complete before buffer runs dry nor be fetched in real time
+				if (elapsedMs + remainingMs > context->fragmentDurationMs && remainingMs > context->bufferedMs - elapsedMs)
+				{
+					logprintf("Abort download as projected completion in %.0f ms exceeds buffer %.0f ms, throughput %.0f bps, downloaded %.0f/%.0f bytes",
+						remainingMs, context->bufferedMs - elapsedMs, context->throughputBps, dlnow, totalBytes);
+					context->abortReason = eCURL_ABORT_REASON_LOW_BANDWIDTH;
+					rc = -1;
+				}
+			}
+		}
+	}
 	return rc;
 }
 
@@ -2556,7 +2657,7 @@ static void SimulateLinearWindow( struct GrowableBuffer *buffer, const char *ptr
  * @param http_error error code in case of failure
  * @param range http range
  * @param curlInstance instance to be used to fetch
- * @param resetBuffer true to reset buffer before fetch
+ * @param resetBuffer true to reset buffer before fetch, false to keep memory attached by caller (e.g. pre-sized fetch buffer)
  * @param fileType media type of the file
  * @param fragmentDurationSeconds to know the current fragment length in case fragment fetch
  * @retval true if success
@@ -2584,24 +2685,98 @@ bool PrivateInstanceAAMP::GetFile(std::string remoteUrl,struct GrowableBuffer *b
 	{
 		maxDownloadAttempt += DEFAULT_DOWNLOAD_RETRY_COUNT;
 	}
+	// Disk cache holds immutable files only: init fragments, VOD fragments and VOD playlists (checked for ENDLIST on insert).
+	// Content served by fog is already local, main manifest is left to AampCacheHandler.
+	bool diskCacheable = false;
+	std::string diskCacheKey;
+	if (mDiskCache && !mTSBEnabled && simType != eMEDIATYPE_MANIFEST && !gpGlobalConfig->useLinearSimulator)
+	{
+		diskCacheable = (mediaType == eMEDIATYPE_TELEMETRY_INIT || mediaType == eMEDIATYPE_TELEMETRY_MANIFEST ||
+				(mediaType == eMEDIATYPE_TELEMETRY_AVS && !IsLive()));
+		if (diskCacheable)
+		{
+			diskCacheKey = remoteUrl;
+			if (range)
+			{
+				diskCacheKey.append("#range=");
+				diskCacheKey.append(range);
+			}
+		}
+	}
+
+	// Init fragments are kept in memory for the session, so ABR switches back to a profile,
+	// period changes and retunes do not download them again
+	bool initFragmentCacheable = (gpGlobalConfig->initFragmentCache && mediaType == eMEDIATYPE_TELEMETRY_INIT &&
+				!gpGlobalConfig->useLinearSimulator);
+	std::string initFragmentKey;
+	if (initFragmentCacheable)
+	{
+		initFragmentKey = remoteUrl;
+		if (range)
+		{
+			initFragmentKey.append("#range=");
+			initFragmentKey.append(range);
+		}
+	}
+
+	// Playlists are downloaded conditionally once a response with validators is cached;
+	// an unchanged playlist (304) is handed out from AampCacheHandler as if downloaded
+	bool conditionalGet = (gpGlobalConfig->conditionalPlaylistGet && mediaType == eMEDIATYPE_TELEMETRY_MANIFEST && !range &&
+				!gpGlobalConfig->useLinearSimulator);
+	std::string livePlaylistKey;
+	std::shared_ptr<const LivePlaylistData> livePlaylist;
+	if (conditionalGet)
+	{
+		livePlaylistKey = remoteUrl;
+		livePlaylist = mAampCacheHandler->RetrieveFromLivePlaylistCache(livePlaylistKey);
+	}
 
 	pthread_mutex_lock(&mLock);
 	if (resetBuffer)
 	{
 		if(buffer->avail)
-        	{
-            		AAMPLOG_TRACE("%s:%d reset buffer %p avail %d", __FUNCTION__, __LINE__, buffer, (int)buffer->avail);
-        	}	
+		{
+			AAMPLOG_TRACE("%s:%d reset buffer %p avail %d", __FUNCTION__, __LINE__, buffer, (int)buffer->avail);
+		}
+		// Buffer content is not trusted here, callers reusing attached memory pass resetBuffer false
 		memset(buffer, 0x00, sizeof(*buffer));
 	}
 	if (mDownloadsEnabled)
 	{
 		int downloadTimeMS = 0;
+		int concurrentTransfers = 1;
 		bool isDownloadStalled = false;
 		CurlAbortReason abortReason = eCURL_ABORT_REASON_NONE;
+		double abortThroughputBps = 0;
 		double connectTime = 0;
 		pthread_mutex_unlock(&mLock);
 
+		bool initFragmentCacheHit = (initFragmentCacheable && mAampCacheHandler->RetrieveFromInitFragmentCache(initFragmentKey, buffer, effectiveUrl));
+		if (initFragmentCacheHit)
+		{
+			AAMPLOG_INFO("%s:%d init fragment cache hit:%d,%s", __FUNCTION__, __LINE__, simType, remoteUrl.c_str());
+		}
+		if (initFragmentCacheHit || (diskCacheable && mDiskCache->Retrieve(diskCacheKey, buffer, effectiveUrl)))
+		{
+			if (!initFragmentCacheHit)
+			{
+				AAMPLOG_INFO("%s:%d disk cache hit:%d,%s", __FUNCTION__, __LINE__, simType, remoteUrl.c_str());
+				if (initFragmentCacheable)
+				{
+					mAampCacheHandler->InsertToInitFragmentCache(initFragmentKey, buffer, effectiveUrl);
+				}
+			}
+			if (http_error)
+			{
+				*http_error = 200;
+			}
+			if (bitrate)
+			{
+				*bitrate = 0;
+			}
+			return true;
+		}
+
 		// append custom uri parameter with remoteUrl at the end before curl request if curlHeader logging enabled.
 		if (gpGlobalConfig->logging.curlHeader && gpGlobalConfig->uriParameter && simType == eMEDIATYPE_MANIFEST)
 		{
@@ -2614,7 +2789,7 @@ bool PrivateInstanceAAMP::GetFile(std::string remoteUrl,struct GrowableBuffer *b
 			//printf ("URL after appending uriParameter :: %s\n", remoteUrl.c_str());
 		}
 
-		AAMPLOG_INFO("aamp url:%d,%d,%s",mediaType, simType, remoteUrl.c_str());
+		AAMPLOG_INFO_DEFERRED("aamp url:%d,%d,%s",mediaType, simType, remoteUrl.c_str());
 		CurlCallbackContext context;
 		if (curl)
 		{
@@ -2650,6 +2825,18 @@ bool PrivateInstanceAAMP::GetFile(std::string remoteUrl,struct GrowableBuffer *b
 				progressCtx.stallTimeout = gpGlobalConfig->curlStallTimeout;
 			}
 			progressCtx.stallTimeout = gpGlobalConfig->curlStallTimeout;
+			progressCtx.abandonCheck = false;
+			progressCtx.bufferedMs = 0;
+			progressCtx.fragmentDurationMs = fragmentDurationMs;
+			progressCtx.expectedBytes = 0;
+			if (simType == eMEDIATYPE_VIDEO && gpGlobalConfig->abrFragmentAbandon && gpGlobalConfig->bEnableABR && !mTSBEnabled &&
+				rate == AAMP_NORMAL_PLAY_RATE && fragmentDurationMs > 0 && mpStreamAbstractionAAMP && mpStreamAbstractionAAMP->CanRampDownProfile())
+			{
+				// No abandonment while buffer is empty (startup/rebuffering), lower profile would not help
+				progressCtx.bufferedMs = mpStreamAbstractionAAMP->GetBufferedDuration() * 1000;
+				progressCtx.abandonCheck = (progressCtx.bufferedMs > 0);
+				progressCtx.expectedBytes = (double)mpStreamAbstractionAAMP->GetVideoBitrate() * fragmentDurationMs / 8000.0;
+			}
                   
 			// note: win32 curl lib doesn't support multi-part range
 			curl_easy_setopt(curl, CURLOPT_RANGE, range);
@@ -2713,11 +2900,20 @@ bool PrivateInstanceAAMP::GetFile(std::string remoteUrl,struct GrowableBuffer *b
 					}
 				}
 
-				if (httpHeaders != NULL)
+			}
+			if (livePlaylist)
+			{
+				if (!livePlaylist->mETag.empty())
 				{
-					curl_easy_setopt(curl, CURLOPT_HTTPHEADER, httpHeaders);
+					httpHeaders = curl_slist_append(httpHeaders, ("If-None-Match: " + livePlaylist->mETag).c_str());
+				}
+				if (!livePlaylist->mLastModified.empty())
+				{
+					httpHeaders = curl_slist_append(httpHeaders, ("If-Modified-Since: " + livePlaylist->mLastModified).c_str());
 				}
 			}
+			// Always set, so headers of a previous request are not sent again
+			curl_easy_setopt(curl, CURLOPT_HTTPHEADER, httpHeaders);
 
 			while(downloadAttempt < maxDownloadAttempt)
 			{
@@ -2725,6 +2921,9 @@ bool PrivateInstanceAAMP::GetFile(std::string remoteUrl,struct GrowableBuffer *b
 				progressCtx.downloadUpdatedTime = -1;
 				progressCtx.downloadSize = -1;
 				progressCtx.abortReason = eCURL_ABORT_REASON_NONE;
+				progressCtx.sampleTime = -1;
+				progressCtx.sampleBytes = 0;
+				progressCtx.throughputBps = 0;
 				curl_easy_setopt(curl, CURLOPT_PROGRESSDATA, &progressCtx);
 				if(buffer->ptr != NULL)
 				{
@@ -2736,7 +2935,22 @@ bool PrivateInstanceAAMP::GetFile(std::string remoteUrl,struct GrowableBuffer *b
 				abortReason = eCURL_ABORT_REASON_NONE;
 
 				long long tStartTime = NOW_STEADY_TS_MS;
-				CURLcode res = curl_easy_perform(curl); // synchronous; callbacks allow interruption
+				CURLcode res;
+				// Video fragments fetched ahead share the link with this one
+				concurrentTransfers = (simType == eMEDIATYPE_VIDEO) ? ++mVideoTransfersInFlight : 1;
+				if (mMultiDownloader)
+				{
+					// synchronous for caller; transfer shares connections with other tracks/players
+					res = mMultiDownloader->Perform(curl);
+				}
+				else
+				{
+					res = curl_easy_perform(curl); // synchronous; callbacks allow interruption
+				}
+				if (simType == eMEDIATYPE_VIDEO)
+				{
+					concurrentTransfers = std::max(concurrentTransfers, mVideoTransfersInFlight--);
+				}
 
 //				InterruptableMsSleep( 250 ); // this can be uncommented to locally induce extra per-download latency
 
@@ -2749,7 +2963,7 @@ bool PrivateInstanceAAMP::GetFile(std::string remoteUrl,struct GrowableBuffer *b
 				{ // all data collected
 					curl_easy_getinfo(curl, CURLINFO_RESPONSE_CODE, &http_code);
 					char *effectiveUrlPtr = NULL;
-					if (http_code != 200 && http_code != 204 && http_code != 206)
+					if (http_code != 200 && http_code != 204 && http_code != 206 && !(http_code == 304 && livePlaylist))
 					{
 						AAMP_LOG_NETWORK_ERROR (remoteUrl.c_str(), AAMPNetworkErrorHttp, (int)http_code, simType);
 						print_headerResponse(context.allResponseHeadersForErrorLogging, simType);
@@ -2813,11 +3027,12 @@ bool PrivateInstanceAAMP::GetFile(std::string remoteUrl,struct GrowableBuffer *b
 					//abortReason for progress_callback exit scenarios
 					// curl sometimes exceeds the wait time by few milliseconds.Added buffer of 10msec
 					isDownloadStalled = ((res == CURLE_OPERATION_TIMEDOUT || res == CURLE_PARTIAL_FILE ||
-									(progressCtx.abortReason != eCURL_ABORT_REASON_NONE)) &&
+									(progressCtx.abortReason != eCURL_ABORT_REASON_NONE && progressCtx.abortReason != eCURL_ABORT_REASON_LOW_BANDWIDTH)) &&
 									(buffer->len >= 0) &&
 									((downloadTimeMS-10) <= curlDownloadTimeoutMS));
 					// set flag if download aborted with start/stall timeout.
 					abortReason = progressCtx.abortReason;
+					abortThroughputBps = progressCtx.throughputBps;
 
 					/* Curl 23 and 42 is not a real network error, so no need to log it here */
 					//Log errors due to curl stall/start detection abort
@@ -2926,7 +3141,7 @@ bool PrivateInstanceAAMP::GetFile(std::string remoteUrl,struct GrowableBuffer *b
 						// example 18(0) if connection failure with PARTIAL_FILE code
 						timeoutClass = "\(" + to_string(reqSize > 0) + "\)";
 					}
-					AAMPLOG(reqEndLogLevel, "HttpRequestEnd: %s%d,%d,%ld%s,%2.4f,%2.4f,%2.4f,%2.4f,%2.4f,%2.4f,%2.4f,%2.4f,%g,%ld,%.500s",
+					AAMPLOG_DEFERRED(reqEndLogLevel, "HttpRequestEnd: %s%d,%d,%ld%s,%2.4f,%2.4f,%2.4f,%2.4f,%2.4f,%2.4f,%2.4f,%2.4f,%g,%ld,%.500s",
 						appName.c_str(), mediaType, simType, http_code, timeoutClass.c_str(), totalPerformRequest, total, connect, startTransfer, resolve, appConnect, preTransfer, redirect, dlSize, reqSize,
 						((res == CURLE_OK) ? effectiveUrl.c_str() : remoteUrl.c_str())); // Effective URL could be different than remoteURL and it is updated only for CURLE_OK case
 				}
@@ -2948,10 +3163,11 @@ bool PrivateInstanceAAMP::GetFile(std::string remoteUrl,struct GrowableBuffer *b
 				if(mABRBufferCheckEnabled || (!mABRBufferCheckEnabled && buffer->len > gpGlobalConfig->aampAbrThresholdSize))
 				{
 					pthread_mutex_lock(&mLock);
-					long downloadbps = ((long)(buffer->len / downloadTimeMS)*8000);
+					// Throughput of the link is shared by concurrent transfers
+					long downloadbps = ((long)(buffer->len / downloadTimeMS)*8000) * concurrentTransfers;
 					long currentProfilebps  = mpStreamAbstractionAAMP->GetVideoBitrate();
 					// extra coding to avoid picking lower profile
-					AAMPLOG_INFO("%s downloadbps:%ld currentProfilebps:%ld downloadTimeMS:%d fragmentDurationMs:%d",__FUNCTION__,downloadbps,currentProfilebps,downloadTimeMS,fragmentDurationMs);
+					AAMPLOG_INFO_DEFERRED("%s downloadbps:%ld currentProfilebps:%ld downloadTimeMS:%d fragmentDurationMs:%d",__FUNCTION__,downloadbps,currentProfilebps,downloadTimeMS,fragmentDurationMs);
 					if(fragmentDurationMs && downloadTimeMS < fragmentDurationMs/2 && downloadbps < currentProfilebps)
 					{
 						downloadbps = currentProfilebps;
@@ -2965,7 +3181,15 @@ bool PrivateInstanceAAMP::GetFile(std::string remoteUrl,struct GrowableBuffer *b
 				}
 			}
 		}
-		if (http_code == 200 || http_code == 206)
+		if (http_code == 304 && livePlaylist)
+		{
+			AAMPLOG_INFO("%s:%d not modified:%d,%s", __FUNCTION__, __LINE__, simType, remoteUrl.c_str());
+			buffer->len = 0;
+			aamp_AppendBytes(buffer, livePlaylist->mData.data(), livePlaylist->mData.size());
+			effectiveUrl = livePlaylist->mEffectiveUrl;
+			ret = true;
+		}
+		else if (http_code == 200 || http_code == 206)
 		{
 #ifdef SAVE_DOWNLOADS_TO_DISK
 			const char *fname = remoteUrl;
@@ -2995,11 +3219,7 @@ bool PrivateInstanceAAMP::GetFile(std::string remoteUrl,struct GrowableBuffer *b
 				AAMPLOG_WARN("AAMP Content-Length=%d actual=%d", (int)expectedContentLength, (int)buffer->len);
 				http_code       =       416; // Range Not Satisfiable
 				ret             =       false; // redundant, but harmless
-				if (buffer->ptr)
-				{
-					aamp_Free(&buffer->ptr);
-				}
-				memset(buffer, 0x00, sizeof(*buffer));
+				mBufferPool->Release(buffer);
 			}
 			else
 			{
@@ -3012,6 +3232,20 @@ bool PrivateInstanceAAMP::GetFile(std::string remoteUrl,struct GrowableBuffer *b
 					fileType = eMEDIATYPE_IFRAME;
 				}
 				ret = true;
+				if (diskCacheable && (mediaType != eMEDIATYPE_TELEMETRY_MANIFEST ||
+					(buffer->len > 0 && memmem(buffer->ptr, buffer->len, "#EXT-X-ENDLIST", strlen("#EXT-X-ENDLIST")))))
+				{
+					mDiskCache->Insert(diskCacheKey, buffer, effectiveUrl);
+				}
+				if (initFragmentCacheable)
+				{
+					mAampCacheHandler->InsertToInitFragmentCache(initFragmentKey, buffer, effectiveUrl);
+				}
+				if (conditionalGet && (!context.eTag.empty() || !context.lastModified.empty()) && buffer->len > 0 &&
+					!memmem(buffer->ptr, buffer->len, "#EXT-X-ENDLIST", strlen("#EXT-X-ENDLIST")))
+				{
+					mAampCacheHandler->InsertToLivePlaylistCache(livePlaylistKey, buffer, effectiveUrl, context.eTag, context.lastModified);
+				}
 			}
 		}
 		else
@@ -3020,11 +3254,7 @@ bool PrivateInstanceAAMP::GetFile(std::string remoteUrl,struct GrowableBuffer *b
 			{
 				logprintf("BAD URL:%s", remoteUrl.c_str());
 			}
-			if (buffer->ptr)
-			{
-				aamp_Free(&buffer->ptr);
-			}
-			memset(buffer, 0x00, sizeof(*buffer));
+			mBufferPool->Release(buffer);
 
 			if (rate != 1.0)
 			{
@@ -3114,6 +3344,16 @@ bool PrivateInstanceAAMP::GetFile(std::string remoteUrl,struct GrowableBuffer *b
 			}
 		}
 		pthread_mutex_lock(&mLock);
+		if (abortReason == eCURL_ABORT_REASON_LOW_BANDWIDTH)
+		{
+			// Throughput of the abandoned download is the latest view of the network
+			mAbrBitrateData.push_back(std::make_pair(aamp_GetCurrentTimeMS(), (long)abortThroughputBps));
+			if (mAbrBitrateData.size() > gpGlobalConfig->abrCacheLength)
+			{
+				mAbrBitrateData.erase(mAbrBitrateData.begin());
+			}
+			http_code = PARTIAL_FILE_LOW_BANDWIDTH_AAMP;
+		}
 	}
 	else
 	{
@@ -3811,6 +4051,11 @@ int ReadConfigNumericHelper(std::string buf, const char* prefixPtr, T& value1, T
 			gpGlobalConfig->logging.curl = !gpGlobalConfig->logging.curl;
 			logprintf("curl logging %s", gpGlobalConfig->logging.curl ? "on" : "off");
 		}
+		else if (ReadConfigNumericHelper(cfg, "async-log=", value) == 1)
+		{
+			AampLogManager::asyncLogging = (value == 1);
+			logprintf("async-log=%d", value);
+		}
 		else if (ReadConfigNumericHelper(cfg, "default-bitrate=", gpGlobalConfig->defaultBitrate) == 1)
 		{
 			VALIDATE_LONG("default-bitrate",gpGlobalConfig->defaultBitrate, DEFAULT_INIT_BITRATE)
@@ -3836,6 +4081,14 @@ int ReadConfigNumericHelper(std::string buf, const char* prefixPtr, T& value1, T
 			VALIDATE_INT("abr-cache-length", gpGlobalConfig->abrCacheLength, DEFAULT_ABR_CACHE_LENGTH)
 			logprintf("aamp abr cache length: %ld", gpGlobalConfig->abrCacheLength);
 		}
+		else if (ReadConfigNumericHelper(cfg, "abr-mode=", value) == 1)
+		{
+			if (value >= eAAMP_ABR_MODE_DEFAULT && value <= eAAMP_ABR_MODE_BOLA)
+			{
+				gpGlobalConfig->abrMode = value;
+			}
+			logprintf("aamp abr-mode: %d", gpGlobalConfig->abrMode);
+		}
 		else if (ReadConfigNumericHelper(cfg, "useNewABR=", value) == 1)
 		{
 			gpGlobalConfig->abrBufferCheckEnabled  = (TriState)(value != 0);
@@ -3891,6 +4144,11 @@ int ReadConfigNumericHelper(std::string buf, const char* prefixPtr, T& value1, T
 			VALIDATE_INT("abr-skip-duration",gpGlobalConfig->abrSkipDuration, DEFAULT_ABR_SKIP_DURATION)
 			logprintf("aamp abr skip duration: %d", gpGlobalConfig->abrSkipDuration);
 		}
+		else if (ReadConfigNumericHelper(cfg, "abr-fragment-abandon=", value) == 1)
+		{
+			gpGlobalConfig->abrFragmentAbandon = (value == 1);
+			logprintf("aamp abr fragment abandon is %s", gpGlobalConfig->abrFragmentAbandon ? "enabled" : "disabled");
+		}
 		else if (ReadConfigNumericHelper(cfg, "abr-nw-consistency=", gpGlobalConfig->abrNwConsistency) == 1)
 		{
 			VALIDATE_INT("abr-nw-consistency", gpGlobalConfig->abrNwConsistency, DEFAULT_ABR_NW_CONSISTENCY_CNT)
@@ -4018,6 +4276,31 @@ int ReadConfigNumericHelper(std::string buf, const char* prefixPtr, T& value1, T
 			gpGlobalConfig->hlsAVTrackSyncUsingStartTime = (value != 0);
 			logprintf("hls-av-sync-use-start-time=%d", value);
 		}
+		else if (ReadConfigNumericHelper(cfg, "hls-incremental-index=", value) == 1)
+		{
+			gpGlobalConfig->hlsIncrementalIndex = (value != 0);
+			logprintf("hls-incremental-index=%d", value);
+		}
+		else if (ReadConfigNumericHelper(cfg, "hls-decrypt-pipeline=", value) == 1)
+		{
+			gpGlobalConfig->hlsDecryptPipeline = (value != 0);
+			logprintf("hls-decrypt-pipeline=%d", value);
+		}
+		else if (ReadConfigNumericHelper(cfg, "init-fragment-cache=", value) == 1)
+		{
+			gpGlobalConfig->initFragmentCache = (value != 0);
+			logprintf("init-fragment-cache=%d", value);
+		}
+		else if (ReadConfigNumericHelper(cfg, "conditional-playlist-get=", value) == 1)
+		{
+			gpGlobalConfig->conditionalPlaylistGet = (value != 0);
+			logprintf("conditional-playlist-get=%d", value);
+		}
+		else if (ReadConfigNumericHelper(cfg, "playlist-delta-update=", value) == 1)
+		{
+			gpGlobalConfig->playlistDeltaUpdate = (value != 0);
+			logprintf("playlist-delta-update=%d", value);
+		}
 		else if (ReadConfigNumericHelper(cfg, "mpd-discontinuity-handling=", value) == 1)
 		{
 			gpGlobalConfig->mpdDiscontinuityHandling = (value != 0);
@@ -4105,6 +4388,16 @@ int ReadConfigNumericHelper(std::string buf, const char* prefixPtr, T& value1, T
 			VALIDATE_INT("fragment-cache-length", gpGlobalConfig->maxCachedFragmentsPerTrack, DEFAULT_CACHED_FRAGMENTS_PER_TRACK)
 			logprintf("aamp fragment cache length: %d", gpGlobalConfig->maxCachedFragmentsPerTrack);
 		}
+		else if (ReadConfigNumericHelper(cfg, "fragment-cache-length-audio=", gpGlobalConfig->maxCachedFragmentsAudio) == 1)
+		{
+			VALIDATE_INT("fragment-cache-length-audio", gpGlobalConfig->maxCachedFragmentsAudio, 0)
+			logprintf("aamp audio fragment cache length: %d", gpGlobalConfig->maxCachedFragmentsAudio);
+		}
+		else if (ReadConfigNumericHelper(cfg, "fragment-cache-length-subtitle=", gpGlobalConfig->maxCachedFragmentsSubtitle) == 1)
+		{
+			VALIDATE_INT("fragment-cache-length-subtitle", gpGlobalConfig->maxCachedFragmentsSubtitle, 0)
+			logprintf("aamp subtitle fragment cache length: %d", gpGlobalConfig->maxCachedFragmentsSubtitle);
+		}
 		else if (ReadConfigNumericHelper(cfg, "pts-error-threshold=", gpGlobalConfig->ptsErrorThreshold) == 1)
 		{
 			VALIDATE_INT("pts-error-threshold", gpGlobalConfig->ptsErrorThreshold, MAX_PTS_ERRORS_THRESHOLD)
@@ -4122,6 +4415,20 @@ int ReadConfigNumericHelper(std::string buf, const char* prefixPtr, T& value1, T
 			VALIDATE_INT("max-playlist-cache", gpGlobalConfig->gMaxPlaylistCacheSize, MAX_PLAYLIST_CACHE_SIZE);
 			logprintf("aamp max-playlist-cache: %ld", gpGlobalConfig->gMaxPlaylistCacheSize);
 		}
+		else if(ReadConfigNumericHelper(cfg, "buffer-pool-size=", gpGlobalConfig->maxBufferPoolSize) == 1)
+		{
+			// Read value in KB , convert it to bytes. 0 disables pooling
+			if (gpGlobalConfig->maxBufferPoolSize < 0 || gpGlobalConfig->maxBufferPoolSize > (INT_MAX / 1024))
+			{
+				logprintf("%s(): Parameter 'buffer-pool-size' not within limit. Using default value instead.", __FUNCTION__);
+				gpGlobalConfig->maxBufferPoolSize = DEFAULT_BUFFER_POOL_SIZE;
+			}
+			else
+			{
+				gpGlobalConfig->maxBufferPoolSize = gpGlobalConfig->maxBufferPoolSize * 1024;
+			}
+			logprintf("aamp buffer-pool-size: %d", gpGlobalConfig->maxBufferPoolSize);
+		}
 		else if(sscanf(cfg.c_str(), "dash-max-drm-sessions=%d", &gpGlobalConfig->dash_MaxDRMSessions) == 1)
 		{
 			// Read value in KB , convert it to bytes
@@ -4166,6 +4473,25 @@ int ReadConfigNumericHelper(std::string buf, const char* prefixPtr, T& value1, T
 			gpGlobalConfig->disableSslVerifyPeer = (value != 1);
 			logprintf("ssl verify peer is %s", gpGlobalConfig->disableSslVerifyPeer? "disabled" : "enabled");
 		}
+		else if (ReadConfigNumericHelper(cfg, "curl-multi=", value) == 1)
+		{
+			gpGlobalConfig->useCurlMulti = (value == 1);
+			logprintf("curl multi download engine is %s", gpGlobalConfig->useCurlMulti ? "enabled" : "disabled");
+		}
+		else if (ReadConfigNumericHelper(cfg, "fetch-pipeline-depth=", value) == 1)
+		{
+			gpGlobalConfig->fetchPipelineDepth = std::max(1, std::min(value, AAMP_FETCH_PIPELINE_MAX_DEPTH));
+			logprintf("fetch-pipeline-depth=%d", gpGlobalConfig->fetchPipelineDepth);
+		}
+		else if (ReadConfigStringHelper(cfg, "disk-cache-path=", (const char**)&gpGlobalConfig->diskCachePath))
+		{
+			logprintf("disk-cache-path=%s", gpGlobalConfig->diskCachePath);
+		}
+		else if (ReadConfigNumericHelper(cfg, "disk-cache-size=", gpGlobalConfig->diskCacheSizeMB) == 1)
+		{
+			VALIDATE_INT("disk-cache-size", gpGlobalConfig->diskCacheSizeMB, DEFAULT_DISK_CACHE_SIZE_MB);
+			logprintf("aamp disk-cache-size: %d MB", gpGlobalConfig->diskCacheSizeMB);
+		}
 		else if (ReadConfigNumericHelper(cfg, "curl-stall-timeout=", gpGlobalConfig->curlStallTimeout) == 1)
 		{
 			//Not calling VALIDATE_LONG since zero is supported
@@ -4924,6 +5250,8 @@ void PrivateInstanceAAMP::TuneHelper(TuneType tuneType)
 
 	if (newTune)
 	{
+		//Cues of previous content must not be sent again
+		mVTTCueStore.reset();
 
 		// send previouse tune VideoEnd Metrics data
 		// this is done here because events are cleared on stop and there is chance that event may not get sent
@@ -7304,6 +7632,17 @@ void PlayerInstanceAAMP::SetNewABRConfig(bool bValue)
 	aamp->SetNewABRConfig(bValue);
 }
 
+/**
+ *   @brief Select ABR strategy of next tune
+ *   @param[in] mode - 0: default ABR, 1: throughput rule, 2: buffer based (BOLA) rule
+ *
+ *   @return void
+ */
+void PlayerInstanceAAMP::SetABRMode(int mode)
+{
+	aamp->SetABRMode(mode);
+}
+
 /**
  *   @brief Configure New AdBreaker Enable/Disable
  *   @param[in] bValue - true if new AdBreaker enabled
@@ -7404,6 +7743,28 @@ void PlayerInstanceAAMP::SendId3MetadataEvent(uint8_t* data, int32_t length)
 }
 
 
+/**
+ *   @brief Select ABR strategy of next tune
+ *   @param[in] mode - AAMPAbrMode value
+ *
+ *   @return void
+ */
+void PrivateInstanceAAMP::SetABRMode(int mode)
+{
+	if (gpGlobalConfig->abrMode == -1)
+	{
+		if (mode >= eAAMP_ABR_MODE_DEFAULT && mode <= eAAMP_ABR_MODE_BOLA)
+		{
+			mABRMode = (AAMPAbrMode)mode;
+		}
+		else
+		{
+			AAMPLOG_WARN("%s:%d Invalid ABR mode %d", __FUNCTION__, __LINE__, mode);
+		}
+	}
+	AAMPLOG_INFO("%s:%d ABR mode : %d", __FUNCTION__, __LINE__, mABRMode);
+}
+
 /**
  *   @brief Configure New ABR Enable/Disable
  *   @param[in] bValue - true if new ABR enabled
@@ -7688,6 +8049,35 @@ void PrivateInstanceAAMP::SendStream(MediaType mediaType, GrowableBuffer* buffer
 }
 
 
+/**
+ * @brief Sends a batch of media buffers to sink
+ * @note  Ownership of buffer memory is transferred.
+ * @param mediaType type of media
+ * @param buffers buffers in presentation order, cleared on return
+ */
+void PrivateInstanceAAMP::SendStream(MediaType mediaType, std::vector<StreamSinkBuffer>& buffers)
+{
+	profiler.ProfilePerformed(PROFILE_BUCKET_FIRST_BUFFER);
+	mStreamSink->SendBatch(mediaType, buffers);
+}
+
+
+/**
+ * @brief Sends a batch of media buffers, one buffer at a time
+ * @param mediaType type of media
+ * @param buffers buffers in presentation order, cleared on return
+ */
+void StreamSink::SendBatch(MediaType mediaType, std::vector<StreamSinkBuffer>& buffers)
+{
+	for (StreamSinkBuffer &entry : buffers)
+	{
+		GrowableBuffer buffer = { entry.ptr, entry.len, entry.avail };
+		Send(mediaType, &buffer, entry.fpts, entry.fdts, entry.duration);
+	}
+	buffers.clear();
+}
+
+
 /**
  * @brief Set stream sink
  * @param streamSink pointer of sink object
@@ -7743,6 +8133,7 @@ void PrivateInstanceAAMP::Stop()
 		}
 		mPendingAsyncEvents.clear();
 	}
+	mCoalescedEvents.clear();
 	if (timedMetadata.size() > 0)
 	{
 		logprintf("PrivateInstanceAAMP::%s() - timedMetadata.size - %d", __FUNCTION__, timedMetadata.size());
@@ -8213,7 +8604,7 @@ void PrivateInstanceAAMP::ScheduleRetune(PlaybackErrorType errorType, MediaType
 /**
  * @brief PrivateInstanceAAMP Constructor
  */
-PrivateInstanceAAMP::PrivateInstanceAAMP() : mAbrBitrateData(), mLock(), mMutexAttr(),
+PrivateInstanceAAMP::PrivateInstanceAAMP() : mAbrBitrateData(), mVideoTransfersInFlight(0), mLock(), mMutexAttr(),
 	mpStreamAbstractionAAMP(NULL), mInitSuccess(false), mVideoFormat(FORMAT_INVALID), mAudioFormat(FORMAT_INVALID), mDownloadsDisabled(),
 	mDownloadsEnabled(true), mStreamSink(NULL), profiler(), licenceFromManifest(false), previousAudioType(eAUDIO_UNKNOWN),
 	mbDownloadsBlocked(false), streamerIsActive(false), mTSBEnabled(false), mIscDVR(false), mLiveOffset(AAMP_LIVE_OFFSET), mNewLiveOffsetflag(false),
@@ -8225,7 +8616,7 @@ PrivateInstanceAAMP::PrivateInstanceAAMP() : mAbrBitrateData(), mLock(), mMutexA
 	m_fd(-1), mIsLive(false), mTuneCompleted(false), mFirstTune(true), mfirstTuneFmt(-1), mTuneAttempts(0), mPlayerLoadTime(0),
 	mState(eSTATE_RELEASED), mMediaFormat(eMEDIAFORMAT_HLS), mCurrentDrm(eDRM_NONE), mPersistedProfileIndex(0), mAvailableBandwidth(0),
 	mDiscontinuityTuneOperationInProgress(false), mContentType(), mTunedEventPending(false),
-	mSeekOperationInProgress(false), mPendingAsyncEvents(), mCustomHeaders(),
+	mSeekOperationInProgress(false), mPendingAsyncEvents(), mCoalescedEvents(), mCustomHeaders(),
 	mManifestUrl(""), mTunedManifestUrl(""), mServiceZone(),
 	mCurrentLanguageIndex(0), noExplicitUserLanguageSelection(true), languageSetByUser(false), preferredLanguagesString(), preferredLanguagesList(),
 	mVideoEnd(NULL),mTimeToTopProfile(0),mTimeAtTopProfile(0),mPlaybackDuration(0),mTraceUUID(),
@@ -8254,7 +8645,7 @@ PrivateInstanceAAMP::PrivateInstanceAAMP() : mAbrBitrateData(), mLock(), mMutexA
 	,mRampDownLimit(-1), mMinBitrate(0), mMaxBitrate(LONG_MAX), mSegInjectFailCount(MAX_SEG_INJECT_FAIL_COUNT), mDrmDecryptFailCount(MAX_SEG_DRM_DECRYPT_FAIL_COUNT)
 #ifdef AAMP_HLS_DRM
     , fragmentCdmEncrypted(false) ,drmParserMutex(), aesCtrAttrDataList()
-	, drmSessionThreadStarted(false), createDRMSessionThreadID(0)
+	, createDRMSessionTask()
 #endif
 	, mPlayermode(PLAYERMODE_JSPLAYER)
 	, mReportProgressInterval(DEFAULT_REPORT_PROGRESS_INTERVAL)
@@ -8265,6 +8656,7 @@ PrivateInstanceAAMP::PrivateInstanceAAMP() : mAbrBitrateData(), mLock(), mMutexA
 	, mPreCacheDnldList()
 	, mPreCacheDnldTimeWindow(0)
 	, mABRBufferCheckEnabled(false)
+	, mABRMode(eAAMP_ABR_MODE_DEFAULT)
 	, mNewAdBreakerEnabled(false)
 	, prevPositionMiliseconds(-1)
 	, mProgressReportFromProcessDiscontinuity(false)
@@ -8272,6 +8664,11 @@ PrivateInstanceAAMP::PrivateInstanceAAMP() : mAbrBitrateData(), mLock(), mMutexA
 	, mInitFragmentRetryCount(-1)
 	, mbPlayEnabled(true)
 	, mAampCacheHandler(new AampCacheHandler())
+	, mBufferPool()
+	, mMultiDownloader()
+	, mDiskCache()
+	, mVTTCueStore()
+	, mVTTCueStoreLanguage()
 #if defined(AAMP_MPD_DRM) || defined(AAMP_HLS_DRM)
 	, mDRMSessionManager(NULL)
 #endif
@@ -8281,6 +8678,15 @@ PrivateInstanceAAMP::PrivateInstanceAAMP() : mAbrBitrateData(), mLock(), mMutexA
 	, m_minInitialCacheSeconds(DEFAULT_MINIMUM_INIT_CACHE_SECONDS)
 {
 	LazilyLoadConfigIfNeeded();
+	mBufferPool = std::make_shared<AampBufferPool>(gpGlobalConfig->maxBufferPoolSize);
+	if (gpGlobalConfig->useCurlMulti)
+	{
+		mMultiDownloader = AampMultiDownloader::GetInstance();
+	}
+	if (gpGlobalConfig->diskCachePath)
+	{
+		mDiskCache = AampDiskCache::GetInstance(gpGlobalConfig->diskCachePath, (size_t)gpGlobalConfig->diskCacheSizeMB * 1024 * 1024);
+	}
 #if defined(AAMP_MPD_DRM) || defined(AAMP_HLS_DRM)
 	mDRMSessionManager = new AampDRMSessionManager();
 #endif
@@ -8304,10 +8710,6 @@ PrivateInstanceAAMP::PrivateInstanceAAMP() : mAbrBitrateData(), mLock(), mMutexA
 		httpRespHeaders[i].data.clear();
 		curlDLTimeout[i] = 0;
 	}
-	for (int i = 0; i < AAMP_MAX_NUM_EVENTS; i++)
-	{
-		mEventListeners[i] = NULL;
-	}
 
 	for (int i = 0; i < AAMP_TRACK_COUNT; i++)
 	{
@@ -8360,6 +8762,8 @@ PrivateInstanceAAMP::PrivateInstanceAAMP() : mAbrBitrateData(), mLock(), mMutexA
 	}
 	if(gpGlobalConfig->abrBufferCheckEnabled != eUndefinedState)
 		mABRBufferCheckEnabled = (bool)gpGlobalConfig->abrBufferCheckEnabled;
+	if(gpGlobalConfig->abrMode != -1)
+		mABRMode = (AAMPAbrMode)gpGlobalConfig->abrMode;
 	if(gpGlobalConfig->useNewDiscontinuity != eUndefinedState)
 		mNewAdBreakerEnabled	= (bool)gpGlobalConfig->useNewDiscontinuity;
 #ifdef AAMP_HLS_DRM
@@ -8389,12 +8793,7 @@ PrivateInstanceAAMP::~PrivateInstanceAAMP()
 	pthread_mutex_lock(&mLock);
 	for (int i = 0; i < AAMP_MAX_NUM_EVENTS; i++)
 	{
-		while (mEventListeners[i] != NULL)
-		{
-			ListenerData* pListener = mEventListeners[i];
-			mEventListeners[i] = pListener->pNext;
-			delete pListener;
-		}
+		std::atomic_store(&mEventListeners[i], std::shared_ptr<const EventListenerTable>());
 	}
 
 	if (mNetworkProxy)
@@ -8457,7 +8856,7 @@ void PrivateInstanceAAMP::SetState(PrivAAMPState state)
 		sentSync = false;
 	}
 
-	if (state == eSTATE_PLAYING && mState == eSTATE_SEEKING && (mEventListener || mEventListeners[0] || mEventListeners[AAMP_EVENT_SEEKED]))
+	if (state == eSTATE_PLAYING && mState == eSTATE_SEEKING && (IsEventListenerAvailable(AAMP_EVENT_SEEKED)))
 	{
 		AAMPEvent eventData;
 		eventData.type = AAMP_EVENT_SEEKED;
@@ -8476,7 +8875,7 @@ void PrivateInstanceAAMP::SetState(PrivAAMPState state)
 	mState = state;
 	pthread_mutex_unlock(&mLock);
 
-	if (mEventListener || mEventListeners[0] || mEventListeners[AAMP_EVENT_STATE_CHANGED])
+	if (IsEventListenerAvailable(AAMP_EVENT_STATE_CHANGED))
 	{
 		if (mState == eSTATE_PREPARING)
 		{
@@ -8645,7 +9044,7 @@ bool PrivateInstanceAAMP::SendVideoEndEvent()
 
 	if(strVideoEndJson)
 	{
-		if (mEventListener || mEventListeners[0] || mEventListeners[AAMP_EVENT_REPORT_METRICS_DATA])
+		if (IsEventListenerAvailable(AAMP_EVENT_REPORT_METRICS_DATA))
 		{
 			AsyncMetricsEventDescriptor* e = new AsyncMetricsEventDescriptor(MetricsDataType::AAMP_DATA_VIDEO_END,strVideoEndJson,this->mTraceUUID);
 
@@ -8772,7 +9171,7 @@ void PrivateInstanceAAMP::UpdateVideoEndMetrics(MediaType mediaType, long bitrat
 					eCountType = COUNT_CURL;
 				}
 			}
-			else if (curlOrHTTPCode == 200 || curlOrHTTPCode == 206)
+			else if (curlOrHTTPCode == 200 || curlOrHTTPCode == 206 || curlOrHTTPCode == 304)
 			{
 				//success
 				eCountType = COUNT_SUCCESS;
@@ -10442,7 +10841,7 @@ void PrivateInstanceAAMP::NotifyVideoBasePTS(unsigned long long basepts)
 void PrivateInstanceAAMP::SendVTTCueDataAsEvent(VTTCue* cue)
 {
 	//This function is called from an idle handler and hence we call SendEventSync
-	if (mEventListener || mEventListeners[0] || mEventListeners[AAMP_EVENT_WEBVTT_CUE_DATA])
+	if (IsEventListenerAvailable(AAMP_EVENT_WEBVTT_CUE_DATA))
 	{
 		AAMPEvent ev;
 		ev.type = AAMP_EVENT_WEBVTT_CUE_DATA;
@@ -10451,6 +10850,21 @@ void PrivateInstanceAAMP::SendVTTCueDataAsEvent(VTTCue* cue)
 	}
 }
 
+/**
+ *   @brief Get cue store of current subtitle track
+ *
+ *   @return std::shared_ptr<VTTCueStore> - cue store
+ */
+std::shared_ptr<VTTCueStore> PrivateInstanceAAMP::GetVTTCueStore()
+{
+	if (!mVTTCueStore || mVTTCueStoreLanguage != mSubLanguage)
+	{
+		mVTTCueStore = std::make_shared<VTTCueStore>();
+		mVTTCueStoreLanguage = mSubLanguage;
+	}
+	return mVTTCueStore;
+}
+
 /**
  *   @brief To check if subtitles are enabled
  *
@@ -10459,7 +10873,7 @@ void PrivateInstanceAAMP::SendVTTCueDataAsEvent(VTTCue* cue)
 bool PrivateInstanceAAMP::IsSubtitleEnabled(void)
 {
 	// Subtitle disabled for DASH
-	return (!IsDashAsset() && (mEventListener || mEventListeners[AAMP_EVENT_WEBVTT_CUE_DATA]));
+	return (!IsDashAsset() && (mEventListener || GetEventListenerStatus(AAMP_EVENT_WEBVTT_CUE_DATA)));
 
 }
 
@@ -10531,7 +10945,7 @@ void PrivateInstanceAAMP::SendId3MetadataEvent(uint8_t* data, int32_t length)
  */
 bool PrivateInstanceAAMP::GetEventListenerStatus(AAMPEventType eventType)
 {
-	if (mEventListeners[eventType] != NULL)
+	if (std::atomic_load(&mEventListeners[eventType]))
 	{
 		return true;
 	}
@@ -10540,6 +10954,34 @@ bool PrivateInstanceAAMP::GetEventListenerStatus(AAMPEventType eventType)
 }
 
 
+/**
+ * @brief Check if any listener will receive a given event
+ * @param[in] eventType - type of the event to be checked
+ *
+ * @retval bool - True if a listener for all events or for the event type exists
+ */
+bool PrivateInstanceAAMP::IsEventListenerAvailable(AAMPEventType eventType)
+{
+	return (mEventListener || GetEventListenerStatus((AAMPEventType)0) || GetEventListenerStatus(eventType));
+}
+
+
+/**
+ * @brief Detach a coalesced async event from pending state
+ * @param e event descriptor
+ */
+void PrivateInstanceAAMP::ReleaseCoalescedEvent(AsyncEventDescriptor* e)
+{
+	pthread_mutex_lock(&mLock);
+	std::map<AAMPEventType, AsyncEventDescriptor*>::iterator it = mCoalescedEvents.find(e->event.type);
+	if (it != mCoalescedEvents.end() && it->second == e)
+	{
+		mCoalescedEvents.erase(it);
+	}
+	pthread_mutex_unlock(&mLock);
+}
+
+
 /**
  *	 @brief Set parallel playlist download config value for linear .
  *	 @param[in] bValue - true if a/v playlist to be downloaded in parallel for linear
@@ -10577,9 +11019,15 @@ void PrivateInstanceAAMP::PreCachePlaylistDownloadTask()
 	if(szPlaylistCount)
 	{
 		PrivAAMPState state;
-		// First wait for Tune to complete to start this functionality
+		// First wait for Tune to complete to start this functionality.
+		// Task may start after play start or Stop was signalled, so check state first
 		pthread_mutex_lock(&mMutexPlaystart);
-		pthread_cond_wait(&waitforplaystart, &mMutexPlaystart);
+		GetState(state);
+		while(state != eSTATE_PLAYING && state != eSTATE_RELEASED)
+		{
+			pthread_cond_wait(&waitforplaystart, &mMutexPlaystart);
+			GetState(state);
+		}
 		pthread_mutex_unlock(&mMutexPlaystart);
 		// May be Stop is called to release all resources .
 		// Before download , check the state 
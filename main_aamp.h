@@ -656,6 +656,20 @@ struct TextTrackInfo
 	}
 };
 
+/**
+ * @brief Media buffer of a batch sent to StreamSink
+ *        Memory is allocated as GrowableBuffer memory, ownership is taken by the sink
+ */
+struct StreamSinkBuffer
+{
+	char *ptr;          /**< Buffer memory */
+	size_t len;         /**< Data length */
+	size_t avail;       /**< Allocated size of memory */
+	double fpts;        /**< Presentation Time Stamp */
+	double fdts;        /**< Decode Time Stamp */
+	double duration;    /**< Buffer duration */
+};
+
 /**
  * @brief GStreamer Abstraction class for the implementation of AAMPGstPlayer and gstaamp plugin
  */
@@ -698,6 +712,17 @@ public:
 	 */
 	virtual void Send( MediaType mediaType, struct GrowableBuffer* buffer, double fpts, double fdts, double duration)= 0;
 
+	/**
+	 *   @brief  API to send a batch of audio/video buffers into the sink.
+	 *
+	 *   Default implementation sends buffers one by one.
+	 *
+	 *   @param[in]  mediaType - Type of the media.
+	 *   @param[in,out]  buffers - Buffers in presentation order; ownership of memory is taken by the sink and list is cleared
+	 *   @return void
+	 */
+	virtual void SendBatch( MediaType mediaType, std::vector<StreamSinkBuffer>& buffers);
+
 	/**
 	 *   @brief  Notifies EOS to sink
 	 *
@@ -1467,6 +1492,14 @@ public:
 	 */
 	void SetNewABRConfig(bool bValue);
 
+	/**
+	 *	 @brief Select ABR strategy of next tune
+	 *	 @param[in] mode - 0: default ABR, 1: throughput rule, 2: buffer based (BOLA) rule
+	 *
+	 *	 @return void
+	 */
+	void SetABRMode(int mode);
+
 	/**
 	 *	 @brief Configure New AdBreaker Enable/Disable
 	 *	 @param[in] bValue - true if new AdBreaker enabled
@@ -27,6 +27,8 @@
 
 #include <stddef.h>
 
+struct GrowableBuffer;
+
 /**
 * @enum _PlayMode
 * @brief Defines the parameters required for Recording Playback
@@ -83,6 +85,22 @@ public:
 	 */
 	virtual bool sendSegment( char *segment, size_t& size, double position, double duration, bool discontinuous, bool &ptsError) = 0;
 
+	/**
+	 * @brief Process and send media fragment, handing over buffer ownership
+	 *
+	 * Processors which forward the fragment unmodified pass the fragment
+	 * memory to the sink without another copy. On return, buffer is either
+	 * reset (ownership taken) or left for the caller to free.
+	 *
+	 * @param[in,out] buffer - fragment buffer
+	 * @param[in] position - position of fragment
+	 * @param[in] duration - duration of fragment
+	 * @param[in] discontinuous - true if discontinuous fragment
+	 * @param[out] ptsError - flag indicates if any PTS error occurred
+	 * @return true if fragment was sent, false otherwise
+	 */
+	virtual bool sendSegmentBuffer(struct GrowableBuffer *buffer, double position, double duration, bool discontinuous, bool &ptsError) = 0;
+
 	/**
 	 * @brief Set playback rate
 	 *
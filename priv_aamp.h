@@ -41,7 +41,12 @@
 #include <sstream>
 #include <mutex>
 #include <queue>
+#include <memory>
+#include <future>
+#include <atomic>
 #include <VideoStat.h>
+#include "AampAbrStrategy.h"
+#include "AampLogQueue.h"
 #include <limits>
 
 static const char *mMediaFormatName[] =
@@ -57,6 +62,8 @@ static const char *mMediaFormatName[] =
 
 #define AAMP_TRACK_COUNT 3              /**< internal use - audio+video+sub track */
 #define DEFAULT_CURL_INSTANCE_COUNT (AAMP_TRACK_COUNT + 1) // One for Manifest/Playlist + Number of tracks
+#define AAMP_FETCH_PIPELINE_MAX_DEPTH 4 /**< Max fragment downloads in flight per track */
+#define DEFAULT_FETCH_PIPELINE_DEPTH 3  /**< Fragment downloads in flight per track, 1 disables pipelining */
 #define AAMP_DRM_CURL_COUNT 2           /**< audio+video track DRMs */
 #define AAMP_MAX_PIPE_DATA_SIZE 1024    /**< Max size of data send across pipe */
 #define AAMP_LIVE_OFFSET 15             /**< Live offset in seconds */
@@ -114,6 +121,8 @@ static const char *mMediaFormatName[] =
 #define AAMP_USER_AGENT_MAX_CONFIG_LEN  512    /**< Max Chars allowed in aamp.cfg for user-agent */
 // HLS CDVR/VOD playlist size for 1hr -> 225K , 2hr -> 450-470K , 3hr -> 670K . Most played CDVR/Vod < 2hr
 #define MAX_PLAYLIST_CACHE_SIZE    (3*1024*1024) // Approx 3MB -> 2 video profiles + one audio profile + one iframe profile, 500-700K MainManifest
+#define DEFAULT_BUFFER_POOL_SIZE   (16*1024*1024) // Free fragment/playlist memory kept for reuse per player instance
+#define DEFAULT_DISK_CACHE_SIZE_MB 100 // Max size of on-disk cache of VOD fragments/playlists, when enabled
 #define DEFAULT_WAIT_TIME_BEFORE_RETRY_HTTP_5XX_MS (1000)    /**< Wait time in milliseconds before retry for 5xx errors */
 
 // VSS Service Zone identifier in url 
@@ -149,6 +158,7 @@ static const char *mMediaFormatName[] =
 #define PARTIAL_FILE_DOWNLOAD_TIME_EXPIRED_AAMP (131)
 #define OPERATION_TIMEOUT_CONNECTIVITY_AAMP (132)
 #define PARTIAL_FILE_START_STALL_TIMEOUT_AAMP (133)
+#define PARTIAL_FILE_LOW_BANDWIDTH_AAMP (134)
 /**
  * @brief Structure of GrowableBuffer
  */
@@ -181,7 +191,8 @@ enum AampCurlInstance
 	eCURLINSTANCE_DAI,
 	eCURLINSTANCE_AES,
 	eCURLINSTANCE_PLAYLISTPRECACHE,
-	eCURLINSTANCE_MAX
+	eCURLINSTANCE_PIPELINE,		/**< First of (AAMP_FETCH_PIPELINE_MAX_DEPTH - 1) instances per track for fragments fetched ahead */
+	eCURLINSTANCE_MAX = eCURLINSTANCE_PIPELINE + AAMP_TRACK_COUNT * (AAMP_FETCH_PIPELINE_MAX_DEPTH - 1)
 };
 
 /**
@@ -291,7 +302,8 @@ enum CurlAbortReason
 {
 	eCURL_ABORT_REASON_NONE = 0,
 	eCURL_ABORT_REASON_STALL_TIMEDOUT,
-	eCURL_ABORT_REASON_START_TIMEDOUT
+	eCURL_ABORT_REASON_START_TIMEDOUT,
+	eCURL_ABORT_REASON_LOW_BANDWIDTH
 };
 
 /**
@@ -338,7 +350,7 @@ typedef enum
  */
 #define AAMPLOG(LEVEL,FORMAT, ...) \
 		do { if (gpGlobalConfig->logging.isLogLevelAllowed(LEVEL)) { \
-				logprintf(FORMAT, ##__VA_ARGS__); \
+				aamp_LevelLogPrintf(LEVEL, FORMAT, ##__VA_ARGS__); \
 		} } while (0)
 
 /**
@@ -358,6 +370,27 @@ typedef enum
 #define AAMPLOG_WARN(FORMAT, ...) AAMPLOG(eLOGLEVEL_WARN, FORMAT, ##__VA_ARGS__)
 #define AAMPLOG_ERR(FORMAT, ...) AAMPLOG(eLOGLEVEL_ERROR,  FORMAT, ##__VA_ARGS__)
 
+/**
+ * @brief Log with arguments packed in binary form and formatted lazily by the log writer
+ *
+ * For high rate log sites. Arguments must be scalars or C strings, which are copied.
+ * Falls back to logprintf when asynchronous logging is off.
+ */
+#define AAMP_LOG_DEFERRED(FORMAT, ...) \
+		do { if (AampLogManager::asyncLogging) { \
+				aamp_LogDeferred(FORMAT, ##__VA_ARGS__); \
+			} else { \
+				logprintf(FORMAT, ##__VA_ARGS__); \
+		} } while (0)
+
+#define AAMPLOG_DEFERRED(LEVEL, FORMAT, ...) \
+		do { if (gpGlobalConfig->logging.isLogLevelAllowed(LEVEL)) { \
+				AAMP_LOG_DEFERRED(FORMAT, ##__VA_ARGS__); \
+		} } while (0)
+
+#define AAMPLOG_TRACE_DEFERRED(FORMAT, ...) AAMPLOG_DEFERRED(eLOGLEVEL_TRACE, FORMAT, ##__VA_ARGS__)
+#define AAMPLOG_INFO_DEFERRED(FORMAT, ...) AAMPLOG_DEFERRED(eLOGLEVEL_INFO, FORMAT, ##__VA_ARGS__)
+
 #define AAMPLOG_FAILOVER(FORMAT, ...) \
 		if (gpGlobalConfig->logging.failover) { \
 				logprintf(FORMAT, ##__VA_ARGS__); \
@@ -438,6 +471,7 @@ public:
 	bool logMetadata;	 /**< Timed metadata logs*/
 	bool curlHeader; /**< Curl header logs*/
 	static bool disableLogRedirection;
+	static bool asyncLogging;	/**< Queue logs to a background writer instead of writing on calling thread*/
 
 	/**
 	 * @brief AampLogManager constructor
@@ -506,7 +540,10 @@ public:
 	 * @param[in] chkLevel - log level
 	 * @retval true if the log level allowed for print mechanism
 	 */
-	bool isLogLevelAllowed(AAMP_LogLevel chkLevel);
+	bool isLogLevelAllowed(AAMP_LogLevel chkLevel)
+	{
+		return (chkLevel>=aampLoglevel);
+	}
 
 	/**
 	 * @brief Set the log level for print mechanism
@@ -549,6 +586,14 @@ private:
  */
 extern void logprintf(const char *format, ...);
 
+/**
+ * @brief Print logs of a level to console / log file
+ * @param[in] level - log level, trace and info logs may be dropped under asynchronous logging
+ * @param[in] format - printf style string
+ * @retuen void
+ */
+extern void aamp_LevelLogPrintf(AAMP_LogLevel level, const char *format, ...);
+
 /**
  * @brief Compactly log blobs of binary data
  *
@@ -615,15 +660,23 @@ public:
 	int abrCacheLife;                       /**< Adaptive bitrate cache life in seconds*/
 	int abrCacheLength;                     /**< Adaptive bitrate cache length*/
 	int maxCachedFragmentsPerTrack;         /**< fragment cache length*/
+	int maxCachedFragmentsAudio;            /**< fragment cache length of audio track, 0 to use maxCachedFragmentsPerTrack*/
+	int maxCachedFragmentsSubtitle;         /**< fragment cache length of subtitle track, 0 to use maxCachedFragmentsPerTrack*/
 	int abrOutlierDiffBytes;                /**< Adaptive bitrate outlier, if values goes beyond this*/
 	int abrNwConsistency;                   /**< Adaptive bitrate network consistency*/
 	int minABRBufferForRampDown;		/**< Mininum ABR Buffer for Rampdown*/
 	int maxABRBufferForRampUp;		/**< Maximum ABR Buffer for Rampup*/
 	TriState abrBufferCheckEnabled;         /**< Flag to enable/disable buffer based ABR handling*/
+	int abrMode;                            /**< ABR strategy (AAMPAbrMode) overriding application setting, -1 if not configured */
 	TriState useNewDiscontinuity;         /**< Flag to enable/disable buffer based ABR handling*/
 	int bufferHealthMonitorDelay;           /**< Buffer health monitor start delay after tune/ seek*/
 	int bufferHealthMonitorInterval;        /**< Buffer health monitor interval*/
 	bool hlsAVTrackSyncUsingStartTime;      /**< HLS A/V track to be synced with start time*/
+	bool hlsIncrementalIndex;               /**< Reuse index of fragments retained across live HLS playlist refresh*/
+	bool hlsDecryptPipeline;                /**< Decrypt AES-128 HLS fragments on a per track thread, overlapped with next download*/
+	bool initFragmentCache;                 /**< Keep downloaded init fragments in memory for reuse within session*/
+	bool conditionalPlaylistGet;            /**< Refresh live playlists with If-None-Match/If-Modified-Since*/
+	bool playlistDeltaUpdate;               /**< Refresh live playlists by HLS delta update or DASH MPD patch when offered by server*/
 	char* licenseServerURL;                 /**< License server URL*/
 	bool licenseServerLocalOverride;        /**< Enable license server local overriding*/
 	int vodTrickplayFPS;                    /**< Trickplay frames per second for VOD*/
@@ -640,6 +693,7 @@ public:
 	bool mpdDiscontinuityHandlingCdvr;      /**< Enable MPD discontinuity handling for CDVR*/
 	bool bForceHttp;                        /**< Force HTTP*/
 	int abrSkipDuration;                    /**< Initial duration for ABR skip*/
+	bool abrFragmentAbandon;                /**< Abort video fragment downloads projected to outlast the buffer */
 	bool internalReTune;                    /**< Internal re-tune on underflows/ pts errors*/
 	int ptsErrorThreshold;                       /**< Max number of back-to-back PTS errors within designated time*/
 	bool bAudioOnlyPlayback;                /**< AAMP Audio Only Playback*/
@@ -657,8 +711,13 @@ public:
 	char *pUserAgentString;			/**< Curl user-agent string */
 	bool reTuneOnBufferingTimeout;          /**< Re-tune on buffering timeout */
 	int gMaxPlaylistCacheSize;              /**< Max Playlist Cache Size  */
+	int maxBufferPoolSize;                  /**< Max size of free memory pooled for download buffers, 0 disables pooling */
 	int waitTimeBeforeRetryHttp5xxMS;		/**< Wait time in milliseconds before retry for 5xx errors*/
 	bool disableSslVerifyPeer;		/**< Disable curl ssl certificate verification. */
+	bool useCurlMulti;			/**< Drive downloads through shared curl multi handle (connection sharing, HTTP/2 multiplexing) */
+	int fetchPipelineDepth;			/**< Fragment downloads kept in flight per track */
+	char *diskCachePath;			/**< Directory of on-disk download cache, NULL disables the cache */
+	int diskCacheSizeMB;			/**< Max size of on-disk download cache in MB */
 	std::string mSubtitleLanguage;          /**< User preferred subtitle language*/
 	bool enableClientDai;                   /**< Enabling the client side DAI*/
 	bool playAdFromCDN;                     /**< Play Ad from CDN. Not from FOG.*/
@@ -692,19 +751,20 @@ public:
 	/**
 	 * @brief GlobalConfigAAMP Constructor
 	 */
-	GlobalConfigAAMP() :defaultBitrate(DEFAULT_INIT_BITRATE), defaultBitrate4K(DEFAULT_INIT_BITRATE_4K), bEnableABR(true), noFog(false), mapMPD(0), fogSupportsDash(true),abrCacheLife(DEFAULT_ABR_CACHE_LIFE),abrCacheLength(DEFAULT_ABR_CACHE_LENGTH),maxCachedFragmentsPerTrack(DEFAULT_CACHED_FRAGMENTS_PER_TRACK),
+	GlobalConfigAAMP() :defaultBitrate(DEFAULT_INIT_BITRATE), defaultBitrate4K(DEFAULT_INIT_BITRATE_4K), bEnableABR(true), noFog(false), mapMPD(0), fogSupportsDash(true),abrCacheLife(DEFAULT_ABR_CACHE_LIFE),abrCacheLength(DEFAULT_ABR_CACHE_LENGTH),maxCachedFragmentsPerTrack(DEFAULT_CACHED_FRAGMENTS_PER_TRACK),maxCachedFragmentsAudio(0),maxCachedFragmentsSubtitle(0),
 #ifdef AAMP_HARVEST_SUPPORT_ENABLED
 		harvest(0),
 #endif
 		gPreservePipeline(0), gAampDemuxHLSAudioTsTrack(1), gAampMergeAudioTrack(1), forceEC3(0),
 		gAampDemuxHLSVideoTsTrack(1), demuxHLSVideoTsTrackTM(1), gThrottle(0), demuxedAudioBeforeVideo(0),
 		playlistsParallelFetch(eUndefinedState), prefetchIframePlaylist(false),
-		disableEC3(0), disableATMOS(0),abrOutlierDiffBytes(DEFAULT_ABR_OUTLIER),abrSkipDuration(DEFAULT_ABR_SKIP_DURATION),
+		disableEC3(0), disableATMOS(0),abrOutlierDiffBytes(DEFAULT_ABR_OUTLIER),abrSkipDuration(DEFAULT_ABR_SKIP_DURATION),abrFragmentAbandon(false),
 		liveOffset(-1),cdvrliveOffset(-1), abrNwConsistency(DEFAULT_ABR_NW_CONSISTENCY_CNT),
 		disablePlaylistIndexEvent(1), enableSubscribedTags(1), dashIgnoreBaseURLIfSlash(false),networkTimeoutMs(-1),
 		licenseAnonymousRequest(false), minInitialCacheSeconds(MINIMUM_INIT_CACHE_NOT_OVERRIDDEN), useLinearSimulator(false),
 		bufferHealthMonitorDelay(DEFAULT_BUFFER_HEALTH_MONITOR_DELAY), bufferHealthMonitorInterval(DEFAULT_BUFFER_HEALTH_MONITOR_INTERVAL),
-		preferredDrm(eDRM_PlayReady), hlsAVTrackSyncUsingStartTime(false), licenseServerURL(NULL), licenseServerLocalOverride(false),
+		preferredDrm(eDRM_PlayReady), hlsAVTrackSyncUsingStartTime(false), hlsIncrementalIndex(true), hlsDecryptPipeline(false),
+		initFragmentCache(true), conditionalPlaylistGet(true), playlistDeltaUpdate(true), licenseServerURL(NULL), licenseServerLocalOverride(false),
 		vodTrickplayFPS(TRICKPLAY_NETWORK_PLAYBACK_FPS),vodTrickplayFPSLocalOverride(false),
 		linearTrickplayFPS(TRICKPLAY_TSB_PLAYBACK_FPS),linearTrickplayFPSLocalOverride(false),
 		stallErrorCode(DEFAULT_STALL_ERROR_CODE), stallTimeoutInMS(DEFAULT_STALL_DETECTION_TIMEOUT), httpProxy(0),
@@ -713,12 +773,12 @@ public:
 		iframeBitrate(0), iframeBitrate4K(0),ptsErrorThreshold(MAX_PTS_ERRORS_THRESHOLD),
 		prLicenseServerURL(NULL), wvLicenseServerURL(NULL),ckLicenseServerURL(NULL)
 		,curlStallTimeout(0), curlDownloadStartTimeout(0)
-		,enableMicroEvents(false),enablePROutputProtection(false), reTuneOnBufferingTimeout(true), gMaxPlaylistCacheSize(0)
+		,enableMicroEvents(false),enablePROutputProtection(false), reTuneOnBufferingTimeout(true), gMaxPlaylistCacheSize(0), maxBufferPoolSize(DEFAULT_BUFFER_POOL_SIZE)
 		,waitTimeBeforeRetryHttp5xxMS(DEFAULT_WAIT_TIME_BEFORE_RETRY_HTTP_5XX_MS),
 		dash_MaxDRMSessions(MIN_DASH_DRM_SESSIONS),
 		tunedEventConfigLive(eTUNED_EVENT_MAX), tunedEventConfigVOD(eTUNED_EVENT_MAX),
 		isUsingLocalConfigForPreferredDRM(false), pUserAgentString(NULL), logging()
-		, disableSslVerifyPeer(true)
+		, disableSslVerifyPeer(true), useCurlMulti(true), fetchPipelineDepth(DEFAULT_FETCH_PIPELINE_DEPTH), diskCachePath(NULL), diskCacheSizeMB(DEFAULT_DISK_CACHE_SIZE_MB)
 		,mSubtitleLanguage()
 		, enableClientDai(false), playAdFromCDN(false)
 		,mEnableVideoEndEvent(true)
@@ -735,7 +795,7 @@ public:
 		,mUseAverageBWForABR(eUndefinedState)
 		,parallelPlaylistRefresh(eUndefinedState)
 		,mPreCacheTimeWindow(0)
-		,abrBufferCheckEnabled(eUndefinedState)
+		,abrBufferCheckEnabled(eUndefinedState), abrMode(-1)
 		,useNewDiscontinuity(eUndefinedState)
 		,mAsyncTuneConfig(eUndefinedState)
 		,aampRemovePersistent(0)
@@ -1550,12 +1610,12 @@ struct httpRespHeaderData {
 
 
 /**
- * @brief  Structure of the event listener list
+ * @brief  Immutable table of listeners registered for an event type
+ *
+ * Tables are never modified once published; add/remove builds a new table and
+ * swaps it in, so events can be dispatched from a snapshot without locking.
  */
-struct ListenerData {
-	AAMPEventListener* eventListener;   /**< Event listener */
-	ListenerData* pNext;                /**< Next listener */
-};
+typedef std::vector<AAMPEventListener*> EventListenerTable;
 
 
 #ifdef AAMP_HLS_DRM
@@ -1582,6 +1642,13 @@ class attrNameData{
 
 class AampCacheHandler;
 
+class AampBufferPool;
+
+class VTTCueStore;
+
+class AampMultiDownloader;
+class AampDiskCache;
+
 class AampDRMSessionManager;
 
 /**
@@ -1729,6 +1796,7 @@ public:
 	void SetTuneEventConfig( TunedEventConfig tuneEventType);
 
 	std::vector< std::pair<long long,long> > mAbrBitrateData;
+	std::atomic<int> mVideoTransfersInFlight; /**< Video fragment downloads in progress, they share the link */
 
 	pthread_mutex_t mLock;// = PTHREAD_MUTEX_INITIALIZER;
 	pthread_mutexattr_t mMutexAttr;
@@ -1834,13 +1902,13 @@ public:
 	std::vector <attrNameData> aesCtrAttrDataList; /**< Queue to hold the values of DRM data parsed from manifest */
 	pthread_mutex_t drmParserMutex; /**< Mutex to lock DRM parsing logic */
 	bool fragmentCdmEncrypted; /**< Indicates CDM protection added in fragments **/
-	pthread_t createDRMSessionThreadID; /**< thread ID for DRM session creation **/
-	bool drmSessionThreadStarted; /**< flag to indicate the thread is running on not **/
+	std::future<void> createDRMSessionTask; /**< DRM session creation task **/
 #endif
 	Playermode mPlayermode;
 	pthread_t mPreCachePlaylistThreadId;
 	bool mPreCachePlaylistThreadFlag;
 	bool mABRBufferCheckEnabled;
+	AAMPAbrMode mABRMode;          /**< ABR strategy of video profile selection */
 	bool mNewAdBreakerEnabled;
 	bool mbPlayEnabled;	//Send buffer to pipeline or just cache them.
 #if defined(AAMP_MPD_DRM) || defined(AAMP_HLS_DRM)
@@ -1934,7 +2002,7 @@ public:
 	 * @param[out] http_error - HTTP error code
 	 * @param[in] range - Byte range
 	 * @param[in] curlInstance - Curl instance to be used
-	 * @param[in] resetBuffer - Flag to reset the out buffer
+	 * @param[in] resetBuffer - Flag to reset the out buffer, false to download into memory attached by caller
 	 * @param[in] fileType - File type
 	 * @return void
 	 */
@@ -2256,6 +2324,15 @@ public:
 	 */
 	void SendStream(MediaType mediaType, GrowableBuffer* buffer, double fpts, double fdts, double fDuration);
 
+	/**
+	 *   @brief  API to send a batch of audio/video buffers into the sink.
+	 *
+	 *   @param[in]  mediaType - Type of the media.
+	 *   @param[in,out]  buffers - Buffers in presentation order; ownership of memory is transferred and list is cleared
+	 *   @return void
+	 */
+	void SendStream(MediaType mediaType, std::vector<StreamSinkBuffer>& buffers);
+
 	/**
 	 * @brief Setting the stream sink
 	 *
@@ -3238,6 +3315,16 @@ public:
 	 */
 	void SendVTTCueDataAsEvent(VTTCue* cue);
 
+	/**
+	 *   @brief Get cue store of current subtitle track
+	 *
+	 *   Store is kept across seeks of a tune, a new one is created
+	 *   on new tune or subtitle language change.
+	 *
+	 *   @return std::shared_ptr<VTTCueStore> - cue store
+	 */
+	std::shared_ptr<VTTCueStore> GetVTTCueStore();
+
 	/**
 	 *   @brief To check if subtitles are enabled
 	 *
@@ -3395,6 +3482,14 @@ public:
 	 *	 @return void
 	 */
 	void SetNewABRConfig(bool bValue);
+
+	/**
+	 *	 @brief Select ABR strategy of next tune
+	 *	 @param[in] mode - AAMPAbrMode value
+	 *
+	 *	 @return void
+	 */
+	void SetABRMode(int mode);
 	/**
 	 *	 @brief Configure New AdBreaker Enable/Disable
 	 *	 @param[in] bValue - true if new AdBreaker enabled
@@ -3476,6 +3571,25 @@ public:
 	 */
 	bool GetEventListenerStatus(AAMPEventType eventType);
 
+	/**
+	 * @brief Check if any listener will receive a given event
+	 * @param[in] eventType - type of the event to be checked
+	 *
+	 * @retval bool - True if a listener for all events or for the event type exists
+	 */
+	bool IsEventListenerAvailable(AAMPEventType eventType);
+
+	/**
+	 * @brief Detach a coalesced async event from pending state
+	 *
+	 * Once detached, newer events of the same type are scheduled afresh
+	 * instead of updating this descriptor.
+	 *
+	 * @param[in] e - Pointer to the event descriptor
+	 * @return void
+	 */
+	void ReleaseCoalescedEvent(struct AsyncEventDescriptor* e);
+
 	/**
 	 * @brief Check if track can inject data into GStreamer.
 	 *
@@ -3511,6 +3625,13 @@ public:
 	 */
 	AampCacheHandler * getAampCacheHandler();
 
+	/**
+	 * @brief Get memory pool used for download buffers
+	 *
+	 * @return Reference to shared pointer of AampBufferPool
+	 */
+	const std::shared_ptr<AampBufferPool>& GetBufferPool() { return mBufferPool; }
+
 	/*
 	 * @brief Set profile ramp down limit.
 	 *
@@ -3612,7 +3733,7 @@ private:
  	 */
 	void NotifySinkBufferFull(MediaType type);
 
-	ListenerData* mEventListeners[AAMP_MAX_NUM_EVENTS];
+	std::shared_ptr<const EventListenerTable> mEventListeners[AAMP_MAX_NUM_EVENTS]; /**< Listener table per event type, NULL if none. Access with std::atomic_load/atomic_store */
 	TuneType mTuneType;
 	int m_fd;
 	bool mIsLive;
@@ -3634,6 +3755,7 @@ private:
 	bool mTunedEventPending;
 	bool mSeekOperationInProgress;
 	std::map<guint, bool> mPendingAsyncEvents;
+	std::map<AAMPEventType, struct AsyncEventDescriptor*> mCoalescedEvents; /**< Undispatched async event per coalesced event type, protected by mLock */
 	std::unordered_map<std::string, std::vector<std::string>> mCustomHeaders;
 	bool mIsFirstRequestToFOG;
 	bool mIsLocalPlayback; /** indicates if the playback is from FOG(TSB/IP-DVR) */
@@ -3661,6 +3783,11 @@ private:
 	bool mProgressReportFromProcessDiscontinuity; /** flag dentoes if progress reporting is in execution from ProcessPendingDiscontinuity*/
 
 	AampCacheHandler *mAampCacheHandler;
+	std::shared_ptr<AampBufferPool> mBufferPool; /**< Memory pool for fragment and playlist buffers */
+	std::shared_ptr<AampMultiDownloader> mMultiDownloader; /**< Shared curl multi download engine, NULL if disabled */
+	std::shared_ptr<AampDiskCache> mDiskCache; /**< Shared on-disk download cache, NULL if disabled */
+	std::shared_ptr<VTTCueStore> mVTTCueStore; /**< WebVTT cues of current subtitle track, kept across seeks */
+	std::string mVTTCueStoreLanguage; /**< Subtitle language of mVTTCueStore */
 	long mMinBitrate;	/** minimum bitrate limit of profiles to be selected during playback */
 	long mMaxBitrate;	/** Maximum bitrate limit of profiles to be selected during playback */
 	int m_minInitialCacheSeconds; /**< Minimum cached duration before playing in seconds*/
@@ -23,12 +23,15 @@
  */
 
 #include "StreamAbstractionAAMP.h"
+#include "AampBufferPool.h"
+#include "AampFetchPipeline.h"
 #include <assert.h>
 #include <errno.h>
 #include <math.h>
 #include <iterator>
 #include <sys/time.h>
 #include <cmath>
+#include <algorithm>
 
 #ifdef USE_MAC_FOR_RANDOM_GEN
 #include <sys/types.h>
@@ -189,24 +192,31 @@ void MediaTrack::MonitorBufferHealth()
  */
 void MediaTrack::UpdateTSAfterInject()
 {
+	// Slot, index and count change together under mutex, as other tracks walk the cache
+	// (CheckForFutureDiscontinuity). Memory is returned to the pool after unlocking
 	pthread_mutex_lock(&mutex);
-	aamp_Free(&cachedFragment[fragmentIdxToInject].fragment.ptr);
+	GrowableBuffer injected = cachedFragment[fragmentIdxToInject].fragment;
 	memset(&cachedFragment[fragmentIdxToInject], 0, sizeof(CachedFragment));
 	fragmentIdxToInject++;
-	if (fragmentIdxToInject == gpGlobalConfig->maxCachedFragmentsPerTrack)
+	if (fragmentIdxToInject == maxCachedFragments)
 	{
 		fragmentIdxToInject = 0;
 	}
-	numberOfFragmentsCached--;
+	int cachedCount = --numberOfFragmentsCached;
 #ifdef AAMP_DEBUG_FETCH_INJECT
 	if ((1 << type) & AAMP_DEBUG_FETCH_INJECT)
 	{
 		logprintf("%s:%d [%s] updated fragmentIdxToInject = %d numberOfFragmentsCached %d", __FUNCTION__, __LINE__,
-		        name, fragmentIdxToInject, numberOfFragmentsCached);
+		        name, fragmentIdxToInject, cachedCount);
 	}
 #endif
-	pthread_cond_signal(&fragmentInjected);
+	if (cachedCount == maxCachedFragments - 1)
+	{
+		// Fetcher waits only on a full cache
+		pthread_cond_signal(&fragmentInjected);
+	}
 	pthread_mutex_unlock(&mutex);
+	aamp->GetBufferPool()->Release(&injected);
 }
 
 
@@ -216,34 +226,53 @@ void MediaTrack::UpdateTSAfterInject()
 void MediaTrack::UpdateTSAfterFetch()
 {
 	bool notifyCacheCompleted = false;
-	pthread_mutex_lock(&mutex);
-	cachedFragment[fragmentIdxToFetch].profileIndex = GetContext()->profileIdxForBandwidthNotification;
-	GetContext()->UpdateStreamInfoBitrateData(cachedFragment[fragmentIdxToFetch].profileIndex, cachedFragment[fragmentIdxToFetch].cacheFragStreamInfo);
+	// Slot at fragmentIdxToFetch is owned by fetcher till count is incremented
+	CachedFragment* fetchedFragment = &cachedFragment[fragmentIdxToFetch];
+	fetchedFragment->profileIndex = GetContext()->profileIdxForBandwidthNotification;
+	GetContext()->UpdateStreamInfoBitrateData(fetchedFragment->profileIndex, fetchedFragment->cacheFragStreamInfo);
 #ifdef AAMP_DEBUG_FETCH_INJECT
 	if ((1 << type) & AAMP_DEBUG_FETCH_INJECT)
 	{
 		logprintf("%s:%d [%s] before update fragmentIdxToFetch = %d numberOfFragmentsCached %d",
-		        __FUNCTION__, __LINE__, name, fragmentIdxToFetch, numberOfFragmentsCached);
+		        __FUNCTION__, __LINE__, name, fragmentIdxToFetch, numberOfFragmentsCached.load());
 	}
 #endif
-	totalFetchedDuration += cachedFragment[fragmentIdxToFetch].duration;
+	totalFetchedDuration += fetchedFragment->duration;
+	double fetchedDuration = fetchedFragment->duration;
+	fragmentIdxToFetch++;
+	if (fragmentIdxToFetch == maxCachedFragments)
+	{
+		fragmentIdxToFetch = 0;
+	}
+	totalFragmentsDownloaded++;
+
+	int cachedCount = ++numberOfFragmentsCached;
+	assert(cachedCount <= maxCachedFragments);
 #ifdef AAMP_DEBUG_FETCH_INJECT
 	if ((1 << type) & AAMP_DEBUG_FETCH_INJECT)
 	{
-		if (numberOfFragmentsCached == 0)
+		if (cachedCount == 1)
 		{
 			logprintf("## %s:%d [%s] Caching fragment for track when numberOfFragmentsCached is 0 ##", __FUNCTION__, __LINE__, name);
 		}
+		logprintf("%s:%d [%s] updated fragmentIdxToFetch = %d numberOfFragmentsCached %d",
+			__FUNCTION__, __LINE__, name, fragmentIdxToFetch, cachedCount);
 	}
 #endif
-	numberOfFragmentsCached++;
-	assert(numberOfFragmentsCached <= gpGlobalConfig->maxCachedFragmentsPerTrack);
+	if (cachedCount == 1)
+	{
+		// Injector waits only on an empty cache. Taking the lock orders this signal after its check
+		pthread_mutex_lock(&mutex);
+		pthread_cond_signal(&fragmentFetched);
+		pthread_mutex_unlock(&mutex);
+	}
 
 	if( (eTRACK_VIDEO == type)
 			&& aamp->IsFragmentBufferingRequired()
 			&& !notifiedCachingComplete)
 	{
-		currentInitialCacheDurationSeconds += cachedFragment[fragmentIdxToFetch].duration;
+		pthread_mutex_lock(&mutex);
+		currentInitialCacheDurationSeconds += fetchedDuration;
 		const int minInitialCacheSeconds = aamp->GetInitialBufferDuration();
 		if(currentInitialCacheDurationSeconds >= minInitialCacheSeconds)
 		{
@@ -251,7 +280,7 @@ void MediaTrack::UpdateTSAfterFetch()
 					__FUNCTION__, __LINE__, name, currentInitialCacheDurationSeconds, minInitialCacheSeconds);
 			notifyCacheCompleted = true;
 		}
-		else if (sinkBufferIsFull && numberOfFragmentsCached == gpGlobalConfig->maxCachedFragmentsPerTrack)
+		else if (sinkBufferIsFull && numberOfFragmentsCached == maxCachedFragments)
 		{
 			logprintf("## %s:%d [%s] Cache is Full cacheDuration %d minInitialCacheSeconds %d, aborting caching!##",
 					__FUNCTION__, __LINE__, name, currentInitialCacheDurationSeconds, minInitialCacheSeconds);
@@ -262,22 +291,8 @@ void MediaTrack::UpdateTSAfterFetch()
 			logprintf("## %s:%d [%s] Caching Ongoing cacheDuration %d minInitialCacheSeconds %d##",
 					__FUNCTION__, __LINE__, name, currentInitialCacheDurationSeconds, minInitialCacheSeconds);
 		}
+		pthread_mutex_unlock(&mutex);
 	}
-	fragmentIdxToFetch++;
-	if (fragmentIdxToFetch == gpGlobalConfig->maxCachedFragmentsPerTrack)
-	{
-		fragmentIdxToFetch = 0;
-	}
-#ifdef AAMP_DEBUG_FETCH_INJECT
-	if ((1 << type) & AAMP_DEBUG_FETCH_INJECT)
-	{
-		logprintf("%s:%d [%s] updated fragmentIdxToFetch = %d numberOfFragmentsCached %d",
-			__FUNCTION__, __LINE__, name, fragmentIdxToFetch, numberOfFragmentsCached);
-	}
-#endif
-	totalFragmentsDownloaded++;
-	pthread_cond_signal(&fragmentFetched);
-	pthread_mutex_unlock(&mutex);
 	if(notifyCacheCompleted)
 	{
 		aamp->NotifyFragmentCachingComplete();
@@ -335,7 +350,7 @@ bool MediaTrack::WaitForFreeFragmentAvailable( int timeoutMs)
 	}
 	
 	pthread_mutex_lock(&mutex);
-	if ( ret && (numberOfFragmentsCached == gpGlobalConfig->maxCachedFragmentsPerTrack) )
+	if ( ret && (numberOfFragmentsCached == maxCachedFragments) )
 	{
 		if (timeoutMs >= 0)
 		{
@@ -396,7 +411,7 @@ bool MediaTrack::WaitForFreeFragmentAvailable( int timeoutMs)
 	if ((1 << type) & AAMP_DEBUG_FETCH_INJECT)
 	{
 		logprintf("%s:%d [%s] fragmentIdxToFetch = %d numberOfFragmentsCached %d",
-			__FUNCTION__, __LINE__, name, fragmentIdxToFetch, numberOfFragmentsCached);
+			__FUNCTION__, __LINE__, name, fragmentIdxToFetch, numberOfFragmentsCached.load());
 	}
 #endif
 	pthread_mutex_unlock(&mutex);
@@ -428,7 +443,7 @@ bool MediaTrack::WaitForCachedFragmentAvailable()
 	if ((1 << type) & AAMP_DEBUG_FETCH_INJECT)
 	{
 		logprintf("%s:%d [%s] fragmentIdxToInject = %d numberOfFragmentsCached %d",
-			__FUNCTION__, __LINE__, name, fragmentIdxToInject, numberOfFragmentsCached);
+			__FUNCTION__, __LINE__, name, fragmentIdxToInject, numberOfFragmentsCached.load());
 	}
 #endif
 	ret = !(abort || abortInject || (numberOfFragmentsCached == 0));
@@ -786,14 +801,81 @@ CachedFragment* MediaTrack::GetFetchBuffer(bool initialize)
 	{
 		if (cachedFragment->fragment.ptr)
 		{
-			logprintf("%s:%d fragment.ptr already set - possible memory leak", __FUNCTION__, __LINE__);
+			// Memory attached by an earlier fetch which was not completed, take it back
+			AAMPLOG_TRACE("%s:%d fragment.ptr already set - releasing", __FUNCTION__, __LINE__);
+			aamp->GetBufferPool()->Release(&cachedFragment->fragment);
 		}
 		memset(&cachedFragment->fragment, 0x00, sizeof(GrowableBuffer));
+		// Pre-size from profile bitrate x fragment duration, avoids reallocations if Content-Length is not available
+		size_t expectedSize = (size_t)((bandwidthBitsPerSecond / 8) * fragmentDurationSeconds);
+		if (expectedSize > 0)
+		{
+			aamp->GetBufferPool()->Acquire(&cachedFragment->fragment, expectedSize + (expectedSize / 4));
+		}
 	}
 	return cachedFragment;
 }
 
 
+/**
+ * @brief Get number of fragments following the one being fetched to download ahead
+ * @retval fragments to queue with PrefetchFragment, 0 if pipelining is disabled
+ */
+int MediaTrack::GetPrefetchCount()
+{
+	int count = 0;
+	if (mFetchPipeline)
+	{
+		// Ring slot of current fetch is not free for fragments downloaded ahead
+		int freeSlots = maxCachedFragments - numberOfFragmentsCached - 1;
+		count = std::max(0, std::min(mFetchPipeline->GetDepth(), freeSlots));
+	}
+	return count;
+}
+
+
+/**
+ * @brief Download a fragment ahead of the fetcher, no-op if it is already downloading
+ * @param url fragment url
+ * @param range byte range, NULL for whole file
+ * @param durationSeconds fragment duration
+ */
+void MediaTrack::PrefetchFragment(const std::string &url, const char *range, double durationSeconds)
+{
+	if (mFetchPipeline)
+	{
+		mFetchPipeline->Queue(url, range, durationSeconds);
+	}
+}
+
+
+/**
+ * @brief Take fragment downloaded ahead into fetch buffer
+ * @param url fragment url
+ * @param range byte range, NULL for whole file
+ * @param[out] cachedFragment fetch buffer
+ * @param[out] effectiveUrl effective url of download
+ * @param[out] http_error http status of download
+ * @retval true if fragment was downloaded ahead, false if it has to be downloaded now
+ */
+bool MediaTrack::TakePrefetchedFragment(const std::string &url, const char *range, CachedFragment* cachedFragment, std::string &effectiveUrl, long &http_error)
+{
+	return (mFetchPipeline && mFetchPipeline->Take(url, range, &cachedFragment->fragment, effectiveUrl, http_error));
+}
+
+
+/**
+ * @brief Stop downloads ahead of the fetcher, to be called with downloads disabled
+ */
+void MediaTrack::StopPrefetch()
+{
+	if (mFetchPipeline)
+	{
+		mFetchPipeline->Stop();
+	}
+}
+
+
 /**
  * @brief Set current bandwidth of track
  * @param bandwidthBps bandwidth in bits per second
@@ -813,6 +895,26 @@ int MediaTrack::GetCurrentBandWidth()
 }
 
 
+/**
+ * @brief Get fragment cache capacity of a track
+ * @param type Type of track
+ * @retval Number of fragments which can be cached
+ */
+static int GetMaxCachedFragments(TrackType type)
+{
+	int maxCachedFragments = gpGlobalConfig->maxCachedFragmentsPerTrack;
+	if (eTRACK_AUDIO == type && gpGlobalConfig->maxCachedFragmentsAudio > 0)
+	{
+		maxCachedFragments = gpGlobalConfig->maxCachedFragmentsAudio;
+	}
+	else if (eTRACK_SUBTITLE == type && gpGlobalConfig->maxCachedFragmentsSubtitle > 0)
+	{
+		maxCachedFragments = gpGlobalConfig->maxCachedFragmentsSubtitle;
+	}
+	return maxCachedFragments;
+}
+
+
 /**
  * @brief MediaTrack Constructor
  * @param type Type of track
@@ -820,7 +922,7 @@ int MediaTrack::GetCurrentBandWidth()
  * @param name Name of the track
  */
 MediaTrack::MediaTrack(TrackType type, PrivateInstanceAAMP* aamp, const char* name) :
-		eosReached(false), enabled(false), numberOfFragmentsCached(0), fragmentIdxToInject(0),
+		eosReached(false), enabled(false), numberOfFragmentsCached(0), maxCachedFragments(GetMaxCachedFragments(type)), fragmentIdxToInject(0),
 		fragmentIdxToFetch(0), abort(false), fragmentInjectorThreadID(0), bufferMonitorThreadID(0), totalFragmentsDownloaded(0),
 		fragmentInjectorThreadStarted(false), bufferMonitorThreadStarted(false), totalInjectedDuration(0), currentInitialCacheDurationSeconds(0),
 		sinkBufferIsFull(false), notifiedCachingComplete(false), fragmentDurationSeconds(0), segDLFailCount(0),segDrmDecryptFailCount(0),mSegInjectFailCount(0),
@@ -828,12 +930,16 @@ MediaTrack::MediaTrack(TrackType type, PrivateInstanceAAMP* aamp, const char* na
 		bandwidthBitsPerSecond(0), totalFetchedDuration(0),
 		discontinuityProcessed(false), ptsError(false), cachedFragment(NULL), name(name), type(type), aamp(aamp),
 		mutex(), fragmentFetched(), fragmentInjected(), abortInject(false),
-		mSubtitleParser(NULL)
+		mSubtitleParser(NULL), mFetchPipeline(NULL)
 {
-	cachedFragment = new CachedFragment[gpGlobalConfig->maxCachedFragmentsPerTrack];
-	for(int X =0; X< gpGlobalConfig->maxCachedFragmentsPerTrack; ++X){
+	cachedFragment = new CachedFragment[maxCachedFragments];
+	for(int X =0; X< maxCachedFragments; ++X){
 		memset(&cachedFragment[X], 0, sizeof(CachedFragment));
 	}
+	if (gpGlobalConfig->fetchPipelineDepth > 1)
+	{
+		mFetchPipeline = new AampFetchPipeline(aamp, (MediaType)type, gpGlobalConfig->fetchPipelineDepth);
+	}
 	pthread_cond_init(&fragmentFetched, NULL);
 	pthread_cond_init(&fragmentInjected, NULL);
 	pthread_mutex_init(&mutex, NULL);
@@ -845,6 +951,11 @@ MediaTrack::MediaTrack(TrackType type, PrivateInstanceAAMP* aamp, const char* na
  */
 MediaTrack::~MediaTrack()
 {
+	if (mFetchPipeline)
+	{
+		delete mFetchPipeline;
+		mFetchPipeline = NULL;
+	}
 	if (bufferMonitorThreadStarted)
 	{
 		int rc = pthread_join(bufferMonitorThreadID, NULL);
@@ -859,7 +970,7 @@ MediaTrack::~MediaTrack()
 		}
 #endif
 	}
-	for (int j=0; j< gpGlobalConfig->maxCachedFragmentsPerTrack; j++)
+	for (int j=0; j< maxCachedFragments; j++)
 	{
 		aamp_Free(&cachedFragment[j].fragment.ptr);
 	}
@@ -958,7 +1069,7 @@ StreamAbstractionAAMP::StreamAbstractionAAMP(PrivateInstanceAAMP* aamp):
 		mStartTimeStamp(-1),mLastPausedTimeStamp(-1), aamp(aamp),
 		mIsPlaybackStalled(false), mCheckForRampdown(false), mTuneType(), mLock(),
 		mCond(), mLastVideoFragCheckedforABR(0), mLastVideoFragParsedTimeMS(0),
-		mAbrManager(), mSubCond(), mAudioTracks(), mTextTracks(),mABRHighBufferCounter(0),mABRLowBufferCounter(0),mMaxBufferCountCheck(gpGlobalConfig->abrCacheLength),
+		mAbrManager(), mSubCond(), mAudioTracks(), mTextTracks(),mABRHighBufferCounter(0),mABRLowBufferCounter(0),mMaxBufferCountCheck(gpGlobalConfig->abrCacheLength),mAbrStrategy(NULL),
 		mStateLock(), mStateCond(), mTrackState(eDISCONTIUITY_FREE),
 		mRampDownLimit(-1), mRampDownCount(0),
 		mBitrateReason(eAAMP_BITRATE_CHANGE_BY_TUNE)
@@ -979,6 +1090,11 @@ StreamAbstractionAAMP::StreamAbstractionAAMP(PrivateInstanceAAMP* aamp):
 		mAbrManager.setDefaultIframeBitrate(gpGlobalConfig->iframeBitrate);
 	}
 	mRampDownLimit = aamp->mRampDownLimit;
+	mAbrStrategy = AampAbrStrategy::Create(aamp->mABRMode, gpGlobalConfig->minABRBufferForRampDown, gpGlobalConfig->maxABRBufferForRampUp);
+	if (mAbrStrategy)
+	{
+		AAMPLOG_INFO("%s:%d Using %s ABR strategy", __FUNCTION__, __LINE__, mAbrStrategy->GetName());
+	}
 
 	if (!aamp->IsNewTune())
 	{
@@ -999,6 +1115,7 @@ StreamAbstractionAAMP::~StreamAbstractionAAMP()
 
 	pthread_cond_destroy(&mStateCond);
 	pthread_mutex_destroy(&mStateLock);
+	delete mAbrStrategy;
 	AAMPLOG_INFO("Exit StreamAbstractionAAMP::%s", __FUNCTION__);
 }
 
@@ -1172,7 +1289,7 @@ void StreamAbstractionAAMP::GetDesiredProfileOnSteadyState(int currProfileIndex,
 
 	if(bufferValue > 0 && currProfileIndex == newProfileIndex)
 	{
-		AAMPLOG_INFO("%s buffer:%f currProf:%d nwBW:%ld",__FUNCTION__,bufferValue,currProfileIndex,nwBandwidth);
+		AAMPLOG_INFO_DEFERRED("%s buffer:%f currProf:%d nwBW:%ld",__FUNCTION__,bufferValue,currProfileIndex,nwBandwidth);
 		if(bufferValue > gpGlobalConfig->maxABRBufferForRampUp)
 		{
 			mABRHighBufferCounter++;
@@ -1297,6 +1414,10 @@ int StreamAbstractionAAMP::GetDesiredProfileBasedOnCache(void)
 			desiredProfileIndex = tmpIframeProfile;
 		}
 	}
+	else if (mAbrStrategy)
+	{
+		desiredProfileIndex = GetDesiredProfileByStrategy();
+	}
 	/*In live, fog takes care of ABR, and cache updating is not based only on bandwidth,
 	 * but also depends on fragment availability in CDN*/
 	else
@@ -1308,7 +1429,7 @@ int StreamAbstractionAAMP::GetDesiredProfileBasedOnCache(void)
 		desiredProfileIndex = mAbrManager.getProfileIndexByBitrateRampUpOrDown(currentProfileIndex,
 				currentBandwidth, networkBandwidth, nwConsistencyCnt);
 
-		AAMPLOG_INFO("%s currBW:%ld NwBW=%ld currProf:%d desiredProf:%d",__FUNCTION__,currentBandwidth,networkBandwidth,currentProfileIndex,desiredProfileIndex);
+		AAMPLOG_INFO_DEFERRED("%s currBW:%ld NwBW=%ld currProf:%d desiredProf:%d",__FUNCTION__,currentBandwidth,networkBandwidth,currentProfileIndex,desiredProfileIndex);
 		if (currentProfileIndex != desiredProfileIndex)
 		{
 			// There is a chance that desiredProfileIndex is reset in below GetDesiredProfileOnBuffer call
@@ -1338,6 +1459,51 @@ int StreamAbstractionAAMP::GetDesiredProfileBasedOnCache(void)
 }
 
 
+/**
+ * @brief Get desired profile from ABR strategy selected for tune
+ * @retval index of desired profile
+ */
+int StreamAbstractionAAMP::GetDesiredProfileByStrategy(void)
+{
+	MediaTrack *video = GetMediaTrack(eTRACK_VIDEO);
+	AbrStrategyInput input;
+	int profileCount = GetProfileCount();
+	for (int i = 0; i < profileCount; i++)
+	{
+		StreamInfo *streamInfo = GetStreamInfo(i);
+		if (streamInfo && !streamInfo->isIframeTrack)
+		{
+			AbrLadderProfile profile;
+			profile.profileIndex = i;
+			profile.bandwidthBitsPerSecond = streamInfo->bandwidthBitsPerSecond;
+			input.ladder.push_back(profile);
+		}
+	}
+	std::sort(input.ladder.begin(), input.ladder.end(), [](const AbrLadderProfile &a, const AbrLadderProfile &b)
+	{
+		return a.bandwidthBitsPerSecond < b.bandwidthBitsPerSecond;
+	});
+	input.currentProfileIndex = currentProfileIndex;
+	input.bufferedSeconds = video->GetBufferedDuration();
+	input.fragmentDurationSeconds = video->fragmentDurationSeconds;
+	input.networkBandwidth = aamp->GetCurrentlyAvailableBandwidth();
+
+	int desiredProfileIndex = mAbrStrategy->GetDesiredProfile(input);
+	AAMPLOG_INFO_DEFERRED("%s %s buffer:%f NwBW=%ld currProf:%d desiredProf:%d", __FUNCTION__, mAbrStrategy->GetName(), input.bufferedSeconds,
+		input.networkBandwidth, currentProfileIndex, desiredProfileIndex);
+	if (currentProfileIndex != desiredProfileIndex)
+	{
+		mBitrateReason = eAAMP_BITRATE_CHANGE_BY_ABR;
+	}
+	if (aamp->mABRBufferCheckEnabled)
+	{
+		// Timeouts of next downloads based on buffer, as done for ABRManager rules
+		ConfigureTimeoutOnBuffer();
+	}
+	return desiredProfileIndex;
+}
+
+
 /**
  * @brief Rampdown profile
  *
@@ -1368,6 +1534,20 @@ bool StreamAbstractionAAMP::RampDownProfile(long http_error)
 	else
 	{
 		desiredProfileIndex = mAbrManager.getRampedDownProfileIndex(currentProfileIndex);
+		if (http_error == PARTIAL_FILE_LOW_BANDWIDTH_AAMP)
+		{
+			// Fragment was abandoned mid-download, go straight to the profile sustainable at measured throughput
+			long networkBandwidth = aamp->GetCurrentlyAvailableBandwidth();
+			if (networkBandwidth > 0)
+			{
+				int bandwidthProfileIndex = mAbrManager.getBestMatchedProfileIndexByBandWidth(networkBandwidth);
+				if (ABRManager::INVALID_PROFILE != bandwidthProfileIndex && desiredProfileIndex != currentProfileIndex &&
+					GetStreamInfo(bandwidthProfileIndex)->bandwidthBitsPerSecond < GetStreamInfo(desiredProfileIndex)->bandwidthBitsPerSecond)
+				{
+					desiredProfileIndex = bandwidthProfileIndex;
+				}
+			}
+		}
 	}
 	if (desiredProfileIndex != currentProfileIndex)
 	{
@@ -1422,7 +1602,7 @@ bool StreamAbstractionAAMP::CheckForRampDownProfile(long http_error)
 
 	if (!aamp->IsTSBSupported())
 	{
-		if (http_error == 404 || http_error == 500 || http_error == 503 || http_error == CURLE_PARTIAL_FILE)
+		if (http_error == 404 || http_error == 500 || http_error == 503 || http_error == CURLE_PARTIAL_FILE || http_error == PARTIAL_FILE_LOW_BANDWIDTH_AAMP)
 		{
 			if (RampDownProfile(http_error))
 			{
@@ -1453,6 +1633,25 @@ bool StreamAbstractionAAMP::CheckForRampDownProfile(long http_error)
 }
 
 
+/**
+ *   @brief Check if a lower video profile is available to ramp down to
+ *
+ *   @retval true if not at lowest profile and ramp down limit not reached
+ */
+bool StreamAbstractionAAMP::CanRampDownProfile()
+{
+	if (trickplayMode || aamp->IsTSBSupported())
+	{
+		return false;
+	}
+	if ((mRampDownCount >= mRampDownLimit) && (mRampDownLimit >= 0))
+	{
+		return false;
+	}
+	return (mAbrManager.getRampedDownProfileIndex(currentProfileIndex) != currentProfileIndex);
+}
+
+
 /**
  *   @brief Checks and update profile based on bandwidth.
  */
@@ -2059,13 +2258,13 @@ bool MediaTrack::CheckForFutureDiscontinuity(double &cachedDuration)
 			}
 		}
 		cachedDuration += cachedFragment[start].duration;
-		if (++start == gpGlobalConfig->maxCachedFragmentsPerTrack)
+		if (++start == maxCachedFragments)
 		{
 			start = 0;
 		}
 		count--;
 	}
-	AAMPLOG_WARN("%s:%d track %s numberOfFragmentsCached - %d, cachedDuration - %f", __FUNCTION__, __LINE__, name, numberOfFragmentsCached, cachedDuration);
+	AAMPLOG_WARN("%s:%d track %s numberOfFragmentsCached - %d, cachedDuration - %f", __FUNCTION__, __LINE__, name, numberOfFragmentsCached.load(), cachedDuration);
 	pthread_mutex_unlock(&mutex);
 
 	return ret;
@@ -2084,7 +2283,7 @@ void MediaTrack::OnSinkBufferFull()
 	pthread_mutex_lock(&mutex);
 	sinkBufferIsFull = true;
 	// check if cache buffer is full and caching was needed
-	if( numberOfFragmentsCached == gpGlobalConfig->maxCachedFragmentsPerTrack
+	if( numberOfFragmentsCached == maxCachedFragments
 			&& (eTRACK_VIDEO == type)
 			&& aamp->IsFragmentBufferingRequired()
 			&& !notifiedCachingComplete)
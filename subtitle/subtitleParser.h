@@ -68,7 +68,7 @@ public:
 	SubtitleParser& operator=(const SubtitleParser&) = delete;
 
 	virtual bool init(double startPos, unsigned long long basePTS) = 0;
-	virtual bool processData(char* buffer, size_t bufferLen, double position, double duration) = 0;
+	virtual bool processData(const char* buffer, size_t bufferLen, double position, double duration) = 0;
 	virtual bool close() = 0;
 	virtual void reset() = 0;
 	virtual void setProgressEventOffset(double offset) = 0;
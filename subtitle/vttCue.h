@@ -28,6 +28,7 @@
 #define __VTT_CUE_H__
 
 #include <string>
+#include <utility>
 
 
 /**
@@ -40,7 +41,7 @@ struct VTTCue
 {
 	VTTCue(double startTime, double duration, std::string text, std::string settings):
 		mStart(startTime), mDuration(duration),
-		mText(text), mSettings(settings)
+		mText(std::move(text)), mSettings(std::move(settings))
 	{
 
 	}
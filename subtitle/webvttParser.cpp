@@ -28,112 +28,400 @@
 #include <assert.h>
 #include <cctype>
 #include <algorithm>
+#include <utility>
 #include "webvttParser.h"
 
 //Macros
 #define CHAR_CARRIAGE_RETURN    '\r'
 #define CHAR_LINE_FEED          '\n'
 #define CHAR_SPACE              ' '
+#define CHAR_TAB                '\t'
 
 #define VTT_QUEUE_TIMER_INTERVAL 250 //milliseconds
+#define VTT_CUE_STORE_HISTORY 120000 //milliseconds of cues kept behind current fragment for seeks
 
-/// Variable initialization for supported cue line alignment values
-std::vector<std::string> allowedCueLineAligns = { "start", "center", "end" };
+#define VTT_SIGNATURE           "WEBVTT"
+#define VTT_TIMESTAMP_MAP       "X-TIMESTAMP-MAP="
+#define VTT_TIMESTAMP_LOCAL     "LOCAL:"
+#define VTT_TIMESTAMP_MPEGTS    "MPEGTS:"
+#define VTT_CUE_ARROW           "-->"
 
-/// Variable initialization for supported cue position alignment values
-std::vector<std::string> allowedCuePosAligns = { "line-left", "center", "line-right" };
 
-/// Variable initialization for supported cue text alignment values
-std::vector<std::string> allowedCueTextAligns = { "start", "center", "end", "left", "right" };
+/***************************************************************************
+* @fn startsWith
+* @brief Function to check if a line starts with given prefix
+* 
+* @param pos[in] start of line
+* @param end[in] end of line
+* @param prefix[in] prefix to compare
+* @return bool true if line starts with prefix
+***************************************************************************/
+static bool startsWith(const char *pos, const char *end, const char *prefix)
+{
+	size_t len = strlen(prefix);
+	return ((size_t)(end - pos) >= len && memcmp(pos, prefix, len) == 0);
+}
 
 
 /***************************************************************************
-* @fn parsePercentageValueSetting
-* @brief Function to parse the value in percentage format
+* @fn skipWebVTTBlanks
+* @brief Function to skip spaces and tabs in a line
 * 
-* @param settingValue[in] value to be parsed
-* @return char* pointer to the parsed value
+* @param pos[in] current position
+* @param end[in] end of line
+* @return const char* position of first non blank character
 ***************************************************************************/
-static char * parsePercentageValueSetting(char *settingValue)
+static const char * skipWebVTTBlanks(const char *pos, const char *end)
 {
-	char *ret = NULL;
-	char *percentageSym = strchr(settingValue, '%');
-	if ((std::isdigit( static_cast<unsigned char>(settingValue[0]) ) != 0) && (percentageSym != NULL))
+	while (pos < end && (*pos == CHAR_SPACE || *pos == CHAR_TAB))
 	{
-		*percentageSym = '\0';
-		ret = settingValue;
+		pos++;
 	}
-	return ret;
+	return pos;
 }
 
 
 /***************************************************************************
-* @fn findWebVTTLineBreak
-* @brief Function to extract a line from a VTT fragment
+* @fn readWebVTTLine
+* @brief Function to extract a line from a VTT fragment without modifying it
 * 
-* @param buffer[in] VTT data to extract from
-* @return char* pointer to extracted line
+* @param pos[in,out] VTT data to extract from, moved past the line terminator
+* @param end[in] end of VTT data
+* @param lineBegin[out] start of line
+* @param lineEnd[out] end of line, excluding line terminator
+* @return bool false if there is no more data
 ***************************************************************************/
-static char * findWebVTTLineBreak(char *buffer)
+static bool readWebVTTLine(const char *&pos, const char *end, const char *&lineBegin, const char *&lineEnd)
 {
+	if (pos >= end)
+	{
+		return false;
+	}
+	lineBegin = pos;
 	//VTT has CR and LF as line terminators or both
-	char *lineBreak = strpbrk(buffer, "\r\n");
-	char *next = NULL;
-	if (lineBreak)
+	while (pos < end && *pos != CHAR_CARRIAGE_RETURN && *pos != CHAR_LINE_FEED)
+	{
+		pos++;
+	}
+	lineEnd = pos;
+	if (pos < end)
 	{
-		next = lineBreak + 1;
 		//For CR, LF pair cases
-		if (*lineBreak == CHAR_CARRIAGE_RETURN && *next == CHAR_LINE_FEED)
+		if (*pos == CHAR_CARRIAGE_RETURN && (pos + 1) < end && pos[1] == CHAR_LINE_FEED)
 		{
-			next += 1;
+			pos++;
 		}
-		*lineBreak = '\0';
+		pos++;
 	}
-	return next;
+	return true;
 }
 
 
 /***************************************************************************
-* @fn convertHHMMSSToTime
-* @brief Function to convert time in HH:MM:SS.MS format to milliseconds
+* @fn parseWebVTTTimestamp
+* @brief Function to convert time in [HH:]MM:SS.MS format to milliseconds
 * 
-* @param str[in] time in HH:MM:SS.MS format
-* @return long long equivalent time in milliseconds
+* @param pos[in,out] start of timestamp, moved past it
+* @param end[in] end of line
+* @param timeValueMs[out] equivalent time in milliseconds
+* @return bool true if a timestamp was parsed
 ***************************************************************************/
-static long long convertHHMMSSToTime(char *str)
+static bool parseWebVTTTimestamp(const char *&pos, const char *end, long long &timeValueMs)
 {
-	long long timeValueMs = 0;
-	//HH:MM:SS.MS
-	char *args[4] = { str, NULL, NULL, NULL };
-	int argCount = 1;
-	while(*(++str) != '\0' && argCount < 4)
+	long long fields[3] = { 0, 0, 0 };
+	int fieldCount = 0;
+	while (pos < end && std::isdigit(static_cast<unsigned char>(*pos)) != 0 && fieldCount < 3)
+	{
+		long long value = 0;
+		while (pos < end && std::isdigit(static_cast<unsigned char>(*pos)) != 0)
+		{
+			value = (value * 10) + (*pos++ - '0');
+		}
+		fields[fieldCount++] = value;
+		if (pos < end && *pos == ':')
+		{
+			pos++;
+		}
+		else
+		{
+			break;
+		}
+	}
+
+	bool hasFraction = (pos < end && *pos == '.');
+	if (fieldCount == 0 || (fieldCount == 1 && !hasFraction))
+	{
+		return false;
+	}
+
+	long long fraction = 0;
+	int digits = 0;
+	if (hasFraction)
 	{
-		if(*str == ':' || *str == '.')
+		pos++;
+		while (pos < end && std::isdigit(static_cast<unsigned char>(*pos)) != 0)
 		{
-			args[argCount++] = (str + 1);
-			*str = '\0';
+			if (digits < 3)
+			{
+				fraction = (fraction * 10) + (*pos - '0');
+				digits++;
+			}
+			pos++;
 		}
 	}
+	for (; digits < 3; digits++)
+	{
+		fraction *= 10;
+	}
 
-	if (argCount == 1)
+	long long seconds = 0;
+	for (int i = 0; i < fieldCount; i++)
+	{
+		seconds = (seconds * 60) + fields[i];
+	}
+	timeValueMs = (seconds * 1000) + fraction;
+	return true;
+}
+
+
+/***************************************************************************
+* @fn parseWebVTTCueTiming
+* @brief Function to parse a cue timing line
+*        <start> --> <end> [settings]
+* 
+* @param pos[in] start of line
+* @param end[in] end of line
+* @param start[out] cue start time in milliseconds
+* @param endTime[out] cue end time in milliseconds
+* @param settings[out] start of cue settings
+* @return bool true if line is a cue timing line
+***************************************************************************/
+static bool parseWebVTTCueTiming(const char *pos, const char *end, long long &start, long long &endTime, const char *&settings)
+{
+	if (!parseWebVTTTimestamp(pos, end, start))
+	{
+		return false;
+	}
+	pos = skipWebVTTBlanks(pos, end);
+	if (!startsWith(pos, end, VTT_CUE_ARROW))
+	{
+		return false;
+	}
+	pos = skipWebVTTBlanks(pos + strlen(VTT_CUE_ARROW), end);
+	if (!parseWebVTTTimestamp(pos, end, endTime))
 	{
-		logprintf("%s:%d Unsupported value received!", __FUNCTION__, __LINE__);
+		return false;
 	}
-	//HH:MM:SS.MS
-	else
+	settings = skipWebVTTBlanks(pos, end);
+	return true;
+}
+
+
+/***************************************************************************
+* @fn appendWebVTTCueText
+* @brief Function to append cue payload, line terminators converted to LF
+* 
+* @param pos[in] start of payload
+* @param end[in] end of payload
+* @param text[in,out] string cue text is appended to
+* @return void
+***************************************************************************/
+static void appendWebVTTCueText(const char *pos, const char *end, std::string &text)
+{
+	const char *cr = (const char *)memchr(pos, CHAR_CARRIAGE_RETURN, end - pos);
+	if (cr == NULL)
+	{
+		text.append(pos, end);
+		return;
+	}
+	text.append(pos, cr);
+	for (pos = cr; pos < end; pos++)
+	{
+		if (*pos == CHAR_CARRIAGE_RETURN)
+		{
+			text.push_back(CHAR_LINE_FEED);
+			if ((pos + 1) < end && pos[1] == CHAR_LINE_FEED)
+			{
+				pos++;
+			}
+		}
+		else
+		{
+			text.push_back(*pos);
+		}
+	}
+}
+
+
+/***************************************************************************
+* @fn toCue
+* @brief Copy cue out of its arena
+* 
+* @return VTTCue cue to deliver
+***************************************************************************/
+VTTCue VTTStoredCue::toCue() const
+{
+	return VTTCue(mStart, mDuration, mArena->substr(mTextOffset, mTextLength), mArena->substr(mSettingsOffset, mSettingsLength));
+}
+
+
+/***************************************************************************
+* @fn VTTCueStore
+* @brief Constructor function
+* 
+* @return void
+***************************************************************************/
+VTTCueStore::VTTCueStore() : mCues(), mMaxDuration(0), mDeliveryId(0), mMutex()
+{
+	pthread_mutex_init(&mMutex, NULL);
+}
+
+
+/***************************************************************************
+* @fn ~VTTCueStore
+* @brief Destructor function
+* 
+* @return void
+***************************************************************************/
+VTTCueStore::~VTTCueStore()
+{
+	pthread_mutex_destroy(&mMutex);
+}
+
+
+/***************************************************************************
+* @fn beginDelivery
+* @brief Start a new delivery, cues sent before are sent again when parsed
+*        or queried
+* 
+* @return void
+***************************************************************************/
+void VTTCueStore::beginDelivery()
+{
+	pthread_mutex_lock(&mMutex);
+	mDeliveryId++;
+	pthread_mutex_unlock(&mMutex);
+}
+
+
+/***************************************************************************
+* @fn firstActiveCandidate
+* @brief Get first cue that can be active at a position, called with mMutex held
+* 
+* @param position[in] position in milliseconds
+* @return iterator to first cue starting within max duration before position
+***************************************************************************/
+std::vector<VTTStoredCue>::iterator VTTCueStore::firstActiveCandidate(double position)
+{
+	//No cue starting before this can be active
+	return std::lower_bound(mCues.begin(), mCues.end(), position - mMaxDuration,
+			[](const VTTStoredCue &c, double t) { return c.mStart < t; });
+}
+
+
+/***************************************************************************
+* @fn insert
+* @brief Add cues of a fragment to store
+*
+* A cue advertised again, in this or a later fragment, is sent only if it
+* was not sent in current delivery.
+* 
+* @param cues[in,out] cues parsed from a fragment, moved to the store
+* @param newCues[out] cues to send
+* @return void
+***************************************************************************/
+void VTTCueStore::insert(std::vector<VTTStoredCue> &cues, std::vector<VTTCue> &newCues)
+{
+	pthread_mutex_lock(&mMutex);
+	for (VTTStoredCue &cue : cues)
 	{
-		timeValueMs = atoll(args[--argCount]);
-		int multiplier = 1;
-		while (argCount > 0)
+		bool found = false;
+		std::vector<VTTStoredCue>::iterator it = firstActiveCandidate(cue.mStart);
+		for (; it != mCues.end() && it->mStart <= cue.mStart; it++)
+		{
+			if (it->mStart == cue.mStart && it->mDuration == cue.mDuration)
+			{
+				found = true;
+				break;
+			}
+		}
+		if (found)
 		{
-			timeValueMs += (atoll(args[--argCount]) * multiplier * 1000);
-			if (argCount > 0)
+			if (it->mDeliveryId != mDeliveryId)
 			{
-				multiplier *= 60;
+				it->mDeliveryId = mDeliveryId;
+				newCues.push_back(it->toCue());
 			}
+			continue;
 		}
+		cue.mDeliveryId = mDeliveryId;
+		newCues.push_back(cue.toCue());
+		//Cues mostly arrive in order, so this is an append
+		it = std::upper_bound(mCues.begin(), mCues.end(), cue.mStart,
+				[](double t, const VTTStoredCue &c) { return t < c.mStart; });
+		mMaxDuration = std::max(mMaxDuration, cue.mDuration);
+		mCues.insert(it, std::move(cue));
 	}
-	return timeValueMs;
+	pthread_mutex_unlock(&mMutex);
+	cues.clear();
+}
+
+
+/***************************************************************************
+* @fn getActiveCues
+* @brief Get cues active at a position, they count as sent in current delivery
+* 
+* @param position[in] position in milliseconds
+* @param cues[out] cues with start <= position <= start + duration
+* @return void
+***************************************************************************/
+void VTTCueStore::getActiveCues(double position, std::vector<VTTCue> &cues)
+{
+	pthread_mutex_lock(&mMutex);
+	std::vector<VTTStoredCue>::iterator it = firstActiveCandidate(position);
+	for (; it != mCues.end() && it->mStart <= position; it++)
+	{
+		if (it->mStart + it->mDuration >= position)
+		{
+			it->mDeliveryId = mDeliveryId;
+			cues.push_back(it->toCue());
+		}
+	}
+	pthread_mutex_unlock(&mMutex);
+}
+
+
+/***************************************************************************
+* @fn evict
+* @brief Remove cues ended before a position
+* 
+* @param position[in] position in milliseconds
+* @return void
+***************************************************************************/
+void VTTCueStore::evict(double position)
+{
+	pthread_mutex_lock(&mMutex);
+	std::vector<VTTStoredCue>::iterator last = std::upper_bound(mCues.begin(), mCues.end(), position,
+			[](double t, const VTTStoredCue &c) { return t < c.mStart; });
+	//Only cues started before position can have ended; remove_if keeps them in order
+	mCues.erase(std::remove_if(mCues.begin(), last,
+			[position](const VTTStoredCue &c) { return (c.mStart + c.mDuration) < position; }), last);
+	pthread_mutex_unlock(&mMutex);
+}
+
+
+/***************************************************************************
+* @fn clear
+* @brief Remove all cues
+* 
+* @return void
+***************************************************************************/
+void VTTCueStore::clear()
+{
+	pthread_mutex_lock(&mMutex);
+	mCues.clear();
+	mMaxDuration = 0;
+	pthread_mutex_unlock(&mMutex);
 }
 
 
@@ -162,11 +450,12 @@ static gboolean SendVttCueToExt(gpointer user_data)
 ***************************************************************************/
 WebVTTParser::WebVTTParser(PrivateInstanceAAMP *aamp, SubtitleMimeType type) : SubtitleParser(aamp, type),
 	mStartPTS(0), mCurrentPos(0), mStartPos(0), mPtsOffset(0),
-	mReset(true), mVttQueue(), mVttQueueIdleTaskId(0), mVttQueueMutex(), lastCue(),
+	mReset(true), mActiveCuesSent(false), mCueStore(aamp->GetVTTCueStore()), mVttQueue(), mVttQueueIdleTaskId(0), mVttQueueMutex(),
 	mProgressOffset(0)
 {
 	pthread_mutex_init(&mVttQueueMutex, NULL);
-	lastCue = { 0, 0 };
+	//App has flushed cues of previous parser, if any
+	mCueStore->beginDelivery();
 }
 
 
@@ -202,6 +491,15 @@ bool WebVTTParser::init(double startPos, unsigned long long basePTS)
 	}
 
 	logprintf("WebVTTParser::%s %d startPos:%.3f and mStartPTS:%lld", __FUNCTION__, __LINE__, startPos, mStartPTS);
+	if (!mActiveCuesSent)
+	{
+		//Cues parsed before a seek which are still active at the new position
+		std::vector<VTTCue> cues;
+		mCueStore->getActiveCues(startPos - mProgressOffset, cues);
+		logprintf("WebVTTParser::%s %d %d cues active at start", __FUNCTION__, __LINE__, (int)cues.size());
+		addCueBatch(cues);
+		mActiveCuesSent = true;
+	}
 	//We are ready to receive data, unblock in PrivateInstanceAAMP
 	mAamp->ResumeTrackDownloads(eMEDIATYPE_SUBTITLE);
 	return ret;
@@ -211,6 +509,9 @@ bool WebVTTParser::init(double startPos, unsigned long long basePTS)
 /***************************************************************************
 * @fn processData
 * @brief Parse incoming VTT data
+*
+* Data is tokenized in a single pass and is not modified. Cues of the
+* buffer are queued as one batch.
 * 
 * @param buffer[in] input VTT data
 * @param bufferLen[in] data length
@@ -218,9 +519,13 @@ bool WebVTTParser::init(double startPos, unsigned long long basePTS)
 * @param duration[in] duration of buffer
 * @return bool true if successful, false otherwise
 ***************************************************************************/
-bool WebVTTParser::processData(char* buffer, size_t bufferLen, double position, double duration)
+bool WebVTTParser::processData(const char* buffer, size_t bufferLen, double position, double duration)
 {
 	bool ret = false;
+	const char *pos = buffer;
+	const char *end = buffer + bufferLen;
+	const char *lineBegin = NULL;
+	const char *lineEnd = NULL;
 
 	traceprintf("WebVTTParser::%s %d Enter with position:%.3f and duration:%.3f ", __FUNCTION__, __LINE__, position, duration);
 
@@ -232,163 +537,99 @@ bool WebVTTParser::processData(char* buffer, size_t bufferLen, double position,
 	}
 
 	//Check for VTT signature at the start of buffer
-	if (bufferLen > 6)
+	if (bufferLen > 6 && readWebVTTLine(pos, end, lineBegin, lineEnd))
 	{
-		char *next = findWebVTTLineBreak(buffer);
-		if (next && strlen(buffer) >= 6)
+		//VTT is UTF-8 encoded and BOM is 0xEF,0xBB,0xBF
+		if (startsWith(lineBegin, lineEnd, "\xEF\xBB\xBF"))
 		{
-			char *token = strtok(buffer, " \t\n\r");
-			//VTT is UTF-8 encoded and BOM is 0xEF,0xBB,0xBF
-			if ((unsigned char) token[0] == 0xEF && (unsigned char) token[1] == 0xBB && (unsigned char) token[2] == 0xBF)
-			{
-				//skip BOM
-				token += 3;
-			}
-			if (strlen(token) == 6 && strncmp(token, "WEBVTT", 6) == 0)
-			{
-				buffer = next;
-				ret = true;
-			}
+			//skip BOM
+			lineBegin += 3;
+		}
+		lineBegin = skipWebVTTBlanks(lineBegin, lineEnd);
+		if (startsWith(lineBegin, lineEnd, VTT_SIGNATURE))
+		{
+			const char *next = lineBegin + strlen(VTT_SIGNATURE);
+			ret = (next == lineEnd || *next == CHAR_SPACE || *next == CHAR_TAB);
 		}
 	}
 
 	if (ret)
 	{
-		while (buffer)
+		//Text and settings of all cues of the buffer go to one arena
+		std::shared_ptr<std::string> arena = std::make_shared<std::string>();
+		std::vector<VTTStoredCue> parsedCues;
+		arena->reserve(bufferLen);
+		//Keep cues a seek back may find active
+		mCueStore->evict((position * 1000) - mProgressOffset - VTT_CUE_STORE_HISTORY);
+
+		while (readWebVTTLine(pos, end, lineBegin, lineEnd))
 		{
-			char *nextLine = findWebVTTLineBreak(buffer);
+			long long start = -1;
+			long long endTime = -1;
+			const char *settings = NULL;
 			//TODO: Parse CUE ID
 
-			if (strstr(buffer, "X-TIMESTAMP-MAP") != NULL && mPtsOffset == 0)
+			if (mPtsOffset == 0 && startsWith(lineBegin, lineEnd, VTT_TIMESTAMP_MAP))
 			{
 				unsigned long long mpegTime = 0;
-				unsigned long long localTime = 0;
+				long long localTime = 0;
 				//Found X-TIMESTAMP-MAP=LOCAL:<cue time>,MPEGTS:<MPEG-2 time>
-				char* token = strtok(buffer, "=,");
-				while (token)
+				const char *token = lineBegin + strlen(VTT_TIMESTAMP_MAP);
+				while (token < lineEnd)
 				{
-					if (token[0] == 'L')
+					if (startsWith(token, lineEnd, VTT_TIMESTAMP_LOCAL))
 					{
-						localTime = convertHHMMSSToTime(token + 6);
+						token += strlen(VTT_TIMESTAMP_LOCAL);
+						parseWebVTTTimestamp(token, lineEnd, localTime);
 					}
-					else if (token[0] == 'M')
+					else if (startsWith(token, lineEnd, VTT_TIMESTAMP_MPEGTS))
 					{
-						mpegTime = atoll(token + 7);
+						token += strlen(VTT_TIMESTAMP_MPEGTS);
+						while (token < lineEnd && std::isdigit(static_cast<unsigned char>(*token)) != 0)
+						{
+							mpegTime = (mpegTime * 10) + (*token++ - '0');
+						}
 					}
-					token = strtok(NULL, "=,");
+					const char *comma = (const char *)memchr(token, ',', lineEnd - token);
+					token = comma ? (comma + 1) : lineEnd;
 				}
 				mPtsOffset = (mpegTime / 90) - localTime; //in milliseconds
 				logprintf("Parsed local time:%lld and PTS:%lld and cuePTSOffset:%lld", localTime, mpegTime, mPtsOffset);
 			}
-			else if (strstr(buffer, " --> ") != NULL)
+			else if (parseWebVTTCueTiming(lineBegin, lineEnd, start, endTime, settings))
 			{
-				AAMPLOG_INFO("Found cue:%s", buffer);
-				long long start = -1;
-				long long end = -1;
-				char *text = NULL;
-				//cue settings
-				char *cueLine = NULL; //default "auto"
-				char *cueLineAlign = NULL; //default "start"
-				char *cuePosition = NULL; //default "auto"
-				char *cuePosAlign = NULL; //default "auto"
-				char *cueSize = NULL; //default 100
-				char *cueTextAlign = NULL; //default "center"
-
-				char *token = strtok(buffer, " -->\t");
-				while (token != NULL)
+				AAMPLOG_INFO("Found cue:%.*s", (int)(lineEnd - lineBegin), lineBegin);
+				size_t settingsOffset = arena->size();
+				arena->append(settings, lineEnd);
+
+				//Cue payload runs till an empty line or end of data
+				const char *textBegin = pos;
+				const char *textEnd = pos;
+				while (readWebVTTLine(pos, end, lineBegin, lineEnd) && lineBegin != lineEnd)
 				{
-					traceprintf("Inside tokenizer, token:%s", token);
-					if (std::isdigit( static_cast<unsigned char>(token[0]) ) != 0)
-					{
-						if (start == -1)
-						{
-							start = convertHHMMSSToTime(token);
-						}
-						else if (end == -1)
-						{
-							end = convertHHMMSSToTime(token);
-						}
-					}
-					//TODO:parse cue settings
-					else
-					{
-						//for setting ':' is the delimiter
-						char *key = token;
-						char *value = strchr(token, ':');
-						if (value != NULL)
-						{
-							*value = '\0';
-							value++;
-							if (strncmp(key, "line", 4) == 0)
-							{
-								char *lineAlign = strchr(value, ',');
-								if (lineAlign != NULL)
-								{
-									*lineAlign = '\0';
-									lineAlign++;
-									if (std::find(allowedCueLineAligns.begin(), allowedCueLineAligns.end(), lineAlign) != allowedCueLineAligns.end())
-									{
-										cueLineAlign = lineAlign;
-									}
-								}
-								cueLine = parsePercentageValueSetting(value);
-							}
-							else if (strncmp(key, "position", 8) == 0)
-							{
-								char *posAlign = strchr(value, ',');
-								if (posAlign != NULL)
-								{
-									*posAlign = '\0';
-									posAlign++;
-									if (std::find(allowedCuePosAligns.begin(), allowedCuePosAligns.end(), posAlign) != allowedCuePosAligns.end())
-									{
-										cuePosAlign = posAlign;
-									}
-								}
-								cuePosition = parsePercentageValueSetting(value);
-							}
-							else if (strncmp(key, "size", 4) == 0)
-							{
-								cueSize = parsePercentageValueSetting(value);
-							}
-							else if (strncmp(key, "align", 5) == 0)
-							{
-								if (std::find(allowedCueTextAligns.begin(), allowedCueTextAligns.end(), value) != allowedCueTextAligns.end())
-								{
-									cueTextAlign = value;
-								}
-							}
-						}
-					}
-					token = strtok(NULL, " -->\t");
+					traceprintf("Found nextLine:%.*s", (int)(lineEnd - lineBegin), lineBegin);
+					textEnd = lineEnd;
 				}
+				size_t textOffset = arena->size();
+				appendWebVTTCueText(textBegin, textEnd, *arena);
 
-				text = nextLine;
-				nextLine = findWebVTTLineBreak(nextLine);
-
-				while(nextLine && (*nextLine != CHAR_LINE_FEED && *nextLine != CHAR_CARRIAGE_RETURN && *nextLine != '\0'))
-				{
-					traceprintf("Found nextLine:%s", nextLine);
-					if (nextLine[-1] == '\0')
-					{
-						nextLine[-1] = '\n';
-					}
-					else if (nextLine[-2] == '\0')
-					{
-						nextLine[-1] = '\r';
-					}
-					nextLine = findWebVTTLineBreak(nextLine);
-				}
 				double cueStartInMpegTime = (start + mPtsOffset);
-				double duration = (end - start);
+				double duration = (endTime - start);
 				double mpegTimeOffset = cueStartInMpegTime - (mStartPTS / 90);
 				double relativeStartPos = mStartPos + mpegTimeOffset; //w.r.t to position in reportProgress
 				AAMPLOG_INFO("So found cue with startPTS:%.3f and duration:%.3f, and mpegTimeOffset:%.3f and relative time being:%.3f", cueStartInMpegTime/1000.0, duration/1000.0, mpegTimeOffset/1000.0, relativeStartPos/1000.0);
-				addCueData(new VTTCue(relativeStartPos, duration, std::string(text), std::string()));
+				parsedCues.emplace_back(relativeStartPos, duration, textOffset, arena->size() - textOffset,
+						settingsOffset, textOffset - settingsOffset);
 			}
-
-			buffer = nextLine;
 		}
+		arena->shrink_to_fit();
+		for (VTTStoredCue &cue : parsedCues)
+		{
+			cue.mArena = arena;
+		}
+		std::vector<VTTCue> cues;
+		mCueStore->insert(parsedCues, cues);
+		addCueBatch(cues);
 	}
 	mCurrentPos = (position + duration) * 1000.0;
 	traceprintf("%s:%d ################# Exit sub PTS:%.3f", __FUNCTION__, __LINE__, mCurrentPos);
@@ -413,19 +654,10 @@ bool WebVTTParser::close()
 	}
 
 	pthread_mutex_lock(&mVttQueueMutex);
-	if (!mVttQueue.empty())
-	{
-		while(mVttQueue.size() > 0)
-		{
-			VTTCue *cue = mVttQueue.front();
-			mVttQueue.pop();
-			delete cue;
-		}
-	}
+	mVttQueue.clear();
 	pthread_mutex_unlock(&mVttQueueMutex);
 
-	lastCue.mStart = 0;
-	lastCue.mDuration = 0;
+	//Cue store is kept for the next parser of this track, seeks query it
 	mProgressOffset = 0;
 
 	return ret;
@@ -456,52 +688,53 @@ void WebVTTParser::reset()
 
 
 /***************************************************************************
-* @fn addCueData
-* @brief Add cue to queue
+* @fn addCueBatch
+* @brief Queue cues parsed from a fragment
 * 
-* @param cue[in] pointer to cue to store
+* @param cues[in,out] cues to queue, moved to the queue
 * @return void
 ***************************************************************************/
-void WebVTTParser::addCueData(VTTCue *cue)
+void WebVTTParser::addCueBatch(std::vector<VTTCue> &cues)
 {
-	if (lastCue.mStart != cue->mStart || lastCue.mDuration != cue->mDuration)
+	if (!cues.empty())
 	{
 		pthread_mutex_lock(&mVttQueueMutex);
-		mVttQueue.push(cue);
+		mVttQueue.push_back(std::move(cues));
 		pthread_mutex_unlock(&mVttQueueMutex);
 	}
-	lastCue.mStart = cue->mStart;
-	lastCue.mDuration = cue->mDuration;
 }
 
 
 /***************************************************************************
 * @fn sendCueData
 * @brief Send cues stored in queue to AAMP
+*
+* Queued batches are taken in one go, so the parser is not blocked while
+* listeners handle the cues.
 * 
 * @return void
 ***************************************************************************/
 void WebVTTParser::sendCueData()
 {
+	std::vector<std::vector<VTTCue> > batches;
 	pthread_mutex_lock(&mVttQueueMutex);
-	if (!mVttQueue.empty())
+	batches.swap(mVttQueue);
+	pthread_mutex_unlock(&mVttQueueMutex);
+
+	for (std::vector<VTTCue> &cues : batches)
 	{
-		while(mVttQueue.size() > 0)
+		for (VTTCue &cue : cues)
 		{
-			VTTCue *cue = mVttQueue.front();
-			mVttQueue.pop();
-			if (cue->mStart > 0)
+			if (cue.mStart > 0)
 			{
-				mAamp->SendVTTCueDataAsEvent(cue);
+				mAamp->SendVTTCueDataAsEvent(&cue);
 			}
 			else
 			{
-				logprintf("Discarding cue with start:%.3f and text:%s", cue->mStart/1000.0, cue->mText.c_str());
+				logprintf("Discarding cue with start:%.3f and text:%s", cue.mStart/1000.0, cue.mText.c_str());
 			}
-			delete cue;
 		}
 	}
-	pthread_mutex_unlock(&mVttQueueMutex);
 }
 
 /**
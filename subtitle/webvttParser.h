@@ -27,24 +27,77 @@
 #ifndef __WEBVTT_PARSER_H__
 #define __WEBVTT_PARSER_H__
 
-#include <queue>
+#include <vector>
+#include <memory>
+#include <string>
 #include <pthread.h>
 #include "subtitleParser.h"
 #include "vttCue.h"
 
 
 /**
-* \struct      CueTimeStamp
-* \brief       Hold timestamps of a cue
+* \struct      VTTStoredCue
+* \brief       Cue held in VTTCueStore
 *
-* Structure to hold timestamps of previously parsed cues
-* This is required since in playlists a single cue may be
-* advertised twice
+* Text and settings are spans of the arena of the fragment the cue was
+* parsed from, so a fragment needs one allocation for all its cues. The
+* arena is freed along with the last of its cues.
 */
-typedef struct {
-	double mStart;
-	double mDuration;
-} CueTimeStamp;
+struct VTTStoredCue
+{
+	VTTStoredCue(double start, double duration, size_t textOffset, size_t textLength, size_t settingsOffset, size_t settingsLength) :
+		mStart(start), mDuration(duration), mArena(), mTextOffset(textOffset), mTextLength(textLength),
+		mSettingsOffset(settingsOffset), mSettingsLength(settingsLength), mDeliveryId(0)
+	{
+	}
+
+	VTTCue toCue() const;
+
+	double mStart;                              //start w.r.t position in reportProgress, milliseconds
+	double mDuration;                           //duration in milliseconds
+	std::shared_ptr<const std::string> mArena;  //text and settings of cues of a fragment
+	size_t mTextOffset;
+	size_t mTextLength;
+	size_t mSettingsOffset;
+	size_t mSettingsLength;
+	unsigned int mDeliveryId;                   //delivery the cue was last sent in
+};
+
+
+/**
+* \class       VTTCueStore
+* \brief       Time indexed store of parsed cues
+*
+* Cues are kept sorted by start time along with the longest cue duration,
+* so cues active at a position are found by a binary search and a scan of
+* the cues that started within one max duration before it. The store lives
+* across seeks of a tune; cues are sent once per delivery, a delivery
+* starting whenever the app has flushed its cues.
+*/
+class VTTCueStore
+{
+
+public:
+	VTTCueStore();
+	~VTTCueStore();
+
+	VTTCueStore(const VTTCueStore&) = delete;
+	VTTCueStore& operator=(const VTTCueStore&) = delete;
+
+	void beginDelivery();
+	void insert(std::vector<VTTStoredCue> &cues, std::vector<VTTCue> &newCues);
+	void getActiveCues(double position, std::vector<VTTCue> &cues);
+	void evict(double position);
+	void clear();
+
+private:
+	std::vector<VTTStoredCue>::iterator firstActiveCandidate(double position);
+
+	std::vector<VTTStoredCue> mCues;    //cues, sorted by start
+	double mMaxDuration;                //longest cue duration in store
+	unsigned int mDeliveryId;           //current delivery
+	pthread_mutex_t mMutex;             //store is used by injector and first PTS notification
+};
 
 
 /**
@@ -61,12 +114,12 @@ public:
 	~WebVTTParser();
 
 	bool init(double startPos, unsigned long long basePTS);
-	bool processData(char *buffer, size_t bufferLen, double position, double duration);
+	bool processData(const char *buffer, size_t bufferLen, double position, double duration);
 	bool close();
 	void reset();
 	void setProgressEventOffset(double offset) { mProgressOffset = offset; }
 
-	void addCueData(VTTCue *cue);
+	void addCueBatch(std::vector<VTTCue> &cues);
 	void sendCueData();
 
 private:
@@ -75,10 +128,11 @@ private:
 	double mStartPos;               //position of first fragment in playlist
 	double mCurrentPos;             //current fragment position in playlist
 	bool mReset;                    //true if waiting for first fragment after processing a discontinuity or at start
+	bool mActiveCuesSent;           //cues active at start position were queued
 
-	CueTimeStamp lastCue;           //holds timestamp of last parsed cue
+	std::shared_ptr<VTTCueStore> mCueStore;  //cues of current subtitle track, kept across seeks
 
-	std::queue<VTTCue*> mVttQueue;  //queue for storing parsed cues
+	std::vector<std::vector<VTTCue> > mVttQueue;  //batches of parsed cues, one per fragment
 	guint mVttQueueIdleTaskId;      //task id for handler that sends cues upstream
 	pthread_mutex_t mVttQueueMutex; //mutex for synchronising queue access
 	double mProgressOffset;         //offset value in progress event compared to playlist position
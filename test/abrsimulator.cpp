@@ -0,0 +1,531 @@
+/*
+ * If not stated otherwise in this file or this component's license file the
+ * following copyright and licenses apply:
+ *
+ * Copyright 2020 RDK Management
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ * http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+*/
+
+/**
+ * @file abrsimulator.cpp
+ * @brief Offline replay of bandwidth traces against a profile ladder with the default ABRManager path
+ *        and the built-in ABR strategies
+ *
+ * Trace file has one "<duration seconds> <bandwidth kbps>" pair per line, '#' starts a comment.
+ * Trace is looped if playback outlasts it. Fragment downloads consume the trace in order, the
+ * player drains buffer in real time once startup buffer is reached, and bandwidth is estimated
+ * as the player does: average of the last abr-cache-length fragment download samples.
+ */
+
+#include "../AampAbrStrategy.h"
+#include <ABRManager.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <math.h>
+#include <algorithm>
+#include <string>
+#include <vector>
+
+#define SIM_DEFAULT_FRAGMENT_DURATION 2.0   /**< Fragment duration in seconds */
+#define SIM_DEFAULT_MAX_BUFFER 30.0         /**< Max buffered duration in seconds */
+#define SIM_DEFAULT_MIN_BUFFER 10.0         /**< Default min-buffer-rampdown of player */
+#define SIM_DEFAULT_TARGET_BUFFER 15.0      /**< Default max-buffer-rampup of player */
+#define SIM_DEFAULT_FRAGMENT_COUNT 300      /**< Fragments played per run */
+#define SIM_ABR_CACHE_LENGTH 3              /**< Bandwidth samples averaged, as abr-cache-length */
+#define SIM_ABR_NW_CONSISTENCY 2            /**< Default abr-nw-consistency of player */
+#define SIM_NETWORK_TIMEOUT 10.0            /**< Default network timeout of player in seconds */
+
+/**
+ * @brief Segment of bandwidth trace
+ */
+struct TraceSegment
+{
+	double duration;    /**< Seconds */
+	double bps;         /**< Bandwidth in bits per second */
+};
+
+/**
+ * @brief Result of a simulation run
+ */
+struct SimResult
+{
+	double avgBitrate;      /**< Average bitrate of played fragments in bps */
+	int switches;           /**< Number of profile changes */
+	double rebufferSeconds; /**< Time spent stalled after startup */
+	int stalls;             /**< Number of stalls after startup */
+	double startupSeconds;  /**< Time to startup buffer */
+};
+
+/**
+ * @brief Bandwidth trace, consumed in time order and looped
+ */
+class Trace
+{
+public:
+	Trace() : mSegments(), mTotal(0)
+	{
+	}
+
+	/**
+	 * @brief Load trace from file
+	 * @param path trace file
+	 * @retval true on success
+	 */
+	bool Load(const char *path)
+	{
+		FILE *f = fopen(path, "r");
+		if (!f)
+		{
+			fprintf(stderr, "Cannot open trace %s\n", path);
+			return false;
+		}
+		char line[256];
+		while (fgets(line, sizeof(line), f))
+		{
+			char *comment = strchr(line, '#');
+			if (comment)
+			{
+				*comment = '\0';
+			}
+			TraceSegment seg;
+			double kbps;
+			if (sscanf(line, "%lf %lf", &seg.duration, &kbps) == 2 && seg.duration > 0 && kbps >= 0)
+			{
+				seg.bps = kbps * 1000;
+				mSegments.push_back(seg);
+				mTotal += seg.duration;
+			}
+		}
+		fclose(f);
+		if (mSegments.empty())
+		{
+			fprintf(stderr, "No samples in trace %s\n", path);
+			return false;
+		}
+		return true;
+	}
+
+	/**
+	 * @brief Get time needed to download bits starting at a given time
+	 * @param start start time in seconds
+	 * @param bits bits to download
+	 * @retval download duration in seconds
+	 */
+	double DownloadTime(double start, double bits) const
+	{
+		double t = start;
+		while (bits > 0)
+		{
+			double offset = fmod(t, mTotal);
+			size_t i = 0;
+			double segStart = 0;
+			while (i + 1 < mSegments.size() && segStart + mSegments[i].duration <= offset)
+			{
+				segStart += mSegments[i].duration;
+				i++;
+			}
+			double remaining = segStart + mSegments[i].duration - offset;
+			double capacity = remaining * mSegments[i].bps;
+			if (capacity >= bits)
+			{
+				t += bits / mSegments[i].bps;
+				bits = 0;
+			}
+			else
+			{
+				t += remaining;
+				bits -= capacity;
+			}
+		}
+		return t - start;
+	}
+
+private:
+	std::vector<TraceSegment> mSegments;    /**< trace segments in time order */
+	double mTotal;                          /**< trace duration in seconds */
+};
+
+/**
+ * @brief Default ABR of player, ABRManager rules with buffer checks
+ *
+ * Mirrors StreamAbstractionAAMP::GetDesiredProfileBasedOnCache with ABR buffer
+ * check enabled: ABRManager::getProfileIndexByBitrateRampUpOrDown followed by
+ * GetDesiredProfileOnBuffer and GetDesiredProfileOnSteadyState.
+ */
+class SimDefaultAbr : public AampAbrStrategy
+{
+public:
+	/**
+	 * @brief SimDefaultAbr constructor
+	 * @param ladder profiles, profile indices are 0 to size - 1
+	 * @param minBuffer min-buffer-rampdown
+	 * @param targetBuffer max-buffer-rampup
+	 */
+	SimDefaultAbr(const std::vector<AbrLadderProfile> &ladder, double minBuffer, double targetBuffer) : mAbrManager(),
+		mBandwidth(ladder.size()), mMinBuffer(minBuffer), mTargetBuffer(targetBuffer), mNwConsistencyBypass(true),
+		mHighBufferCounter(0), mLowBufferCounter(0), mMaxBufferCountCheck(SIM_ABR_CACHE_LENGTH), mRampUpLoop(1)
+	{
+		for (const AbrLadderProfile &p : ladder)
+		{
+			mBandwidth[p.profileIndex] = p.bandwidthBitsPerSecond;
+		}
+		// ABRManager profile index is the order of addProfile
+		for (long bandwidth : mBandwidth)
+		{
+			mAbrManager.addProfile({ false, bandwidth, 0, 0 });
+		}
+		mAbrManager.updateProfile();
+	}
+
+	int GetDesiredProfile(const AbrStrategyInput &input) override;
+	const char *GetName() const override { return "default"; }
+
+private:
+	ABRManager mAbrManager;         /**< ABR rules of player */
+	std::vector<long> mBandwidth;   /**< bandwidth by profile index */
+	double mMinBuffer;              /**< min-buffer-rampdown */
+	double mTargetBuffer;           /**< max-buffer-rampup */
+	bool mNwConsistencyBypass;      /**< first decision ignores network consistency */
+	int mHighBufferCounter;         /**< decisions with buffer above mTargetBuffer */
+	int mLowBufferCounter;          /**< decisions with low buffer and no bandwidth estimate */
+	int mMaxBufferCountCheck;       /**< high buffer decisions before steady state rampup */
+	int mRampUpLoop;                /**< steady state rampup back off exponent */
+};
+
+/**
+ * @brief Select profile as StreamAbstractionAAMP::GetDesiredProfileBasedOnCache does
+ * @param input player state
+ * @retval profile index of desired profile
+ */
+int SimDefaultAbr::GetDesiredProfile(const AbrStrategyInput &input)
+{
+	int current = input.currentProfileIndex;
+	long currentBandwidth = mBandwidth[current];
+	long networkBandwidth = input.networkBandwidth;
+	int nwConsistencyCnt = mNwConsistencyBypass ? 1 : SIM_ABR_NW_CONSISTENCY;
+	int desired = mAbrManager.getProfileIndexByBitrateRampUpOrDown(current, currentBandwidth, networkBandwidth, nwConsistencyCnt);
+	double buffer = input.bufferedSeconds;
+
+	if (!mNwConsistencyBypass)
+	{
+		// GetDesiredProfileOnBuffer
+		if (desired != current && buffer > 0)
+		{
+			if (mBandwidth[desired] > currentBandwidth)
+			{
+				if (buffer < mTargetBuffer)
+				{
+					desired = current;
+				}
+			}
+			else
+			{
+				double minBufferNeeded = input.fragmentDurationSeconds + SIM_NETWORK_TIMEOUT;
+				if (buffer > minBufferNeeded && mAbrManager.getRampedDownProfileIndex(current) == desired)
+				{
+					desired = current;
+				}
+			}
+		}
+
+		// GetDesiredProfileOnSteadyState
+		if (buffer > 0 && desired == current)
+		{
+			if (buffer > mTargetBuffer)
+			{
+				mHighBufferCounter++;
+				mLowBufferCounter = 0;
+				if (mHighBufferCounter > mMaxBufferCountCheck)
+				{
+					int up = mAbrManager.getRampedUpProfileIndex(current);
+					if (mBandwidth[up] - networkBandwidth < 2000000)
+					{
+						desired = up;
+					}
+					if (desired != current)
+					{
+						mRampUpLoop = (mRampUpLoop + 1 > 4) ? 1 : mRampUpLoop + 1;
+						mMaxBufferCountCheck = (int)pow(SIM_ABR_CACHE_LENGTH, mRampUpLoop);
+					}
+					mHighBufferCounter = 0;
+				}
+			}
+			if (networkBandwidth == -1 && buffer < mMinBuffer)
+			{
+				mLowBufferCounter++;
+				mHighBufferCounter = 0;
+				if (mLowBufferCounter > SIM_ABR_CACHE_LENGTH)
+				{
+					desired = mAbrManager.getRampedDownProfileIndex(current);
+					mLowBufferCounter = 0;
+				}
+			}
+		}
+		else
+		{
+			mLowBufferCounter = 0;
+			mHighBufferCounter = 0;
+		}
+	}
+	mNwConsistencyBypass = false;
+	return desired;
+}
+
+/**
+ * @brief Simulation parameters
+ */
+struct SimConfig
+{
+	SimConfig() : ladder(), fragmentDuration(SIM_DEFAULT_FRAGMENT_DURATION), maxBuffer(SIM_DEFAULT_MAX_BUFFER),
+		minBuffer(SIM_DEFAULT_MIN_BUFFER), targetBuffer(SIM_DEFAULT_TARGET_BUFFER), fragmentCount(SIM_DEFAULT_FRAGMENT_COUNT), verbose(false)
+	{
+	}
+
+	std::vector<AbrLadderProfile> ladder;   /**< profile ladder, ascending */
+	double fragmentDuration;                /**< fragment duration in seconds */
+	double maxBuffer;                       /**< max buffered duration */
+	double minBuffer;                       /**< BOLA min buffer, min-buffer-rampdown of default ABR */
+	double targetBuffer;                    /**< BOLA target buffer, max-buffer-rampup of default ABR */
+	int fragmentCount;                      /**< fragments per run */
+	bool verbose;                           /**< print per fragment decisions */
+};
+
+/**
+ * @brief Replay trace with a strategy
+ * @param cfg simulation parameters
+ * @param trace bandwidth trace
+ * @param strategy ABR strategy, deleted after run
+ * @retval result of run
+ */
+static SimResult Simulate(const SimConfig &cfg, const Trace &trace, AampAbrStrategy *strategy)
+{
+	SimResult result = {};
+	std::vector<double> samples;
+	double now = 0;
+	double buffer = 0;
+	bool playing = false;
+	bool started = false;
+	double bitrateSum = 0;
+	int profile = cfg.ladder[0].profileIndex;
+
+	for (int frag = 0; frag < cfg.fragmentCount; frag++)
+	{
+		if (playing && buffer + cfg.fragmentDuration > cfg.maxBuffer)
+		{
+			// Fetcher waits for a free fragment slot
+			double wait = buffer + cfg.fragmentDuration - cfg.maxBuffer;
+			now += wait;
+			buffer -= wait;
+		}
+
+		AbrStrategyInput input;
+		input.ladder = cfg.ladder;
+		input.currentProfileIndex = profile;
+		input.bufferedSeconds = buffer;
+		input.fragmentDurationSeconds = cfg.fragmentDuration;
+		if (!samples.empty())
+		{
+			double sum = 0;
+			for (double s : samples)
+			{
+				sum += s;
+			}
+			input.networkBandwidth = (long)(sum / samples.size());
+		}
+		int desired = strategy->GetDesiredProfile(input);
+		if (frag > 0 && desired != profile)
+		{
+			result.switches++;
+		}
+		profile = desired;
+
+		long bandwidth = cfg.ladder[0].bandwidthBitsPerSecond;
+		for (const AbrLadderProfile &p : cfg.ladder)
+		{
+			if (p.profileIndex == profile)
+			{
+				bandwidth = p.bandwidthBitsPerSecond;
+			}
+		}
+		double bits = bandwidth * cfg.fragmentDuration;
+		double dt = trace.DownloadTime(now, bits);
+		now += dt;
+		if (playing)
+		{
+			buffer -= dt;
+			if (buffer < 0)
+			{
+				result.rebufferSeconds += -buffer;
+				result.stalls++;
+				buffer = 0;
+				playing = false;
+			}
+		}
+		buffer += cfg.fragmentDuration;
+		bitrateSum += bandwidth;
+		if (!playing && buffer >= 2 * cfg.fragmentDuration)
+		{
+			playing = true;
+			if (!started)
+			{
+				started = true;
+				result.startupSeconds = now;
+			}
+		}
+
+		samples.push_back(bits / dt);
+		if (samples.size() > SIM_ABR_CACHE_LENGTH)
+		{
+			samples.erase(samples.begin());
+		}
+		if (cfg.verbose)
+		{
+			printf("%s frag:%d t:%.2f profile:%d bitrate:%ld dl:%.2fs buffer:%.2f nwBW:%ld\n", strategy->GetName(), frag, now,
+				profile, bandwidth, dt, buffer, input.networkBandwidth);
+		}
+	}
+	result.avgBitrate = bitrateSum / cfg.fragmentCount;
+	delete strategy;
+	return result;
+}
+
+/**
+ * @brief Print usage
+ */
+static void Usage()
+{
+	printf("Usage: aamp-abr-simulator -t <trace> -l <kbps,kbps,...> [options]\n");
+	printf("  -t <file>   bandwidth trace, \"<seconds> <kbps>\" per line\n");
+	printf("  -l <list>   profile ladder bandwidths in kbps\n");
+	printf("  -d <sec>    fragment duration (default %.0f)\n", SIM_DEFAULT_FRAGMENT_DURATION);
+	printf("  -b <sec>    max buffer (default %.0f)\n", SIM_DEFAULT_MAX_BUFFER);
+	printf("  -r <sec>    min buffer for rampdown (default %.0f)\n", SIM_DEFAULT_MIN_BUFFER);
+	printf("  -u <sec>    buffer for rampup (default %.0f)\n", SIM_DEFAULT_TARGET_BUFFER);
+	printf("  -n <count>  fragments to play (default %d)\n", SIM_DEFAULT_FRAGMENT_COUNT);
+	printf("  -c          exit with failure if bola has lower average bitrate, more switches or more rebuffering than default ABR\n");
+	printf("  -v          print every decision\n");
+}
+
+int main(int argc, char **argv)
+{
+	SimConfig cfg;
+	const char *tracePath = NULL;
+	bool check = false;
+
+	for (int i = 1; i < argc; i++)
+	{
+		const char *arg = argv[i];
+		const char *value = (i + 1 < argc) ? argv[i + 1] : NULL;
+		if (0 == strcmp(arg, "-c"))
+		{
+			check = true;
+		}
+		else if (0 == strcmp(arg, "-v"))
+		{
+			cfg.verbose = true;
+		}
+		else if (value && 0 == strcmp(arg, "-t"))
+		{
+			tracePath = value;
+			i++;
+		}
+		else if (value && 0 == strcmp(arg, "-l"))
+		{
+			std::string list(value);
+			size_t pos = 0;
+			while (pos < list.size())
+			{
+				size_t end = list.find(',', pos);
+				if (end == std::string::npos)
+				{
+					end = list.size();
+				}
+				AbrLadderProfile p;
+				p.profileIndex = (int)cfg.ladder.size();
+				p.bandwidthBitsPerSecond = atol(list.substr(pos, end - pos).c_str()) * 1000;
+				if (p.bandwidthBitsPerSecond > 0)
+				{
+					cfg.ladder.push_back(p);
+				}
+				pos = end + 1;
+			}
+			i++;
+		}
+		else if (value && 0 == strcmp(arg, "-d"))
+		{
+			cfg.fragmentDuration = atof(value);
+			i++;
+		}
+		else if (value && 0 == strcmp(arg, "-b"))
+		{
+			cfg.maxBuffer = atof(value);
+			i++;
+		}
+		else if (value && 0 == strcmp(arg, "-r"))
+		{
+			cfg.minBuffer = atof(value);
+			i++;
+		}
+		else if (value && 0 == strcmp(arg, "-u"))
+		{
+			cfg.targetBuffer = atof(value);
+			i++;
+		}
+		else if (value && 0 == strcmp(arg, "-n"))
+		{
+			cfg.fragmentCount = atoi(value);
+			i++;
+		}
+		else
+		{
+			Usage();
+			return 2;
+		}
+	}
+	if (!tracePath || cfg.ladder.empty() || cfg.fragmentDuration <= 0 || cfg.fragmentCount <= 0 || cfg.maxBuffer < 2 * cfg.fragmentDuration)
+	{
+		Usage();
+		return 2;
+	}
+	std::sort(cfg.ladder.begin(), cfg.ladder.end(), [](const AbrLadderProfile &a, const AbrLadderProfile &b)
+	{
+		return a.bandwidthBitsPerSecond < b.bandwidthBitsPerSecond;
+	});
+
+	Trace trace;
+	if (!trace.Load(tracePath))
+	{
+		return 2;
+	}
+
+	SimResult def = Simulate(cfg, trace, new SimDefaultAbr(cfg.ladder, cfg.minBuffer, cfg.targetBuffer));
+	SimResult throughput = Simulate(cfg, trace, AampAbrStrategy::Create(eAAMP_ABR_MODE_THROUGHPUT, cfg.minBuffer, cfg.targetBuffer));
+	SimResult bola = Simulate(cfg, trace, AampAbrStrategy::Create(eAAMP_ABR_MODE_BOLA, cfg.minBuffer, cfg.targetBuffer));
+	printf("%-12s %12s %9s %12s %7s %10s\n", "strategy", "avg-kbps", "switches", "rebuffer-s", "stalls", "startup-s");
+	printf("%-12s %12.0f %9d %12.2f %7d %10.2f\n", "default", def.avgBitrate / 1000, def.switches,
+		def.rebufferSeconds, def.stalls, def.startupSeconds);
+	printf("%-12s %12.0f %9d %12.2f %7d %10.2f\n", "throughput", throughput.avgBitrate / 1000, throughput.switches,
+		throughput.rebufferSeconds, throughput.stalls, throughput.startupSeconds);
+	printf("%-12s %12.0f %9d %12.2f %7d %10.2f\n", "bola", bola.avgBitrate / 1000, bola.switches,
+		bola.rebufferSeconds, bola.stalls, bola.startupSeconds);
+
+	if (check && (bola.avgBitrate < def.avgBitrate || bola.switches > def.switches ||
+		bola.rebufferSeconds > def.rebufferSeconds))
+	{
+		printf("FAIL: bola does not improve on default ABR\n");
+		return 1;
+	}
+	return 0;
+}
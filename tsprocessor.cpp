@@ -30,9 +30,16 @@
 #include <errno.h>
 #include <stdint.h>
 #include <sys/time.h>
+#include <algorithm>
 #include "priv_aamp.h"
 
 #include "tsprocessor.h"
+#include "AampBufferPool.h"
+#if defined(__SSE2__)
+#include <emmintrin.h>
+#elif defined(__ARM_NEON) || defined(__ARM_NEON__)
+#include <arm_neon.h>
+#endif
 
 
 /**
@@ -42,15 +49,15 @@
 void print_nop(const char *format, ...){}
 
 #ifdef LOG_ENABLE_TRACE
-#define TRACE1 logprintf("PC: TRACE1 %s:%d:", __FUNCTION__, __LINE__ ); logprintf
-#define TRACE2 logprintf("PC: TRACE2 %s:%d:", __FUNCTION__, __LINE__ ); logprintf
-#define TRACE3 logprintf("PC: TRACE3 %s:%d:", __FUNCTION__, __LINE__ ); logprintf
-#define TRACE4 logprintf("PC: TRACE4 %s:%d:", __FUNCTION__, __LINE__ ); logprintf
+#define TRACE1(FORMAT, ...) AAMP_LOG_DEFERRED("PC: TRACE1 %s:%d: " FORMAT, __FUNCTION__, __LINE__, ##__VA_ARGS__)
+#define TRACE2(FORMAT, ...) AAMP_LOG_DEFERRED("PC: TRACE2 %s:%d: " FORMAT, __FUNCTION__, __LINE__, ##__VA_ARGS__)
+#define TRACE3(FORMAT, ...) AAMP_LOG_DEFERRED("PC: TRACE3 %s:%d: " FORMAT, __FUNCTION__, __LINE__, ##__VA_ARGS__)
+#define TRACE4(FORMAT, ...) AAMP_LOG_DEFERRED("PC: TRACE4 %s:%d: " FORMAT, __FUNCTION__, __LINE__, ##__VA_ARGS__)
 #else
-#define TRACE1  print_nop
-#define TRACE2  print_nop
-#define TRACE3  print_nop
-#define TRACE4  print_nop
+#define TRACE1(FORMAT, ...)
+#define TRACE2(FORMAT, ...)
+#define TRACE3(FORMAT, ...)
+#define TRACE4(FORMAT, ...)
 #endif
 
 #ifndef LOG_ENABLE
@@ -123,7 +130,7 @@ void print_nop(const char *format, ...){}
 #define ADAPTATION_FIELD_PRESENT(mpegbuf) ((mpegbuf[3] & 0x20) == 0x20)
 #define PES_PAYLOAD_LENGTH(pesStart) (pesStart[4]<<8|pesStart[5])
 #define MAX_FIRST_PTS_OFFSET (45000) /*500 ms*/
-
+#define DEMUX_MAX_BATCH 64 /*PES packets handed to sink in one call*/
 //#define DEBUG_DEMUX_TRACK 1
 #ifdef DEBUG_DEMUX_TRACK
 #define DEBUG_DEMUX(a...) { \
@@ -153,8 +160,11 @@ private:
 	int pes_state;
 	int pes_header_ext_len;
 	int pes_header_ext_read;
-	GrowableBuffer pes_header;
+	unsigned char pes_header[PES_MIN_DATA];
+	int pes_header_len;
 	GrowableBuffer es;
+	size_t es_size_hint;
+	std::vector<StreamSinkBuffer> pending;
 	double position;
 	double duration;
 	unsigned long long base_pts;
@@ -194,7 +204,15 @@ private:
 			}
 			DEBUG_DEMUX("Send : pts %f dts %f", pts, dts);
 			DEBUG_DEMUX("position %f base_pts %llu current_pts %llu diff %f seconds length %d", position, base_pts, current_pts, (double)(current_pts - base_pts) / 90000, (int)es.len );
-			aamp->SendStream(type, es.ptr, es.len, pts, dts, duration);
+			es_size_hint = es.len;
+			// Ownership of es memory goes to the batch, handed to the sink without a copy
+			StreamSinkBuffer entry = { es.ptr, es.len, es.avail, pts, dts, duration };
+			pending.push_back(entry);
+			memset(&es, 0x00, sizeof(GrowableBuffer));
+			if (pending.size() >= DEMUX_MAX_BATCH)
+			{
+				sendPending();
+			}
 			if (gpGlobalConfig->logging.info)
 			{
 				sentESCount++;
@@ -207,6 +225,36 @@ private:
 		es.len = 0;
 	}
 
+	/**
+	 * @brief Release memory of PES packets not yet sent
+	 */
+	void dropPending()
+	{
+		for (StreamSinkBuffer &entry : pending)
+		{
+			aamp->GetBufferPool()->Release(entry.ptr, entry.avail);
+		}
+		pending.clear();
+	}
+
+	/**
+	 * @brief Size es buffer for the PES packet starting, so payload is appended without reallocation
+	 * @param[in] size expected ES bytes in PES packet
+	 */
+	void reserveES(size_t size)
+	{
+		if (size >= AAMP_BUFFER_POOL_MIN_CLASS_SIZE)
+		{
+			aamp->GetBufferPool()->Reserve(&es, size);
+		}
+		else if (es.avail < size)
+		{
+			// Below smallest pool class, exact sized heap block
+			es.avail = size;
+			es.ptr = (char *)g_realloc(es.ptr, es.avail);
+		}
+	}
+
 public:
 	/**
 	 * @brief Demuxer Constructor
@@ -214,8 +262,8 @@ public:
 	 * @param[in] type Media type to be demuxed
 	 */
 	Demuxer(class PrivateInstanceAAMP *aamp,MediaType type) : aamp(aamp), pes_state(0),
-		pes_header_ext_len(0), pes_header_ext_read(0), pes_header(),
-		es(), position(0), duration(0), base_pts(0), current_pts(0),
+		pes_header_ext_len(0), pes_header_ext_read(0), pes_header(), pes_header_len(0),
+		es(), es_size_hint(0), pending(), position(0), duration(0), base_pts(0), current_pts(0),
 		current_dts(0), type(type), trickmode(false), finalized_base_pts(false),
 		sentESCount(0), first_pts(0)
 	{
@@ -237,8 +285,8 @@ public:
 	 */
 	~Demuxer()
 	{
+		dropPending();
 		aamp_Free(&es.ptr);
-		aamp_Free(&pes_header.ptr);
 	}
 
 
@@ -262,7 +310,7 @@ public:
 		current_pts = 0;
 		first_pts = 0;
 		finalized_base_pts = false;
-		memset(&pes_header, 0x00, sizeof(GrowableBuffer));
+		pes_header_len = 0;
 		memset(&es, 0x00, sizeof(GrowableBuffer));
 		sentESCount = 0;
 		pes_state = PES_STATE_WAITING_FOR_HEADER;
@@ -280,19 +328,32 @@ public:
 			INFO("demux : sending remaining bytes. es.len %d", (int)es.len);
 			send();
 		}
+		sendPending();
 		AAMPLOG_INFO("Demuxer::%s:%d: count %d in duration %f", __FUNCTION__, __LINE__, sentESCount, duration);
 		reset();
 	}
 
 
+	/**
+	 * @brief Send PES packets batched so far to the sink in one call
+	 */
+	void sendPending()
+	{
+		if (!pending.empty())
+		{
+			aamp->SendStream(type, pending);
+		}
+	}
+
+
 	/**
 	 * @brief reset demux state
 	 */
 	void reset()
 	{
+		dropPending();
 		aamp_Free(&es.ptr);
-		aamp_Free(&pes_header.ptr);
-		memset(&pes_header, 0x00, sizeof(GrowableBuffer));
+		pes_header_len = 0;
 		memset(&es, 0x00, sizeof(GrowableBuffer));
 		sentESCount = 0;
 	}
@@ -475,7 +536,7 @@ public:
 				if (PAYLOAD_UNIT_START(packetStart))
 				{
 					pes_state = PES_STATE_GETTING_HEADER;
-					pes_header.len = 0;
+					pes_header_len = 0;
 					DEBUG_DEMUX("Payload Unit Start");
 				}
 
@@ -488,28 +549,29 @@ public:
 						size = 0;
 						break;
 					case PES_STATE_GETTING_HEADER:
-						bytes_to_read = PES_MIN_DATA - pes_header.len;
+						bytes_to_read = PES_MIN_DATA - pes_header_len;
 						if (size < bytes_to_read)
 						{
 							bytes_to_read = size;
 						}
 						DEBUG("PES_STATE_GETTING_HEADER. size = %d, bytes_to_read =%d", size, bytes_to_read);
-						aamp_AppendBytes(&pes_header, data, bytes_to_read);
+						memcpy(pes_header + pes_header_len, data, bytes_to_read);
+						pes_header_len += bytes_to_read;
 						data += bytes_to_read;
 						size -= bytes_to_read;
-						if (pes_header.len == PES_MIN_DATA)
+						if (pes_header_len == PES_MIN_DATA)
 						{
-							if (!IS_PES_PACKET_START(pes_header.ptr))
+							if (!IS_PES_PACKET_START(pes_header))
 							{
-								WARNING("Packet start prefix check failed 0x%x 0x%x 0x%x", pes_header.ptr[0],
-									pes_header.ptr[1], pes_header.ptr[2]);
+								WARNING("Packet start prefix check failed 0x%x 0x%x 0x%x", pes_header[0],
+									pes_header[1], pes_header[2]);
 								pes_state = PES_STATE_WAITING_FOR_HEADER;
 								break;
 							}
-							if (PES_OPTIONAL_HEADER_PRESENT(pes_header.ptr))
+							if (PES_OPTIONAL_HEADER_PRESENT(pes_header))
 							{
 								pes_state = PES_STATE_GETTING_HEADER_EXTENSION;
-								pes_header_ext_len = PES_OPTIONAL_HEADER_LENGTH(pes_header.ptr);
+								pes_header_ext_len = PES_OPTIONAL_HEADER_LENGTH(pes_header);
 								pes_header_ext_read = 0;
 								DEBUG(
 									"Optional header preset len = %d. Switching to PES_STATE_GETTING_HEADER_EXTENSION",
@@ -519,7 +581,7 @@ public:
 							{
 								WARNING(
 									"Optional header not preset pesStart[6] 0x%x bytes_to_read %d- switching to PES_STATE_WAITING_FOR_HEADER",
-									pes_header.ptr[6], bytes_to_read);
+									pes_header[6], bytes_to_read);
 								pes_state = PES_STATE_WAITING_FOR_HEADER;
 							}
 						}
@@ -536,6 +598,9 @@ public:
 						if (pes_header_ext_read == pes_header_ext_len)
 						{
 							pes_state = PES_STATE_GETTING_ES;
+							// PES packet length is 0 (unbounded) for most video, previous ES size is a good guess then
+							int esLength = PES_PAYLOAD_LENGTH(pes_header) - (PES_MIN_DATA - PES_HEADER_LENGTH) - pes_header_ext_len;
+							reserveES((esLength > 0) ? esLength : es_size_hint);
 							DEBUG("Optional header read. switch to PES_STATE_GETTING_ES");
 						}
 						break;
@@ -563,6 +628,181 @@ public:
 
 #define rmf_osal_memcpy(d, s, n, dc, sc)  memcpy(d, s, n)
 
+/**
+ * @brief Find next MPEG start code prefix (00 00 01)
+ *
+ * Sixteen candidate positions are checked per step with SSE2 or NEON where
+ * available; the scalar loop skips three bytes whenever the third byte rules
+ * out a start code at all of them.
+ *
+ * @param[in] data buffer to scan
+ * @param[in] start index to scan from
+ * @param[in] end index to scan till, data up to end + 2 is read
+ * @retval index of first start code at or after start, end if there is none
+ */
+static inline int findStartCode(const unsigned char *data, int start, int end)
+{
+	int j = start;
+#if defined(__SSE2__)
+	const __m128i zero = _mm_setzero_si128();
+	const __m128i one = _mm_set1_epi8(1);
+	for (; j + 16 <= end; j += 16)
+	{
+		__m128i match = _mm_and_si128(
+			_mm_and_si128(_mm_cmpeq_epi8(_mm_loadu_si128((const __m128i *)(data + j)), zero),
+				_mm_cmpeq_epi8(_mm_loadu_si128((const __m128i *)(data + j + 1)), zero)),
+			_mm_cmpeq_epi8(_mm_loadu_si128((const __m128i *)(data + j + 2)), one));
+		int mask = _mm_movemask_epi8(match);
+		if (mask)
+		{
+			return j + __builtin_ctz(mask);
+		}
+	}
+#elif defined(__ARM_NEON) || defined(__ARM_NEON__)
+	for (; j + 16 <= end; j += 16)
+	{
+		uint8x16_t match = vandq_u8(
+			vandq_u8(vceqq_u8(vld1q_u8(data + j), vdupq_n_u8(0)), vceqq_u8(vld1q_u8(data + j + 1), vdupq_n_u8(0))),
+			vceqq_u8(vld1q_u8(data + j + 2), vdupq_n_u8(1)));
+		uint64x2_t lanes = vreinterpretq_u64_u8(match);
+		if (vgetq_lane_u64(lanes, 0) | vgetq_lane_u64(lanes, 1))
+		{
+			// Located within these 16 bytes by the scalar loop
+			break;
+		}
+	}
+#endif
+	while (j < end)
+	{
+		unsigned char third = data[j + 2];
+		if (third > 0x01)
+		{
+			j += 3;
+		}
+		else if (third == 0x01)
+		{
+			if ((data[j] == 0x00) && (data[j + 1] == 0x00))
+			{
+				return j;
+			}
+			j += 3;
+		}
+		else
+		{
+			j++;
+		}
+	}
+	return end;
+}
+
+#define TS_PACKET_PUSI 0x40             /**< payload_unit_start_indicator, as in header byte 1 */
+#define TS_PACKET_CONTINUED 0x01        /**< payload packet following a payload packet of same pid */
+#define TS_PACKET_CC_ERROR 0x02         /**< continuity counter does not follow previous packet */
+#define TS_CLASSIFY_BLOCK 16            /**< packets classified per vector step */
+
+/**
+ * @brief Classify TS packets ahead of their processing
+ *
+ * Header bytes of sixteen packets are gathered and decoded together with SSE2
+ * or NEON where available: PID, payload unit start, adaptation/continuity
+ * byte, and continuity against the previous packet when both carry payload
+ * of the same PID. Only the first packet of such a run needs the per-PID
+ * continuity counter.
+ *
+ * @param[in] packet first TS packet, after TTS header if any
+ * @param[in] packetSize distance between packets
+ * @param[in] count number of packets
+ * @param[out] pid PID of each packet
+ * @param[out] header header byte 3 (scrambling, adaptation, continuity) of each packet
+ * @param[out] flags TS_PACKET_* flags of each packet
+ */
+static void classifyPackets(const unsigned char *packet, int packetSize, int count, unsigned short *pid, unsigned char *header, unsigned char *flags)
+{
+	// Header bytes 1 to 3 of previous packet at index 0, a null packet before the first one
+	unsigned char b1[TS_CLASSIFY_BLOCK + 1] = { 0x1F };
+	unsigned char b2[TS_CLASSIFY_BLOCK + 1] = { 0xFF };
+	unsigned char b3[TS_CLASSIFY_BLOCK + 1] = { 0x00 };
+	for (int i = 0; i < count; )
+	{
+		int n = std::min(count - i, TS_CLASSIFY_BLOCK);
+		for (int k = 1; k <= n; k++, packet += packetSize)
+		{
+			b1[k] = packet[1];
+			b2[k] = packet[2];
+			b3[k] = packet[3];
+		}
+		int k = 0;
+#if defined(__SSE2__)
+		if (n == TS_CLASSIFY_BLOCK)
+		{
+			__m128i cur1 = _mm_loadu_si128((const __m128i *)(b1 + 1));
+			__m128i cur2 = _mm_loadu_si128((const __m128i *)(b2 + 1));
+			__m128i cur3 = _mm_loadu_si128((const __m128i *)(b3 + 1));
+			__m128i prev3 = _mm_loadu_si128((const __m128i *)b3);
+			__m128i pidHigh = _mm_and_si128(cur1, _mm_set1_epi8(0x1F));
+			__m128i samePid = _mm_and_si128(_mm_cmpeq_epi8(pidHigh, _mm_and_si128(_mm_loadu_si128((const __m128i *)b1), _mm_set1_epi8(0x1F))),
+				_mm_cmpeq_epi8(cur2, _mm_loadu_si128((const __m128i *)b2)));
+			__m128i nullPid = _mm_and_si128(_mm_cmpeq_epi8(pidHigh, _mm_set1_epi8(0x1F)), _mm_cmpeq_epi8(cur2, _mm_set1_epi8((char)0xFF)));
+			__m128i payload = _mm_and_si128(_mm_cmpeq_epi8(_mm_and_si128(cur3, _mm_set1_epi8(0x10)), _mm_set1_epi8(0x10)),
+				_mm_cmpeq_epi8(_mm_and_si128(prev3, _mm_set1_epi8(0x10)), _mm_set1_epi8(0x10)));
+			__m128i continued = _mm_andnot_si128(nullPid, _mm_and_si128(samePid, payload));
+			__m128i ccNext = _mm_cmpeq_epi8(_mm_and_si128(cur3, _mm_set1_epi8(0x0F)),
+				_mm_and_si128(_mm_add_epi8(prev3, _mm_set1_epi8(1)), _mm_set1_epi8(0x0F)));
+			__m128i result = _mm_or_si128(_mm_and_si128(cur1, _mm_set1_epi8(TS_PACKET_PUSI)),
+				_mm_or_si128(_mm_and_si128(continued, _mm_set1_epi8(TS_PACKET_CONTINUED)),
+					_mm_and_si128(_mm_andnot_si128(ccNext, continued), _mm_set1_epi8(TS_PACKET_CC_ERROR))));
+			_mm_storeu_si128((__m128i *)(flags + i), result);
+			_mm_storeu_si128((__m128i *)(header + i), cur3);
+			_mm_storeu_si128((__m128i *)(pid + i), _mm_unpacklo_epi8(cur2, pidHigh));
+			_mm_storeu_si128((__m128i *)(pid + i + 8), _mm_unpackhi_epi8(cur2, pidHigh));
+			k = n;
+		}
+#elif (defined(__ARM_NEON) || defined(__ARM_NEON__)) && (__BYTE_ORDER__ == __ORDER_LITTLE_ENDIAN__)
+		if (n == TS_CLASSIFY_BLOCK)
+		{
+			uint8x16_t cur1 = vld1q_u8(b1 + 1);
+			uint8x16_t cur2 = vld1q_u8(b2 + 1);
+			uint8x16_t cur3 = vld1q_u8(b3 + 1);
+			uint8x16_t prev3 = vld1q_u8(b3);
+			uint8x16_t pidHigh = vandq_u8(cur1, vdupq_n_u8(0x1F));
+			uint8x16_t samePid = vandq_u8(vceqq_u8(pidHigh, vandq_u8(vld1q_u8(b1), vdupq_n_u8(0x1F))), vceqq_u8(cur2, vld1q_u8(b2)));
+			uint8x16_t nullPid = vandq_u8(vceqq_u8(pidHigh, vdupq_n_u8(0x1F)), vceqq_u8(cur2, vdupq_n_u8(0xFF)));
+			uint8x16_t payload = vandq_u8(vtstq_u8(cur3, vdupq_n_u8(0x10)), vtstq_u8(prev3, vdupq_n_u8(0x10)));
+			uint8x16_t continued = vbicq_u8(vandq_u8(samePid, payload), nullPid);
+			uint8x16_t ccNext = vceqq_u8(vandq_u8(cur3, vdupq_n_u8(0x0F)), vandq_u8(vaddq_u8(prev3, vdupq_n_u8(1)), vdupq_n_u8(0x0F)));
+			uint8x16_t result = vorrq_u8(vandq_u8(cur1, vdupq_n_u8(TS_PACKET_PUSI)),
+				vorrq_u8(vandq_u8(continued, vdupq_n_u8(TS_PACKET_CONTINUED)), vandq_u8(vbicq_u8(continued, ccNext), vdupq_n_u8(TS_PACKET_CC_ERROR))));
+			vst1q_u8(flags + i, result);
+			vst1q_u8(header + i, cur3);
+			uint8x16x2_t pids = vzipq_u8(cur2, pidHigh);
+			vst1q_u8((unsigned char *)(pid + i), pids.val[0]);
+			vst1q_u8((unsigned char *)(pid + i + 8), pids.val[1]);
+			k = n;
+		}
+#endif
+		for (; k < n; k++)
+		{
+			int packetPid = (((b1[k + 1] & 0x1F) << 8) | b2[k + 1]);
+			int packetFlags = (b1[k + 1] & TS_PACKET_PUSI);
+			if ((packetPid != 0x1FFF) && (packetPid == (((b1[k] & 0x1F) << 8) | b2[k])) && (b3[k + 1] & 0x10) && (b3[k] & 0x10))
+			{
+				packetFlags |= TS_PACKET_CONTINUED;
+				if ((b3[k + 1] & 0x0F) != ((b3[k] + 1) & 0x0F))
+				{
+					packetFlags |= TS_PACKET_CC_ERROR;
+				}
+			}
+			pid[i + k] = packetPid;
+			header[i + k] = b3[k + 1];
+			flags[i + k] = packetFlags;
+		}
+		b1[0] = b1[n];
+		b2[0] = b2[n];
+		b3[0] = b3[n];
+		i += n;
+	}
+}
+
 static unsigned long crc32_table[256];
 static int crc32_initialized = 0;
 
@@ -685,7 +925,7 @@ TSProcessor::TSProcessor(class PrivateInstanceAAMP *aamp,StreamOperation streamO
 	m_havePAT(false), m_versionPAT(0), m_program(0), m_pmtPid(0), m_havePMT(false), m_versionPMT(-1), m_indexAudio(false),
 	m_haveAspect(false), m_haveFirstPTS(false), m_currentPTS(-1), m_pmtCollectorNextContinuity(0),
 	m_pmtCollectorSectionLength(0), m_pmtCollectorOffset(0), m_pmtCollector(NULL),
-	m_scrambledWarningIssued(false), m_checkContinuity(false), videoComponentCount(0), audioComponentCount(0),
+	m_scrambledWarningIssued(false), m_checkContinuity(false), m_packetPid(), m_packetHeader(), m_packetFlags(), videoComponentCount(0), audioComponentCount(0),
 	m_actualStartPTS(-1LL), m_throttleMaxDelayMs(DEFAULT_THROTTLE_MAX_DELAY_MS),
 	m_throttleMaxDiffSegments(DEFAULT_THROTTLE_MAX_DIFF_SEGMENTS_MS),
 	m_throttleDelayIgnoredMs(DEFAULT_THROTTLE_DELAY_IGNORED_MS), m_throttleDelayForDiscontinuityMs(DEFAULT_THROTTLE_DELAY_FOR_DISCONTINUITY_MS),
@@ -1359,6 +1599,7 @@ bool TSProcessor::processBuffer(unsigned char *buffer, int size, bool &insPatPmt
 	unsigned char *packet, *bufferEnd;
 	int pid, payloadStart, adaptation, payloadOffset;
 	int continuity, scramblingControl;
+	int header, flags;
 	int packetCount = 0;
 	insPatPmt = false;
 	bool removePatPmt = false;
@@ -1393,33 +1634,58 @@ bool TSProcessor::processBuffer(unsigned char *buffer, int size, bool &insPatPmt
 	}
 
 	bufferEnd = packet + size - m_ttsSize;
+	int packetTotal = size / m_packetSize;
+	if ((int)m_packetFlags.size() <= packetTotal)
+	{
+		m_packetPid.resize(packetTotal + 1);
+		m_packetHeader.resize(packetTotal + 1);
+		m_packetFlags.resize(packetTotal + 1);
+	}
+	classifyPackets(packet, m_packetSize, packetTotal, m_packetPid.data(), m_packetHeader.data(), m_packetFlags.data());
+	// Packet after the last one does not continue its run
+	m_packetFlags[packetTotal] = 0;
+
 	while (packet < bufferEnd)
 	{
-		pid = (((packet[1] << 8) | packet[2]) & 0x1FFF);
+		pid = m_packetPid[packetCount];
+		header = m_packetHeader[packetCount];
+		flags = m_packetFlags[packetCount];
 		TRACE4("pid = %d, m_ttsSize %d", pid, m_ttsSize);
 
 		if (m_checkContinuity)
 		{
-			if ((pid != 0x1FFF) && (packet[3] & 0x10))
+			if ((pid != 0x1FFF) && (header & 0x10))
 			{
-				continuity = (packet[3] & 0x0F);
-				if (m_continuityCounters[pid] >= 0)
+				continuity = (header & 0x0F);
+				if (flags & TS_PACKET_CONTINUED)
 				{
-					int expected = m_continuityCounters[pid];
-					expected = ((expected + 1) & 0xF);
+					// Checked against previous packet of the run by classification
+					if (flags & TS_PACKET_CC_ERROR)
+					{
+						WARNING("input SPTS discontinuity on pid %X (%d instead of %d) offset %llx",
+							pid, continuity, ((m_packetHeader[packetCount - 1] + 1) & 0xF), (long long)(packetCount*m_packetSize));
+					}
+				}
+				else
+				{
+					int expected = ((m_continuityCounters[pid] + 1) & 0xF);
 					if (expected != continuity)
 					{
 						WARNING("input SPTS discontinuity on pid %X (%d instead of %d) offset %llx",
 							pid, continuity, expected, (long long)(packetCount*m_packetSize));
 					}
 				}
-				m_continuityCounters[pid] = continuity;
+				// Counter of the pid is needed once its run ends
+				if (!(m_packetFlags[packetCount + 1] & TS_PACKET_CONTINUED))
+				{
+					m_continuityCounters[pid] = continuity;
+				}
 			}
 		}
 
 		if (pid == 0)
 		{
-			adaptation = ((packet[3] & 0x30) >> 4);
+			adaptation = ((header & 0x30) >> 4);
 			if (adaptation & 0x01)
 			{
 				payloadOffset = 4;
@@ -1429,7 +1695,7 @@ bool TSProcessor::processBuffer(unsigned char *buffer, int size, bool &insPatPmt
 					payloadOffset += (1 + packet[4]);
 				}
 
-				payloadStart = (packet[1] & 0x40);
+				payloadStart = (flags & TS_PACKET_PUSI);
 				if (payloadStart)
 				{
 					int tableid = packet[payloadOffset + 1];
@@ -1500,7 +1766,7 @@ bool TSProcessor::processBuffer(unsigned char *buffer, int size, bool &insPatPmt
 		else if (pid == m_pmtPid)
 		{
 			TRACE4("Got PMT : m_pmtPid %d", m_pmtPid);
-			adaptation = ((packet[3] & 0x30) >> 4);
+			adaptation = ((header & 0x30) >> 4);
 			if (adaptation & 0x01)
 			{
 				payloadOffset = 4;
@@ -1510,7 +1776,7 @@ bool TSProcessor::processBuffer(unsigned char *buffer, int size, bool &insPatPmt
 					payloadOffset += (1 + packet[4]);
 				}
 
-				payloadStart = (packet[1] & 0x40);
+				payloadStart = (flags & TS_PACKET_PUSI);
 				if (payloadStart)
 				{
 					int tableid = packet[payloadOffset + 1];
@@ -1563,7 +1829,7 @@ bool TSProcessor::processBuffer(unsigned char *buffer, int size, bool &insPatPmt
 										rmf_osal_memcpy(m_pmtCollector, sectionData, sectionAvail, MAX_PMT_SECTION_SIZE, (bufferEnd - sectionData));
 										m_pmtCollectorSectionLength = sectionLength;
 										m_pmtCollectorOffset = sectionAvail;
-										m_pmtCollectorNextContinuity = ((packet[3] + 1) & 0xF);
+										m_pmtCollectorNextContinuity = ((header + 1) & 0xF);
 										INFO("RecordContext: starting to collect multi-packet pmt: section length %d", sectionLength);
 									}
 									else
@@ -1589,7 +1855,7 @@ bool TSProcessor::processBuffer(unsigned char *buffer, int size, bool &insPatPmt
 					// process subsequent parts of multi-packet pmt
 					if (m_pmtCollectorOffset)
 					{
-						int continuity = (packet[3] & 0xF);
+						int continuity = (header & 0xF);
 						if (((continuity + 1) & 0xF) == m_pmtCollectorNextContinuity)
 						{
 							WARNING("Warning: RecordContext: next packet of multi-packet pmt has wrong continuity count %d (expecting %d)",
@@ -1646,10 +1912,10 @@ bool TSProcessor::processBuffer(unsigned char *buffer, int size, bool &insPatPmt
 			if ((m_actualStartPTS == -1LL) && doThrottle)
 			{
 				payloadOffset = 4;
-				adaptation = ((packet[3] & 0x30) >> 4);
-				payloadStart = (packet[1] & 0x40);
+				adaptation = ((header & 0x30) >> 4);
+				payloadStart = (flags & TS_PACKET_PUSI);
 
-				scramblingControl = ((packet[3] & 0xC0) >> 6);
+				scramblingControl = ((header & 0xC0) >> 6);
 				if (scramblingControl)
 				{
 					if (!m_scrambledWarningIssued)
@@ -1943,6 +2209,14 @@ bool TSProcessor::demuxAndSend(const void *ptr, size_t len, double position, dou
 		packetStart += PACKET_SIZE;
 		len -= PACKET_SIZE;
 	}
+	if (m_vidDemuxer)
+	{
+		m_vidDemuxer->sendPending();
+	}
+	if (m_audDemuxer)
+	{
+		m_audDemuxer->sendPending();
+	}
 	return ret;
 }
 
@@ -2249,6 +2523,21 @@ bool TSProcessor::sendSegment(char *segment, size_t& size, double position, doub
 	return ret;
 }
 
+/**
+ * @brief Does configured operation on the segment held in buffer and injects data to sink
+ * @note Data is re-packetized by the processor, buffer ownership is retained by caller
+ * @param[in] buffer Buffer containing the data segment
+ * @param[in] position Position of the segment in seconds
+ * @param[in] duration Duration of the segment in seconds
+ * @param[in] discontinuous true if fragment is discontinuous
+ * @param[out] true on PTS error
+ * @retval true on success
+ */
+bool TSProcessor::sendSegmentBuffer(GrowableBuffer *buffer, double position, double duration, bool discontinuous, bool &ptsError)
+{
+	return sendSegment(buffer->ptr, buffer->len, position, duration, discontinuous, ptsError);
+}
+
 #define HEADER_SIZE 4
 #define INDEX(i) (base+i < m_packetSize-m_ttsSize-HEADER_SIZE) ? i : i+m_ttsSize+HEADER_SIZE
 
@@ -2606,12 +2895,10 @@ void TSProcessor::checkIfInterlaced(unsigned char *packet, int length)
 							m_scanRemainderSize += copyLen;
 							if (m_scanRemainderSize >= m_scanRemainderLimit * 2)
 							{
-								for (j = 0; j < m_scanRemainderLimit; ++j)
+								for (j = findStartCode(remainder, 0, m_scanRemainderLimit); j < m_scanRemainderLimit;
+									j = findStartCode(remainder, j + 1, m_scanRemainderLimit))
 								{
-									if ((remainder[j] == 0x00) && (remainder[j + 1] == 0x00) && (remainder[j + 2] == 0x01))
-									{
-										processStartCode(&remainder[j], m_scanForFrameSize, 2 * m_scanRemainderLimit - j, j);
-									}
+									processStartCode(&remainder[j], m_scanForFrameSize, 2 * m_scanRemainderLimit - j, j);
 								}
 
 								m_scanRemainderSize = 0;
@@ -2641,16 +2928,13 @@ void TSProcessor::checkIfInterlaced(unsigned char *packet, int length)
 						// where we can no longer access all needed start code bytes.
 						jmax = m_packetSize - m_scanRemainderLimit - m_ttsSize;
 
-						for (j = payload; j < jmax; ++j)
+						for (j = findStartCode(packet, payload, jmax); j < jmax; j = findStartCode(packet, j + 1, jmax))
 						{
-							if ((packet[j] == 0x00) && (packet[j + 1] == 0x00) && (packet[j + 2] == 0x01))
-							{
-								processStartCode(&packet[j], m_scanForFrameSize, jmax - j, j);
+							processStartCode(&packet[j], m_scanForFrameSize, jmax - j, j);
 
-								if (!m_scanForFrameSize || m_isInterlacedKnown)
-								{
-									break;
-								}
+							if (!m_scanForFrameSize || m_isInterlacedKnown)
+							{
+								break;
 							}
 						}
 
@@ -2954,13 +3238,11 @@ void TSProcessor::reTimestamp(unsigned char *&packet, int length)
 
 						  if (m_scanRemainderSize >= m_scanRemainderLimit * 3)
 						  {
-							  for (j = 0; j < m_scanRemainderLimit; ++j)
+							  for (j = findStartCode(remainder, 0, m_scanRemainderLimit); j < m_scanRemainderLimit;
+								  j = findStartCode(remainder, j + 1, m_scanRemainderLimit))
 							  {
-								  if ((remainder[j] == 0x00) && (remainder[j + 1] == 0x00) && (remainder[j + 2] == 0x01))
-								  {
-									  processStartCode(&remainder[j], m_scanForFrameSize, 3 * m_scanRemainderLimit - j, j);
-									  rmf_osal_memcpy(packet + payload, remainder + m_scanRemainderLimit, 2 * m_scanRemainderLimit, packetEnd - (packet + payload), m_scanRemainderLimit * 3 - m_scanRemainderLimit);
-								  }
+								  processStartCode(&remainder[j], m_scanForFrameSize, 3 * m_scanRemainderLimit - j, j);
+								  rmf_osal_memcpy(packet + payload, remainder + m_scanRemainderLimit, 2 * m_scanRemainderLimit, packetEnd - (packet + payload), m_scanRemainderLimit * 3 - m_scanRemainderLimit);
 							  }
 
 							  m_scanRemainderSize = 0;
@@ -2990,16 +3272,13 @@ void TSProcessor::reTimestamp(unsigned char *&packet, int length)
 					  // where we can no longer access all needed start code bytes.
 					  jmax = m_packetSize - m_scanRemainderLimit - m_ttsSize;
 
-					  for (j = payload; j < jmax; ++j)
+					  for (j = findStartCode(packet, payload, jmax); j < jmax; j = findStartCode(packet, j + 1, jmax))
 					  {
-						  if ((packet[j] == 0x00) && (packet[j + 1] == 0x00) && (packet[j + 2] == 0x01))
-						  {
-							  processStartCode(&packet[j], m_scanForFrameSize, jmax - j, j);
+						  processStartCode(&packet[j], m_scanForFrameSize, jmax - j, j);
 
-							  if (!m_scanForFrameSize)
-							  {
-								  break;
-							  }
+						  if (!m_scanForFrameSize)
+						  {
+							  break;
 						  }
 					  }
 
@@ -110,6 +110,7 @@ class TSProcessor : public MediaProcessor
       TSProcessor& operator=(const TSProcessor&) = delete;
       ~TSProcessor();
       bool sendSegment( char *segment, size_t& size, double position, double duration, bool discontinuous, bool &ptsError);
+      bool sendSegmentBuffer(GrowableBuffer *buffer, double position, double duration, bool discontinuous, bool &ptsError);
       void setRate(double rate, PlayMode mode);
       void setThrottleEnable(bool enable);
 
@@ -282,6 +283,9 @@ class TSProcessor : public MediaProcessor
       unsigned char *m_pmtCollector; //!< A buffer pointer to hold PMT data at the time of examining TS buffer
       bool m_scrambledWarningIssued;
       bool m_checkContinuity;
+      std::vector<unsigned short> m_packetPid; //!< PID of each packet of buffer being processed
+      std::vector<unsigned char> m_packetHeader; //!< Header byte 3 of each packet of buffer being processed
+      std::vector<unsigned char> m_packetFlags; //!< Classification flags of each packet of buffer being processed
       int videoComponentCount, audioComponentCount;
       RecordingComponent videoComponents[MAX_PIDS], audioComponents[MAX_PIDS];
 